@@ -25,6 +25,9 @@
 #define INITIAL_NUM_ARRAYS  50
 #define NO_JOBS_IN_ARRAY   -21
 
+/* number of queued subjobs kept as jobs when virtual subjobs are enabled */
+#define VIRTUAL_SUBJOB_WINDOW 256
+
 #define ARRAY_FILE_SUFFIX ".AR"
 
 enum ArrayEventsEnum {
@@ -201,6 +204,15 @@ int release_array_range(job_array *,struct batch_request *,char *);
 
 int first_job_index(job_array *);
 
+bool use_virtual_subjobs();
+int  array_next_virtual_index(job_array *pa);
+int  array_count_virtual_indices(job_array *pa);
+int  array_restore_virtual_index(job_array *pa, int index);
+int  array_drop_virtual_range(job_array *pa, int start, int end);
+int  array_materialize_budget(job_array *pa);
+int  materialize_virtual_index(job_array **pa_ptr, int index);
+int  materialize_virtual_subjobs(job_array **pa_ptr);
+
 void update_array_statuses();
 
 int num_array_jobs(const char *);
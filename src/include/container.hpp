@@ -15,8 +15,11 @@
 #include <boost/multi_index/member.hpp>
 */
 #include <boost/unordered_map.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/functional/hash.hpp>
 #include <string>
 #include <vector>
+#include <map>
 #include <pthread.h>
 #include <memory.h>
 #include <errno.h>
@@ -28,6 +31,8 @@ extern bool exit_called;
 #define THING_NOT_FOUND    -2
 #define ALREADY_IN_LIST     9
 #define ALWAYS_EMPTY_INDEX  0
+#define CONTAINER_SHARDS    16
+#define SNAPSHOT_CHUNK      256 /* entries per block of a snapshot */
 
 
 //#define CHECK_LOCKING
@@ -49,7 +54,7 @@ class item
   {
   public:
 
-  item(std::string const &idString, T p): id(idString), ptr(p)
+  item(std::string const &idString, T p): id(idString), generation(0), ptr(p)
     {
     }
 
@@ -69,7 +74,8 @@ class item
     return ptr;
     }
 
-  std::string id;
+  std::string   id;
+  unsigned long generation; /* when it was inserted, tells it from an earlier insert of the same id */
   private:
   item(){}
   T ptr;
@@ -81,13 +87,176 @@ template <class T> class slot
   item<T> *pItem;
   int     next;
   int     prev;
+  bool    ranked; /* true if the slot is in the container's rank index */
+  long    rank;
   };
 
+/*
+ * sharded_index mirrors the id to item mapping of an item_container in
+ * CONTAINER_SHARDS hash tables, each with its own mutex, so a lookup by id
+ * only contends with writers that hash to the same shard and never waits on
+ * the container mutex. The container keeps it current while holding its own
+ * lock; the shard mutexes are leaf locks and nothing else is taken under them.
+ */
+
+template <class T>
+class sharded_index
+  {
+  public:
+
+  sharded_index()
+    {
+    for (int i = 0; i < CONTAINER_SHARDS; i++)
+      pthread_mutex_init(&shards[i].mutex, NULL);
+    }
+
+
+
+  void set(
+
+    std::string const &id,
+    T                  it,
+    unsigned long      generation)
+
+    {
+    shard &s = shard_for(id);
+
+    pthread_mutex_lock(&s.mutex);
+    s.map[id].it = it;
+    s.map[id].generation = generation;
+    pthread_mutex_unlock(&s.mutex);
+    }
+
+
+
+  void erase(
+
+    std::string const &id)
+
+    {
+    shard &s = shard_for(id);
+
+    pthread_mutex_lock(&s.mutex);
+    s.map.erase(id);
+    pthread_mutex_unlock(&s.mutex);
+    }
+
+
+
+  bool get(
+
+    std::string const &id,
+    T                 &it)
+
+    {
+    shard &s = shard_for(id);
+    bool   found = false;
+
+    pthread_mutex_lock(&s.mutex);
+
+    typename boost::unordered_map<std::string, shard_entry>::iterator entry = s.map.find(id);
+
+    if (entry != s.map.end())
+      {
+      it = entry->second.it;
+      found = true;
+      }
+
+    pthread_mutex_unlock(&s.mutex);
+
+    return(found);
+    }
+
+
+
+  /*
+   * @return true if id is still mapped to it, inserted at generation
+   */
+  bool is_current(
+
+    std::string const &id,
+    T                  it,
+    unsigned long      generation)
+
+    {
+    shard &s = shard_for(id);
+    bool   current = false;
+
+    pthread_mutex_lock(&s.mutex);
+
+    typename boost::unordered_map<std::string, shard_entry>::iterator entry = s.map.find(id);
+
+    if ((entry != s.map.end()) &&
+        (entry->second.it == it) &&
+        (entry->second.generation == generation))
+      current = true;
+
+    pthread_mutex_unlock(&s.mutex);
+
+    return(current);
+    }
+
+
+
+  void clear()
+    {
+    for (int i = 0; i < CONTAINER_SHARDS; i++)
+      {
+      pthread_mutex_lock(&shards[i].mutex);
+      shards[i].map.clear();
+      pthread_mutex_unlock(&shards[i].mutex);
+      }
+    }
+
+  private:
+
+  struct shard_entry
+    {
+    T             it;
+    unsigned long generation;
+    };
+
+  struct shard
+    {
+    pthread_mutex_t                                  mutex;
+    boost::unordered_map<std::string, shard_entry>   map;
+    };
+
+  shard &shard_for(
+
+    std::string const &id)
+
+    {
+    return(shards[boost::hash<std::string>()(id) % CONTAINER_SHARDS]);
+    }
+
+  shard shards[CONTAINER_SHARDS];
+  };
+
+
+
 template <class T>
 class item_container
   {
   public:
 
+  /* an item as it was when it went into a snapshot */
+  struct snapshot_entry
+    {
+    std::string   id;
+    T             it;
+    unsigned long generation;
+    };
+
+  /*
+   * the container's items in order, in blocks of up to SNAPSHOT_CHUNK
+   * entries. Once an iterator holds a snapshot neither the list nor its
+   * blocks change: a writer copies the list of block pointers and at most
+   * the block it appends to.
+   */
+  typedef std::vector<snapshot_entry> snapshot_chunk;
+  typedef std::vector<boost::shared_ptr<snapshot_chunk> > snapshot_list;
+
 #if 0
   typedef multi_index_container<item<T>,
       indexed_by<
@@ -107,7 +276,8 @@ class item_container
     T get_next_item()
       {
 #ifdef CHECK_LOCKING
-      if (!*pLocked)
+      if ((snapshot.get() == NULL) &&
+          (!*pLocked))
         {
         char *p = NULL;
         while(1)
@@ -124,6 +294,9 @@ class item_container
       if (endHit)
         return(NULL);
 
+      if (snapshot.get() != NULL)
+        return(next_from_snapshot());
+
       if (iter == ALWAYS_EMPTY_INDEX)
         {
         endHit = true;
@@ -169,9 +342,41 @@ class item_container
       pContainer->initialize_ra_iterator(&iter);
       reversed = reverse;
       endHit = false;
+      chunk = 0;
+      offset = 0;
+      }
+
+    /*
+     * iterates over a snapshot instead of the live slots. The container lock
+     * is only needed to create the iterator, not to advance it.
+     */
+    item_iterator(item_container<T> *pCtner,
+        boost::shared_ptr<snapshot_list> snap,
+        bool reverse = false) : snapshot(snap)
+      {
+#ifdef CHECK_LOCKING
+      pLocked = NULL;
+#endif
+      pContainer = pCtner;
+      iter = -1;
+      reversed = reverse;
+      endHit = false;
+      rewind_snapshot();
       }
+
+    bool is_snapshot() const
+      {
+      return(snapshot.get() != NULL);
+      }
+
     void reset(void) //Reset the iterator;
       {
+      if (snapshot.get() != NULL)
+        {
+        rewind_snapshot();
+        endHit = false;
+        return;
+        }
 #ifdef CHECK_LOCKING
     if(!*pLocked)
       {
@@ -187,7 +392,68 @@ class item_container
       endHit = false;
       }
   private:
+
+    void rewind_snapshot()
+      {
+      chunk = 0;
+      offset = 0;
+
+      if ((reversed) &&
+          (snapshot.get() != NULL))
+        chunk = snapshot->size();
+      }
+
+    /*
+     * returns the next item of the snapshot that is still in the container.
+     * Items removed since the snapshot was taken are skipped, so the caller
+     * sees the same thing a locked walk would have shown at that moment.
+     */
+    T next_from_snapshot()
+      {
+      while (true)
+        {
+        snapshot_entry const *entry;
+
+        if (reversed)
+          {
+          if (offset == 0)
+            {
+            if (chunk == 0)
+              break;
+
+            offset = (*snapshot)[--chunk]->size();
+            continue;
+            }
+
+          entry = &(*(*snapshot)[chunk])[--offset];
+          }
+        else
+          {
+          if (chunk >= snapshot->size())
+            break;
+
+          if (offset >= (*snapshot)[chunk]->size())
+            {
+            chunk++;
+            offset = 0;
+            continue;
+            }
+
+          entry = &(*(*snapshot)[chunk])[offset++];
+          }
+
+        if (pContainer->is_current(*entry))
+          return(entry->it);
+        }
+
+      endHit = true;
+      return(pContainer->empty_val());
+      }
+
     item_container<T> *pContainer;
+    boost::shared_ptr<snapshot_list> snapshot;
+    size_t chunk;
+    size_t offset;
     int iter;
     bool endHit;
     bool reversed;
@@ -196,9 +462,13 @@ class item_container
 #endif
     };
 
-  item_container():
+  item_container(
+
+    bool sharded = false):
 
     updateCounter(0),
+    snapshot_stale(0),
+    shard_index(NULL),
     max(0),
     num(0),
     next_slot(1),
@@ -206,6 +476,10 @@ class item_container
 
     {
     pthread_mutex_init(&mutex, NULL);
+
+    if (sharded)
+      shard_index = new sharded_index<T>();
+
     max = 10;
     slots = (slot<T> *)calloc(max, sizeof(slot<T>));
 #ifdef CHECK_LOCKING
@@ -232,6 +506,12 @@ class item_container
       free(slots);
       slots = NULL;
       }
+
+    if (shard_index != NULL)
+      {
+      delete shard_index;
+      shard_index = NULL;
+      }
     }
 
 
@@ -287,6 +567,57 @@ class item_container
 
 
 
+  /*
+   * inserts it ahead of the first item ranked at or above rank, the place
+   * a walk from the back of a rank ordered container would choose. Only
+   * the rank index is consulted, so no other item is looked at.
+   *
+   * @return false if id is already present or the insert failed
+   */
+
+  bool insert_by_rank(
+
+    T                  it,
+    std::string const &id,
+    long               rank)
+
+    {
+    CHECK_LOCK
+    if (exit_called)
+      return false;
+
+    if (map[id] != ALWAYS_EMPTY_INDEX)
+      return false;
+
+    std::multimap<long, int>::iterator before = ranks.lower_bound(rank);
+    int                                index = ALWAYS_EMPTY_INDEX;
+
+    if (before != ranks.begin())
+      {
+      std::multimap<long, int>::iterator prev = before;
+
+      index = (--prev)->second;
+      }
+
+    item<T> *pItem = new item<T>(id,it);
+    int      rc = insert_thing_after(pItem, index);
+
+    if (rc < 0)
+      {
+      delete pItem;
+      return false;
+      }
+
+    /* the hint keeps equal ranks in the index in container order */
+    slots[rc].ranked = true;
+    slots[rc].rank = rank;
+    ranks.insert(before, std::make_pair(rank, rc));
+
+    return true;
+    }
+
+
+
   bool insert_at(
       
     int                index,
@@ -401,6 +732,48 @@ class item_container
 
 
 
+  /*
+   * find an item by id without the caller holding the container lock. With
+   * a sharded index this only takes the lock of the id's shard; otherwise it
+   * briefly takes the container lock. Must not be called with the container
+   * locked. The item may be removed as soon as this returns.
+   */
+  T lookup(
+
+    std::string const &id)
+
+    {
+    T it;
+
+    if (exit_called)
+      return empty_val();
+
+    if (shard_index != NULL)
+      {
+      if (shard_index->get(id, it))
+        return it;
+
+      return empty_val();
+      }
+
+    it = empty_val();
+
+    lock();
+
+    boost::unordered_map<std::string, int>::iterator entry = map.find(id);
+
+    if ((entry != map.end()) &&
+        (entry->second != ALWAYS_EMPTY_INDEX) &&
+        (slots[entry->second].pItem != NULL))
+      it = slots[entry->second].pItem->get();
+
+    unlock();
+
+    return it;
+    }
+
+
+
   T pop(void)
     {
     CHECK_LOCK
@@ -458,6 +831,8 @@ class item_container
     slots[ind2].pItem = pTmp;
     map[id1] = ind2;
     map[id2] = ind1;
+    updateCounter++;
+    snapshot.reset();
 
     return true;
     }
@@ -483,6 +858,74 @@ class item_container
 
 
 
+  /*
+   * returns an iterator over the container as it is now that walks without
+   * the container lock. The snapshot is shared by every iterator and kept
+   * up to date by the writers: appends add to its last block (copying only
+   * that block if an iterator still holds it), removals are skipped by the
+   * iterators, and it is only rebuilt after a reorder or once removed items
+   * outnumber the live ones. Items removed after the iterator was created
+   * are skipped, and an id removed and inserted again is only returned once.
+   */
+  item_iterator *get_snapshot_iterator(
+
+    bool reverse = false)
+
+    {
+    CHECK_LOCK
+
+    if (exit_called)
+      return(NULL);
+
+    if (snapshot.get() == NULL)
+      {
+      snapshot.reset(new snapshot_list());
+      snapshot_stale = 0;
+
+      for (int i = slots[ALWAYS_EMPTY_INDEX].next; i != ALWAYS_EMPTY_INDEX; i = slots[i].next)
+        snapshot_append(slots[i].pItem);
+      }
+
+    return new item_iterator(this, snapshot, reverse);
+    }
+
+
+
+  /*
+   * @return true if the snapshot entry is still in the container, the same
+   * item that was there when the entry was taken
+   */
+  bool is_current(
+
+    snapshot_entry const &entry)
+
+    {
+    bool current = false;
+
+    if (exit_called)
+      return(false);
+
+    if (shard_index != NULL)
+      return(shard_index->is_current(entry.id, entry.it, entry.generation));
+
+    lock();
+
+    boost::unordered_map<std::string, int>::iterator it = map.find(entry.id);
+
+    if ((it != map.end()) &&
+        (it->second != ALWAYS_EMPTY_INDEX) &&
+        (slots[it->second].pItem != NULL) &&
+        (slots[it->second].pItem->get() == entry.it) &&
+        (slots[it->second].pItem->generation == entry.generation))
+      current = true;
+
+    unlock();
+
+    return(current);
+    }
+
+
+
   void clear()
     {
     CHECK_LOCK
@@ -500,8 +943,17 @@ class item_container
 
       slots[i].next = ALWAYS_EMPTY_INDEX;
       slots[i].prev = ALWAYS_EMPTY_INDEX;
+      slots[i].ranked = false;
       }
 
+    ranks.clear();
+
+    if (shard_index != NULL)
+      shard_index->clear();
+
+    snapshot.reset();
+    updateCounter++;
+
     num = 0;
     next_slot = 1;
     last = 0;
@@ -649,6 +1101,11 @@ class item_container
     slots[next_slot].pItem = thing;
     map[thing->id] = next_slot;
 
+    thing->generation = ++updateCounter;
+
+    if (shard_index != NULL)
+      shard_index->set(thing->id, thing->get(), thing->generation);
+
     /* save the insertion point */
     rc = next_slot;
 
@@ -673,6 +1130,8 @@ class item_container
 
     update_next_slot();
 
+    snapshot_append(thing);
+
     return(rc);
     } /* END insert_thing() */
 
@@ -702,6 +1161,11 @@ class item_container
     slots[next_slot].pItem = thing;
     map[thing->id] = next_slot;
 
+    thing->generation = ++updateCounter;
+
+    if (shard_index != NULL)
+      shard_index->set(thing->id, thing->get(), thing->generation);
+
     /* save the insertion point */
     rc = next_slot;
 
@@ -716,9 +1180,14 @@ class item_container
       slots[next].prev = rc;
       }
 
-    /* update the last index if needed */
+    /* update the last index if needed, only an append keeps the snapshot */
     if (last == index)
+      {
       last = rc;
+      snapshot_append(thing);
+      }
+    else
+      snapshot.reset();
 
     /* increase the count */
     num++;
@@ -753,6 +1222,11 @@ class item_container
     slots[next_slot].pItem = thing;
     map[thing->id] = next_slot;
 
+    thing->generation = ++updateCounter;
+
+    if (shard_index != NULL)
+      shard_index->set(thing->id, thing->get(), thing->generation);
+
     /* save the insertion point */
     rc = next_slot;
 
@@ -763,6 +1237,8 @@ class item_container
     slots[index].prev = rc;
     slots[prev].next = rc;
 
+    snapshot.reset();
+
     /* increase the count */
     num++;
 
@@ -807,6 +1283,35 @@ class item_container
     int next = slots[index].next;
 
     map.erase(slots[index].pItem->id);
+
+    if (shard_index != NULL)
+      shard_index->erase(slots[index].pItem->id);
+
+    if (slots[index].ranked)
+      {
+      std::pair<std::multimap<long, int>::iterator, std::multimap<long, int>::iterator> range;
+
+      range = ranks.equal_range(slots[index].rank);
+
+      for (std::multimap<long, int>::iterator r = range.first; r != range.second; r++)
+        {
+        if (r->second == index)
+          {
+          ranks.erase(r);
+          break;
+          }
+        }
+
+      slots[index].ranked = false;
+      }
+
+    /* the snapshot skips removed items; rebuild it once they dominate it */
+    updateCounter++;
+
+    if ((snapshot.get() != NULL) &&
+        (++snapshot_stale > (unsigned long)num))
+      snapshot.reset();
+
     slots[index].prev = ALWAYS_EMPTY_INDEX;
     slots[index].next = ALWAYS_EMPTY_INDEX;
     delete slots[index].pItem;
@@ -1083,6 +1588,41 @@ class item_container
 
 
 
+  /*
+   * appends an item to the snapshot, if there is one. Blocks and the list of
+   * blocks an iterator may be reading are copied rather than changed.
+   */
+  void snapshot_append(
+
+    item<T> *thing)
+
+    {
+    if (snapshot.get() == NULL)
+      return;
+
+    if (!snapshot.unique())
+      snapshot.reset(new snapshot_list(*snapshot));
+
+    if ((snapshot->empty()) ||
+        (snapshot->back()->size() >= SNAPSHOT_CHUNK))
+      {
+      snapshot->push_back(boost::shared_ptr<snapshot_chunk>(new snapshot_chunk()));
+      snapshot->back()->reserve(SNAPSHOT_CHUNK);
+      }
+    else if (!snapshot->back().unique())
+      snapshot->back().reset(new snapshot_chunk(*snapshot->back()));
+
+    snapshot_entry entry;
+
+    entry.id = thing->id;
+    entry.it = thing->get();
+    entry.generation = thing->generation;
+
+    snapshot->back()->push_back(entry);
+    } /* END snapshot_append() */
+
+
+
   item<T> *get_thing_from_index(
 
     int index)
@@ -1099,18 +1639,37 @@ class item_container
 
   //indexed_container container;
   pthread_mutex_t mutex;
-  unsigned long updateCounter;
+  unsigned long updateCounter;   /* bumped on every change, dates inserted items */
+  unsigned long snapshot_stale;  /* removals since the snapshot was built */
+  boost::shared_ptr<snapshot_list> snapshot;
+  sharded_index<T> *shard_index;
   slot<T> *slots;
   int max;
   int num;
   int next_slot;
   int last;
   boost::unordered_map<std::string, int> map;
+  std::multimap<long, int> ranks; /* rank -> slot, for insert_by_rank() */
 #ifdef CHECK_LOCKING
   bool locked;
 #endif
   };
 
+/*
+ * an item_container that also keeps a sharded_index, so lookup() never takes
+ * the container lock. Meant for the large, busy containers such as alljobs.
+ */
+
+template <class T>
+class sharded_container : public item_container<T>
+  {
+  public:
+
+  sharded_container() : item_container<T>(true)
+    {
+    }
+  };
+
 } //End of namespace scope.
 
 #endif
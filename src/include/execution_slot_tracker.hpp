@@ -82,10 +82,24 @@
 
 #include <vector>
 
+/*
+ * Slots are kept one bit per slot in words, set when the slot is occupied.
+ * Only the window of words from first_word up to the last one with a bit
+ * set is stored; every slot outside it is free. A node's tracker and the
+ * per-job subsets in job_usage_info share this layout, so a job using a
+ * few neighbouring slots costs a word or two however wide the node is.
+ */
+
 class execution_slot_tracker
   {
-  std::vector<bool> slots;
-  int               open_count;
+  std::vector<unsigned long> words;      /* occupied bits for the stored window */
+  int                        first_word; /* index of the word at words[0] */
+  int                        slot_count; /* total number of slots */
+  int                        open_count; /* number of free slots */
+
+  unsigned long *word_for(int index, bool create);
+  void           trim();
+  void           resize_to(int size);
 
   public:
     execution_slot_tracker(const execution_slot_tracker& est);
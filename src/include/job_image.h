@@ -0,0 +1,155 @@
+#ifndef JOB_IMAGE_H
+#define JOB_IMAGE_H
+/*
+*         OpenPBS (Portable Batch System) v2.3 Software License
+*
+* Copyright (c) 1999-2000 Veridian Information Solutions, Inc.
+* All rights reserved.
+*
+* ---------------------------------------------------------------------------
+* For a license to use or redistribute the OpenPBS software under conditions
+* other than those described below, or to purchase support for this software,
+* please contact Veridian Systems, PBS Products Department ("Licensor") at:
+*
+*    www.OpenPBS.org  +1 650 967-4675                  sales@OpenPBS.org
+*                        877 902-4PBS (US toll-free)
+* ---------------------------------------------------------------------------
+*
+* This license covers use of the OpenPBS v2.3 software (the "Software") at
+* your site or location, and, for certain users, redistribution of the
+* Software to other sites and locations.  Use and redistribution of
+* OpenPBS v2.3 in source and binary forms, with or without modification,
+* are permitted provided that all of the following conditions are met.
+* After December 31, 2001, only conditions 3-6 must be met:
+*
+* 1. Commercial and/or non-commercial use of the Software is permitted
+*    provided a current software registration is on file at www.OpenPBS.org.
+*    If use of this software contributes to a publication, product, or
+*    service, proper attribution must be given; see www.OpenPBS.org/credit.html
+*
+* 2. Redistribution in any form is only permitted for non-commercial,
+*    non-profit purposes.  There can be no charge for the Software or any
+*    software incorporating the Software.  Further, there can be no
+*    expectation of revenue generated as a consequence of redistributing
+*    the Software.
+*
+* 3. Any Redistribution of source code must retain the above copyright notice
+*    and the acknowledgment contained in paragraph 6, this list of conditions
+*    and the disclaimer contained in paragraph 7.
+*
+* 4. Any Redistribution in binary form must reproduce the above copyright
+*    notice and the acknowledgment contained in paragraph 6, this list of
+*    conditions and the disclaimer contained in paragraph 7 in the
+*    documentation and/or other materials provided with the distribution.
+*
+* 5. Redistributions in any form must be accompanied by information on how to
+*    obtain complete source code for the OpenPBS software and any
+*    modifications and/or additions to the OpenPBS software.  The source code
+*    must either be included in the distribution or be available for no more
+*    than the cost of distribution plus a nominal fee, and all modifications
+*    and additions to the Software must be freely redistributable by any party
+*    (including Licensor) without restriction.
+*
+* 6. All advertising materials mentioning features or use of the Software must
+*    display the following acknowledgment:
+*
+*     "This product includes software developed by NASA Ames Research Center,
+*     Lawrence Livermore National Laboratory, and Veridian Information
+*     Solutions, Inc.
+*     Visit www.OpenPBS.org for OpenPBS software support,
+*     products, and information."
+*
+* 7. DISCLAIMER OF WARRANTY
+*
+* THIS SOFTWARE IS PROVIDED "AS IS" WITHOUT WARRANTY OF ANY KIND. ANY EXPRESS
+* OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+* OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE, AND NON-INFRINGEMENT
+* ARE EXPRESSLY DISCLAIMED.
+*
+* IN NO EVENT SHALL VERIDIAN CORPORATION, ITS AFFILIATED COMPANIES, OR THE
+* U.S. GOVERNMENT OR ANY OF ITS AGENCIES BE LIABLE FOR ANY DIRECT OR INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+* OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+* LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+* EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* This license will be governed by the laws of the Commonwealth of Virginia,
+* without reference to its choice of law rules.
+*/
+
+
+
+#include <string>
+#include <stddef.h>
+
+
+#define JOB_IMAGE_MAGIC    0x494a4254 /* "TBJI" */
+#define JOB_IMAGE_VERSION  1
+
+#define JOB_IMAGE_FIELD    1 /* a fixed job field, named by its xml tag */
+#define JOB_IMAGE_ATTR     2 /* a job attribute, or one resource of a resource list */
+
+/*
+ * A job image is this header followed by jh_count entries.  Each entry is
+ * a job_image_entry followed by the name, resource and value as
+ * nul-terminated strings, padded so the next entry is JOB_IMAGE_ALIGN
+ * aligned.  The strings can be used in place once the file is mapped.
+ *
+ * Images are written in the host's byte order; use convertjob to move
+ * jobs to a different architecture through xml.
+ */
+
+#define JOB_IMAGE_ALIGN    4
+
+typedef struct job_image_header
+  {
+  unsigned int jh_magic;
+  unsigned int jh_version;
+  unsigned int jh_count;   /* number of entries */
+  unsigned int jh_length;  /* bytes of entries following the header */
+  } job_image_header;
+
+typedef struct job_image_entry
+  {
+  unsigned short je_type;
+  unsigned short je_name_len;  /* string lengths exclude the nul */
+  unsigned short je_resc_len;
+  unsigned short je_unused;
+  unsigned int   je_value_len;
+  unsigned int   je_flags;
+  } job_image_entry;
+
+/* a job image mapped for reading */
+typedef struct job_image_map
+  {
+  char         *jm_base;
+  size_t        jm_size;
+  size_t        jm_offset;  /* of the next entry */
+  unsigned int  jm_remaining;
+  } job_image_map;
+
+/* one entry of a mapped image, the strings point into the map */
+typedef struct job_image_item
+  {
+  int           it_type;
+  char         *it_name;
+  char         *it_resc;   /* empty unless a resource list entry */
+  char         *it_value;
+  unsigned int  it_flags;
+  } job_image_item;
+
+
+
+void job_image_begin(std::string &image);
+void job_image_add(std::string &image, int type, const char *name, const char *resc, const char *value, unsigned int flags);
+int  job_image_write(std::string &image, const char *path);
+int  job_image_open(const char *path, job_image_map *map);
+int  job_image_next(job_image_map *map, job_image_item *item);
+void job_image_close(job_image_map *map);
+int  job_image_from_xml(const char *xml_path, const char *image_path);
+int  job_image_to_xml(const char *image_path, const char *xml_path);
+
+
+#endif /* JOB_IMAGE_H */
@@ -34,6 +34,7 @@
 #define STDERR_TAG    "socket_stderr"
 #define TASKID_TAG    "taskid"
 #define NODEID_TAG    "nodeid"
+#define JRNL_SEQ_TAG  "journal_seq"
 #define AL_FLAGS_ATTR "flags"
 
 #endif // JOB_RECOV_H
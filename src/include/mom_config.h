@@ -89,6 +89,7 @@
 #define MAX_UPDATES_BEFORE_SENDING  20
 #define DEFAULT_JOB_EXIT_WAIT_TIME  600
 #define DEFAULT_SERVER_STAT_UPDATES 45
+#define DEFAULT_STATUS_REFRESH_COUNT 10
 #define CHECK_POLL_TIME             45
 #define MAX_JOIN_WAIT_TIME          600
 #define RESEND_WAIT_TIME            300
@@ -115,6 +116,8 @@ extern char            *auto_ideal_load;
 extern char            *auto_max_load;
 extern int              exec_with_exec;
 extern int              ServerStatUpdateInterval;
+extern int              status_refresh_count;
+extern int              use_cgroup_accounting;
 extern char            *AllocParCmd;
 extern char             PBSNodeCheckPath[];
 extern int              PBSNodeCheckProlog;
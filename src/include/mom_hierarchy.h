@@ -85,6 +85,7 @@
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <vector>
+#include <string>
 #include <netdb.h>
 #include "tcp.h" /* tcp_chan */
 
@@ -95,6 +96,19 @@
 #define NODE_COMM_RETRY_TIME    90
 #define UNREAD_STATUS           -505
 
+/* starts a string holding the packed statuses of a mom's subtree */
+#define STATUS_FRAME_KEYWORD    "status_frame="
+
+/* pbs_server advertises the frame version it reads after the mom hierarchy;
+ * moms only send frames once a server has advertised them */
+#define STATUS_FRAME_VERSION            1
+#define STATUS_FRAME_VERSION_KEYWORD    "status_frame_version="
+
+/* and after that the version of the status deltas it merges; moms send
+ * full statuses to a server that hasn't advertised deltas */
+#define STATUS_DELTAS_VERSION           1
+#define STATUS_DELTAS_KEYWORD           "status_deltas_version="
+
 #define IS_VALID_STREAM(x) (x >= 0)
 
 
@@ -134,5 +148,9 @@ void free_mom_hierarchy(mom_hierarchy_t *);
 int handle_level(char *level_iter, int path_index, int &level_index);
 int handle_path(char *path_iter, int &path_index);
 void parse_mom_hierarchy(int fds);
+void pack_status_frame(std::vector<std::string> &strings, std::string &frame);
+void unpack_status_frame(const char *frame, std::vector<std::string> &strings);
+int  parse_status_frame_version(const char *str);
+int  parse_status_deltas_version(const char *str);
 
 #endif /* ifndef MOM_HIERARCHY_H */
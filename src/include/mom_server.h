@@ -102,6 +102,9 @@ typedef struct mom_server
   int                received_hello_count;
   int                received_cluster_address_count;
   char               MOMSendStatFailure[MMAX_LINE];
+  long               MOMLastStatusLatency;           /* milliseconds to send the last status update */
+  long               MOMStatusLatencyTotal;
+  long               MOMStatusUpdateCount;
   } mom_server;
 
 extern mom_server    mom_servers[];
@@ -77,8 +77,30 @@
 * without reference to its choice of law rules.
 */
 
+#ifndef _MOM_UPDATE_H
+#define _MOM_UPDATE_H
+
 #include <string>
 #include <vector>
+#include <sys/time.h>
+
+/* one node's part of a status update, waiting to be applied. See queue_status_info() */
+typedef struct queued_status
+  {
+  std::string              sender;   /* the mom the update came from */
+  std::vector<std::string> strings;  /* starts with node=<name> */
+  struct timeval           received; /* when the oldest update folded into it arrived */
+  } queued_status;
 
 
 int process_status_info(char *nd_name, std::vector<std::string> &status_info);
+
+bool fold_node_status(queued_status &queued, queued_status &newer);
+
+int queue_status_info(char *sender, std::vector<std::string> &status_info);
+
+void *apply_queued_statuses(void *vp);
+
+void get_status_queue_stats(long *depth, long *lag);
+
+#endif /* _MOM_UPDATE_H */
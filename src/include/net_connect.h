@@ -191,6 +191,14 @@ enum conn_type
   Idle
   };
 
+/* how wait_request() waits for sockets with data to read */
+
+enum wait_request_type
+  {
+  WAIT_REQUEST_SELECT = 0,
+  WAIT_REQUEST_EPOLL
+  };
+
 /* functions available in libnet.a */
 
 #ifdef __cplusplus
@@ -211,6 +219,8 @@ unsigned int  get_svrport(char *, char *, unsigned int);
 int  init_network(unsigned int, void *(*readfunc)(void *));
 void net_close(int);
 int  wait_request(time_t waittime, long *);
+int  set_wait_request_mechanism(enum wait_request_type);
+enum wait_request_type get_wait_request_mechanism(void);
 void net_add_close_func(int, void(*func)(int));
 int get_max_num_descriptors(void);
 int get_fdset_size(void);
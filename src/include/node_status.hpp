@@ -0,0 +1,154 @@
+#ifndef NODE_STATUS_HPP
+#define NODE_STATUS_HPP
+/*
+*         OpenPBS (Portable Batch System) v2.3 Software License
+*
+* Copyright (c) 1999-2000 Veridian Information Solutions, Inc.
+* All rights reserved.
+*
+* ---------------------------------------------------------------------------
+* For a license to use or redistribute the OpenPBS software under conditions
+* other than those described below, or to purchase support for this software,
+* please contact Veridian Systems, PBS Products Department ("Licensor") at:
+*
+*    www.OpenPBS.org  +1 650 967-4675                  sales@OpenPBS.org
+*                        877 902-4PBS (US toll-free)
+* ---------------------------------------------------------------------------
+*
+* This license covers use of the OpenPBS v2.3 software (the "Software") at
+* your site or location, and, for certain users, redistribution of the
+* Software to other sites and locations.  Use and redistribution of
+* OpenPBS v2.3 in source and binary forms, with or without modification,
+* are permitted provided that all of the following conditions are met.
+* After December 31, 2001, only conditions 3-6 must be met:
+*
+* 1. Commercial and/or non-commercial use of the Software is permitted
+*    provided a current software registration is on file at www.OpenPBS.org.
+*    If use of this software contributes to a publication, product, or
+*    service, proper attribution must be given; see www.OpenPBS.org/credit.html
+*
+* 2. Redistribution in any form is only permitted for non-commercial,
+*    non-profit purposes.  There can be no charge for the Software or any
+*    software incorporating the Software.  Further, there can be no
+*    expectation of revenue generated as a consequence of redistributing
+*    the Software.
+*
+* 3. Any Redistribution of source code must retain the above copyright notice
+*    and the acknowledgment contained in paragraph 6, this list of conditions
+*    and the disclaimer contained in paragraph 7.
+*
+* 4. Any Redistribution in binary form must reproduce the above copyright
+*    notice and the acknowledgment contained in paragraph 6, this list of
+*    conditions and the disclaimer contained in paragraph 7 in the
+*    documentation and/or other materials provided with the distribution.
+*
+* 5. Redistributions in any form must be accompanied by information on how to
+*    obtain complete source code for the OpenPBS software and any
+*    modifications and/or additions to the OpenPBS software.  The source code
+*    must either be included in the distribution or be available for no more
+*    than the cost of distribution plus a nominal fee, and all modifications
+*    and additions to the Software must be freely redistributable by any party
+*    (including Licensor) without restriction.
+*
+* 6. All advertising materials mentioning features or use of the Software must
+*    display the following acknowledgment:
+*
+*     "This product includes software developed by NASA Ames Research Center,
+*     Lawrence Livermore National Laboratory, and Veridian Information
+*     Solutions, Inc.
+*     Visit www.OpenPBS.org for OpenPBS software support,
+*     products, and information."
+*
+* 7. DISCLAIMER OF WARRANTY
+*
+* THIS SOFTWARE IS PROVIDED "AS IS" WITHOUT WARRANTY OF ANY KIND. ANY EXPRESS
+* OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+* OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE, AND NON-INFRINGEMENT
+* ARE EXPRESSLY DISCLAIMED.
+*
+* IN NO EVENT SHALL VERIDIAN CORPORATION, ITS AFFILIATED COMPANIES, OR THE
+* U.S. GOVERNMENT OR ANY OF ITS AGENCIES BE LIABLE FOR ANY DIRECT OR INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+* OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+* LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+* EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* This license will be governed by the laws of the Commonwealth of Virginia,
+* without reference to its choice of law rules.
+*/
+
+#include <string>
+#include <vector>
+#include <map>
+#include "attribute.h" /* pbs_attribute */
+
+/*
+ * A piece of a status string received from a mom. It points into that
+ * string instead of copying it, so it isn't NUL terminated.
+ */
+
+class status_view
+  {
+  public:
+    const char *ptr;
+    size_t      len;
+
+    status_view() : ptr(NULL), len(0) {}
+    status_view(const char *p, size_t l) : ptr(p), len(l) {}
+
+    bool        is_set() const { return(ptr != NULL); }
+    bool        starts_with(const char *prefix) const;
+    bool        operator <(const status_view &other) const;
+    std::string to_string() const;
+  };
+
+enum status_key
+  {
+  STATUS_OTHER,
+  STATUS_STATE,
+  STATUS_NCPUS,
+  STATUS_JOBS,
+  STATUS_JOBDATA,
+  STATUS_MESSAGE,
+  STATUS_MACADDR,
+  STATUS_UNAME,
+  STATUS_FIRST_UPDATE,
+  STATUS_DELTA,
+  STATUS_REMOVED
+  };
+
+/*
+ * The status of one node, filled in by a single pass over the strings its
+ * mom sent. The keys the server acts on get typed fields, every other key
+ * is kept in others. Nothing is copied until encode() builds the node's
+ * status attribute, so the strings passed to add() must outlive this.
+ */
+
+class node_status
+  {
+  public:
+    int                                 state;        /* INUSE_* reported, -1 if none */
+    long                                ncpus;        /* -1 if none */
+    bool                                first_update;
+    bool                                delta;
+    status_view                         state_str;
+    status_view                         jobs;
+    status_view                         jobdata;
+    status_view                         message;
+    status_view                         macaddr;
+    status_view                         uname;
+    status_view                         removed;      /* keys a delta dropped */
+    std::map<status_view, status_view>  others;
+    std::vector<status_view>            entries;      /* the strings to store, as received */
+
+    node_status();
+    void       clear();
+    status_key add(const char *str, size_t len);
+    int        encode(pbs_attribute *pattr, const std::vector<const char *> &kept) const;
+  };
+
+status_view status_entry_key(const status_view &entry);
+
+#endif /* NODE_STATUS_HPP */
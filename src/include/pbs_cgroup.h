@@ -0,0 +1,37 @@
+#ifndef PBS_CGROUP_H
+#define PBS_CGROUP_H 1
+
+#include <sys/types.h>
+#include <vector>
+
+#define CGROUP_ROOT   "/sys/fs/cgroup"
+#define TORQUE_CGROUP "torque"
+
+/* the cgroup interface the job cgroups were set up with */
+#define CGROUP_NONE   0
+#define CGROUP_V1     1
+#define CGROUP_V2     2
+
+/* how long delete_job_cgroup() waits for killed processes to leave */
+#define CGROUP_RMDIR_TRIES  20
+#define CGROUP_RMDIR_WAIT   50000 /* microseconds */
+
+/* a job's usage, as accounted by its cgroup */
+typedef struct cgroup_usage
+  {
+  unsigned long long cput_usec; /* cpu time of its processes, including the ones that exited */
+  unsigned long long mem;       /* memory charged to it now, less page cache, in bytes */
+  int                nprocs;    /* processes in it now */
+  } cgroup_usage;
+
+extern int  cgroup_version;
+
+extern int  init_job_cgroups(const char *root);
+extern bool job_cgroups_active(void);
+extern int  create_job_cgroup(const char *jobid);
+extern int  move_to_job_cgroup(pid_t pid, const char *jobid);
+extern int  delete_job_cgroup(const char *jobid);
+extern int  get_job_cgroup_pids(const char *jobid, std::vector<pid_t> &pids);
+extern int  read_job_cgroup_usage(const char *jobid, cgroup_usage &usage, std::vector<pid_t> &pids);
+
+#endif /* END PBS_CGROUP_H */
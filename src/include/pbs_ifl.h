@@ -333,6 +333,12 @@
 #define ATTR_jobsynctimeout           "job_sync_timeout"
 #define ATTR_pass_cpu_clock           "pass_cpu_clock"
 #define ATTR_job_full_report_time     "job_full_report_time"
+#define ATTR_commit_interval          "commit_interval"
+#define ATTR_commit_batch_size        "commit_batch_size"
+#define ATTR_binary_job_images        "binary_job_images"
+#define ATTR_virtual_array_subjobs    "virtual_array_subjobs"
+#define ATTR_status_queue_depth       "node_status_queue_depth"
+#define ATTR_status_queue_lag         "node_status_queue_lag"
 /* additional node "attributes" names */
 
 #define ATTR_NODE_state            "state"
@@ -462,6 +462,7 @@ typedef std::set<pid_t> job_pid_set_t;
 #define MOM_NO_PROC                   0x00000008 /* no procs found for job */
 #define MOM_HAS_TMPDIR                0x00000010 /* Mom made a tmpdir */
 #define MOM_EPILOGUE_RUN 64 /* The epilogue has been run for this job */ 
+#define MOM_EPILOGUE_DONE             0x00000080 /* The epilogue subtask has finished */
 
 #ifdef USESAVEDRESOURCES
 #define MOM_JOB_RECOVERY              0x000000020  /* recovering dead job on restart */
@@ -680,6 +681,9 @@ struct job
   char              ji_being_recycled;
   time_t            ji_last_reported_time;
   time_t            ji_mod_time;       // the timestamp of when the state last changed
+  unsigned long     ji_journal_seq;    /* last journal record written or replayed */
+  unsigned int     *ji_journal_sums;   /* crc of each attribute as last persisted */
+  unsigned long     ji_commit_ticket;  /* group commit ticket of the last save */
 #endif/* PBS_MOM */   /* END SERVER ONLY */
   int               ji_commit_done;   /* req_commit has completed. If in routing queue job can now be routed */
 
@@ -713,8 +717,10 @@ struct job
 
 typedef struct job job;
 
-/* on the server this array will replace many of the doubly linked-lists */
-typedef container::item_container<job *> all_jobs;
+/* on the server this array will replace many of the doubly linked-lists.
+ * Job lookups by id go through a sharded index and don't take the container
+ * lock; see sharded_container in container.hpp */
+typedef container::sharded_container<job *> all_jobs;
 typedef container::item_container<job *>::item_iterator all_jobs_iterator;
 
 #ifndef PBS_MOM
@@ -976,6 +982,7 @@ typedef struct send_job_request
 
 #define JOB_FILE_COPY           ".JC"    /* tmp copy while updating */
 #define JOB_FILE_SUFFIX         ".JB"    /* job control file */
+#define JOB_FILE_JOURNAL        ".JL"    /* job attribute change journal */
 #define JOB_FILE_BACKUP         ".BK"    /* job file backup */
 #define JOB_SCRIPT_SUFFIX       ".SC"    /* job script file  */
 #define JOB_STDOUT_SUFFIX       ".OU"    /* job standard out */
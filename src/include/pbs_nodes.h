@@ -97,6 +97,8 @@
 #include <string>
 #include "container.hpp"
 #include "job_usage_info.hpp"
+#include "prop_index.hpp"
+#include "capacity_index.hpp"
 
 #ifdef NUMA_SUPPORT
 /* NOTE: cpuset support needs hwloc */
@@ -108,6 +110,8 @@
 #define END_GPU_STATUS         "</gpu_status>"
 #define START_MIC_STATUS       "<mic_status>"
 #define END_MIC_STATUS         "</mic_status>"
+#define STATUS_DELTA_KEYWORD   "status_delta=true"
+#define STATUS_REMOVED_KEYWORD "status_removed="
 
 #ifdef NUMA_SUPPORT
 #  define MAX_NODE_BOARDS      2048
@@ -183,6 +187,8 @@ typedef struct single_spec_data
   int          mic;   /* mics for this req */
   int          req_id;  /* the id of this alps req - used only for cray */
   struct prop *prop;    /* node properties needed */
+  prop_bitset *prop_bits; /* prop as interned ids, NULL if no properties */
+  bool         prop_unknown; /* some property in prop is on no node */
   } single_spec_data;
 
 typedef struct complete_spec_data
@@ -265,6 +271,7 @@ typedef struct nodeboard_t
 
 
 #define SEND_HELLO 11
+#define NEED_FULL_STATUS -506 /* status delta arrived with nothing to apply it to */
 
 /* container for holding communication information */
 typedef struct received_node
@@ -297,6 +304,7 @@ struct pbsnode
   unsigned short                nd_mom_rm_port;   /* For multi-mom-mode unique port value PBS_MANAGER_SERVICE_PORT */
   struct sockaddr_in            nd_sock_addr;        /* address information */
   short                         nd_nprops;           /* number of properties */
+  prop_bitset                   nd_prop_bits;        /* nd_first as interned property ids */
   short                         nd_nstatus;          /* number of status items */
   execution_slot_tracker        nd_slots;            /* bitmap of execution slots */
   std::vector<job_usage_info >  nd_job_usages;       /* information about each job using this node */
@@ -623,6 +631,8 @@ void             reinitialize_node_iterator(node_iterator *);
 #endif /* BATCH_REQUEST_H */
 
 struct prop     *init_prop(char *pname);
+void             update_prop_bits(struct pbsnode *pnode);
+void             update_node_capacity(struct pbsnode *pnode);
 int              initialize_pbsnode(struct pbsnode *, char *pname, u_long *pul, int ntype, bool isNUMANode);
 int              hasprop(struct pbsnode *pnode, struct prop *props);
 void             update_node_state(struct pbsnode *np, int newstate);
@@ -0,0 +1,148 @@
+#ifndef PROC_SAMPLER_HPP
+#define PROC_SAMPLER_HPP
+/*
+*         OpenPBS (Portable Batch System) v2.3 Software License
+*
+* Copyright (c) 1999-2000 Veridian Information Solutions, Inc.
+* All rights reserved.
+*
+* ---------------------------------------------------------------------------
+* For a license to use or redistribute the OpenPBS software under conditions
+* other than those described below, or to purchase support for this software,
+* please contact Veridian Systems, PBS Products Department ("Licensor") at:
+*
+*    www.OpenPBS.org  +1 650 967-4675                  sales@OpenPBS.org
+*                        877 902-4PBS (US toll-free)
+* ---------------------------------------------------------------------------
+*
+* This license covers use of the OpenPBS v2.3 software (the "Software") at
+* your site or location, and, for certain users, redistribution of the
+* Software to other sites and locations.  Use and redistribution of
+* OpenPBS v2.3 in source and binary forms, with or without modification,
+* are permitted provided that all of the following conditions are met.
+* After December 31, 2001, only conditions 3-6 must be met:
+*
+* 1. Commercial and/or non-commercial use of the Software is permitted
+*    provided a current software registration is on file at www.OpenPBS.org.
+*    If use of this software contributes to a publication, product, or
+*    service, proper attribution must be given; see www.OpenPBS.org/credit.html
+*
+* 2. Redistribution in any form is only permitted for non-commercial,
+*    non-profit purposes.  There can be no charge for the Software or any
+*    software incorporating the Software.  Further, there can be no
+*    expectation of revenue generated as a consequence of redistributing
+*    the Software.
+*
+* 3. Any Redistribution of source code must retain the above copyright notice
+*    and the acknowledgment contained in paragraph 6, this list of conditions
+*    and the disclaimer contained in paragraph 7.
+*
+* 4. Any Redistribution in binary form must reproduce the above copyright
+*    notice and the acknowledgment contained in paragraph 6, this list of
+*    conditions and the disclaimer contained in paragraph 7 in the
+*    documentation and/or other materials provided with the distribution.
+*
+* 5. Redistributions in any form must be accompanied by information on how to
+*    obtain complete source code for the OpenPBS software and any
+*    modifications and/or additions to the OpenPBS software.  The source code
+*    must either be included in the distribution or be available for no more
+*    than the cost of distribution plus a nominal fee, and all modifications
+*    and additions to the Software must be freely redistributable by any party
+*    (including Licensor) without restriction.
+*
+* 6. All advertising materials mentioning features or use of the Software must
+*    display the following acknowledgment:
+*
+*     "This product includes software developed by NASA Ames Research Center,
+*     Lawrence Livermore National Laboratory, and Veridian Information
+*     Solutions, Inc.
+*     Visit www.OpenPBS.org for OpenPBS software support,
+*     products, and information."
+*
+* 7. DISCLAIMER OF WARRANTY
+*
+* THIS SOFTWARE IS PROVIDED "AS IS" WITHOUT WARRANTY OF ANY KIND. ANY EXPRESS
+* OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+* OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE, AND NON-INFRINGEMENT
+* ARE EXPRESSLY DISCLAIMED.
+*
+* IN NO EVENT SHALL VERIDIAN CORPORATION, ITS AFFILIATED COMPANIES, OR THE
+* U.S. GOVERNMENT OR ANY OF ITS AGENCIES BE LIABLE FOR ANY DIRECT OR INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+* OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+* LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+* EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* This license will be governed by the laws of the Commonwealth of Virginia,
+* without reference to its choice of law rules.
+*/
+
+#include <sys/types.h>
+#include <dirent.h>
+#include <string>
+#include <vector>
+#include <map>
+#include "pbs_job.h" /* job_pid_set_t, pid2jobsid_map_t */
+#include "mom_mach.h" /* proc_stat_t */
+
+#define PROC_NAME_SIZE             64   /* the comm of a process is at most 16 */
+#define PROC_REFRESH_POLLS         10   /* every process is read again this often */
+#define PROC_SAMPLE_MIN_PER_THREAD 1024 /* fewer reads than this aren't worth a thread */
+#define MAX_PROC_SAMPLE_THREADS    8
+
+/*
+ * A process as it was last read from /proc/<pid>/stat. ps.name points at
+ * name, so the entry must not move while ps is in use.
+ */
+
+typedef struct sampled_proc
+  {
+  proc_stat_t  ps;
+  char         name[PROC_NAME_SIZE];
+  unsigned int seen;       /* the poll it was last listed in */
+  ino_t        ino;        /* inode of its stat file when it was read */
+  bool         valid;      /* ps holds what was read */
+  bool         in_job;     /* it belonged to a job in the last poll */
+  int          read_errno; /* why it couldn't be read, 0 if it could */
+  } sampled_proc;
+
+/*
+ * Samples processes from /proc across polls. The table of processes is kept
+ * between polls so that a process that was seen in the previous poll and
+ * doesn't belong to a job isn't read again, only stat()ed: a reused pid
+ * gets a new /proc inode and a changed uid shows in the owner, either of
+ * which has it read again. Every PROC_REFRESH_POLLS'th poll reads them all.
+ * The stat files are opened relative to a /proc descriptor that stays open,
+ * and large samples are read by several threads.
+ */
+
+class proc_sampler
+  {
+  std::string                   proc_root;
+  int                           proc_fd;
+  DIR                          *proc_dir;
+  unsigned int                  polls;
+  int                           stats_read;
+  std::map<pid_t, sampled_proc> procs;
+
+  int  read_proc(sampled_proc &sp, pid_t pid);
+  bool is_same_proc(const sampled_proc &sp, pid_t pid);
+  void read_procs(std::vector<std::pair<pid_t, sampled_proc *> > &to_read, int threads);
+
+  friend void *read_proc_chunk(void *);
+
+  public:
+    proc_sampler(const char *root);
+    ~proc_sampler();
+
+    int  list_pids(std::vector<pid_t> &pids);
+    int  sample(const std::vector<pid_t> &pids, const job_pid_set_t &job_sids,
+                int threads, std::vector<proc_stat_t *> &sampled);
+    void mark_job_procs(const pid2jobsid_map_t &job_procs);
+    int  get_stats_read() const;
+    int  size() const;
+  };
+
+#endif /* PROC_SAMPLER_HPP */
@@ -184,5 +184,9 @@ ATTR_nppcu,
 ATTR_jobsynctimeout,
 ATTR_pass_cpu_clock,
 ATTR_job_full_report_time,
+ATTR_commit_interval,
+ATTR_commit_batch_size,
+ATTR_binary_job_images,
+ATTR_virtual_array_subjobs,
 ATTR_copy_on_rerun,
 ATTR_job_exclusive_on_use,
@@ -206,6 +206,12 @@ enum srv_atr
   SRV_ATR_job_sync_timeout,
   SRV_ATR_pass_cpu_clock,
   SRV_ATR_job_full_report_time,
+  SRV_ATR_CommitInterval,
+  SRV_ATR_CommitBatchSize,
+  SRV_ATR_BinaryJobImages,
+  SRV_ATR_VirtualArraySubjobs,
+  SRV_ATR_StatusQueueDepth,
+  SRV_ATR_StatusQueueLag,
 
 #include "site_svr_attr_enum.h"
   
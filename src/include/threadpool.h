@@ -91,6 +91,9 @@
 
 #define POOL_DESTROY 0x1
 
+/* number of preallocated work slots per pool, must be a power of two */
+#define TP_RING_SIZE 4096
+
 
 
 typedef struct tp_work tp_work_t;
@@ -104,6 +107,19 @@ struct tp_work
 
 
 
+/* a slot in the bounded lock-free work queue. seq tells producers and
+ * consumers whose turn it is to use the slot */
+typedef struct tp_slot tp_slot_t;
+struct tp_slot
+  {
+  volatile unsigned long  seq;
+  void                 *(*work_func)(void *);
+  void                   *work_arg;
+  };
+
+
+
+
 typedef struct tp_working tp_working_t;
 struct tp_working
   {
@@ -121,13 +137,19 @@ struct threadpool
   pthread_cond_t   tp_waiting_work; /* what waiting threads pend on */
   pthread_cond_t   tp_can_destroy; /* thread pool is ready to be deleted */
   tp_working_t    *tp_active;  /* list of currently working threads */
-  tp_work_t       *tp_first; /* first in queue */
-  tp_work_t       *tp_last;  /* last in queue */
+  tp_work_t       *tp_first; /* first in overflow queue, used when tp_ring is full */
+  tp_work_t       *tp_last;  /* last in overflow queue */
+  tp_slot_t       *tp_ring;  /* preallocated work slots, enqueued without tp_mutex */
+  volatile unsigned long tp_enqueue_pos; /* next slot producers claim */
+  char             tp_pad[64]; /* keep producers and consumers off the same cache line */
+  volatile unsigned long tp_dequeue_pos; /* next slot consumers claim */
+  volatile int     tp_overflow; /* number of items in the overflow queue */
+  volatile int     tp_sleeping; /* number of threads blocked on tp_waiting_work */
   pthread_attr_t   tp_attr; /* attributes for workers */
   int              tp_nthreads; /* number of threads */
   int              tp_min_threads; /* minimum number of threads */
   int              tp_max_threads; /* maximum number of threads */
-  int              tp_idle_threads; /* number of currently idle threads */
+  volatile int     tp_idle_threads; /* number of currently idle threads */
   int              tp_max_idle_secs; /* number of seconds before a thread terminates */
   int              tp_flags; /* pool state flags */
   unsigned char    tp_started; /* once this is TRUE begin processing */
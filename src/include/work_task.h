@@ -99,6 +99,7 @@
 #include <list>
 #include <vector>
 #include <stdlib.h>
+#include <time.h>
 
 #define INITIAL_ALL_TASKS_SIZE 4
 
@@ -129,10 +130,40 @@ int task_is_in_threadpool(struct work_task *ptask);
 
 typedef struct timed_task
   {
-  work_task *wt;
-  long       task_time;
+  work_task     *wt;
+  long           task_time;
+  unsigned long  seq; /* insertion order, breaks ties between equal task_times */
   } timed_task;
 
+
+
+/*
+ * timed_task_heap - binary min-heap of WORK_Timed tasks ordered by task_time
+ *
+ * Each queued task records its heap position in wt_timed_index so it can be
+ * removed in O(log n) when the task is deleted before it fires.
+ * The heap is not thread safe, callers hold task_list_timed_mutex.
+ */
+
+class timed_task_heap
+  {
+  std::vector<timed_task> heap;
+  unsigned long           next_seq;
+
+  bool earlier(size_t a, size_t b) const;
+  void swap_entries(size_t a, size_t b);
+  void sift_up(size_t i);
+  void sift_down(size_t i);
+
+public:
+  timed_task_heap() : next_seq(0) {}
+
+  void             push(work_task *wt);
+  bool             remove(work_task *wt);
+  work_task       *pop_expired(time_t time_now);
+  size_t           size() const;
+  };
+
 class all_tasks
   {
 public:
@@ -165,14 +196,22 @@ typedef struct work_task
   void (*wt_parmfunc)  (struct work_task *);
   /* used in reissue_to_svr to store wt_func */
   int                  wt_aux; /* optional info: e.g. child status */
+  size_t               wt_timed_index; /* position + 1 in the timed task heap, 0 if not queued */
   } work_task;
 
+/* wt_timed_index of a task popped by pop_expired_timed_tasks() that
+ * check_tasks() hasn't claimed yet, and of one deleted in the meantime */
+#define TIMED_TASK_DISPATCHING ((size_t)-1)
+#define TIMED_TASK_CANCELLED   ((size_t)-2)
+
 int        insert_task(all_tasks *, work_task *);
 int        remove_task(all_tasks *,work_task *);
 int        has_task(all_tasks *);
 int        dispatch_timed_task(work_task *);
 work_task *pop_timed_task(time_t time_now);
-int        insert_timed_task(all_tasks *, time_t task_time, work_task *);
+int        pop_expired_timed_tasks(time_t time_now, std::vector<work_task *> &expired);
+bool       claim_timed_task(work_task *);
+void       insert_timed_task(work_task *);
 
 
 
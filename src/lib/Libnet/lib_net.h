@@ -83,8 +83,10 @@ int check_trqauthd_unix_domain_port(const char *);
 int ping_trqauthd(const char *);
 int thread_func(int active_sockets, fd_set *select_set);
 int wait_request(time_t waittime, long *SState);
+int set_wait_request_mechanism(enum wait_request_type type);
+enum wait_request_type get_wait_request_mechanism(void);
 /* static void accept_conn(void *new_conn); */
-void globalset_add_sock(int sock);
+void globalset_add_sock(int sock, u_long addr, u_long port);
 void globalset_del_sock(int sock);
 int add_conn(int, enum conn_type, pbs_net_t, unsigned int, unsigned int, void *(*func)(void *));
 int add_scheduler_conn(int, enum conn_type, pbs_net_t, unsigned int, unsigned int, void *(*func)(void *));
@@ -105,6 +105,9 @@
 #if defined(FD_SET_IN_SYS_SELECT_H)
 #include <sys/select.h>
 #endif
+#ifdef HAVE_SYS_EPOLL_H
+#include <sys/epoll.h>
+#endif
 #if defined(NTOHL_NEEDS_ARPA_INET_H) && defined(HAVE_ARPA_INET_H)
 #include <arpa/inet.h>
 #endif
@@ -158,6 +161,18 @@ static u_long   *GlobalSocketAddrSet = NULL;
 static u_long   *GlobalSocketPortSet = NULL;
 pthread_mutex_t *global_sock_read_mutex = NULL;
 
+/* mechanism used by wait_request() to find sockets with data to read */
+static enum wait_request_type wait_mechanism = WAIT_REQUEST_SELECT;
+static time_t    last_idle_check = 0;
+
+#ifdef HAVE_SYS_EPOLL_H
+#define MAX_EPOLL_EVENTS 512
+
+/* mirrors GlobalSocketReadSet when epoll is in use, guarded by global_sock_read_mutex */
+static int       epoll_fd = -1;
+static int       epoll_atfork_registered = FALSE;
+#endif
+
 void *(*read_func[2])(void *);
 
 pthread_mutex_t *nc_list_mutex  = NULL;
@@ -645,22 +660,197 @@ int check_network_port(
 
 
 
+#ifdef HAVE_SYS_EPOLL_H
 /*
- * wait_request - wait for a request (socket with data to read)
- * This routine does a select on the readset of sockets,
- * when data is ready, the processing routine associated with
- * the socket is invoked.
+ * epoll_watch_sock - add a socket to the epoll set
+ * NOTE: must be called with global_sock_read_mutex held
  */
 
-int wait_request(
+static void epoll_watch_sock(
+
+  int sock)
+
+  {
+  struct epoll_event ev;
+
+  memset(&ev, 0, sizeof(ev));
+  ev.events = EPOLLIN;
+  ev.data.fd = sock;
+
+  if ((epoll_ctl(epoll_fd, EPOLL_CTL_ADD, sock, &ev) != 0) &&
+      (errno == EEXIST))
+    epoll_ctl(epoll_fd, EPOLL_CTL_MOD, sock, &ev);
+  } /* END epoll_watch_sock() */
+
+
+
+/*
+ * epoll_child_after_fork - the epoll set is shared with the parent across fork(),
+ * so a child must never modify it. Drop the child's reference instead.
+ */
+
+static void epoll_child_after_fork(void)
+
+  {
+  if (epoll_fd >= 0)
+    {
+    close(epoll_fd);
+    epoll_fd = -1;
+    }
+  } /* END epoll_child_after_fork() */
+
+
+
+/*
+ * epoll_attach_global_set - create the epoll set and load it with every
+ * socket currently in GlobalSocketReadSet
+ * NOTE: must be called with global_sock_read_mutex held
+ */
+
+static int epoll_attach_global_set(void)
+
+  {
+  int i;
+  int MaxNumDescriptors = get_max_num_descriptors();
+
+  if ((epoll_fd = epoll_create1(EPOLL_CLOEXEC)) < 0)
+    return(-1);
+
+  if (epoll_atfork_registered == FALSE)
+    {
+    pthread_atfork(NULL, NULL, epoll_child_after_fork);
+    epoll_atfork_registered = TRUE;
+    }
+
+  for (i = 0; i < MaxNumDescriptors; i++)
+    {
+    if (FD_ISSET(i, GlobalSocketReadSet))
+      epoll_watch_sock(i);
+    }
+
+  return(PBSE_NONE);
+  } /* END epoll_attach_global_set() */
+#endif /* HAVE_SYS_EPOLL_H */
+
+
+
+/*
+ * set_wait_request_mechanism - choose whether wait_request() uses select()
+ * or epoll to wait for sockets. May be called at any time; the epoll set is
+ * built lazily from the global read set on the next wait_request().
+ */
+
+int set_wait_request_mechanism(
+
+  enum wait_request_type type) /* I */
+
+  {
+#ifndef HAVE_SYS_EPOLL_H
+  if (type == WAIT_REQUEST_EPOLL)
+    return(PBSE_BAD_PARAMETER);
+#endif
+
+  if (global_sock_read_mutex != NULL)
+    pthread_mutex_lock(global_sock_read_mutex);
+
+  wait_mechanism = type;
+
+#ifdef HAVE_SYS_EPOLL_H
+  if ((type == WAIT_REQUEST_SELECT) &&
+      (epoll_fd >= 0))
+    {
+    close(epoll_fd);
+    epoll_fd = -1;
+    }
+#endif
+
+  if (global_sock_read_mutex != NULL)
+    pthread_mutex_unlock(global_sock_read_mutex);
+
+  return(PBSE_NONE);
+  } /* END set_wait_request_mechanism() */
+
+
+
+enum wait_request_type get_wait_request_mechanism(void)
+
+  {
+  return(wait_mechanism);
+  } /* END get_wait_request_mechanism() */
+
+
+
+/*
+ * process_ready_socket - invoke the processing routine for a socket
+ * that has data to read. Sockets whose connection is Idle are dropped
+ * from the global read set and closed.
+ */
+
+static void process_ready_socket(
+
+  int    sock, /* I */
+  u_long addr, /* I */
+  u_long port) /* I */
+
+  {
+  char tmpLine[1024];
+
+  pthread_mutex_lock(svr_conn[sock].cn_mutex);
+
+  svr_conn[sock].cn_lasttime = time(NULL);
+
+  if (svr_conn[sock].cn_active != Idle)
+    {
+    void *(*func)(void *) = svr_conn[sock].cn_func;
+
+    netcounter_incr();
+
+    pthread_mutex_unlock(svr_conn[sock].cn_mutex);
+
+    if (func != NULL)
+      {
+      int args[3];
+
+      args[0] = sock;
+      args[1] = (int)addr;
+      args[2] = (int)port;
+      func((void *)args);
+      }
+    }
+  else
+    {
+    pthread_mutex_unlock(svr_conn[sock].cn_mutex);
+
+    globalset_del_sock(sock);
+    close_conn(sock, FALSE);
+
+    pthread_mutex_lock(num_connections_mutex);
+
+    sprintf(tmpLine, "closed connections to fd %d - num_connections=%d (select bad socket)",
+      sock,
+      num_connections);
+
+    pthread_mutex_unlock(num_connections_mutex);
+    log_err(-1, __func__, tmpLine);
+    }
+  } /* END process_ready_socket() */
+
+
+
+/*
+ * wait_request_select - select() over a copy of the global read set and
+ * process every socket that has data
+ */
+
+static int wait_request_select(
 
   time_t  waittime,   /* I (seconds) */
-  long   *SState)     /* I (optional) */
+  long   *SState,     /* I (optional) */
+  long    OrigState)  /* I */
 
   {
   int             i;
   int             n;
-  time_t          now;
 
   fd_set          *SelectSet = NULL;
   int             SelectSetSize = 0;
@@ -669,13 +859,7 @@ int wait_request(
   u_long   		  *SocketAddrSet = NULL;
   u_long          *SocketPortSet = NULL;
 
-
-  char            tmpLine[1024];
   struct timeval  timeout;
-  long            OrigState = 0;
-
-  if (SState != NULL)
-    OrigState = *SState;
 
   timeout.tv_usec = 0;
   timeout.tv_sec  = waittime;
@@ -754,67 +938,133 @@ int wait_request(
     {
     if (FD_ISSET(i, SelectSet))
       {
-      pthread_mutex_lock(svr_conn[i].cn_mutex);
       /* this socket has data */
       n--;
 
-      svr_conn[i].cn_lasttime = time(NULL);
+      process_ready_socket(i, SocketAddrSet[i], SocketPortSet[i]);
 
-      if (svr_conn[i].cn_active != Idle)
-        {
-        void *(*func)(void *) = svr_conn[i].cn_func;
+      /* NOTE:  breakout if state changed (probably received shutdown request) */
 
-        netcounter_incr();
+      if ((SState != NULL) && 
+          (OrigState != *SState))
+        break;
+      }
+    } /* END for i */
 
-        pthread_mutex_unlock(svr_conn[i].cn_mutex);
+  free(SelectSet);
+  free(SocketAddrSet);
+  free(SocketPortSet);
 
-        if (func != NULL)
-          {
-          int args[3];
+  return(PBSE_NONE);
+  }  /* END wait_request_select() */
 
-          args[0] = i;
-          args[1] = (int)SocketAddrSet[i];
-          args[2] = (int)SocketPortSet[i];
-          func((void *)args);
-          }
 
-        /* NOTE:  breakout if state changed (probably received shutdown request) */
 
-        if ((SState != NULL) && 
-            (OrigState != *SState))
-          break;
-        }
-      else
-        {
-        pthread_mutex_unlock(svr_conn[i].cn_mutex);
+#ifdef HAVE_SYS_EPOLL_H
+/*
+ * wait_request_epoll - wait on the epoll set and process only the sockets
+ * the kernel reports as ready. Unlike select() this does not scan every
+ * descriptor and is not limited by FD_SETSIZE.
+ */
 
-        globalset_del_sock(i);
-        close_conn(i, FALSE);
+static int wait_request_epoll(
 
-        pthread_mutex_lock(num_connections_mutex);
+  time_t  waittime,   /* I (seconds) */
+  long   *SState,     /* I (optional) */
+  long    OrigState)  /* I */
 
-        sprintf(tmpLine, "closed connections to fd %d - num_connections=%d (select bad socket)",
-          i,
-          num_connections);
+  {
+  struct epoll_event events[MAX_EPOLL_EVENTS];
+  int                efd;
+  int                n;
+  int                i;
 
-        pthread_mutex_unlock(num_connections_mutex);
-        log_err(-1, __func__, tmpLine);
-        }
+  pthread_mutex_lock(global_sock_read_mutex);
+
+  if ((epoll_fd < 0) &&
+      (epoll_attach_global_set() != PBSE_NONE))
+    {
+    wait_mechanism = WAIT_REQUEST_SELECT;
+    pthread_mutex_unlock(global_sock_read_mutex);
+
+    log_err(errno, __func__, "Unable to create epoll set, falling back to select()");
+
+    return(wait_request_select(waittime, SState, OrigState));
+    }
+
+  efd = epoll_fd;
+
+  pthread_mutex_unlock(global_sock_read_mutex);
+
+  n = epoll_wait(efd, events, MAX_EPOLL_EVENTS, (int)waittime * 1000);
+
+  if (n == -1)
+    {
+    if (errno == EINTR)
+      return(PBSE_NONE); /* interrupted, cycle around */
+
+    log_err(errno, __func__, "Unable to wait on epoll set to read requests");
+
+    return(-1);
+    }
+
+  for (i = 0; i < n; i++)
+    {
+    int    sock = events[i].data.fd;
+    u_long addr;
+    u_long port;
+
+    if ((sock < 0) ||
+        (sock >= max_connection))
+      continue;
+
+    /* a processing routine earlier in this batch may have closed the socket */
+    pthread_mutex_lock(global_sock_read_mutex);
+
+    if (FD_ISSET(sock, GlobalSocketReadSet) == 0)
+      {
+      pthread_mutex_unlock(global_sock_read_mutex);
+      continue;
       }
-    } /* END for i */
 
-  free(SelectSet);
-  free(SocketAddrSet);
-  free(SocketPortSet);
+    addr = GlobalSocketAddrSet[sock];
+    port = GlobalSocketPortSet[sock];
 
-  /* NOTE:  break out if shutdown request received */
+    pthread_mutex_unlock(global_sock_read_mutex);
 
-  if ((SState != NULL) && (OrigState != *SState))
-    return(0);
+    process_ready_socket(sock, addr, port);
 
-  /* have any connections timed out ?? */
+    /* NOTE:  breakout if state changed (probably received shutdown request) */
+
+    if ((SState != NULL) &&
+        (OrigState != *SState))
+      break;
+    }
+
+  return(PBSE_NONE);
+  }  /* END wait_request_epoll() */
+#endif /* HAVE_SYS_EPOLL_H */
+
+
+
+/*
+ * close_idle_connections - close client connections that have been idle
+ * longer than PBS_NET_MAXCONNECTIDLE. The table is walked at most once per
+ * second rather than on every wakeup.
+ */
 
-  now = time((time_t *)0);
+static void close_idle_connections(
+
+  time_t now) /* I */
+
+  {
+  int  i;
+  char tmpLine[1024];
+
+  if (now == last_idle_check)
+    return;
+
+  last_idle_check = now;
 
   for (i = 0;i < max_connection;i++)
     {
@@ -866,6 +1116,47 @@ int wait_request(
 
     pthread_mutex_unlock(svr_conn[i].cn_mutex);
     }  /* END for (i) */
+  } /* END close_idle_connections() */
+
+
+
+/*
+ * wait_request - wait for a request (socket with data to read)
+ * This routine waits on the readset of sockets using select() or epoll
+ * (see set_wait_request_mechanism()), when data is ready, the processing
+ * routine associated with the socket is invoked.
+ */
+
+int wait_request(
+
+  time_t  waittime,   /* I (seconds) */
+  long   *SState)     /* I (optional) */
+
+  {
+  int             rc;
+  long            OrigState = 0;
+
+  if (SState != NULL)
+    OrigState = *SState;
+
+#ifdef HAVE_SYS_EPOLL_H
+  if (wait_mechanism == WAIT_REQUEST_EPOLL)
+    rc = wait_request_epoll(waittime, SState, OrigState);
+  else
+#endif
+    rc = wait_request_select(waittime, SState, OrigState);
+
+  if (rc != PBSE_NONE)
+    return(rc);
+
+  /* NOTE:  break out if shutdown request received */
+
+  if ((SState != NULL) && (OrigState != *SState))
+    return(0);
+
+  /* have any connections timed out ?? */
+
+  close_idle_connections(time((time_t *)0));
 
   return(PBSE_NONE);
   }  /* END wait_request() */
@@ -965,6 +1256,10 @@ void globalset_add_sock(
   FD_SET(sock, GlobalSocketReadSet);
   GlobalSocketAddrSet[sock] = addr;
   GlobalSocketPortSet[sock] = port;
+#ifdef HAVE_SYS_EPOLL_H
+  if (epoll_fd >= 0)
+    epoll_watch_sock(sock);
+#endif
   pthread_mutex_unlock(global_sock_read_mutex);
   } /* END globalset_add_sock() */
 
@@ -980,6 +1275,10 @@ void globalset_del_sock(
   FD_CLR(sock, GlobalSocketReadSet);
   GlobalSocketAddrSet[sock] = 0;
   GlobalSocketPortSet[sock] = 0;
+#ifdef HAVE_SYS_EPOLL_H
+  if (epoll_fd >= 0)
+    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, sock, NULL);
+#endif
   pthread_mutex_unlock(global_sock_read_mutex);
   } /* END globalset_del_sock() */
 
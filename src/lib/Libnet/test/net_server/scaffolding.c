@@ -3,6 +3,8 @@
 #include <stdio.h>
 #include <netinet/in.h>
 #include <string.h>
+#include <unistd.h>
+#include <sys/select.h>
 
 #include "pbs_error.h"
 #include "net_connect.h"
@@ -121,14 +123,14 @@ char *PAddrToString(pbs_net_t *Addr)
 
 int get_max_num_descriptors(void)
   {
-  fprintf(stderr, "The call to get_max_num_descriptors needs to be mocked!!\n");
-  return(0);
+  return(getdtablesize());
   }
 
 int get_fdset_size(void)
   {
-  fprintf(stderr, "The call to get_fdset_size needs to be mocked!!\n");
-  return(0);
+  int fdsets = (get_max_num_descriptors() + FD_SETSIZE - 1) / FD_SETSIZE;
+
+  return(((fdsets > 0) ? fdsets : 1) * sizeof(fd_set));
   }
 
 void log_err(int errnum, const char *routine, const char *text) {}
@@ -66,6 +66,71 @@ START_TEST(test_add_connection)
   }
 END_TEST
 
+int   ready_sock = -1;
+extern char *net_server_name;
+
+void *read_ready_sock(void *args)
+  {
+  char c;
+
+  ready_sock = ((int *)args)[0];
+  read(ready_sock, &c, 1);
+
+  return(NULL);
+  }
+
+void check_wait_request(enum wait_request_type type)
+  {
+  int sv[2];
+
+  net_server_name = strdup("napali");
+  fail_unless(init_network(0, read_ready_sock) == PBSE_NONE);
+  fail_unless(set_wait_request_mechanism(type) == PBSE_NONE);
+  fail_unless(get_wait_request_mechanism() == type);
+
+  fail_unless(socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == 0);
+  fail_unless(add_conn(sv[0], FromClientDIS, 0, 0, PBS_SOCK_UNIX, read_ready_sock) == PBSE_NONE);
+
+  // nothing to read yet
+  ready_sock = -1;
+  fail_unless(wait_request(0, NULL) == PBSE_NONE);
+  fail_unless(ready_sock == -1);
+
+  fail_unless(write(sv[1], "x", 1) == 1);
+  fail_unless(wait_request(1, NULL) == PBSE_NONE);
+  fail_unless(ready_sock == sv[0]);
+
+  // a socket removed from the global set is no longer dispatched
+  globalset_del_sock(sv[0]);
+  fail_unless(write(sv[1], "x", 1) == 1);
+  ready_sock = -1;
+  fail_unless(wait_request(0, NULL) == PBSE_NONE);
+  fail_unless(ready_sock == -1);
+
+  // and is dispatched again once it is re-added
+  globalset_add_sock(sv[0], 0, 0);
+  fail_unless(wait_request(1, NULL) == PBSE_NONE);
+  fail_unless(ready_sock == sv[0]);
+
+  close(sv[0]);
+  close(sv[1]);
+  }
+
+START_TEST(test_wait_request_select)
+  {
+  check_wait_request(WAIT_REQUEST_SELECT);
+  }
+END_TEST
+
+START_TEST(test_wait_request_epoll)
+  {
+  check_wait_request(WAIT_REQUEST_EPOLL);
+
+  // switching back to select keeps serving the same sockets
+  check_wait_request(WAIT_REQUEST_SELECT);
+  }
+END_TEST
+
 START_TEST(test_ping_trqauthd)
   {
   int rc;
@@ -161,6 +226,11 @@ Suite *net_server_suite(void)
   tcase_add_test(tc_core, test_add_connection);
   suite_add_tcase(s, tc_core);
 
+  tc_core = tcase_create("test_wait_request");
+  tcase_add_test(tc_core, test_wait_request_select);
+  tcase_add_test(tc_core, test_wait_request_epoll);
+  suite_add_tcase(s, tc_core);
+
   tc_core = tcase_create("test_ping_trqauthd");
   tcase_add_test(tc_core, test_ping_trqauthd);
   suite_add_tcase(s, tc_core);
@@ -1,6 +1,7 @@
 #include "license_pbs.h" /* See here for the software license */
 #include "lib_utils.h"
 #include "net_cache.h"
+#include "mom_hierarchy.h"
 #include "test_u_mom_hierarchy.h"
 #include <stdlib.h>
 #include <stdio.h>
@@ -40,6 +41,57 @@ START_TEST(test_two)
   }
 END_TEST
 
+START_TEST(test_status_frame)
+  {
+  std::vector<std::string> strings;
+  std::vector<std::string> unpacked;
+  std::string              frame;
+
+  pack_status_frame(strings, frame);
+  fail_unless(frame == STATUS_FRAME_KEYWORD);
+  unpack_status_frame(frame.c_str() + strlen(STATUS_FRAME_KEYWORD), unpacked);
+  fail_unless(unpacked.size() == 0);
+
+  strings.push_back("node=n001");
+  strings.push_back("message=a\\,b\nc");
+  strings.push_back("");
+  strings.push_back("end\\");
+  strings.push_back("node=n002");
+
+  pack_status_frame(strings, frame);
+  fail_unless(!strncmp(frame.c_str(), STATUS_FRAME_KEYWORD, strlen(STATUS_FRAME_KEYWORD)));
+  fail_unless(strchr(frame.c_str(), '\n') == frame.c_str() + strlen(STATUS_FRAME_KEYWORD) + strlen("node=n001"));
+
+  unpack_status_frame(frame.c_str() + strlen(STATUS_FRAME_KEYWORD), unpacked);
+  fail_unless(unpacked == strings);
+
+  /* a frame cut short gives back the strings that arrived whole */
+  unpacked.clear();
+  frame.erase(frame.size() - 3);
+  unpack_status_frame(frame.c_str() + strlen(STATUS_FRAME_KEYWORD), unpacked);
+  fail_unless(unpacked.size() == 4);
+  fail_unless(unpacked[3] == "end\\");
+  }
+END_TEST
+
+START_TEST(test_parse_status_frame_version)
+  {
+  fail_unless(parse_status_frame_version(NULL) == 0);
+  fail_unless(parse_status_frame_version("</sp>") == 0);
+  fail_unless(parse_status_frame_version("<sp>") == 0);
+  fail_unless(parse_status_frame_version("status_frame_version=1") == 1);
+  fail_unless(parse_status_frame_version("status_frame_version=3") == 3);
+  fail_unless(parse_status_frame_version("status_frame_version=-2") == 0);
+  fail_unless(parse_status_frame_version("status_frame_version=") == 0);
+  fail_unless(parse_status_frame_version("status_deltas_version=1") == 0);
+
+  fail_unless(parse_status_deltas_version(NULL) == 0);
+  fail_unless(parse_status_deltas_version("status_frame_version=1") == 0);
+  fail_unless(parse_status_deltas_version("status_deltas_version=1") == 1);
+  fail_unless(parse_status_deltas_version("status_deltas_version=-1") == 0);
+  }
+END_TEST
+
 Suite *u_mom_hierarchy_suite(void)
   {
   Suite *s = suite_create("u_mom_hierarchy_suite methods");
@@ -51,6 +103,11 @@ Suite *u_mom_hierarchy_suite(void)
   tcase_add_test(tc_core, test_two);
   suite_add_tcase(s, tc_core);
 
+  tc_core = tcase_create("test_status_frame");
+  tcase_add_test(tc_core, test_status_frame);
+  tcase_add_test(tc_core, test_parse_status_frame_version);
+  suite_add_tcase(s, tc_core);
+
   return s;
   }
 
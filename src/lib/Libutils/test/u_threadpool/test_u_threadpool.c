@@ -3,14 +3,95 @@
 #include "test_u_threadpool.h"
 #include <stdlib.h>
 #include <stdio.h>
+#include <unistd.h>
 
 
 #include "pbs_error.h"
+#include "threadpool.h"
+
+volatile int work_done = 0;
+
+void *count_work(void *arg)
+  {
+  __sync_add_and_fetch(&work_done, 1);
+  return(NULL);
+  }
+
+bool wait_for_work_done(int expected)
+  {
+  for (int i = 0; i < 1000; i++)
+    {
+    if (work_done == expected)
+      return(true);
+
+    usleep(10000);
+    }
+
+  return(work_done == expected);
+  }
 
 START_TEST(test_one)
   {
+  threadpool_t *tp = NULL;
+
+  work_done = 0;
+
+  fail_unless(initialize_threadpool(&tp, 5, 20, -1) == PBSE_NONE);
+  fail_unless(tp->tp_ring != NULL);
+  start_request_pool(tp);
+
+  for (int i = 0; i < 1000; i++)
+    fail_unless(enqueue_threadpool_request(count_work, NULL, tp) == PBSE_NONE);
+
+  fail_unless(wait_for_work_done(1000) == true);
+  fail_unless(tp->tp_overflow == 0);
+  fail_unless(tp->tp_enqueue_pos == tp->tp_dequeue_pos);
+  }
+END_TEST
+
+START_TEST(test_overflow)
+  {
+  threadpool_t *tp = NULL;
+  int           queued = TP_RING_SIZE + 100;
+
+  work_done = 0;
+
+  // nothing is processed until the pool is started, so this fills the ring
+  fail_unless(initialize_threadpool(&tp, 2, 2, -1) == PBSE_NONE);
+
+  for (int i = 0; i < queued; i++)
+    fail_unless(enqueue_threadpool_request(count_work, NULL, tp) == PBSE_NONE);
+
+  fail_unless(tp->tp_overflow == 100);
+  fail_unless(tp->tp_first != NULL);
+
+  start_request_pool(tp);
+
+  fail_unless(wait_for_work_done(queued) == true);
+  fail_unless(tp->tp_overflow == 0);
+  fail_unless(tp->tp_first == NULL);
+  }
+END_TEST
+
+START_TEST(test_destroy)
+  {
+  threadpool_t *tp = NULL;
+
+  work_done = 0;
+
+  fail_unless(initialize_threadpool(&tp, 2, 4, -1) == PBSE_NONE);
+  start_request_pool(tp);
+
+  for (int i = 0; i < 100; i++)
+    fail_unless(enqueue_threadpool_request(count_work, NULL, tp) == PBSE_NONE);
+
+  fail_unless(wait_for_work_done(100) == true);
 
+  destroy_request_pool(tp);
+  fail_unless(tp->tp_ring == NULL);
+  fail_unless(tp->tp_nthreads == 0);
 
+  free(tp);
   }
 END_TEST
 
@@ -26,6 +107,8 @@ Suite *u_threadpool_suite(void)
   Suite *s = suite_create("u_threadpool_suite methods");
   TCase *tc_core = tcase_create("test_one");
   tcase_add_test(tc_core, test_one);
+  tcase_add_test(tc_core, test_overflow);
+  tcase_add_test(tc_core, test_destroy);
   suite_add_tcase(s, tc_core);
 
   tc_core = tcase_create("test_two");
@@ -675,5 +675,154 @@ void parse_mom_hierarchy(
 
 
 
+/*
+ * pack_status_frame()
+ *
+ * packs status strings into a single string, so that a mom relays the
+ * statuses of its whole subtree as one unit instead of one DIS string each.
+ * Each packed string ends in a newline. Backslashes and newlines inside a
+ * string are escaped, so unpack_status_frame() gets back exactly what went in.
+ */
+
+void pack_status_frame(
+
+  std::vector<std::string> &strings,
+  std::string              &frame)
+
+  {
+  size_t len = strlen(STATUS_FRAME_KEYWORD);
+
+  for (unsigned int i = 0; i < strings.size(); i++)
+    len += strings[i].size() + 1;
+
+  frame.clear();
+  frame.reserve(len);
+  frame += STATUS_FRAME_KEYWORD;
+
+  for (unsigned int i = 0; i < strings.size(); i++)
+    {
+    const char *str = strings[i].c_str();
+    const char *special;
+
+    while ((special = strpbrk(str, "\\\n")) != NULL)
+      {
+      frame.append(str, special - str);
+      frame += '\\';
+      frame += (*special == '\n') ? 'n' : '\\';
+      str = special + 1;
+      }
+
+    frame += str;
+    frame += '\n';
+    }
+  } /* END pack_status_frame() */
+
+
+
+
+/*
+ * unpack_status_frame()
+ *
+ * appends the strings packed by pack_status_frame() to strings
+ *
+ * @param frame - the packed strings, after the STATUS_FRAME_KEYWORD
+ */
+
+void unpack_status_frame(
+
+  const char               *frame,
+  std::vector<std::string> &strings)
+
+  {
+  const char  *c = frame;
+  const char  *special;
+  std::string  str;
+
+  while ((special = strpbrk(c, "\\\n")) != NULL)
+    {
+    str.append(c, special - c);
+
+    if (*special == '\n')
+      {
+      strings.push_back(str);
+      str.clear();
+      c = special + 1;
+      }
+    else if (special[1] == '\0')
+      break;
+    else
+      {
+      str += (special[1] == 'n') ? '\n' : special[1];
+      c = special + 2;
+      }
+    }
+  } /* END unpack_status_frame() */
+
+
+
+/*
+ * parse_advertised_version()
+ *
+ * @param str - a string pbs_server sent after the mom hierarchy
+ * @param keyword - the keyword of the advertisement to look for
+ * @return the version str advertises, 0 if it isn't that advertisement
+ */
+
+static int parse_advertised_version(
+
+  const char *str,
+  const char *keyword)
+
+  {
+  int version;
+
+  if ((str == NULL) ||
+      (strncmp(str, keyword, strlen(keyword))))
+    return(0);
+
+  version = atoi(str + strlen(keyword));
+
+  if (version < 0)
+    return(0);
+
+  return(version);
+  } /* END parse_advertised_version() */
+
+
+
+/*
+ * parse_status_frame_version()
+ *
+ * @param str - a string pbs_server sent after the mom hierarchy
+ * @return the status frame version it advertises, 0 if it isn't an advertisement
+ */
+
+int parse_status_frame_version(
+
+  const char *str)
+
+  {
+  return(parse_advertised_version(str, STATUS_FRAME_VERSION_KEYWORD));
+  } /* END parse_status_frame_version() */
+
+
+
+/*
+ * parse_status_deltas_version()
+ *
+ * @param str - a string pbs_server sent after the mom hierarchy
+ * @return the status delta version it advertises, 0 if it isn't an advertisement
+ */
+
+int parse_status_deltas_version(
+
+  const char *str)
+
+  {
+  return(parse_advertised_version(str, STATUS_DELTAS_KEYWORD));
+  } /* END parse_status_deltas_version() */
+
+
+
 /* END u_mom_hierarchy.c */
 
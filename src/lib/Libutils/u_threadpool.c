@@ -98,6 +98,146 @@ threadpool_t *async_pool;
 static void *work_thread(void *);
 
 
+
+/*
+ * tp_ring_push()
+ *
+ * claims the next free slot in the ring and stores the work in it, without
+ * taking tp_mutex. This is a bounded multi-producer/multi-consumer queue: each
+ * slot's seq equals the position a producer may claim it at, and pos + 1 once
+ * it holds work for the consumer at pos.
+ *
+ * @return true if the work was queued, false if the ring is full or the
+ * pool has been destroyed
+ */
+
+static bool tp_ring_push(
+
+  threadpool_t  *tp,
+  void        *(*func)(void *),
+  void          *arg)
+
+  {
+  tp_slot_t     *slot;
+  unsigned long  pos = tp->tp_enqueue_pos;
+  long           diff;
+
+  if (tp->tp_ring == NULL)
+    return(false);
+
+  for (;;)
+    {
+    slot = &tp->tp_ring[pos & (TP_RING_SIZE - 1)];
+    diff = (long)slot->seq - (long)pos;
+
+    if (diff == 0)
+      {
+      if (__sync_bool_compare_and_swap(&tp->tp_enqueue_pos, pos, pos + 1))
+        break;
+      }
+    else if (diff < 0)
+      return(false);
+
+    pos = tp->tp_enqueue_pos;
+    }
+
+  slot->work_func = func;
+  slot->work_arg  = arg;
+
+  /* publish the work to consumers */
+  __sync_synchronize();
+  slot->seq = pos + 1;
+
+  return(true);
+  } /* END tp_ring_push() */
+
+
+
+/*
+ * tp_ring_pop()
+ *
+ * removes the oldest work from the ring without taking tp_mutex
+ *
+ * @return true if work was found, false if the ring is empty
+ */
+
+static bool tp_ring_pop(
+
+  threadpool_t  *tp,
+  void        *(**func)(void *),
+  void         **arg)
+
+  {
+  tp_slot_t     *slot;
+  unsigned long  pos = tp->tp_dequeue_pos;
+  long           diff;
+
+  if (tp->tp_ring == NULL)
+    return(false);
+
+  for (;;)
+    {
+    slot = &tp->tp_ring[pos & (TP_RING_SIZE - 1)];
+    diff = (long)slot->seq - (long)(pos + 1);
+
+    if (diff == 0)
+      {
+      if (__sync_bool_compare_and_swap(&tp->tp_dequeue_pos, pos, pos + 1))
+        break;
+      }
+    else if (diff < 0)
+      return(false);
+
+    pos = tp->tp_dequeue_pos;
+    }
+
+  __sync_synchronize();
+  *func = slot->work_func;
+  *arg  = slot->work_arg;
+
+  /* hand the slot back to producers one lap later */
+  __sync_synchronize();
+  slot->seq = pos + TP_RING_SIZE;
+
+  return(true);
+  } /* END tp_ring_pop() */
+
+
+
+/*
+ * threadpool_has_work()
+ *
+ * @return true if there is queued work in the ring or the overflow queue
+ */
+
+static bool threadpool_has_work(
+
+  threadpool_t *tp)
+
+  {
+  __sync_synchronize();
+
+  return((tp->tp_enqueue_pos != tp->tp_dequeue_pos) ||
+         (tp->tp_overflow > 0));
+  } /* END threadpool_has_work() */
+
+
+
+/*
+ * reset_work_thread_state()
+ *
+ * undo any signal mask or cancellation changes made by the previous work
+ */
+
+static void reset_work_thread_state(void)
+
+  {
+  pthread_sigmask(SIG_SETMASK,&fillset,NULL);
+  pthread_setcanceltype(PTHREAD_CANCEL_DEFERRED,NULL);
+  pthread_setcancelstate(PTHREAD_CANCEL_ENABLE,NULL);
+  } /* END reset_work_thread_state() */
+
+
 /*
  * create_work_thread()
  *
@@ -157,7 +297,7 @@ static void work_thread_cleanup(
     if (create_work_thread(tp) == 0)
       tp->tp_nthreads++;
     }
-  else if ((tp->tp_first != NULL) &&
+  else if ((threadpool_has_work(tp) == true) &&
            (tp->tp_nthreads < tp->tp_min_threads) &&
            (create_work_thread(tp) == 0))
     {
@@ -245,11 +385,9 @@ static void *work_thread(
   for (;;) 
     {
     /* reset signal mask for each job */
-    pthread_sigmask(SIG_SETMASK,&fillset,NULL);
-    pthread_setcanceltype(PTHREAD_CANCEL_DEFERRED,NULL);
-    pthread_setcancelstate(PTHREAD_CANCEL_ENABLE,NULL);
+    reset_work_thread_state();
 
-    tp->tp_idle_threads++;
+    __sync_add_and_fetch(&tp->tp_idle_threads, 1);
   
     /* stay asleep until the pool is started */
     while (tp->tp_started == FALSE)
@@ -262,9 +400,19 @@ static void *work_thread(
       }
 
 
-    while ((tp->tp_first == NULL) &&
+    while ((threadpool_has_work(tp) == false) &&
            (!(tp->tp_flags & POOL_DESTROY)))
       {
+      /* producers only take tp_mutex to wake us if they see tp_sleeping,
+       * so it must be raised before the final check for work */
+      __sync_add_and_fetch(&tp->tp_sleeping, 1);
+
+      if (threadpool_has_work(tp) == true)
+        {
+        __sync_sub_and_fetch(&tp->tp_sleeping, 1);
+        break;
+        }
+
       if ((tp->tp_nthreads <= tp->tp_min_threads) ||
           (tp->tp_max_idle_secs < 0))
         {
@@ -276,30 +424,36 @@ static void *work_thread(
         clock_gettime(CLOCK_REALTIME,&ts);
         ts.tv_sec += tp->tp_max_idle_secs;
         rc = pthread_cond_timedwait(&tp->tp_waiting_work, &tp->tp_mutex, &ts);
-
-        if (rc == ETIMEDOUT)
-          {
-          break;
-          }
         }
+
+      __sync_sub_and_fetch(&tp->tp_sleeping, 1);
+
+      if (rc == ETIMEDOUT)
+        break;
       }
 
     if ((rc == ETIMEDOUT) && 
         (tp->tp_nthreads > tp->tp_min_threads) &&
         (tp->tp_idle_threads > 2))
       {
-      tp->tp_idle_threads--;
+      __sync_sub_and_fetch(&tp->tp_idle_threads, 1);
       break;
       }
 
-    tp->tp_idle_threads--;
+    rc = PBSE_NONE;
+    __sync_sub_and_fetch(&tp->tp_idle_threads, 1);
 
     /* if we're shutting down, leave this loop */
     if (tp->tp_flags & POOL_DESTROY)
       break;
 
-    if ((mywork = tp->tp_first) != NULL)
+    mywork = NULL;
+
+    if (tp_ring_pop(tp, &func, &arg) == false)
       {
+      if ((mywork = tp->tp_first) == NULL)
+        continue;
+
       func = mywork->work_func;
       arg  = mywork->work_arg;
 
@@ -307,19 +461,30 @@ static void *work_thread(
       if (tp->tp_last == mywork)
         tp->tp_last = NULL;
 
-      working.next = tp->tp_active;
-      tp->tp_active = &working;
+      tp->tp_overflow--;
+      }
 
-      pthread_mutex_unlock(&tp->tp_mutex);
-      pthread_cleanup_push(work_cleanup,tp);
-      free(mywork);
+    working.next = tp->tp_active;
+    tp->tp_active = &working;
+
+    pthread_mutex_unlock(&tp->tp_mutex);
+    pthread_cleanup_push(work_cleanup,tp);
+    free(mywork);
 
-      /* do the work */
+    /* do the work, then keep draining the ring without retaking tp_mutex */
+    do
+      {
       func(arg);
 
-      /* cleanup the work */
-      pthread_cleanup_pop(1); /* calls work_cleanup(NULL) */
-      }
+      /* nothing run by the pools changes the signal mask, so between items
+       * only the cancellation state is restored. The mask is reset when the
+       * thread comes back around the main loop */
+      pthread_setcanceltype(PTHREAD_CANCEL_DEFERRED,NULL);
+      pthread_setcancelstate(PTHREAD_CANCEL_ENABLE,NULL);
+      } while (tp_ring_pop(tp, &func, &arg) == true);
+
+    /* cleanup the work */
+    pthread_cleanup_pop(1); /* calls work_cleanup(NULL) */
     }
 
   /* calls work_thread_cleanup(tp), this also unlock tp->tp_mutex */
@@ -370,12 +535,26 @@ int initialize_threadpool(
   (*pool)->tp_max_threads = max_threads;
   (*pool)->tp_max_idle_secs = max_idle_time;
   (*pool)->tp_started = FALSE;
+
+  if (((*pool)->tp_ring = (tp_slot_t *)calloc(TP_RING_SIZE, sizeof(tp_slot_t))) == NULL)
+    {
+    free(*pool);
+    *pool = NULL;
+
+    return(ENOMEM);
+    }
+
+  for (i = 0; i < TP_RING_SIZE; i++)
+    (*pool)->tp_ring[i].seq = i;
   
   /* initialize attributes */
   if ((rc = pthread_attr_init(&(*pool)->tp_attr)) != 0)
     {
     perror("pthread_attr_init failed. Could not init thread pool.");
     log_err(-1, __func__, "pthread_attr_init failed. Could not init thread pool.");
+    free((*pool)->tp_ring);
+    free(*pool);
+    *pool = NULL;
     return rc;
     }
 
@@ -420,6 +599,36 @@ int enqueue_threadpool_request(
   tp_work_t *work = NULL;
 /*  char              log_buf[LOCAL_LOG_BUF_SIZE];*/
 
+  /* the common case: a free preallocated slot and no backlog in the overflow queue */
+  if ((tp->tp_overflow == 0) &&
+      (tp_ring_push(tp, func, arg) == true))
+    {
+    /* pairs with the tp_sleeping increment in work_thread() */
+    __sync_synchronize();
+
+    if (tp->tp_sleeping > 0)
+      {
+      pthread_mutex_lock(&tp->tp_mutex);
+      pthread_cond_signal(&tp->tp_waiting_work);
+      pthread_mutex_unlock(&tp->tp_mutex);
+      }
+    else if ((tp->tp_idle_threads == 0) &&
+             (tp->tp_nthreads < tp->tp_max_threads))
+      {
+      pthread_mutex_lock(&tp->tp_mutex);
+
+      if ((tp->tp_idle_threads == 0) &&
+          (tp->tp_nthreads < tp->tp_max_threads) &&
+          (create_work_thread(tp) == 0))
+        tp->tp_nthreads++;
+
+      pthread_mutex_unlock(&tp->tp_mutex);
+      }
+
+    return(0);
+    }
+
+  /* the ring is full, queue the work on the overflow list */
   if ((work = (tp_work_t *)calloc(1, sizeof(tp_work_t))) == NULL)
     {
     return(ENOMEM);
@@ -437,6 +646,7 @@ int enqueue_threadpool_request(
     tp->tp_last->next = work;
   
   tp->tp_last = work;
+  tp->tp_overflow++;
 
   if (tp->tp_idle_threads > 0)
     pthread_cond_signal(&tp->tp_waiting_work);
@@ -523,6 +733,20 @@ void destroy_request_pool(
     tp->tp_first = work->next;
     free(work);
     }
+
+  tp->tp_last = NULL;
+  tp->tp_overflow = 0;
+
+  {
+  void *(*func)(void *);
+  void  *arg;
+
+  while (tp_ring_pop(tp, &func, &arg) == true)
+    ;
+  }
+
+  free(tp->tp_ring);
+  tp->tp_ring = NULL;
   } /* END destroy_request_pool() */
 
 
@@ -2219,6 +2219,91 @@ int send_job_obit_to_ms(
 
 
 
+/*
+ * post_sister_epilogue
+ *
+ * @see scan_for_terminated() - calls post_sister_epilogue() via ji_mompost
+ * @see exit_mom_job() - forks the epilogues
+ *
+ * The epilogues are done, the next scan_for_exiting() sends the obit to
+ * mother superior.
+ */
+
+int post_sister_epilogue(
+
+  job *pjob,  /* I */
+  int  ev)    /* I - exit value of the epilogue subtask */
+
+  {
+  if (LOGLEVEL >= 6)
+    {
+    snprintf(log_buffer, sizeof(log_buffer),
+      "epilog subtask finished with %d", ev);
+    log_record(PBSEVENT_DEBUG, PBS_EVENTCLASS_JOB, pjob->ji_qs.ji_jobid, log_buffer);
+    }
+
+  pjob->ji_flags |= MOM_EPILOGUE_DONE;
+
+  exiting_tasks = 1;
+
+  return(PBSE_NONE);
+  } /* END post_sister_epilogue() */
+
+
+
+
+/*
+ * start_sister_epilogue
+ *
+ * Forks the sister's epilogues so a slow script doesn't hold up the mom.
+ * If the fork fails they are run in line as before.
+ */
+
+void start_sister_epilogue(
+
+  job *pjob)  /* I */
+
+  {
+  pid_t cpid;
+
+  if ((cpid = fork_me(-1)) < 0)
+    {
+    log_err(errno, __func__, "fork failed, running the epilogues in line");
+
+    run_epilogues(pjob, FALSE, FALSE);
+
+    pjob->ji_flags |= MOM_EPILOGUE_DONE;
+
+    return;
+    }
+
+  if (cpid > 0)
+    {
+    pjob->ji_flags |= MOM_EPILOGUE_RUN;
+    pjob->ji_momsubt = cpid;
+    pjob->ji_mompost = post_sister_epilogue;
+
+    if (LOGLEVEL >= 2)
+      {
+      snprintf(log_buffer, sizeof(log_buffer),
+        "epilog subtask created with pid %d - registered post_sister_epilogue",
+        cpid);
+
+      log_record(PBSEVENT_DEBUG, PBS_EVENTCLASS_JOB, pjob->ji_qs.ji_jobid, log_buffer);
+      }
+
+    return;
+    }
+
+  /* child - just run epilogues */
+  run_epilogues(pjob, FALSE, FALSE);
+
+  exit(0);
+  } /* END start_sister_epilogue() */
+
+
+
+
 void exit_mom_job(
    
   job *pjob,
@@ -2237,7 +2322,16 @@ void exit_mom_job(
   if (needs_and_ready_for_reply(pjob) == FALSE)
     return;
 
-  run_epilogues(pjob, FALSE, FALSE);
+  if ((pjob->ji_flags & MOM_EPILOGUE_DONE) == 0)
+    {
+    /* wait for another subtask (suspend, checkpoint) or the epilogues to finish */
+    if ((pjob->ji_momsubt == 0) &&
+        ((pjob->ji_flags & MOM_EPILOGUE_RUN) == 0))
+      start_sister_epilogue(pjob);
+
+    if ((pjob->ji_flags & MOM_EPILOGUE_DONE) == 0)
+      return;
+    }
 
   send_job_obit_to_ms(pjob, mom_radix);
   
@@ -30,6 +30,10 @@ int needs_and_ready_for_reply(job *pjob);
 
 int send_job_obit_to_ms(job *pjob, int mom_radix);
 
+int post_sister_epilogue(job *pjob, int ev);
+
+void start_sister_epilogue(job *pjob);
+
 void exit_mom_job(job *pjob, int mom_radix);
 
 #endif /* _CATCH_CHILD_H */
@@ -0,0 +1,530 @@
+#include <pbs_config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <string>
+#include <vector>
+
+#include "pbs_error.h"
+#include "log.h"
+#include "pbs_cgroup.h"
+
+#ifndef MAXPATHLEN
+#define MAXPATHLEN 1024
+#endif /* MAXPATHLEN */
+
+
+extern int LOGLEVEL;
+extern int use_cgroup_accounting;
+
+int        cgroup_version = CGROUP_NONE;
+char       cgroup_root[MAXPATHLEN];
+
+
+
+/*
+ * reads all of a cgroup file into contents
+ *
+ * @return PBSE_NONE on success, PBSE_SYSTEM if it can't be read
+ */
+
+int read_cgroup_file(
+
+  const std::string &path,
+  std::string       &contents)
+
+  {
+  int     fd;
+  ssize_t len;
+  char    buf[4096];
+
+  contents.clear();
+
+  if ((fd = open(path.c_str(), O_RDONLY)) < 0)
+    return(PBSE_SYSTEM);
+
+  while ((len = read(fd, buf, sizeof(buf))) > 0)
+    contents.append(buf, len);
+
+  close(fd);
+
+  if (len < 0)
+    return(PBSE_SYSTEM);
+
+  return(PBSE_NONE);
+  } /* END read_cgroup_file() */
+
+
+
+/*
+ * reads a cgroup file holding a single number into value
+ */
+
+int read_cgroup_value(
+
+  const std::string  &path,
+  unsigned long long &value)
+
+  {
+  std::string contents;
+
+  if (read_cgroup_file(path, contents) != PBSE_NONE)
+    return(PBSE_SYSTEM);
+
+  value = strtoull(contents.c_str(), NULL, 10);
+
+  return(PBSE_NONE);
+  } /* END read_cgroup_value() */
+
+
+
+int write_cgroup_file(
+
+  const std::string &path,
+  const char        *value)
+
+  {
+  int     fd;
+  ssize_t len;
+
+  if ((fd = open(path.c_str(), O_WRONLY)) < 0)
+    return(PBSE_SYSTEM);
+
+  len = write(fd, value, strlen(value));
+
+  close(fd);
+
+  if (len != (ssize_t)strlen(value))
+    return(PBSE_SYSTEM);
+
+  return(PBSE_NONE);
+  } /* END write_cgroup_file() */
+
+
+
+int make_cgroup_dir(
+
+  const std::string &path)
+
+  {
+  if ((mkdir(path.c_str(), 0755) != 0) &&
+      (errno != EEXIST))
+    return(PBSE_SYSTEM);
+
+  return(PBSE_NONE);
+  } /* END make_cgroup_dir() */
+
+
+
+/*
+ * fills dirs with the directories of a job's cgroup: the one in the unified
+ * hierarchy for cgroup v2, the ones in the cpuacct and memory hierarchies for
+ * v1. The first one holds the job's processes and its cpu time.
+ */
+
+void job_cgroup_dirs(
+
+  const char               *jobid,
+  std::vector<std::string> &dirs)
+
+  {
+  std::string root(cgroup_root);
+
+  dirs.clear();
+
+  if (cgroup_version == CGROUP_V2)
+    dirs.push_back(root + "/" TORQUE_CGROUP "/" + jobid);
+  else if (cgroup_version == CGROUP_V1)
+    {
+    dirs.push_back(root + "/cpuacct/" TORQUE_CGROUP "/" + jobid);
+    dirs.push_back(root + "/memory/" TORQUE_CGROUP "/" + jobid);
+    }
+  } /* END job_cgroup_dirs() */
+
+
+
+/*
+ * init_job_cgroups()
+ *
+ * sets up the torque cgroup under root that the job cgroups are made in. A
+ * root with a cgroup.controllers file is the cgroup v2 unified hierarchy, the
+ * memory controller is delegated to the job cgroups from there. Otherwise
+ * root must hold the cgroup v1 cpuacct and memory hierarchies.
+ *
+ * @return PBSE_NONE if jobs can be accounted through their cgroups
+ */
+
+int init_job_cgroups(
+
+  const char *root)
+
+  {
+  struct stat  sb;
+  std::string  base(root);
+  const char  *v1_hierarchies[] = { "cpuacct", "memory", NULL };
+  char         log_buf[LOCAL_LOG_BUF_SIZE];
+
+  cgroup_version = CGROUP_NONE;
+  snprintf(cgroup_root, sizeof(cgroup_root), "%s", root);
+
+  if (stat((base + "/cgroup.controllers").c_str(), &sb) == 0)
+    {
+    /* cpu.stat is always there, memory.current needs the controller */
+    write_cgroup_file(base + "/cgroup.subtree_control", "+memory");
+
+    if (make_cgroup_dir(base + "/" TORQUE_CGROUP) != PBSE_NONE)
+      {
+      snprintf(log_buf, sizeof(log_buf), "could not create %s/%s", root, TORQUE_CGROUP);
+      log_err(errno, __func__, log_buf);
+      return(PBSE_SYSTEM);
+      }
+
+    write_cgroup_file(base + "/" TORQUE_CGROUP "/cgroup.subtree_control", "+memory");
+
+    cgroup_version = CGROUP_V2;
+    }
+  else
+    {
+    for (int i = 0; v1_hierarchies[i] != NULL; i++)
+      {
+      std::string hierarchy = base + "/" + v1_hierarchies[i];
+
+      if ((stat(hierarchy.c_str(), &sb) != 0) ||
+          (make_cgroup_dir(hierarchy + "/" TORQUE_CGROUP) != PBSE_NONE))
+        {
+        snprintf(log_buf, sizeof(log_buf), "could not set up the %s cgroup hierarchy under %s",
+          v1_hierarchies[i], root);
+        log_err(errno, __func__, log_buf);
+        return(PBSE_SYSTEM);
+        }
+      }
+
+    cgroup_version = CGROUP_V1;
+    }
+
+  snprintf(log_buf, sizeof(log_buf), "accounting jobs through cgroup v%d under %s",
+    cgroup_version, root);
+  log_record(PBSEVENT_SYSTEM, PBS_EVENTCLASS_SERVER, __func__, log_buf);
+
+  return(PBSE_NONE);
+  } /* END init_job_cgroups() */
+
+
+
+/*
+ * @return true if $cgroup_accounting is on and the job cgroups were set up
+ */
+
+bool job_cgroups_active(void)
+
+  {
+  return((use_cgroup_accounting == TRUE) &&
+         (cgroup_version != CGROUP_NONE));
+  } /* END job_cgroups_active() */
+
+
+
+int create_job_cgroup(
+
+  const char *jobid)
+
+  {
+  std::vector<std::string> dirs;
+  char                     log_buf[LOCAL_LOG_BUF_SIZE];
+
+  job_cgroup_dirs(jobid, dirs);
+
+  if (dirs.size() == 0)
+    return(PBSE_SYSTEM);
+
+  for (unsigned int i = 0; i < dirs.size(); i++)
+    {
+    if (make_cgroup_dir(dirs[i]) != PBSE_NONE)
+      {
+      snprintf(log_buf, sizeof(log_buf), "could not create cgroup %s", dirs[i].c_str());
+      log_err(errno, __func__, log_buf);
+      return(PBSE_SYSTEM);
+      }
+    }
+
+  return(PBSE_NONE);
+  } /* END create_job_cgroup() */
+
+
+
+/*
+ * moves pid into the job's cgroup. The processes it starts from then on are
+ * in the cgroup too.
+ */
+
+int move_to_job_cgroup(
+
+  pid_t       pid,
+  const char *jobid)
+
+  {
+  std::vector<std::string> dirs;
+  char                     pid_str[32];
+  char                     log_buf[LOCAL_LOG_BUF_SIZE];
+
+  job_cgroup_dirs(jobid, dirs);
+
+  if (dirs.size() == 0)
+    return(PBSE_SYSTEM);
+
+  snprintf(pid_str, sizeof(pid_str), "%d", (int)pid);
+
+  for (unsigned int i = 0; i < dirs.size(); i++)
+    {
+    if (write_cgroup_file(dirs[i] + "/cgroup.procs", pid_str) != PBSE_NONE)
+      {
+      snprintf(log_buf, sizeof(log_buf), "could not move pid %d into cgroup %s",
+        (int)pid, dirs[i].c_str());
+      log_err(errno, __func__, log_buf);
+      return(PBSE_SYSTEM);
+      }
+    }
+
+  return(PBSE_NONE);
+  } /* END move_to_job_cgroup() */
+
+
+
+/*
+ * kills the processes left in the job's cgroup, ones that escaped the
+ * job's sessions. cgroup v2 kernels with cgroup.kill kill them all at once,
+ * including ones forked while they're being killed.
+ *
+ * @return the number of processes that were left
+ */
+
+int kill_job_cgroup_procs(
+
+  const char *jobid)
+
+  {
+  std::vector<std::string> dirs;
+  std::vector<pid_t>       pids;
+
+  if (get_job_cgroup_pids(jobid, pids) != PBSE_NONE)
+    return(0);
+
+  if (pids.size() == 0)
+    return(0);
+
+  job_cgroup_dirs(jobid, dirs);
+
+  if ((cgroup_version != CGROUP_V2) ||
+      (write_cgroup_file(dirs[0] + "/cgroup.kill", "1") != PBSE_NONE))
+    {
+    for (unsigned int i = 0; i < pids.size(); i++)
+      {
+      if (pids[i] > 1)
+        kill(pids[i], SIGKILL);
+      }
+    }
+
+  return(pids.size());
+  } /* END kill_job_cgroup_procs() */
+
+
+
+/*
+ * removes the job's cgroup. Processes left in it are killed first, and the
+ * removal is retried while they exit.
+ */
+
+int delete_job_cgroup(
+
+  const char *jobid)
+
+  {
+  std::vector<std::string> dirs;
+  int                      rc = PBSE_NONE;
+  int                      left;
+  char                     log_buf[LOCAL_LOG_BUF_SIZE];
+
+  job_cgroup_dirs(jobid, dirs);
+
+  if ((left = kill_job_cgroup_procs(jobid)) > 0)
+    {
+    snprintf(log_buf, sizeof(log_buf), "killed %d processes left in the cgroup of job %s",
+      left, jobid);
+    log_record(PBSEVENT_JOB, PBS_EVENTCLASS_JOB, jobid, log_buf);
+    }
+
+  for (unsigned int i = 0; i < dirs.size(); i++)
+    {
+    int tries = 0;
+
+    while ((rmdir(dirs[i].c_str()) != 0) &&
+           (errno != ENOENT))
+      {
+      /* the killed processes may not have exited yet */
+      if ((errno != EBUSY) ||
+          (++tries >= CGROUP_RMDIR_TRIES))
+        {
+        snprintf(log_buf, sizeof(log_buf), "could not remove cgroup %s", dirs[i].c_str());
+        log_err(errno, __func__, log_buf);
+        rc = PBSE_SYSTEM;
+        break;
+        }
+
+      usleep(CGROUP_RMDIR_WAIT);
+      kill_job_cgroup_procs(jobid);
+      }
+    }
+
+  return(rc);
+  } /* END delete_job_cgroup() */
+
+
+
+/*
+ * fills pids with the processes in the job's cgroup
+ *
+ * @return PBSE_NONE on success, PBSE_SYSTEM if the job has no cgroup
+ */
+
+int get_job_cgroup_pids(
+
+  const char         *jobid,
+  std::vector<pid_t> &pids)
+
+  {
+  std::vector<std::string> dirs;
+  std::string              procs;
+  const char              *ptr;
+  char                    *end;
+
+  pids.clear();
+
+  job_cgroup_dirs(jobid, dirs);
+
+  if ((dirs.size() == 0) ||
+      (read_cgroup_file(dirs[0] + "/cgroup.procs", procs) != PBSE_NONE))
+    return(PBSE_SYSTEM);
+
+  ptr = procs.c_str();
+
+  while (true)
+    {
+    long pid = strtol(ptr, &end, 10);
+
+    if (end == ptr)
+      break;
+
+    pids.push_back((pid_t)pid);
+    ptr = end;
+    }
+
+  return(PBSE_NONE);
+  } /* END get_job_cgroup_pids() */
+
+
+
+/*
+ * returns the value of key in a cgroup stat file (cpu.stat, memory.stat),
+ * 0 if it isn't there
+ */
+
+unsigned long long cgroup_stat_value(
+
+  const std::string &contents,
+  const char        *key)
+
+  {
+  size_t len = strlen(key);
+  size_t pos = 0;
+
+  while ((pos = contents.find(key, pos)) != std::string::npos)
+    {
+    /* only whole keys at the start of a line */
+    if (((pos == 0) || (contents[pos - 1] == '\n')) &&
+        (contents[pos + len] == ' '))
+      return(strtoull(contents.c_str() + pos + len + 1, NULL, 10));
+
+    pos += len;
+    }
+
+  return(0);
+  } /* END cgroup_stat_value() */
+
+
+
+/*
+ * read_job_cgroup_usage()
+ *
+ * reads the job's usage and processes from its cgroup: cpu.stat and
+ * memory.current for cgroup v2, cpuacct.usage and memory.usage_in_bytes for
+ * v1. The cgroup keeps the cpu time of processes that have exited, so short
+ * lived processes aren't missed between samples. The page cache charged to
+ * the cgroup (file in memory.stat, cache for v1) isn't the job's resident
+ * memory and is left out.
+ *
+ * @return PBSE_NONE on success, PBSE_SYSTEM if the job has no cgroup
+ */
+
+int read_job_cgroup_usage(
+
+  const char         *jobid,
+  cgroup_usage       &usage,
+  std::vector<pid_t> &pids)
+
+  {
+  std::vector<std::string> dirs;
+  std::string              contents;
+  std::string              mem_dir;
+  unsigned long long       nsecs;
+  unsigned long long       cache;
+
+  memset(&usage, 0, sizeof(usage));
+
+  job_cgroup_dirs(jobid, dirs);
+
+  if (dirs.size() == 0)
+    return(PBSE_SYSTEM);
+
+  if (cgroup_version == CGROUP_V2)
+    {
+    if (read_cgroup_file(dirs[0] + "/cpu.stat", contents) != PBSE_NONE)
+      return(PBSE_SYSTEM);
+
+    usage.cput_usec = cgroup_stat_value(contents, "usage_usec");
+
+    mem_dir = dirs[0];
+    read_cgroup_value(mem_dir + "/memory.current", usage.mem);
+    read_cgroup_file(mem_dir + "/memory.stat", contents);
+    cache = cgroup_stat_value(contents, "file");
+    }
+  else
+    {
+    if (read_cgroup_value(dirs[0] + "/cpuacct.usage", nsecs) != PBSE_NONE)
+      return(PBSE_SYSTEM);
+
+    usage.cput_usec = nsecs / 1000;
+
+    mem_dir = dirs[1];
+    read_cgroup_value(mem_dir + "/memory.usage_in_bytes", usage.mem);
+    read_cgroup_file(mem_dir + "/memory.stat", contents);
+
+    if ((cache = cgroup_stat_value(contents, "total_cache")) == 0)
+      cache = cgroup_stat_value(contents, "cache");
+    }
+
+  usage.mem = (usage.mem > cache) ? usage.mem - cache : 0;
+
+  if (get_job_cgroup_pids(jobid, pids) == PBSE_NONE)
+    usage.nprocs = pids.size();
+
+  return(PBSE_NONE);
+  } /* END read_job_cgroup_usage() */
+
+/* END cgroup.c */
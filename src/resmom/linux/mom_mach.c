@@ -63,6 +63,8 @@
 #ifdef PENABLE_LINUX26_CPUSETS
 #include "pbs_cpuset.h"
 #endif
+#include "pbs_cgroup.h"
+#include "proc_sampler.hpp"
 #include "mom_config.h"
 #include "timer.hpp"
 
@@ -118,6 +120,10 @@ extern  int     LOGLEVEL;
 proc_stat_t   *proc_array = NULL;
 static int            nproc = 0;
 static int            max_proc = 0;
+static proc_sampler  *sampler = NULL;
+
+/* each job's cgroup usage, read once per mom_get_sample() */
+static std::map<std::string, cgroup_usage> cgroup_samples;
 
 extern pid2jobsid_map_t pid2jobsid_map;
 
@@ -1070,12 +1076,36 @@ bool injob(
   }  /* END injob() */
 
 
+/*
+ * @return the usage read from the job's cgroup in the last sample, NULL if
+ * it has none
+ */
+
+static cgroup_usage *job_cgroup_sample(
+
+  job *pjob)
+
+  {
+  std::map<std::string, cgroup_usage>::iterator it;
+
+  if (job_cgroups_active() == false)
+    return(NULL);
+
+  if ((it = cgroup_samples.find(pjob->ji_qs.ji_jobid)) == cgroup_samples.end())
+    return(NULL);
+
+  return(&it->second);
+  } /* END job_cgroup_sample() */
+
+
+
 /*
  * Internal session CPU time decoding routine.
  *
  * Accepts a job pointer.  Returns the sum of all cpu time
  * consumed for all tasks executed by the job, in seconds,
- * adjusted by cputfactor.
+ * adjusted by cputfactor. A job with a cgroup is charged what
+ * the cgroup accounted.
  */
 
 unsigned long cput_sum(
@@ -1086,9 +1116,20 @@ unsigned long cput_sum(
   ulong          cputime;
   int            nps = 0;
   proc_stat_t   *ps;
+  cgroup_usage  *usage;
 
   cputime = 0;
 
+  if ((usage = job_cgroup_sample(pjob)) != NULL)
+    {
+    if (usage->nprocs == 0)
+      pjob->ji_flags |= MOM_NO_PROC;
+    else
+      pjob->ji_flags &= ~MOM_NO_PROC;
+
+    return((unsigned long)((double)usage->cput_usec / 1000000.0 * cputfactor));
+    }
+
   if (LOGLEVEL >= 6)
     {
     sprintf(log_buffer, "pid2jobsid_map loop start - jobid = %s",
@@ -1303,7 +1344,8 @@ unsigned long long mem_sum(
  * Internal session memory usage function.
  *
  * Returns the total number of bytes of resident memory
- * consumed by all current processes within the job.
+ * consumed by all current processes within the job, or the
+ * memory charged to its cgroup if it has one.
  */
 
 unsigned long long resi_sum(
@@ -1313,12 +1355,16 @@ unsigned long long resi_sum(
   {
   unsigned long long  resisize;
   proc_stat_t        *ps;
+  cgroup_usage       *usage;
 #ifdef USELIBMEMACCT
   long long                w_rss;
 #endif
 
   resisize = 0;
 
+  if ((usage = job_cgroup_sample(pjob)) != NULL)
+    return(usage->mem);
+
   if (LOGLEVEL >= 6)
     {
     sprintf(log_buffer, "proc_array loop start - jobid = %s",
@@ -2082,6 +2128,9 @@ int mom_open_poll(void)
 
   max_proc = TBL_INC;
 
+  if (sampler == NULL)
+    sampler = new proc_sampler(procfs);
+
   return(PBSE_NONE);
   }  /* END mom_open_poll() */
 
@@ -2132,6 +2181,143 @@ int get_job_sid_from_pid(pid_t pid)
   }
 
 
+/*
+ * the threads a sample may be read with: one per 32 cpus, so that only
+ * large SMP nodes read in parallel
+ */
+
+int get_sample_threads(void)
+
+  {
+  int threads = system_ncpus / 32;
+
+  if (threads > MAX_PROC_SAMPLE_THREADS)
+    threads = MAX_PROC_SAMPLE_THREADS;
+
+  if (threads < 1)
+    threads = 1;
+
+  return(threads);
+  } /* END get_sample_threads() */
+
+
+
+/*
+ * load_proc_array()
+ *
+ * samples pids through the sampler and fills proc_array with them. The
+ * sampler keeps what it read between polls, so processes that don't belong
+ * to a job aren't read every time. proc_array is grown at most once.
+ *
+ * @return PBSE_NONE, or PBSE_SYSTEM if proc_array couldn't be grown
+ */
+
+int load_proc_array(
+
+  std::vector<pid_t> &pids)
+
+  {
+  std::vector<proc_stat_t *> sampled;
+
+  sampler->sample(pids, global_job_sid_set, get_sample_threads(), sampled);
+
+  if ((int)sampled.size() >= max_proc)
+    {
+    /* proc_array is refilled from scratch, nothing needs to be copied */
+    int          new_max = MAX(max_proc * 2, (int)sampled.size() + 1);
+    proc_stat_t *hold = (proc_stat_t *)calloc(new_max, sizeof(proc_stat_t));
+
+    if (hold == NULL)
+      {
+      log_err(errno, __func__, "unable to realloc space for proc_array sample");
+
+      return(PBSE_SYSTEM);
+      }
+
+    free(proc_array);
+
+    proc_array = hold;
+    max_proc = new_max;
+    }
+
+  for (unsigned int i = 0; i < sampled.size(); i++)
+    {
+    /* map pid to proc_array index */
+    pid2procarrayindex_map[sampled[i]->pid] = nproc;
+
+    proc_array[nproc++] = *sampled[i];
+    }
+
+  if (LOGLEVEL >= 6)
+    {
+    sprintf(log_buffer, "read %d of %d processes", sampler->get_stats_read(), nproc);
+
+    log_record(PBSEVENT_DEBUG, 0, __func__, log_buffer);
+    }
+
+  return(PBSE_NONE);
+  } /* END load_proc_array() */
+
+
+
+
+/*
+ * get_cgroup_sample_pids()
+ *
+ * reads the usage of every job's cgroup into cgroup_samples, fills pids with
+ * the processes in them, and cgroup_sids with the session each of them is
+ * counted under.
+ *
+ * @return false if a job with a session has no cgroup, /proc has to be
+ * scanned for it
+ */
+
+bool get_cgroup_sample_pids(
+
+  std::vector<pid_t>   &pids,
+  std::map<pid_t, int> &cgroup_sids)
+
+  {
+  job                *pjob;
+  std::vector<pid_t>  job_pids;
+  cgroup_usage        usage;
+  bool                all_jobs = true;
+
+  cgroup_samples.clear();
+
+  for (pjob = (job *)GET_NEXT(svr_alljobs);
+       pjob != NULL;
+       pjob = (job *)GET_NEXT(pjob->ji_alljobs))
+    {
+    if (read_job_cgroup_usage(pjob->ji_qs.ji_jobid, usage, job_pids) != PBSE_NONE)
+      {
+      if ((pjob->ji_job_pid_set != NULL) &&
+          (pjob->ji_job_pid_set->size() != 0))
+        all_jobs = false;
+
+      continue;
+      }
+
+    cgroup_samples[pjob->ji_qs.ji_jobid] = usage;
+
+    if ((pjob->ji_job_pid_set == NULL) ||
+        (pjob->ji_job_pid_set->size() == 0))
+      continue;
+
+    /* any of the job's sessions will do for injob() */
+    for (unsigned int i = 0; i < job_pids.size(); i++)
+      {
+      pids.push_back(job_pids[i]);
+      cgroup_sids[job_pids[i]] = *pjob->ji_job_pid_set->begin();
+      }
+    }
+
+  return(all_jobs);
+  } /* END get_cgroup_sample_pids() */
+
+
+
+
 /*
  * Declare start of polling loop.
  *
@@ -2148,6 +2334,12 @@ int get_job_sid_from_pid(pid_t pid)
  * @see get_proc_stat() - child
  * @see mom_set_use() - Aggregates data collected here
  *
+ * With $cgroup_accounting, only the processes in the jobs' cgroups are
+ * sampled, unless a job has no cgroup.
+ *
+ * The processes are read through the proc_sampler, which only reads again
+ * the processes that belong to jobs or are new since the last sample.
+ *
  * NOTE:  populates global 'proc_array[]' variable.
  * NOTE:  reallocs proc_array[] as needed to accomodate processes.
  * NOTE:  populates global 'pid2jobsid_map' map (pid to owning job session id mapping for all pids).
@@ -2163,17 +2355,16 @@ int get_job_sid_from_pid(pid_t pid)
 int mom_get_sample(void)
 
   {
-  proc_stat_t           *pi;
-  proc_stat_t           *ps;
-  pid_t                  pid;
+  std::vector<pid_t>     sample_pids;
+  std::vector<pid_t>     cgroup_pids;
+  std::map<pid_t, int>   cgroup_sids;
 #ifdef PENABLE_LINUX26_CPUSETS
   struct pidl           *pids = NULL;
   struct pidl           *pp;
-#else
-  struct dirent         *dent;
 #endif
 
-  if (proc_array == NULL)
+  if ((proc_array == NULL) ||
+      (sampler == NULL))
     mom_open_poll();
 
   nproc = 0;
@@ -2182,99 +2373,60 @@ int mom_get_sample(void)
   pid2jobsid_map.clear();
   pid2procarrayindex_map.clear();
 
-  pi = proc_array;
-
   if (LOGLEVEL >= 6)
     {
     log_record(PBSEVENT_DEBUG, PBS_EVENTCLASS_SERVER, __func__, "proc_array load started");
     }
 
-#ifdef PENABLE_LINUX26_CPUSETS
-
-  /* Instead of collect stats of all processes running on a large SMP system,
-   * collect stats of processes running in and below the Torque cpuset, only
-   * This relies on reliable process starters for MPI, which bind their tasks
-   * to the cpuset of the job. */
-
-#ifdef USELIBCPUSET
-  pids = get_cpuset_pidlist(TTORQUECPUSET_BASE, pids);
-#else
-  pids = get_cpuset_pidlist(TTORQUECPUSET_PATH, pids);
-#endif
-  pp = pids;
-  while (pp != NULL)
-    {
-    pid = pp->pid;
-    pp  = pp->next;
-#else
-  if (pdir == NULL)
+  if ((job_cgroups_active() == true) &&
+      (get_cgroup_sample_pids(cgroup_pids, cgroup_sids) == true))
     {
-    if ((pdir = opendir(procfs)) == NULL)
+    if (load_proc_array(cgroup_pids) != PBSE_NONE)
       return(PBSE_SYSTEM);
-    }
-    
-  rewinddir(pdir);
-
-  while ((dent = readdir(pdir)) != NULL)
-    {
-    if (!isdigit(dent->d_name[0]))
-      continue;
 
-    pid = atoi(dent->d_name);
-#endif
-    if ((ps = get_proc_stat(pid)) == NULL)
+    /* the cgroups say which job each process belongs to */
+    for (std::map<pid_t, int>::iterator it = cgroup_sids.begin(); it != cgroup_sids.end(); it++)
       {
-      if (errno != ENOENT)
-        {
-        sprintf(log_buffer, "%d: get_proc_stat", pid);
-
-        log_err(errno, __func__, log_buffer);
-        }
-
-      continue;
+      if (pid2procarrayindex_map.find(it->first) != pid2procarrayindex_map.end())
+        pid2jobsid_map[it->first] = it->second;
       }
 
-    /* nproc++; -- we need to increment AFTER assigning this ps to
-       the proc_array--otherwise we could skip it in for loops */
+    sampler->mark_job_procs(pid2jobsid_map);
 
-    if ((nproc + 1) >= max_proc)
+    if (LOGLEVEL >= 6)
       {
-      proc_stat_t *hold;
-
-      if (LOGLEVEL >= 9)
-        {
-        log_record(PBSEVENT_DEBUG, PBS_EVENTCLASS_SERVER, __func__, "alloc more proc_array");
-        }
+      sprintf(log_buffer, "proc_array loaded from job cgroups - nproc=%d", nproc);
 
-      max_proc *= 2;
-
-      hold = (proc_stat_t *)calloc(1, max_proc * sizeof(proc_stat_t));
-
-      if (hold == NULL)
-        {
-        log_err(errno, __func__, "unable to realloc space for proc_array sample");
-
-        return(PBSE_SYSTEM);
-        }
-
-      memcpy(hold, proc_array, sizeof(proc_stat_t) * max_proc / 2);
-      free(proc_array);
+      log_record(PBSEVENT_DEBUG, 0, __func__, log_buffer);
+      }
 
-      proc_array = hold;
-      }  /* END if ((nproc+1) == max_proc) */
+    return(PBSE_NONE);
+    }
 
-    /* map pid to proc_array index */
-    pid2procarrayindex_map[pid] = nproc;
+#ifdef PENABLE_LINUX26_CPUSETS
 
-    pi = &proc_array[nproc++];
+  /* Instead of collect stats of all processes running on a large SMP system,
+   * collect stats of processes running in and below the Torque cpuset, only
+   * This relies on reliable process starters for MPI, which bind their tasks
+   * to the cpuset of the job. */
 
-    memcpy(pi, ps, sizeof(proc_stat_t));
-    }  /* END while (...) != NULL) */
+#ifdef USELIBCPUSET
+  pids = get_cpuset_pidlist(TTORQUECPUSET_BASE, pids);
+#else
+  pids = get_cpuset_pidlist(TTORQUECPUSET_PATH, pids);
+#endif
+  for (pp = pids; pp != NULL; pp = pp->next)
+    sample_pids.push_back(pp->pid);
 
-#ifdef PENABLE_LINUX26_CPUSETS
   free_pidlist(pids);
+#else
+  if (sampler->list_pids(sample_pids) != PBSE_NONE)
+    return(PBSE_SYSTEM);
 #endif
 
+  if (load_proc_array(sample_pids) != PBSE_NONE)
+    return(PBSE_SYSTEM);
+
   if (LOGLEVEL >= 6)
     {
     sprintf(log_buffer, "proc_array loaded - nproc=%d",
@@ -2316,6 +2468,8 @@ int mom_get_sample(void)
     /* If we get to here the proc_array entry does not belong to a current job */
     }
 
+  sampler->mark_job_procs(pid2jobsid_map);
+
   return(PBSE_NONE);
   }  /* END mom_get_sample() */
 
@@ -3102,6 +3256,12 @@ int mom_close_poll(void)
     max_proc = TBL_INC;
     }
 
+  if (sampler != NULL)
+    {
+    delete sampler;
+    sampler = NULL;
+    }
+
   return(PBSE_NONE);
   }  /* END mom_close_poll() */
 
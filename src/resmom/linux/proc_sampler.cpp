@@ -0,0 +1,492 @@
+/*
+*         OpenPBS (Portable Batch System) v2.3 Software License
+*
+* Copyright (c) 1999-2000 Veridian Information Solutions, Inc.
+* All rights reserved.
+*
+* ---------------------------------------------------------------------------
+* For a license to use or redistribute the OpenPBS software under conditions
+* other than those described below, or to purchase support for this software,
+* please contact Veridian Systems, PBS Products Department ("Licensor") at:
+*
+*    www.OpenPBS.org  +1 650 967-4675                  sales@OpenPBS.org
+*                        877 902-4PBS (US toll-free)
+* ---------------------------------------------------------------------------
+*
+* This license covers use of the OpenPBS v2.3 software (the "Software") at
+* your site or location, and, for certain users, redistribution of the
+* Software to other sites and locations.  Use and redistribution of
+* OpenPBS v2.3 in source and binary forms, with or without modification,
+* are permitted provided that all of the following conditions are met.
+* After December 31, 2001, only conditions 3-6 must be met:
+*
+* 1. Commercial and/or non-commercial use of the Software is permitted
+*    provided a current software registration is on file at www.OpenPBS.org.
+*    If use of this software contributes to a publication, product, or
+*    service, proper attribution must be given; see www.OpenPBS.org/credit.html
+*
+* 2. Redistribution in any form is only permitted for non-commercial,
+*    non-profit purposes.  There can be no charge for the Software or any
+*    software incorporating the Software.  Further, there can be no
+*    expectation of revenue generated as a consequence of redistributing
+*    the Software.
+*
+* 3. Any Redistribution of source code must retain the above copyright notice
+*    and the acknowledgment contained in paragraph 6, this list of conditions
+*    and the disclaimer contained in paragraph 7.
+*
+* 4. Any Redistribution in binary form must reproduce the above copyright
+*    notice and the acknowledgment contained in paragraph 6, this list of
+*    conditions and the disclaimer contained in paragraph 7 in the
+*    documentation and/or other materials provided with the distribution.
+*
+* 5. Redistributions in any form must be accompanied by information on how to
+*    obtain complete source code for the OpenPBS software and any
+*    modifications and/or additions to the OpenPBS software.  The source code
+*    must either be included in the distribution or be available for no more
+*    than the cost of distribution plus a nominal fee, and all modifications
+*    and additions to the Software must be freely redistributable by any party
+*    (including Licensor) without restriction.
+*
+* 6. All advertising materials mentioning features or use of the Software must
+*    display the following acknowledgment:
+*
+*     "This product includes software developed by NASA Ames Research Center,
+*     Lawrence Livermore National Laboratory, and Veridian Information
+*     Solutions, Inc.
+*     Visit www.OpenPBS.org for OpenPBS software support,
+*     products, and information."
+*
+* 7. DISCLAIMER OF WARRANTY
+*
+* THIS SOFTWARE IS PROVIDED "AS IS" WITHOUT WARRANTY OF ANY KIND. ANY EXPRESS
+* OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+* OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE, AND NON-INFRINGEMENT
+* ARE EXPRESSLY DISCLAIMED.
+*
+* IN NO EVENT SHALL VERIDIAN CORPORATION, ITS AFFILIATED COMPANIES, OR THE
+* U.S. GOVERNMENT OR ANY OF ITS AGENCIES BE LIABLE FOR ANY DIRECT OR INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+* OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+* LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+* EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* This license will be governed by the laws of the Commonwealth of Virginia,
+* without reference to its choice of law rules.
+*/
+
+#include <pbs_config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+#include "pbs_error.h"
+#include "log.h"
+#include "proc_sampler.hpp"
+
+extern int populate_stats_from_the_buffer(char *buffer, proc_stat_t &ps, char *path, int path_size);
+
+
+
+proc_sampler::proc_sampler(
+
+  const char *root) : proc_root(root), proc_fd(-1), proc_dir(NULL), polls(0), stats_read(0)
+
+  {
+  } /* END constructor */
+
+
+
+proc_sampler::~proc_sampler()
+
+  {
+  /* proc_dir owns proc_fd once it's open */
+  if (this->proc_dir != NULL)
+    closedir(this->proc_dir);
+  else if (this->proc_fd >= 0)
+    close(this->proc_fd);
+  } /* END destructor */
+
+
+
+/*
+ * list_pids()
+ *
+ * fills pids with every process listed in /proc. The /proc descriptor is
+ * opened the first time and kept.
+ *
+ * @return PBSE_NONE on success, PBSE_SYSTEM if /proc can't be opened
+ */
+
+int proc_sampler::list_pids(
+
+  std::vector<pid_t> &pids)
+
+  {
+  struct dirent *dent;
+
+  pids.clear();
+
+  if (this->proc_dir == NULL)
+    {
+    if ((this->proc_fd < 0) &&
+        ((this->proc_fd = open(this->proc_root.c_str(), O_RDONLY | O_DIRECTORY)) < 0))
+      return(PBSE_SYSTEM);
+
+    if ((this->proc_dir = fdopendir(this->proc_fd)) == NULL)
+      return(PBSE_SYSTEM);
+    }
+
+  rewinddir(this->proc_dir);
+
+  while ((dent = readdir(this->proc_dir)) != NULL)
+    {
+    if (!isdigit(dent->d_name[0]))
+      continue;
+
+    pids.push_back(atoi(dent->d_name));
+    }
+
+  return(PBSE_NONE);
+  } /* END list_pids() */
+
+
+
+/*
+ * read_proc()
+ *
+ * reads /proc/<pid>/stat into sp. Only sp is written, so different entries
+ * can be read at the same time.
+ *
+ * @return PBSE_NONE on success, PBSE_SYSTEM with sp.read_errno set otherwise
+ */
+
+int proc_sampler::read_proc(
+
+  sampled_proc &sp,
+  pid_t         pid)
+
+  {
+  char        path[32];
+  char        readbuf[MAXLINE << 2];
+  ssize_t     len;
+  int         fd;
+  struct stat sb;
+
+  sp.valid = false;
+  sp.read_errno = 0;
+
+  snprintf(path, sizeof(path), "%d/stat", (int)pid);
+
+  if ((fd = openat(this->proc_fd, path, O_RDONLY)) < 0)
+    {
+    sp.read_errno = errno;
+    return(PBSE_SYSTEM);
+    }
+
+  if (((len = pread(fd, readbuf, sizeof(readbuf) - 1, 0)) <= 0) ||
+      (fstat(fd, &sb) != 0))
+    {
+    /* a process that exits after it's opened reads as empty or ESRCH */
+    sp.read_errno = (len == 0) ? ESRCH : errno;
+    close(fd);
+    return(PBSE_SYSTEM);
+    }
+
+  close(fd);
+
+  readbuf[len] = '\0';
+
+  if (populate_stats_from_the_buffer(readbuf, sp.ps, sp.name, sizeof(sp.name)) != PBSE_NONE)
+    {
+    sp.read_errno = EINVAL;
+    return(PBSE_SYSTEM);
+    }
+
+  sp.ps.name = sp.name;
+  sp.ps.uid = sb.st_uid;
+  sp.ino = sb.st_ino;
+  sp.valid = true;
+
+  return(PBSE_NONE);
+  } /* END read_proc() */
+
+
+
+typedef struct read_chunk
+  {
+  proc_sampler                                   *sampler;
+  std::vector<std::pair<pid_t, sampled_proc *> > *to_read;
+  size_t                                          start;
+  size_t                                          end;
+  int                                             read;
+  } read_chunk;
+
+
+
+void *read_proc_chunk(
+
+  void *vp)
+
+  {
+  read_chunk *chunk = (read_chunk *)vp;
+
+  for (size_t i = chunk->start; i < chunk->end; i++)
+    {
+    if (chunk->sampler->read_proc(*(*chunk->to_read)[i].second, (*chunk->to_read)[i].first) == PBSE_NONE)
+      chunk->read++;
+    }
+
+  return(NULL);
+  } /* END read_proc_chunk() */
+
+
+
+/*
+ * read_procs()
+ *
+ * reads the entries in to_read, splitting them among up to threads threads.
+ * The calling thread reads the first chunk.
+ */
+
+void proc_sampler::read_procs(
+
+  std::vector<std::pair<pid_t, sampled_proc *> > &to_read,
+  int                                             threads)
+
+  {
+  std::vector<read_chunk> chunks;
+  std::vector<pthread_t>  tids;
+  size_t                  per_chunk;
+  size_t                  start = 0;
+
+  if (threads > MAX_PROC_SAMPLE_THREADS)
+    threads = MAX_PROC_SAMPLE_THREADS;
+
+  if (threads > (int)(to_read.size() / PROC_SAMPLE_MIN_PER_THREAD))
+    threads = to_read.size() / PROC_SAMPLE_MIN_PER_THREAD;
+
+  if (threads < 1)
+    threads = 1;
+
+  /* the first read sets up the clock tick that the others share */
+  if ((threads > 1) &&
+      (this->read_proc(*to_read[0].second, to_read[0].first) == PBSE_NONE))
+    this->stats_read++;
+
+  if (threads > 1)
+    start = 1;
+
+  per_chunk = (to_read.size() - start + threads - 1) / threads;
+
+  chunks.resize(threads);
+  tids.resize(threads);
+
+  for (int i = 0; i < threads; i++)
+    {
+    chunks[i].sampler = this;
+    chunks[i].to_read = &to_read;
+    chunks[i].start = start;
+    chunks[i].end = ((start + per_chunk) < to_read.size()) ? start + per_chunk : to_read.size();
+    chunks[i].read = 0;
+
+    start = chunks[i].end;
+    }
+
+  for (int i = 1; i < threads; i++)
+    {
+    if (pthread_create(&tids[i], NULL, read_proc_chunk, &chunks[i]) != 0)
+      {
+      /* read it here instead */
+      read_proc_chunk(&chunks[i]);
+      tids[i] = 0;
+      }
+    }
+
+  read_proc_chunk(&chunks[0]);
+
+  for (int i = 0; i < threads; i++)
+    {
+    if ((i > 0) &&
+        (tids[i] != 0))
+      pthread_join(tids[i], NULL);
+
+    this->stats_read += chunks[i].read;
+    }
+  } /* END read_procs() */
+
+
+
+/*
+ * is_same_proc()
+ *
+ * @return true if the stat file of pid is still the one sp was read from,
+ * false if the pid was reused, its owner changed, or it's gone
+ */
+
+bool proc_sampler::is_same_proc(
+
+  const sampled_proc &sp,
+  pid_t               pid)
+
+  {
+  char        path[32];
+  struct stat sb;
+
+  snprintf(path, sizeof(path), "%d/stat", (int)pid);
+
+  if (fstatat(this->proc_fd, path, &sb, 0) != 0)
+    return(false);
+
+  return((sb.st_ino == sp.ino) &&
+         (sb.st_uid == sp.ps.uid));
+  } /* END is_same_proc() */
+
+
+
+/*
+ * sample()
+ *
+ * samples the processes in pids. A process is read unless it was seen in
+ * the previous poll, didn't belong to a job then, neither its pid nor its
+ * session is in job_sids, and its stat file is the one read last time.
+ * Processes that aren't in pids any more are dropped.
+ *
+ * @param pids - the processes to sample (I)
+ * @param job_sids - the sessions of the jobs (I)
+ * @param threads - how many threads may read (I)
+ * @param sampled - the processes that could be sampled, in the order of pids (O)
+ * @return PBSE_NONE
+ */
+
+int proc_sampler::sample(
+
+  const std::vector<pid_t>   &pids,
+  const job_pid_set_t        &job_sids,
+  int                         threads,
+  std::vector<proc_stat_t *> &sampled)
+
+  {
+  std::vector<std::pair<pid_t, sampled_proc *> > to_read;
+  bool                                           refresh;
+  char                                           log_buf[LOCAL_LOG_BUF_SIZE];
+
+  sampled.clear();
+  this->stats_read = 0;
+
+  if ((this->proc_fd < 0) &&
+      ((this->proc_fd = open(this->proc_root.c_str(), O_RDONLY | O_DIRECTORY)) < 0))
+    return(PBSE_SYSTEM);
+
+  refresh = ((this->polls % PROC_REFRESH_POLLS) == 0);
+  this->polls++;
+
+  for (size_t i = 0; i < pids.size(); i++)
+    {
+    std::map<pid_t, sampled_proc>::iterator it = this->procs.find(pids[i]);
+
+    if (it == this->procs.end())
+      {
+      sampled_proc sp;
+
+      memset(&sp, 0, sizeof(sp));
+      it = this->procs.insert(std::pair<pid_t, sampled_proc>(pids[i], sp)).first;
+      }
+
+    sampled_proc &sp = it->second;
+
+    /* an entry that's still in the table was seen in the previous poll */
+    if ((refresh == true) ||
+        (sp.valid == false) ||
+        (sp.in_job == true) ||
+        (job_sids.find(pids[i]) != job_sids.end()) ||
+        (job_sids.find(sp.ps.session) != job_sids.end()) ||
+        (this->is_same_proc(sp, pids[i]) == false))
+      to_read.push_back(std::pair<pid_t, sampled_proc *>(pids[i], &sp));
+
+    sp.seen = this->polls;
+    }
+
+  if (to_read.size() > 0)
+    this->read_procs(to_read, threads);
+
+  for (size_t i = 0; i < to_read.size(); i++)
+    {
+    sampled_proc &sp = *to_read[i].second;
+
+    if ((sp.valid == false) &&
+        (sp.read_errno != ENOENT) &&
+        (sp.read_errno != ESRCH))
+      {
+      snprintf(log_buf, sizeof(log_buf), "%d: get_proc_stat", (int)to_read[i].first);
+      log_err(sp.read_errno, __func__, log_buf);
+      }
+    }
+
+  /* drop the processes that are gone and the ones that couldn't be read */
+  for (std::map<pid_t, sampled_proc>::iterator it = this->procs.begin(); it != this->procs.end();)
+    {
+    if ((it->second.seen != this->polls) ||
+        (it->second.valid == false))
+      this->procs.erase(it++);
+    else
+      it++;
+    }
+
+  for (size_t i = 0; i < pids.size(); i++)
+    {
+    std::map<pid_t, sampled_proc>::iterator it = this->procs.find(pids[i]);
+
+    if (it != this->procs.end())
+      sampled.push_back(&it->second.ps);
+    }
+
+  return(PBSE_NONE);
+  } /* END sample() */
+
+
+
+/*
+ * records which processes belonged to a job in this poll, so that the next
+ * poll reads them again
+ */
+
+void proc_sampler::mark_job_procs(
+
+  const pid2jobsid_map_t &job_procs)
+
+  {
+  for (std::map<pid_t, sampled_proc>::iterator it = this->procs.begin(); it != this->procs.end(); it++)
+    it->second.in_job = (job_procs.find(it->first) != job_procs.end());
+  } /* END mark_job_procs() */
+
+
+
+/*
+ * @return the number of stat files read in the last sample
+ */
+
+int proc_sampler::get_stats_read() const
+
+  {
+  return(this->stats_read);
+  } /* END get_stats_read() */
+
+
+
+int proc_sampler::size() const
+
+  {
+  return(this->procs.size());
+  } /* END size() */
+
+/* END proc_sampler.cpp */
@@ -0,0 +1,9 @@
+#include "license_pbs.h" /* See here for the software license */
+#include <stdlib.h>
+#include <stdio.h> /* fprintf */
+
+int LOGLEVEL = 10;
+int use_cgroup_accounting = 1;
+
+void log_err(int errnum, const char *routine, const char *text) {}
+void log_record(int eventtype, int objclass, const char *objname, const char *text) {}
@@ -0,0 +1,242 @@
+#include "license_pbs.h" /* See here for the software license */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <string>
+#include <vector>
+
+#include "pbs_cgroup.h"
+#include "pbs_error.h"
+#include "test_uut.h"
+
+#define JOBID "1.napali"
+
+extern int kill_job_cgroup_procs(const char *jobid);
+
+
+void put_file(
+
+  std::string path,
+  const char *contents)
+
+  {
+  FILE *fp = fopen(path.c_str(), "w");
+
+  fputs(contents, fp);
+  fclose(fp);
+  }
+
+
+std::string get_file(
+
+  std::string path)
+
+  {
+  char  buf[1024];
+  FILE *fp = fopen(path.c_str(), "r");
+
+  buf[0] = '\0';
+
+  if (fgets(buf, sizeof(buf), fp) == NULL)
+    buf[0] = '\0';
+
+  fclose(fp);
+
+  return(buf);
+  }
+
+
+START_TEST(test_cgroup_v2)
+  {
+  char               root_template[] = "/tmp/cgroupXXXXXX";
+  std::string        root(mkdtemp(root_template));
+  std::string        job_dir = root + "/" TORQUE_CGROUP "/" JOBID;
+  std::vector<pid_t> pids;
+  cgroup_usage       usage;
+  struct stat        sb;
+
+  put_file(root + "/cgroup.controllers", "cpu memory");
+  put_file(root + "/cgroup.subtree_control", "");
+
+  fail_unless(init_job_cgroups(root.c_str()) == PBSE_NONE);
+  fail_unless(cgroup_version == CGROUP_V2);
+  fail_unless(job_cgroups_active() == true);
+  fail_unless(get_file(root + "/cgroup.subtree_control") == "+memory");
+
+  fail_unless(get_job_cgroup_pids(JOBID, pids) != PBSE_NONE);
+  fail_unless(create_job_cgroup(JOBID) == PBSE_NONE);
+  fail_unless(stat(job_dir.c_str(), &sb) == 0);
+
+  put_file(job_dir + "/cgroup.procs", "");
+  fail_unless(move_to_job_cgroup(4321, JOBID) == PBSE_NONE);
+  fail_unless(get_file(job_dir + "/cgroup.procs") == "4321");
+
+  put_file(job_dir + "/cgroup.procs", "4321\n4322\n4330\n");
+  put_file(job_dir + "/cpu.stat", "usage_usec 12500000\nuser_usec 10000000\nsystem_usec 2500000\n");
+  put_file(job_dir + "/memory.current", "4096000\n");
+
+  fail_unless(get_job_cgroup_pids(JOBID, pids) == PBSE_NONE);
+  fail_unless(pids.size() == 3);
+  fail_unless(pids[2] == 4330);
+
+  /* memory.stat is only there with the memory controller */
+  pids.clear();
+  fail_unless(read_job_cgroup_usage(JOBID, usage, pids) == PBSE_NONE);
+  fail_unless(usage.cput_usec == 12500000);
+  fail_unless(usage.mem == 4096000);
+  fail_unless(usage.nprocs == 3);
+  fail_unless(pids.size() == 3);
+
+  /* page cache isn't resident memory of the job */
+  put_file(job_dir + "/memory.stat", "anon 3000000\nfile 1000000\nfile_mapped 50000\n");
+  fail_unless(read_job_cgroup_usage(JOBID, usage, pids) == PBSE_NONE);
+  fail_unless(usage.mem == 3096000);
+
+  /* the kernel removes the files with the directory */
+  unlink((job_dir + "/cgroup.procs").c_str());
+  unlink((job_dir + "/cpu.stat").c_str());
+  unlink((job_dir + "/memory.current").c_str());
+  unlink((job_dir + "/memory.stat").c_str());
+  fail_unless(delete_job_cgroup(JOBID) == PBSE_NONE);
+  fail_unless(stat(job_dir.c_str(), &sb) != 0);
+  fail_unless(read_job_cgroup_usage(JOBID, usage, pids) != PBSE_NONE);
+  fail_unless(delete_job_cgroup(JOBID) == PBSE_NONE);
+
+  unlink((root + "/cgroup.controllers").c_str());
+  unlink((root + "/cgroup.subtree_control").c_str());
+  unlink((root + "/" TORQUE_CGROUP "/cgroup.subtree_control").c_str());
+  rmdir((root + "/" TORQUE_CGROUP).c_str());
+  rmdir(root.c_str());
+  }
+END_TEST
+
+
+START_TEST(test_cgroup_v1)
+  {
+  char               root_template[] = "/tmp/cgroupXXXXXX";
+  std::string        root(mkdtemp(root_template));
+  std::string        cpu_dir = root + "/cpuacct/" TORQUE_CGROUP "/" JOBID;
+  std::string        mem_dir = root + "/memory/" TORQUE_CGROUP "/" JOBID;
+  cgroup_usage       usage;
+  std::vector<pid_t> pids;
+
+  /* both hierarchies are needed */
+  mkdir((root + "/cpuacct").c_str(), 0755);
+  fail_unless(init_job_cgroups(root.c_str()) != PBSE_NONE);
+  fail_unless(cgroup_version == CGROUP_NONE);
+  fail_unless(job_cgroups_active() == false);
+  fail_unless(create_job_cgroup(JOBID) != PBSE_NONE);
+
+  mkdir((root + "/memory").c_str(), 0755);
+  fail_unless(init_job_cgroups(root.c_str()) == PBSE_NONE);
+  fail_unless(cgroup_version == CGROUP_V1);
+  fail_unless(create_job_cgroup(JOBID) == PBSE_NONE);
+
+  put_file(cpu_dir + "/cgroup.procs", "77\n");
+  put_file(cpu_dir + "/cpuacct.usage", "3000000000\n");
+  put_file(mem_dir + "/memory.usage_in_bytes", "1024\n");
+  put_file(mem_dir + "/memory.stat", "cache 100\nrss 900\ntotal_cache 200\ntotal_rss 824\n");
+
+  fail_unless(read_job_cgroup_usage(JOBID, usage, pids) == PBSE_NONE);
+  fail_unless(usage.cput_usec == 3000000);
+  fail_unless(usage.mem == 824);
+  fail_unless(usage.nprocs == 1);
+
+  unlink((cpu_dir + "/cgroup.procs").c_str());
+  unlink((cpu_dir + "/cpuacct.usage").c_str());
+  unlink((mem_dir + "/memory.usage_in_bytes").c_str());
+  unlink((mem_dir + "/memory.stat").c_str());
+  fail_unless(delete_job_cgroup(JOBID) == PBSE_NONE);
+
+  rmdir((root + "/cpuacct/" TORQUE_CGROUP).c_str());
+  rmdir((root + "/memory/" TORQUE_CGROUP).c_str());
+  rmdir((root + "/cpuacct").c_str());
+  rmdir((root + "/memory").c_str());
+  rmdir(root.c_str());
+  }
+END_TEST
+
+
+START_TEST(test_kill_job_cgroup_procs)
+  {
+  char               root_template[] = "/tmp/cgroupXXXXXX";
+  std::string        root(mkdtemp(root_template));
+  std::string        job_dir = root + "/" TORQUE_CGROUP "/" JOBID;
+  char               pid_str[32];
+  int                status;
+  pid_t              child;
+
+  put_file(root + "/cgroup.controllers", "cpu memory");
+  put_file(root + "/cgroup.subtree_control", "");
+
+  fail_unless(init_job_cgroups(root.c_str()) == PBSE_NONE);
+  fail_unless(create_job_cgroup(JOBID) == PBSE_NONE);
+
+  put_file(job_dir + "/cgroup.procs", "");
+  fail_unless(kill_job_cgroup_procs(JOBID) == 0);
+
+  /* a process that escaped the job's sessions */
+  if ((child = fork()) == 0)
+    {
+    pause();
+    exit(0);
+    }
+
+  snprintf(pid_str, sizeof(pid_str), "%d\n", (int)child);
+  put_file(job_dir + "/cgroup.procs", pid_str);
+
+  fail_unless(kill_job_cgroup_procs(JOBID) == 1);
+  fail_unless(waitpid(child, &status, 0) == child);
+  fail_unless(WIFSIGNALED(status));
+  fail_unless(WTERMSIG(status) == SIGKILL);
+
+  unlink((job_dir + "/cgroup.procs").c_str());
+  fail_unless(delete_job_cgroup(JOBID) == PBSE_NONE);
+
+  unlink((root + "/cgroup.controllers").c_str());
+  unlink((root + "/cgroup.subtree_control").c_str());
+  unlink((root + "/" TORQUE_CGROUP "/cgroup.subtree_control").c_str());
+  rmdir((root + "/" TORQUE_CGROUP).c_str());
+  rmdir(root.c_str());
+  }
+END_TEST
+
+
+Suite *cgroup_suite(void)
+  {
+  Suite *s = suite_create("cgroup_suite methods");
+  TCase *tc_core = tcase_create("test_cgroup_v2");
+  tcase_add_test(tc_core, test_cgroup_v2);
+  suite_add_tcase(s, tc_core);
+
+  tc_core = tcase_create("test_cgroup_v1");
+  tcase_add_test(tc_core, test_cgroup_v1);
+  suite_add_tcase(s, tc_core);
+
+  tc_core = tcase_create("test_kill_job_cgroup_procs");
+  tcase_add_test(tc_core, test_kill_job_cgroup_procs);
+  suite_add_tcase(s, tc_core);
+
+  return s;
+  }
+
+void rundebug()
+  {
+  }
+
+int main(void)
+  {
+  int number_failed = 0;
+  SRunner *sr = NULL;
+  rundebug();
+  sr = srunner_create(cgroup_suite());
+  srunner_set_log(sr, "cgroup_suite.log");
+  srunner_run_all(sr, CK_NORMAL);
+  number_failed = srunner_ntests_failed(sr);
+  srunner_free(sr);
+  return number_failed;
+  }
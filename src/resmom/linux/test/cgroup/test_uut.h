@@ -0,0 +1,7 @@
+#ifndef _CGROUP_CT_H
+#define _CGROUP_CT_H
+#include <check.h>
+
+Suite *cgroup_suite();
+
+#endif /* _CGROUP_CT_H */
@@ -13,6 +13,8 @@
 #include "pbs_nodes.h"
 #include "pbs_config.h"
 #include "node_frequency.hpp"
+#include "pbs_cgroup.h"
+#include "proc_sampler.hpp"
 
 
 char log_buffer[LOG_BUF_SIZE];
@@ -145,6 +147,49 @@ pidl *get_cpuset_pidlist(const char *path, pidl *bob)
   return(NULL);
   }
 
+bool job_cgroups_active(void)
+  {
+  return(false);
+  }
+
+int get_job_cgroup_pids(const char *jobid, std::vector<pid_t> &pids)
+  {
+  return(-1);
+  }
+
+int read_job_cgroup_usage(const char *jobid, cgroup_usage &usage, std::vector<pid_t> &pids)
+  {
+  return(-1);
+  }
+
+std::vector<proc_stat_t> sampler_procs;
+
+proc_sampler::proc_sampler(const char *root) {}
+
+proc_sampler::~proc_sampler() {}
+
+int proc_sampler::list_pids(std::vector<pid_t> &pids)
+  {
+  return(0);
+  }
+
+int proc_sampler::sample(const std::vector<pid_t> &pids, const job_pid_set_t &job_sids, int threads, std::vector<proc_stat_t *> &sampled)
+  {
+  sampled.clear();
+
+  for (unsigned int i = 0; i < sampler_procs.size(); i++)
+    sampled.push_back(&sampler_procs[i]);
+
+  return(0);
+  }
+
+void proc_sampler::mark_job_procs(const pid2jobsid_map_t &job_procs) {}
+
+int proc_sampler::get_stats_read() const
+  {
+  return(0);
+  }
+
 bool am_i_mother_superior(const job &pjob)
   {
   return(false);
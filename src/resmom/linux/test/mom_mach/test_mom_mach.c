@@ -6,9 +6,11 @@
 
 #include <map>
 #include <set>
+#include <vector>
 
 #include "pbs_job.h"
 #include "pbs_error.h"
+#include "proc_sampler.hpp"
 
 int get_job_sid_from_pid(int);
 int injob(job*, int);
@@ -17,6 +19,9 @@ int overmem_proc(job*, unsigned long long);
 int overcpu_proc(job*, unsigned long);
 unsigned long long resi_sum(job*);
 unsigned long long mem_sum(job*);
+int get_sample_threads(void);
+int load_proc_array(std::vector<pid_t> &);
+int mom_open_poll(void);
 
 double cputfactor;
 
@@ -27,6 +32,8 @@ pid2jobsid_map_t pid2jobsid_map;
 
 extern pid2procarrayindex_map_t pid2procarrayindex_map;
 extern proc_stat_t   *proc_array;
+extern long           system_ncpus;
+extern std::vector<proc_stat_t> sampler_procs;
 
 extern void *get_next_return_value;
 
@@ -434,6 +441,45 @@ START_TEST(test_mem_sum)
   }
 END_TEST
 
+START_TEST(test_get_sample_threads)
+  {
+  system_ncpus = 0;
+  fail_unless(get_sample_threads() == 1);
+
+  system_ncpus = 64;
+  fail_unless(get_sample_threads() == 2);
+
+  system_ncpus = 1024;
+  fail_unless(get_sample_threads() == MAX_PROC_SAMPLE_THREADS);
+  }
+END_TEST
+
+START_TEST(test_load_proc_array)
+  {
+  std::vector<pid_t> pids;
+
+  fail_unless(mom_open_poll() == PBSE_NONE);
+
+  /* more processes than the initial table holds */
+  sampler_procs.resize(500);
+
+  for (unsigned int i = 0; i < sampler_procs.size(); i++)
+    {
+    sampler_procs[i].pid = 100 + i;
+    sampler_procs[i].session = 100;
+    }
+
+  pid2procarrayindex_map.clear();
+  fail_unless(load_proc_array(pids) == PBSE_NONE);
+  fail_unless(pid2procarrayindex_map.size() == 500);
+  fail_unless(pid2procarrayindex_map[599] == 499);
+  fail_unless(proc_array[499].pid == 599);
+  fail_unless(proc_array[0].pid == 100);
+
+  sampler_procs.clear();
+  }
+END_TEST
+
 Suite *mom_mach_suite(void)
   {
   Suite *s = suite_create("mom_mach_suite methods");
@@ -465,6 +511,14 @@ Suite *mom_mach_suite(void)
   tcase_add_test(tc_core, test_mem_sum);
   suite_add_tcase(s, tc_core);
 
+  tc_core = tcase_create("test_get_sample_threads");
+  tcase_add_test(tc_core, test_get_sample_threads);
+  suite_add_tcase(s, tc_core);
+
+  tc_core = tcase_create("test_load_proc_array");
+  tcase_add_test(tc_core, test_load_proc_array);
+  suite_add_tcase(s, tc_core);
+
   return s;
   }
 
@@ -0,0 +1,44 @@
+#include "license_pbs.h" /* See here for the software license */
+#include <stdlib.h>
+#include <stdio.h> /* fprintf */
+#include <string.h>
+
+#include "mom_mach.h"
+#include "pbs_error.h"
+
+int LOGLEVEL = 10;
+int log_err_count = 0;
+
+void log_err(int errnum, const char *routine, const char *text)
+  {
+  log_err_count++;
+  }
+
+void log_record(int eventtype, int objclass, const char *objname, const char *text) {}
+
+int populate_stats_from_the_buffer(
+
+  char        *buffer,
+  proc_stat_t &ps,
+  char        *path,
+  int          path_size)
+
+  {
+  char *lastbracket = strrchr(buffer, ')');
+  char *name = strchr(buffer, '(');
+
+  if ((lastbracket == NULL) ||
+      (name == NULL))
+    return(-1);
+
+  *lastbracket = '\0';
+  snprintf(path, path_size, "%s", name + 1);
+
+  ps.pid = atoi(buffer);
+
+  if (sscanf(lastbracket + 1, " %c %d %d %d %*d %*d %u %*u %*u %*u %*u %lu %lu",
+        &ps.state, &ps.ppid, &ps.pgrp, &ps.session, &ps.flags, &ps.utime, &ps.stime) != 7)
+    return(-1);
+
+  return(PBSE_NONE);
+  }
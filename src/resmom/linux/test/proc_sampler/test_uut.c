@@ -0,0 +1,389 @@
+#include "license_pbs.h" /* See here for the software license */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <string>
+#include <vector>
+#include <set>
+
+#include "proc_sampler.hpp"
+#include "pbs_error.h"
+#include "test_uut.h"
+
+extern int log_err_count;
+
+
+void write_stat(
+
+  const std::string &root,
+  pid_t              pid,
+  int                session,
+  unsigned long      utime)
+
+  {
+  char  path[1024];
+  FILE *fp;
+
+  snprintf(path, sizeof(path), "%s/%d", root.c_str(), (int)pid);
+  mkdir(path, 0755);
+  snprintf(path, sizeof(path), "%s/%d/stat", root.c_str(), (int)pid);
+
+  fp = fopen(path, "w");
+  fprintf(fp, "%d (a.out) S 1 %d %d 0 -1 4202496 0 0 0 0 %lu 0 0 0 20 0 1 0 100 1000 10\n",
+    (int)pid, session, session, utime);
+  fclose(fp);
+  }
+
+
+/* a new process with the same pid gets a new stat file */
+void replace_stat(
+
+  const std::string &root,
+  pid_t              pid,
+  int                session,
+  unsigned long      utime)
+
+  {
+  char path[1024];
+  char tmp[1024];
+
+  write_stat(root, pid + 100000, session, utime);
+
+  snprintf(tmp, sizeof(tmp), "%s/%d/stat", root.c_str(), (int)pid + 100000);
+  snprintf(path, sizeof(path), "%s/%d/stat", root.c_str(), (int)pid);
+  rename(tmp, path);
+
+  snprintf(tmp, sizeof(tmp), "%s/%d", root.c_str(), (int)pid + 100000);
+  rmdir(tmp);
+  }
+
+
+void remove_stat(
+
+  const std::string &root,
+  pid_t              pid)
+
+  {
+  char path[1024];
+
+  snprintf(path, sizeof(path), "%s/%d/stat", root.c_str(), (int)pid);
+  unlink(path);
+  snprintf(path, sizeof(path), "%s/%d", root.c_str(), (int)pid);
+  rmdir(path);
+  }
+
+
+proc_stat_t *find_sampled(
+
+  std::vector<proc_stat_t *> &sampled,
+  pid_t                       pid)
+
+  {
+  for (unsigned int i = 0; i < sampled.size(); i++)
+    if (sampled[i]->pid == pid)
+      return(sampled[i]);
+
+  return(NULL);
+  }
+
+
+START_TEST(test_list_pids)
+  {
+  char               root_template[] = "/tmp/procXXXXXX";
+  std::string        root(mkdtemp(root_template));
+  std::vector<pid_t> pids;
+
+  write_stat(root, 100, 100, 0);
+  write_stat(root, 200, 200, 0);
+  mkdir((root + "/self").c_str(), 0755);
+
+  proc_sampler ps(root.c_str());
+
+  fail_unless(ps.list_pids(pids) == PBSE_NONE);
+  fail_unless(pids.size() == 2);
+
+  remove_stat(root, 200);
+  fail_unless(ps.list_pids(pids) == PBSE_NONE);
+  fail_unless(pids.size() == 1);
+  fail_unless(pids[0] == 100);
+
+  proc_sampler missing("/nonexistent/proc");
+  fail_unless(missing.list_pids(pids) != PBSE_NONE);
+
+  remove_stat(root, 100);
+  rmdir((root + "/self").c_str());
+  rmdir(root.c_str());
+  }
+END_TEST
+
+
+START_TEST(test_sample_skips_non_job_procs)
+  {
+  char                       root_template[] = "/tmp/procXXXXXX";
+  std::string                root(mkdtemp(root_template));
+  std::vector<pid_t>         pids;
+  std::vector<proc_stat_t *> sampled;
+  job_pid_set_t              job_sids;
+  pid2jobsid_map_t           job_procs;
+  proc_stat_t               *ps;
+
+  write_stat(root, 100, 100, 5);
+  write_stat(root, 200, 200, 5);
+  write_stat(root, 201, 200, 5);
+  job_sids.insert(200);
+
+  proc_sampler sampler(root.c_str());
+
+  /* everything is read the first time */
+  fail_unless(sampler.list_pids(pids) == PBSE_NONE);
+  fail_unless(sampler.sample(pids, job_sids, 1, sampled) == PBSE_NONE);
+  fail_unless(sampled.size() == 3);
+  fail_unless(sampler.get_stats_read() == 3);
+  fail_unless((ps = find_sampled(sampled, 201)) != NULL);
+  fail_unless(ps->session == 200);
+  fail_unless(!strcmp(ps->name, "a.out"));
+
+  job_procs[200] = 200;
+  job_procs[201] = 200;
+  sampler.mark_job_procs(job_procs);
+
+  /* only the job's processes are read again */
+  write_stat(root, 100, 100, 50);
+  write_stat(root, 201, 200, 50);
+  fail_unless(sampler.list_pids(pids) == PBSE_NONE);
+  fail_unless(sampler.sample(pids, job_sids, 1, sampled) == PBSE_NONE);
+  fail_unless(sampled.size() == 3);
+  fail_unless(sampler.get_stats_read() == 2);
+  fail_unless(find_sampled(sampled, 100)->utime == 5);
+  fail_unless(find_sampled(sampled, 201)->utime == 50);
+
+  /* a process that became a job's session leader is read again */
+  job_sids.insert(100);
+  fail_unless(sampler.sample(pids, job_sids, 1, sampled) == PBSE_NONE);
+  fail_unless(sampler.get_stats_read() == 3);
+  fail_unless(find_sampled(sampled, 100)->utime == 50);
+  job_sids.erase(100);
+
+  /* processes that are gone are dropped */
+  remove_stat(root, 201);
+  fail_unless(sampler.list_pids(pids) == PBSE_NONE);
+  fail_unless(sampler.sample(pids, job_sids, 1, sampled) == PBSE_NONE);
+  fail_unless(sampled.size() == 2);
+  fail_unless(sampler.size() == 2);
+  fail_unless(find_sampled(sampled, 201) == NULL);
+
+  /* one that exits between the listing and the read isn't an error */
+  log_err_count = 0;
+  pids.push_back(999);
+  fail_unless(sampler.sample(pids, job_sids, 1, sampled) == PBSE_NONE);
+  fail_unless(sampled.size() == 2);
+  fail_unless(sampler.size() == 2);
+  fail_unless(log_err_count == 0);
+
+  remove_stat(root, 100);
+  remove_stat(root, 200);
+  rmdir(root.c_str());
+  }
+END_TEST
+
+
+START_TEST(test_sample_refresh)
+  {
+  char                       root_template[] = "/tmp/procXXXXXX";
+  std::string                root(mkdtemp(root_template));
+  std::vector<pid_t>         pids;
+  std::vector<proc_stat_t *> sampled;
+  job_pid_set_t              job_sids;
+
+  write_stat(root, 100, 100, 5);
+
+  proc_sampler sampler(root.c_str());
+
+  fail_unless(sampler.list_pids(pids) == PBSE_NONE);
+
+  /* a reused pid is caught by the periodic refresh */
+  for (int i = 0; i < PROC_REFRESH_POLLS; i++)
+    {
+    fail_unless(sampler.sample(pids, job_sids, 1, sampled) == PBSE_NONE);
+    fail_unless(sampler.get_stats_read() == ((i == 0) ? 1 : 0));
+    }
+
+  write_stat(root, 100, 4000, 5);
+  fail_unless(sampler.sample(pids, job_sids, 1, sampled) == PBSE_NONE);
+  fail_unless(sampler.get_stats_read() == 1);
+  fail_unless(sampled[0]->session == 4000);
+
+  remove_stat(root, 100);
+  rmdir(root.c_str());
+  }
+END_TEST
+
+
+START_TEST(test_sample_reused_pid)
+  {
+  char                       root_template[] = "/tmp/procXXXXXX";
+  std::string                root(mkdtemp(root_template));
+  std::vector<pid_t>         pids;
+  std::vector<proc_stat_t *> sampled;
+  job_pid_set_t              job_sids;
+
+  write_stat(root, 100, 100, 5);
+
+  proc_sampler sampler(root.c_str());
+
+  fail_unless(sampler.list_pids(pids) == PBSE_NONE);
+  fail_unless(sampler.sample(pids, job_sids, 1, sampled) == PBSE_NONE);
+  fail_unless(sampler.sample(pids, job_sids, 1, sampled) == PBSE_NONE);
+  fail_unless(sampler.get_stats_read() == 0);
+
+  /* the pid now belongs to another process, which is read right away */
+  replace_stat(root, 100, 4000, 7);
+  fail_unless(sampler.sample(pids, job_sids, 1, sampled) == PBSE_NONE);
+  fail_unless(sampler.get_stats_read() == 1);
+  fail_unless(sampled[0]->session == 4000);
+  fail_unless(sampled[0]->utime == 7);
+
+  fail_unless(sampler.sample(pids, job_sids, 1, sampled) == PBSE_NONE);
+  fail_unless(sampler.get_stats_read() == 0);
+
+  remove_stat(root, 100);
+  rmdir(root.c_str());
+  }
+END_TEST
+
+
+START_TEST(test_sample_threads)
+  {
+  char                       root_template[] = "/tmp/procXXXXXX";
+  std::string                root(mkdtemp(root_template));
+  std::vector<pid_t>         pids;
+  std::vector<proc_stat_t *> sampled;
+  std::vector<proc_stat_t *> serial;
+  job_pid_set_t              job_sids;
+  int                        count = PROC_SAMPLE_MIN_PER_THREAD * 3 + 7;
+
+  for (int i = 0; i < count; i++)
+    write_stat(root, 1000 + i, 1000 + i, i);
+
+  proc_sampler threaded(root.c_str());
+  proc_sampler single(root.c_str());
+
+  fail_unless(threaded.list_pids(pids) == PBSE_NONE);
+  fail_unless(threaded.sample(pids, job_sids, 4, sampled) == PBSE_NONE);
+  fail_unless(single.sample(pids, job_sids, 1, serial) == PBSE_NONE);
+
+  fail_unless((int)sampled.size() == count);
+  fail_unless(threaded.get_stats_read() == count);
+
+  for (int i = 0; i < count; i++)
+    {
+    fail_unless(sampled[i]->pid == serial[i]->pid);
+    fail_unless(sampled[i]->utime == serial[i]->utime);
+    fail_unless(sampled[i]->utime == (unsigned long)(sampled[i]->pid - 1000));
+    }
+
+  for (int i = 0; i < count; i++)
+    remove_stat(root, 1000 + i);
+
+  rmdir(root.c_str());
+  }
+END_TEST
+
+
+START_TEST(test_sample_proc)
+  {
+  std::vector<pid_t>         pids;
+  std::vector<pid_t>         children;
+  std::vector<proc_stat_t *> sampled;
+  job_pid_set_t              job_sids;
+  proc_stat_t               *ps;
+
+  for (int i = 0; i < 20; i++)
+    {
+    pid_t pid = fork();
+
+    if (pid == 0)
+      {
+      setsid();
+      pause();
+      exit(0);
+      }
+
+    children.push_back(pid);
+    job_sids.insert(pid);
+    }
+
+  /* let the children call setsid() */
+  sleep(1);
+
+  proc_sampler sampler("/proc");
+
+  fail_unless(sampler.list_pids(pids) == PBSE_NONE);
+  fail_unless(sampler.sample(pids, job_sids, 1, sampled) == PBSE_NONE);
+  fail_unless((ps = find_sampled(sampled, getpid())) != NULL);
+  fail_unless(ps->uid == getuid());
+
+  for (unsigned int i = 0; i < children.size(); i++)
+    {
+    fail_unless((ps = find_sampled(sampled, children[i])) != NULL);
+    fail_unless(ps->session == children[i]);
+    fail_unless(ps->ppid == getpid());
+    }
+
+  for (unsigned int i = 0; i < children.size(); i++)
+    {
+    kill(children[i], SIGKILL);
+    waitpid(children[i], NULL, 0);
+    }
+  }
+END_TEST
+
+
+Suite *proc_sampler_suite(void)
+  {
+  Suite *s = suite_create("proc_sampler_suite methods");
+  TCase *tc_core = tcase_create("test_list_pids");
+  tcase_add_test(tc_core, test_list_pids);
+  suite_add_tcase(s, tc_core);
+
+  tc_core = tcase_create("test_sample_skips_non_job_procs");
+  tcase_add_test(tc_core, test_sample_skips_non_job_procs);
+  suite_add_tcase(s, tc_core);
+
+  tc_core = tcase_create("test_sample_refresh");
+  tcase_add_test(tc_core, test_sample_refresh);
+  tcase_add_test(tc_core, test_sample_reused_pid);
+  suite_add_tcase(s, tc_core);
+
+  tc_core = tcase_create("test_sample_threads");
+  tcase_add_test(tc_core, test_sample_threads);
+  tcase_set_timeout(tc_core, 30);
+  suite_add_tcase(s, tc_core);
+
+  tc_core = tcase_create("test_sample_proc");
+  tcase_add_test(tc_core, test_sample_proc);
+  suite_add_tcase(s, tc_core);
+
+  return s;
+  }
+
+void rundebug()
+  {
+  }
+
+int main(void)
+  {
+  int number_failed = 0;
+  SRunner *sr = NULL;
+  rundebug();
+  sr = srunner_create(proc_sampler_suite());
+  srunner_set_log(sr, "proc_sampler_suite.log");
+  srunner_run_all(sr, CK_NORMAL);
+  number_failed = srunner_ntests_failed(sr);
+  srunner_free(sr);
+  return number_failed;
+  }
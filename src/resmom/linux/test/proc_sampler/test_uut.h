@@ -0,0 +1,7 @@
+#ifndef _PROC_SAMPLER_CT_H
+#define _PROC_SAMPLER_CT_H
+#include <check.h>
+
+Suite *proc_sampler_suite();
+
+#endif /* _PROC_SAMPLER_CT_H */
@@ -132,6 +132,7 @@
 #include "pbs_cpuset.h"
 #endif
 #include "mom_config.h"
+#include "mom_hierarchy.h" /* unpack_status_frame */
 #include <string>
 #include <vector>
 #include "container.hpp"
@@ -166,6 +167,8 @@ unsigned long        ssa_size;
 container::item_container<received_node *> received_statuses; /* holds information on node's whose statuses we've received */
 int                  updates_waiting_to_send = 0;
 extern struct connection svr_conn[];
+
+std::map<std::string, sister_join> sister_joins;
 extern bool          ForceServerUpdate;
 extern int         use_nvidia_gpu;
 
@@ -2216,6 +2219,317 @@ int reply_to_join_job_as_sister(
 
 
 
+/*
+ * finish_join_job_as_sister()
+ *
+ * Completes a sister join once the prologues have run: sets up the radix
+ * tree, links the job and sends the join reply to the sender.
+ *
+ * @return PBSE_NONE, or an error if the job should be purged
+ */
+
+int finish_join_job_as_sister(
+
+  job         *pjob,
+  sister_join &sj)
+
+  {
+  hnodent        *np;
+  char           *radix_hosts = NULL;
+  char           *radix_ports = NULL;
+  char           *cookie = (char *)sj.cookie.c_str();
+  unsigned short  momport = 0;
+
+#if IBM_SP2==2  /* IBM SP with PSSP 3.1 */
+
+  if (load_sp_switch(pjob) != 0)
+    {
+    send_im_error(PBSE_SYSTEM,1,pjob,cookie,sj.event,sj.fromtask);
+
+    log_err(-1, __func__, "cannot load sp switch table");
+
+    return(PBSE_SYSTEM);
+    }
+
+#endif /* IBM SP */
+
+  if (multi_mom)
+    {
+    momport = pbs_rm_port;
+    }
+
+  job_save(pjob, SAVEJOB_FULL, momport);
+
+  sprintf(log_buffer, "JOIN JOB as node %d",
+    sj.nodeid);
+
+  log_record(PBSEVENT_JOB,PBS_EVENTCLASS_JOB,pjob->ji_qs.ji_jobid,log_buffer);
+
+  if (sj.job_radix == TRUE)
+    {
+    radix_hosts = strdup(sj.radix_hosts.c_str());
+    radix_ports = strdup(sj.radix_ports.c_str());
+
+    if ((radix_hosts == NULL) ||
+        (radix_ports == NULL))
+      {
+      if (radix_hosts != NULL)
+        free(radix_hosts);
+
+      if (radix_ports != NULL)
+        free(radix_ports);
+
+      send_im_error(PBSE_SYSTEM,1,pjob,cookie,sj.event,sj.fromtask);
+
+      return(PBSE_SYSTEM);
+      }
+    }
+
+  if ((sj.job_radix == TRUE) &&
+      (sj.sister_count > 2))
+    {
+    /* handle the case where we're contacting multiple nodes */
+    if ((pjob->ji_wattr[JOB_ATR_job_radix].at_flags & ATR_VFLAG_SET) &&
+        (pjob->ji_wattr[JOB_ATR_job_radix].at_val.at_long != 0))
+      {
+      pjob->ji_radix = pjob->ji_wattr[JOB_ATR_job_radix].at_val.at_long;
+      }
+
+    pjob->ji_im_nodeid = 1; /* this will identify us as an intermediate node later */
+
+    if (allocate_demux_sockets(pjob, INTERMEDIATE_MOM))
+      {
+      free(radix_hosts);
+      free(radix_ports);
+      return(PBSE_NONE);
+      }
+
+    contact_sisters(pjob,sj.event,sj.sister_count,radix_hosts,radix_ports);
+    pjob->ji_intermediate_join_event = sj.event;
+    job_save(pjob,SAVEJOB_FULL,momport);
+
+    free(radix_ports);
+    free(radix_hosts);
+
+    return(PBSE_NONE);
+    }
+  else
+    {
+    unsigned short  af_family;
+    char           *host_addr = NULL;
+    int             addr_len;
+    int             local_errno;
+
+    /* handle the single contact case */
+    if (sj.job_radix == TRUE)
+      {
+      sister_job_nodes(pjob, radix_hosts, radix_ports);
+      free(radix_ports);
+      radix_ports = NULL;
+
+      np = &pjob->ji_sisters[0];
+      if (np != NULL)
+        {
+        if (get_hostaddr_hostent_af(&local_errno, np->hn_host, &af_family, &host_addr, &addr_len) == PBSE_NONE)
+          {
+          memmove(&np->sock_addr.sin_addr, host_addr, addr_len);
+          free(host_addr);
+          }
+
+        np->sock_addr.sin_port = htons(np->hn_port);
+        np->sock_addr.sin_family = af_family;
+        }
+
+      /* This is a leaf node in the job radix hierarchy. pjob->ji_radix needs to be set to non-zero
+         for later in tm_spawn calls. */
+      pjob->ji_radix = 2;
+      }
+    }
+
+  /*
+   ** if certain resource limits require that the job usage be
+   ** polled, we link the job to mom_polljobs.
+   **
+   ** NOTE: we overload the job field ji_jobque for this as it
+   ** is not used otherwise by MOM
+   */
+  if (mom_do_poll(pjob))
+    append_link(&mom_polljobs, &pjob->ji_jobque, pjob);
+
+  append_link(&svr_alljobs, &pjob->ji_alljobs, pjob);
+
+  /* establish a connection and write the reply back */
+  reply_to_join_job_as_sister(pjob, &sj.addr, cookie, sj.event, sj.fromtask, sj.job_radix);
+
+  if (radix_ports != NULL)
+    free(radix_ports);
+
+  if (radix_hosts != NULL)
+    free(radix_hosts);
+
+  return(PBSE_NONE);
+  } /* END finish_join_job_as_sister() */
+
+
+
+
+/*
+ * post_sister_prologue()
+ *
+ * The ji_mompost routine for the prologue subtask started by
+ * start_sister_prologue(). The job is not purged here because
+ * scan_for_terminated() saves it after we return, a failed join is
+ * left for purge_failed_sister_joins().
+ */
+
+int post_sister_prologue(
+
+  job *pjob,
+  int  ev)
+
+  {
+  std::map<std::string, sister_join>::iterator it = sister_joins.find(pjob->ji_qs.ji_jobid);
+  sister_join                                  *sj;
+
+  if ((it == sister_joins.end()) ||
+      (it->second.subtask != pjob->ji_momsubt))
+    return(0);
+
+  sj = &it->second;
+  sj->subtask = 0;
+
+  /* finish_join_job_as_sister() links the job again when it succeeds */
+  delete_link(&pjob->ji_alljobs);
+
+  if (ev != 0)
+    {
+    snprintf(log_buffer, sizeof(log_buffer),
+      "prologue failed for job %s, exit value %d",
+      pjob->ji_qs.ji_jobid,
+      ev);
+
+    log_err(-1, __func__, log_buffer);
+
+    send_im_error(PBSE_SYSTEM, 1, pjob, (char *)sj->cookie.c_str(), sj->event, sj->fromtask);
+
+    sj->failed = true;
+    }
+  else if (finish_join_job_as_sister(pjob, *sj) != PBSE_NONE)
+    sj->failed = true;
+
+  if (sj->failed == true)
+    {
+    /* keep it where scan_for_terminated() and the purge sweep can find it */
+    append_link(&svr_alljobs, &pjob->ji_alljobs, pjob);
+    }
+  else
+    sister_joins.erase(it);
+
+  return(0);
+  } /* END post_sister_prologue() */
+
+
+
+
+/*
+ * start_sister_prologue()
+ *
+ * Runs the prologues for a sister join in a subtask so the mom keeps
+ * servicing other requests meanwhile. The join reply is sent from
+ * post_sister_prologue(). If the fork fails they are run in line.
+ *
+ * @return PBSE_NONE, or an error if the caller should purge the job
+ */
+
+int start_sister_prologue(
+
+  job         *pjob,
+  sister_join &sj)
+
+  {
+  pid_t cpid;
+
+  cpid = fork_me(-1);
+
+  if (cpid < 0)
+    {
+    log_err(errno, __func__, "fork failed, running the prologues in line");
+
+    if (run_prologue_scripts(pjob) != PBSE_NONE)
+      {
+      send_im_error(PBSE_SYSTEM, 1, pjob, (char *)sj.cookie.c_str(), sj.event, sj.fromtask);
+
+      return(PBSE_SYSTEM);
+      }
+
+    return(finish_join_job_as_sister(pjob, sj));
+    }
+
+  if (cpid == 0)
+    {
+    /* child */
+    exit((run_prologue_scripts(pjob) == PBSE_NONE) ? 0 : 1);
+    }
+
+  /* parent - scan_for_terminated() looks the subtask up in svr_alljobs */
+  append_link(&svr_alljobs, &pjob->ji_alljobs, pjob);
+
+  pjob->ji_momsubt = cpid;
+  pjob->ji_mompost = post_sister_prologue;
+  sj.subtask = cpid;
+
+  if (LOGLEVEL >= 2)
+    {
+    snprintf(log_buffer, sizeof(log_buffer),
+      "prolog subtask created with pid %d - registered post_sister_prologue",
+      cpid);
+
+    log_record(PBSEVENT_DEBUG, PBS_EVENTCLASS_JOB, pjob->ji_qs.ji_jobid, log_buffer);
+    }
+
+  return(PBSE_NONE);
+  } /* END start_sister_prologue() */
+
+
+
+
+/*
+ * purge_failed_sister_joins()
+ *
+ * Called from the main loop: purges the jobs whose join failed in
+ * post_sister_prologue() and drops entries whose job has gone away.
+ */
+
+void purge_failed_sister_joins()
+
+  {
+  std::map<std::string, sister_join>::iterator it = sister_joins.begin();
+  job                                          *pjob;
+
+  while (it != sister_joins.end())
+    {
+    pjob = mom_find_job(it->first.c_str());
+
+    if ((pjob == NULL) ||
+        ((it->second.failed == false) &&
+         (pjob->ji_momsubt != it->second.subtask)))
+      {
+      sister_joins.erase(it++);
+      }
+    else if (it->second.failed == true)
+      {
+      sister_joins.erase(it++);
+
+      mom_job_purge(pjob);
+      }
+    else
+      it++;
+    }
+  } /* END purge_failed_sister_joins() */
+
+
+
+
 
 /*
  ** Sender is mother superior sending a job structure to me.
@@ -2245,7 +2559,6 @@ int im_join_job_as_sister(
   int                 job_radix)
 
   {
-  hnodent             *np = NULL;
   attribute_def       *pdef;
   job                 *pjob;
   tlist_head           lhead;
@@ -2264,8 +2577,6 @@ int im_join_job_as_sister(
   char                *radix_hosts = NULL;
   char                *radix_ports = NULL;
 
-  unsigned short       momport = 0;
-
   nodeid = disrsi(chan, &ret);
   
   if (ret != DIS_SUCCESS)
@@ -2584,136 +2895,37 @@ int im_join_job_as_sister(
 #endif  /* ndef NUMA_SUPPORT */
 #endif  /* (PENABLE_LINUX26_CPUSETS) */
     
-  ret = run_prologue_scripts(pjob);
-  if (ret != PBSE_NONE)
-    {
-    send_im_error(ret, 1, pjob, cookie, event, fromtask);
-    
-    mom_job_purge(pjob);
-    
-    if (radix_hosts != NULL)
-      free(radix_hosts);
-
-    if (radix_ports != NULL)
-      free(radix_ports);
-
-    return(IM_DONE);
-    }
-  
-#if IBM_SP2==2  /* IBM SP with PSSP 3.1 */
-  
-  if (load_sp_switch(pjob) != 0)
-    {
-    send_im_error(PBSE_SYSTEM,1,pjob,cookie,event,fromtask);
-    
-    log_err(-1, __func__, "cannot load sp switch table");
-    
-    mom_job_purge(pjob);
-    
-    if (radix_hosts != NULL)
-      free(radix_hosts);
-
-    if (radix_ports != NULL)
-      free(radix_ports);
-      
-    return(IM_DONE);
-    }
-  
-#endif /* IBM SP */
-  
-  if (multi_mom)
-    {
-    momport = pbs_rm_port;
-    }
-  
-  job_save(pjob, SAVEJOB_FULL, momport);
-
-  sprintf(log_buffer, "JOIN JOB as node %d",
-    nodeid);
-  
-  log_record(PBSEVENT_JOB,PBS_EVENTCLASS_JOB,jobid,log_buffer);
-
-  if ((job_radix == TRUE) &&
-      (sister_count > 2))
-    {
-    /* handle the case where we're contacting multiple nodes */
-    if ((pjob->ji_wattr[JOB_ATR_job_radix].at_flags & ATR_VFLAG_SET) &&
-        (pjob->ji_wattr[JOB_ATR_job_radix].at_val.at_long != 0))
-      {
-      pjob->ji_radix = pjob->ji_wattr[JOB_ATR_job_radix].at_val.at_long;
-      }
-
-    pjob->ji_im_nodeid = 1; /* this will identify us as an intermediate node later */
-
-    if (allocate_demux_sockets(pjob, INTERMEDIATE_MOM))
-      {
-      free(radix_hosts);
-      free(radix_ports);
-      return(IM_DONE);
-      }
+  /* the rest of the join waits for the prologues, see start_sister_prologue() */
+  sister_join &sj = sister_joins[jobid];
+
+  sj.subtask = 0;
+  sj.failed = false;
+  sj.cookie = cookie;
+  memcpy(&sj.addr, addr, sizeof(sj.addr));
+  sj.event = event;
+  sj.fromtask = fromtask;
+  sj.nodeid = nodeid;
+  sj.job_radix = job_radix;
+  sj.sister_count = sister_count;
+  sj.radix_hosts = (radix_hosts != NULL) ? radix_hosts : "";
+  sj.radix_ports = (radix_ports != NULL) ? radix_ports : "";
 
-    contact_sisters(pjob,event,sister_count,radix_hosts,radix_ports);
-    pjob->ji_intermediate_join_event = event;
-    job_save(pjob,SAVEJOB_FULL,momport);
-
-    free(radix_ports);
+  if (radix_hosts != NULL)
     free(radix_hosts);
-    
-    return(IM_DONE);
-    }
-  else
-    {
-    unsigned short  af_family;
-    char           *host_addr = NULL;
-    int             addr_len;
-    int             local_errno;
-
-    /* handle the single contact case */
-    if (job_radix == TRUE)
-      {
-      sister_job_nodes(pjob, radix_hosts, radix_ports);
-      free(radix_ports);
-      radix_ports = NULL;
-
-      np = &pjob->ji_sisters[0];
-      if (np != NULL)
-        {
-        ret = get_hostaddr_hostent_af(&local_errno, np->hn_host, &af_family, &host_addr, &addr_len);
-        memmove(&np->sock_addr.sin_addr, host_addr, addr_len);
-        free(host_addr);
-        np->sock_addr.sin_port = htons(np->hn_port);
-        np->sock_addr.sin_family = af_family;
-        }
-
-      /* This is a leaf node in the job radix hierarchy. pjob->ji_radix needs to be set to non-zero
-         for later in tm_spawn calls. */
-      pjob->ji_radix = 2;
-      }
-    }
-    
-  /*
-   ** if certain resource limits require that the job usage be
-   ** polled, we link the job to mom_polljobs.
-   **
-   ** NOTE: we overload the job field ji_jobque for this as it
-   ** is not used otherwise by MOM
-   */
-  if (mom_do_poll(pjob))
-    append_link(&mom_polljobs, &pjob->ji_jobque, pjob);
-  
-  append_link(&svr_alljobs, &pjob->ji_alljobs, pjob);
-  
-  /* establish a connection and write the reply back */
-  if ((reply_to_join_job_as_sister(pjob, addr, cookie, event, fromtask, job_radix)) == DIS_SUCCESS)
-    ret = IM_DONE;
 
   if (radix_ports != NULL)
     free(radix_ports);
 
-  if (radix_hosts != NULL)
-    free(radix_hosts);
+  rc = start_sister_prologue(pjob, sj);
 
-  return(ret);
+  /* an entry is only kept while its prologue subtask runs */
+  if (sj.subtask == 0)
+    sister_joins.erase(jobid);
+
+  if (rc != PBSE_NONE)
+    mom_job_purge(pjob);
+
+  return(IM_DONE);
   } /* END im_join_job_as_sister() */
 
 
@@ -8767,6 +8979,30 @@ received_node *get_received_node_entry(
 
 
 
+/*
+ * files a status string under the node it belongs to. A "node=" string starts
+ * the statuses of the next node.
+ *
+ * @return the entry the next string belongs to
+ */
+
+received_node *cache_status_string(
+
+  received_node *rn,
+  const char    *str)
+
+  {
+  if (!strncmp(str, "node=", strlen("node=")))
+    rn = get_received_node_entry((char *)str);
+
+  if (rn != NULL)
+    rn->statuses.push_back(str);
+
+  return(rn);
+  } /* END cache_status_string() */
+
+
+
 /*
  * reads the status strings sent from another mom
  *
@@ -8815,14 +9051,19 @@ int read_status_strings(
       break;
       }
 
-    if (!strncmp(str, "node=", strlen("node=")))
-      rn = get_received_node_entry(str);
-
-    /* place each string into the buffer */
-    if (rn != NULL)
+    /* place each string into the buffer, a frame holds the statuses relayed
+     * from below the sender */
+    if (!strncmp(str, STATUS_FRAME_KEYWORD, strlen(STATUS_FRAME_KEYWORD)))
       {
-      rn->statuses.push_back(str);
+      std::vector<std::string> framed;
+
+      unpack_status_frame(str + strlen(STATUS_FRAME_KEYWORD), framed);
+
+      for (unsigned int i = 0; i < framed.size(); i++)
+        rn = cache_status_string(rn, framed[i].c_str());
       }
+    else
+      rn = cache_status_string(rn, str);
 
     free(str);
     }
@@ -2,6 +2,9 @@
 #define _MOM_COMM_H
 #include "license_pbs.h" /* See here for the software license */
 #include "tm_.h" /* tm_event_t */
+#include <netinet/in.h>
+#include <string>
+#include <map>
 
 /* Forward declarations */
 struct job;
@@ -58,6 +61,30 @@ void send_im_error(int err, int reply, struct job *pjob, char *cookie, tm_event_
 
 int im_join_job_as_sister(struct tcp_chan *chan, char *jobid, struct sockaddr_in *addr, char *cookie, tm_event_t event, int fromtask, int command, int job_radix);
 
+/* a sister join whose prologues are running in a subtask */
+typedef struct sister_join
+  {
+  pid_t              subtask;
+  bool               failed;    /* the job is purged by purge_failed_sister_joins() */
+  std::string        cookie;
+  struct sockaddr_in addr;
+  tm_event_t         event;
+  int                fromtask;
+  int                nodeid;
+  int                job_radix;
+  int                sister_count;
+  std::string        radix_hosts;
+  std::string        radix_ports;
+  } sister_join;
+
+extern std::map<std::string, sister_join> sister_joins;
+
+int start_sister_prologue(struct job *pjob, sister_join &sj);
+
+int post_sister_prologue(struct job *pjob, int ev);
+
+void purge_failed_sister_joins();
+
 void im_kill_job_as_sister(struct job *pjob, tm_event_t event, unsigned int momport, int radix);
 
 int im_spawn_task(struct tcp_chan *chan, char *cookie, tm_event_t event, struct sockaddr_in *addr, tm_task_id fromtask, struct job *pjob);
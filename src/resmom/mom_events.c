@@ -0,0 +1,392 @@
+#include <pbs_config.h>
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/syscall.h>
+#ifdef HAVE_SYS_SIGNALFD_H
+#include <sys/signalfd.h>
+#endif /* HAVE_SYS_SIGNALFD_H */
+#ifdef HAVE_SYS_TIMERFD_H
+#include <sys/timerfd.h>
+#endif /* HAVE_SYS_TIMERFD_H */
+#include <map>
+
+#include "pbs_error.h"
+#include "pbs_job.h"
+#include "log.h"
+#include "net_connect.h"
+#include "catch_child.h"
+#include "mom_events.h"
+
+/*
+ * The main loop waits in wait_request() on the mom's sockets. Besides them,
+ * these descriptors are added to the same set so that the loop wakes up when
+ * something happens instead of when the select timeout runs out:
+ *
+ *   signal_fd - SIGCHLD and SIGHUP, which stay blocked while we wait so a
+ *               signal delivered just before the wait can't be missed
+ *   timer_fd  - the nearest job deadline (sister kill wait, join resend, obit
+ *               retry), armed by the main loop before each wait
+ *   pidfds    - one per session leader of a running task, so tasks that are
+ *               not our children are only scanned for when one has exited
+ *   jsmpipe   - the pipe a job starter reports on once its prologues are
+ *               done, read by TMOMScanForStarting()
+ */
+
+extern tlist_head svr_alljobs;
+extern int        LOGLEVEL;
+
+extern void catch_hup(int);
+
+static int   signal_fd = -1;
+static int   timer_fd = -1;
+static time_t timer_armed = 0;
+
+/* session id of a running task -> its pidfd, -1 once it has fired or can't be opened */
+static std::map<pid_t, int> task_pidfds;
+
+static bool   task_exited = false;
+static bool   tasks_unwatched = true;
+static time_t last_task_scan = 0;
+
+
+
+/*
+ * init_mom_events - create the signal and timer descriptors and add them
+ * to the wait_request set. SIGCHLD and SIGHUP are taken out of wait_sigs,
+ * the signals the main loop unblocks while it waits.
+ *
+ * @return PBSE_NONE, or PBSE_NOSUP/PBSE_SYSTEM if the loop has to keep
+ * polling on the select timeout
+ */
+
+int init_mom_events(
+
+  sigset_t *wait_sigs) /* M */
+
+  {
+#if defined(HAVE_SYS_SIGNALFD_H) && defined(HAVE_SYS_TIMERFD_H)
+  sigset_t sigs;
+
+  sigemptyset(&sigs);
+  sigaddset(&sigs, SIGCHLD);
+  sigaddset(&sigs, SIGHUP);
+
+  if ((signal_fd = signalfd(-1, &sigs, SFD_NONBLOCK | SFD_CLOEXEC)) < 0)
+    {
+    log_err(errno, __func__, "signalfd");
+    return(PBSE_SYSTEM);
+    }
+
+  if ((timer_fd = timerfd_create(CLOCK_REALTIME, TFD_NONBLOCK | TFD_CLOEXEC)) < 0)
+    {
+    log_err(errno, __func__, "timerfd_create");
+    close(signal_fd);
+    signal_fd = -1;
+    return(PBSE_SYSTEM);
+    }
+
+  if ((add_conn(signal_fd, Primary, 0, 0, PBS_SOCK_UNIX, read_signal_event) != PBSE_NONE) ||
+      (add_conn(timer_fd, Primary, 0, 0, PBS_SOCK_UNIX, read_timer_event) != PBSE_NONE))
+    {
+    log_err(-1, __func__, "cannot wait on the signal and timer descriptors");
+    close_conn(signal_fd, FALSE);
+    close_conn(timer_fd, FALSE);
+    signal_fd = -1;
+    timer_fd = -1;
+    return(PBSE_SYSTEM);
+    }
+
+  sigdelset(wait_sigs, SIGCHLD);
+  sigdelset(wait_sigs, SIGHUP);
+
+  return(PBSE_NONE);
+#else
+  return(PBSE_NOSUP);
+#endif /* HAVE_SYS_SIGNALFD_H && HAVE_SYS_TIMERFD_H */
+  } /* END init_mom_events() */
+
+
+
+bool mom_events_active(void)
+
+  {
+  return(signal_fd >= 0);
+  } /* END mom_events_active() */
+
+
+
+/*
+ * read_signal_event - hand each queued signal to its old handler, which
+ * just sets the flag the main loop checks
+ */
+
+void *read_signal_event(
+
+  void *args)
+
+  {
+#ifdef HAVE_SYS_SIGNALFD_H
+  struct signalfd_siginfo si;
+
+  while (read(signal_fd, &si, sizeof(si)) == sizeof(si))
+    {
+    if (si.ssi_signo == SIGCHLD)
+      catch_child(SIGCHLD);
+    else if (si.ssi_signo == SIGHUP)
+      catch_hup(SIGHUP);
+    }
+#endif /* HAVE_SYS_SIGNALFD_H */
+
+  return(NULL);
+  } /* END read_signal_event() */
+
+
+
+/*
+ * set_event_timer - wake the main loop at the absolute time when, or
+ * never if when is 0. The deadline itself is handled by the check_*()
+ * routines once the loop runs.
+ */
+
+void set_event_timer(
+
+  time_t when) /* I */
+
+  {
+#ifdef HAVE_SYS_TIMERFD_H
+  struct itimerspec its;
+
+  if ((timer_fd < 0) ||
+      (when == timer_armed))
+    return;
+
+  memset(&its, 0, sizeof(its));
+  its.it_value.tv_sec = when;
+
+  if (timerfd_settime(timer_fd, TFD_TIMER_ABSTIME, &its, NULL) != 0)
+    {
+    log_err(errno, __func__, "timerfd_settime");
+    return;
+    }
+
+  timer_armed = when;
+#endif /* HAVE_SYS_TIMERFD_H */
+  } /* END set_event_timer() */
+
+
+
+void *read_timer_event(
+
+  void *args)
+
+  {
+  uint64_t expirations;
+
+  if (read(timer_fd, &expirations, sizeof(expirations)) == sizeof(expirations))
+    timer_armed = 0;
+
+  return(NULL);
+  } /* END read_timer_event() */
+
+
+
+static int open_pidfd(
+
+  pid_t pid) /* I */
+
+  {
+#ifdef SYS_pidfd_open
+  return(syscall(SYS_pidfd_open, pid, 0));
+#else
+  errno = ENOSYS;
+  return(-1);
+#endif /* SYS_pidfd_open */
+  } /* END open_pidfd() */
+
+
+
+/*
+ * read_task_pidfd - a task's session leader has exited. The task may live
+ * on in other processes of its session, so only the next scan decides.
+ */
+
+void *read_task_pidfd(
+
+  void *args)
+
+  {
+  int fd = ((int *)args)[0];
+
+  for (std::map<pid_t, int>::iterator it = task_pidfds.begin(); it != task_pidfds.end(); it++)
+    {
+    if (it->second == fd)
+      {
+      it->second = -1;
+      break;
+      }
+    }
+
+  close_conn(fd, FALSE);
+
+  task_exited = true;
+
+  return(NULL);
+  } /* END read_task_pidfd() */
+
+
+
+/*
+ * watch_task_pids - open a pidfd for the session leader of each running
+ * task that doesn't have one yet and drop those of tasks that are gone
+ */
+
+void watch_task_pids(void)
+
+  {
+  job                           *pjob;
+  task                          *ptask;
+  std::map<pid_t, int>           running;
+  std::map<pid_t, int>::iterator it;
+
+  if (signal_fd < 0)
+    return;
+
+  tasks_unwatched = false;
+
+  for (pjob = (job *)GET_NEXT(svr_alljobs); pjob != NULL; pjob = (job *)GET_NEXT(pjob->ji_alljobs))
+    {
+    for (ptask = (task *)GET_NEXT(pjob->ji_tasks); ptask != NULL; ptask = (task *)GET_NEXT(ptask->ti_jobtask))
+      {
+      pid_t sid = ptask->ti_qs.ti_sid;
+      int   fd;
+
+      if ((ptask->ti_qs.ti_status != TI_STATE_RUNNING) ||
+          (sid <= 1))
+        continue;
+
+      if ((it = task_pidfds.find(sid)) != task_pidfds.end())
+        {
+        running[sid] = it->second;
+
+        if (it->second < 0)
+          tasks_unwatched = true;
+
+        continue;
+        }
+
+      if ((fd = open_pidfd(sid)) >= 0)
+        {
+        if (add_conn(fd, Primary, 0, 0, PBS_SOCK_UNIX, read_task_pidfd) != PBSE_NONE)
+          {
+          close(fd);
+          fd = -1;
+          }
+        }
+      else if ((errno != ESRCH) &&
+               (LOGLEVEL >= 7))
+        {
+        snprintf(log_buffer, sizeof(log_buffer), "cannot open a pidfd for session %d", sid);
+        log_err(errno, __func__, log_buffer);
+        }
+
+      if (fd < 0)
+        tasks_unwatched = true;
+
+      running[sid] = fd;
+      }
+    }
+
+  for (it = task_pidfds.begin(); it != task_pidfds.end(); it++)
+    {
+    if ((it->second >= 0) &&
+        (running.find(it->first) == running.end()))
+      close_conn(it->second, FALSE);
+    }
+
+  task_pidfds.swap(running);
+  } /* END watch_task_pids() */
+
+
+
+/*
+ * read_starter_pipe - a job starter has written its result (or died). Stop
+ * watching the pipe, TMOMScanForStarting() reads it on this pass.
+ */
+
+void *read_starter_pipe(
+
+  void *args)
+
+  {
+  clear_conn(((int *)args)[0], FALSE);
+
+  return(NULL);
+  } /* END read_starter_pipe() */
+
+
+
+/*
+ * watch_starter_pipe - wake the main loop when the job starter on fd
+ * reports, instead of blocking on the pipe
+ *
+ * @return true if the pipe is watched
+ */
+
+bool watch_starter_pipe(
+
+  int fd) /* I */
+
+  {
+  if ((signal_fd < 0) ||
+      (fd < 0))
+    return(false);
+
+  return(add_conn(fd, Primary, 0, 0, PBS_SOCK_UNIX, read_starter_pipe) == PBSE_NONE);
+  } /* END watch_starter_pipe() */
+
+
+
+/*
+ * unwatch_starter_pipe - must be called before the pipe is closed
+ */
+
+void unwatch_starter_pipe(
+
+  int fd) /* I */
+
+  {
+  if ((signal_fd >= 0) &&
+      (fd >= 0))
+    clear_conn(fd, FALSE);
+  } /* END unwatch_starter_pipe() */
+
+
+
+/*
+ * task_scan_needed - whether scan_non_child_tasks() has anything to find:
+ * a watched session leader exited, a task couldn't be watched, or the
+ * periodic sweep is due. Without the event descriptors it always is.
+ */
+
+bool task_scan_needed(
+
+  time_t now) /* I */
+
+  {
+  if ((signal_fd >= 0) &&
+      (task_exited == false) &&
+      (tasks_unwatched == false) &&
+      (now - last_task_scan < TASK_SCAN_INTERVAL))
+    return(false);
+
+  task_exited = false;
+  last_task_scan = now;
+
+  return(true);
+  } /* END task_scan_needed() */
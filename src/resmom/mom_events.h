@@ -0,0 +1,33 @@
+#ifndef _MOM_EVENTS_H
+#define _MOM_EVENTS_H
+#include "license_pbs.h" /* See here for the software license */
+
+#include <signal.h>
+#include <time.h>
+
+/* even with a pidfd for every task, sweep the tasks this often (seconds) */
+#define TASK_SCAN_INTERVAL 60
+
+int init_mom_events(sigset_t *wait_sigs);
+
+bool mom_events_active(void);
+
+void set_event_timer(time_t when);
+
+void watch_task_pids(void);
+
+bool task_scan_needed(time_t now);
+
+void *read_signal_event(void *args);
+
+void *read_timer_event(void *args);
+
+void *read_task_pidfd(void *args);
+
+bool watch_starter_pipe(int fd);
+
+void unwatch_starter_pipe(int fd);
+
+void *read_starter_pipe(void *args);
+
+#endif /* _MOM_EVENTS_H */
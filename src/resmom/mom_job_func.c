@@ -140,6 +140,7 @@
 #ifdef PENABLE_LINUX26_CPUSETS
 #include "pbs_cpuset.h"
 #endif
+#include "pbs_cgroup.h"
 #include "utils.h"
 #include "mom_config.h"
 #include "container.hpp"
@@ -680,6 +681,10 @@ void *delete_job_files(
   delete_cpuset(jfdi->jobid, true);
 #endif /* PENABLE_LINUX26_CPUSETS */
 
+  /* even if $cgroup_accounting was turned off since the job started */
+  if (cgroup_version != CGROUP_NONE)
+    delete_job_cgroup(jfdi->jobid);
+
   /* delete the node file and gpu file */
   sprintf(namebuf,"%s/%s", path_aux, jfdi->jobid);
   unlink(namebuf);
@@ -84,6 +84,7 @@
 #include "pbs_cpuset.h"
 #include "node_internals.hpp"
 #endif
+#include "pbs_cgroup.h"
 #include "threadpool.h"
 #include "mom_hierarchy.h"
 #include "../lib/Libutils/u_lock_ctl.h" /* lock_init */
@@ -95,6 +96,7 @@
 #include "mcom.h"
 #include "mom_server_lib.h" /* shutdown_to_server */
 #include "node_frequency.hpp"
+#include "mom_events.h"
 #include <string>
 #include <vector>
 #include <boost/ptr_container/ptr_vector.hpp>
@@ -308,6 +310,7 @@ char                   *ret_string;
 long                    ret_size;
 
 sigset_t  allsigs;
+sigset_t  wait_sigs; /* unblocked while waiting, allsigs less those read from the signalfd */
 unsigned int            reqnum = 0;  /* the packet number */
 
 #ifndef NOPRIVPORTS
@@ -3322,6 +3325,137 @@ const char *find_signal_name(
 
 
 
+/*
+ * kill_job_tasks()
+ *
+ * Sends sig to each running task of the job.
+ *
+ * @return the number of processes signalled
+ */
+
+int kill_job_tasks(
+
+  job *pjob,  /* I */
+  int  sig)   /* I */
+
+  {
+  task *ptask;
+  int   ct = 0;
+
+  ptask = (task *)GET_NEXT(pjob->ji_tasks);
+
+  while (ptask != NULL)
+    {
+    if (ptask->ti_qs.ti_status == TI_STATE_RUNNING)
+      {
+      if (LOGLEVEL >= 4)
+        {
+        log_record(
+          PBSEVENT_JOB,
+          PBS_EVENTCLASS_JOB,
+          pjob->ji_qs.ji_jobid,
+          "kill_job found a task to kill");
+        }
+
+      ct += kill_task(ptask, sig, 0);
+      }
+
+    ptask = (task *)GET_NEXT(ptask->ti_jobtask);
+    }  /* END while (ptask != NULL) */
+
+  return(ct);
+  }  /* END kill_job_tasks() */
+
+
+
+
+/*
+ * post_epilogue_precancel()
+ *
+ * The ji_mompost routine for the precancel epilog subtask, terminates
+ * the job's tasks now that the epilog is done.
+ */
+
+int post_epilogue_precancel(
+
+  job *pjob,  /* I */
+  int  ev)    /* I - exit value of the subtask */
+
+  {
+  if (ev != 0)
+    {
+    log_err(-1, __func__, "precancel epilog failed");
+
+    sprintf(PBSNodeMsgBuf, "ERROR:  precancel epilog failed");
+    }
+
+  kill_job_tasks(pjob, SIGTERM);
+
+  return(0);
+  }  /* END post_epilogue_precancel() */
+
+
+
+
+/*
+ * start_epilogue_precancel()
+ *
+ * Forks the precancel epilog so a slow script doesn't hold up the mom,
+ * the epilog's timeout alarm then only fires in the subtask.
+ *
+ * @return PBSE_NONE if the subtask was started, otherwise the caller
+ * runs the epilog in line
+ */
+
+int start_epilogue_precancel(
+
+  job *pjob)  /* I */
+
+  {
+  struct stat sbuf;
+  pid_t       cpid;
+
+  /* a repeated SIGTERM while the epilog is still running */
+  if ((pjob->ji_momsubt != 0) &&
+      (pjob->ji_mompost == post_epilogue_precancel))
+    return(PBSE_NONE);
+
+  /* nothing to wait for, or another subtask owns ji_mompost */
+  if ((stat(path_epilogpdel, &sbuf) != 0) ||
+      (pjob->ji_momsubt != 0))
+    return(PBSE_IVALREQ);
+
+  if ((cpid = fork_me(-1)) < 0)
+    {
+    log_err(errno, __func__, "fork failed, running the precancel epilog in line");
+
+    return(PBSE_SYSTEM);
+    }
+
+  if (cpid > 0)
+    {
+    pjob->ji_momsubt = cpid;
+    pjob->ji_mompost = post_epilogue_precancel;
+
+    if (LOGLEVEL >= 2)
+      {
+      snprintf(log_buffer, sizeof(log_buffer),
+        "precancel epilog subtask created with pid %d - registered post_epilogue_precancel",
+        cpid);
+
+      log_record(PBSEVENT_DEBUG, PBS_EVENTCLASS_JOB, pjob->ji_qs.ji_jobid, log_buffer);
+      }
+
+    return(PBSE_NONE);
+    }
+
+  /* child - just run the precancel epilog */
+  exit((run_pelog(PE_EPILOGUSER, path_epilogpdel, pjob, PE_IO_TYPE_NULL, FALSE) != 0) ? 1 : 0);
+  }  /* END start_epilogue_precancel() */
+
+
+
+
 /*
  *  Kill a job.
  * Call with the job pointer and a signal number.
@@ -3340,7 +3474,6 @@ int kill_job(
   const char *why_killed_reason) /* I - reason for killing */
 
   {
-  task *ptask;
   int   ct = 0;
 
   sprintf(log_buffer, "%s: sending signal %d, \"%s\" to job %s, reason: %s",
@@ -3360,20 +3493,13 @@ int kill_job(
   /* NOTE:  should change be made to only execute precancel epilog if
    * job is active? (NYI) */
 
-  /* NOTE:  epilog blocks until complete, which may cause issues if
-   * shutdown grace time is enabled.  Change model to allow
-   * epilog.precancel to run in background and have kill_task()
-   * executed once it is complete (NYI) */
-
-  /* NOTE:  this will allow kill_job to return immediately and will
-   * require sigchild harvesting and the kill_task loop to be called
-   * once this signal is received */
-
-  /* NOTE:  if path_epilogpdel is not set, kill_task should be called
-   * immediately (NYI) */
-
   if (sig == SIGTERM)
     {
+    /* the tasks are signalled from post_epilogue_precancel() once the
+     * precancel epilog subtask is done */
+    if (start_epilogue_precancel(pjob) == PBSE_NONE)
+      return(0);
+
     if (run_pelog(PE_EPILOGUSER, path_epilogpdel, pjob, PE_IO_TYPE_NULL, FALSE) != 0)
       {
       log_err(-1, __func__, "precancel epilog failed");
@@ -3382,26 +3508,7 @@ int kill_job(
       }
     }
 
-  ptask = (task *)GET_NEXT(pjob->ji_tasks);
-
-  while (ptask != NULL)
-    {
-    if (ptask->ti_qs.ti_status == TI_STATE_RUNNING)
-      {
-      if (LOGLEVEL >= 4)
-        {
-        log_record(
-          PBSEVENT_JOB,
-          PBS_EVENTCLASS_JOB,
-          pjob->ji_qs.ji_jobid,
-          "kill_job found a task to kill");
-        }
-
-      ct += kill_task(ptask, sig, 0);
-      }
-
-    ptask = (task *)GET_NEXT(ptask->ti_jobtask);
-    }  /* END while (ptask != NULL) */
+  ct = kill_job_tasks(pjob, sig);
 
   if (LOGLEVEL >= 6)
     {
@@ -4820,6 +4927,11 @@ int setup_program_environment(void)
     return(rc);
 #endif
 
+  /* without the job cgroups, usage is sampled from /proc */
+  if ((use_cgroup_accounting == TRUE) &&
+      (init_job_cgroups(CGROUP_ROOT) != PBSE_NONE))
+    log_err(-1, msg_daemonname, "cgroup accounting is not available, sampling job usage from /proc");
+
 
   /* go into the background and become own session/process group */
 
@@ -5007,6 +5119,12 @@ int setup_program_environment(void)
   sigaction(SIGINT, &act, NULL);
   sigaction(SIGTERM, &act, NULL);
 
+  /* SIGCHLD, SIGHUP and the job timers wake wait_request() through descriptors */
+  wait_sigs = allsigs;
+
+  if (init_mom_events(&wait_sigs) != PBSE_NONE)
+    log_err(-1, msg_daemonname, "event descriptors are not available, polling on the select timeout");
+
   act.sa_handler = PBSAdjustLogLevel;
   sigaction(SIGUSR1, &act, NULL);
   sigaction(SIGUSR2, &act, NULL);
@@ -5309,7 +5427,7 @@ int TMOMScanForStarting(void)
 
       /* check if job is ready */
 
-      if (TMomCheckJobChild(TJE, 1, &Count, &RC) == FAILURE)
+      if (TMomCheckJobChild(TJE, (mom_events_active() == true) ? 0 : 1, &Count, &RC) == FAILURE)
         {
         long STime;
 
@@ -5337,6 +5455,8 @@ int TMOMScanForStarting(void)
 
           log_record(PBSEVENT_ERROR, PBS_EVENTCLASS_JOB, __func__, log_buffer);
 
+          unwatch_starter_pipe(TJE->jsmpipe[0]);
+
           memset(TJE, 0, sizeof(pjobexec_t));
 
           exec_bail(pjob, JOB_EXEC_RETRY);
@@ -5744,6 +5864,64 @@ void check_jobs_in_mom_wait()
   } /* END check_jobs_in_mom_wait() */
 
 
+/*
+ * next_job_deadline - the earliest time at which check_jobs_awaiting_join_job_reply(),
+ * check_jobs_in_mom_wait(), check_exiting_jobs() or TMOMScanForStarting() will
+ * have something to do
+ *
+ * @return the deadline, or 0 if no job is waiting on one
+ */
+
+time_t next_job_deadline(void)
+
+  {
+  job    *pjob;
+  time_t  deadline = 0;
+  time_t  when;
+
+  for (pjob = (job *)GET_NEXT(svr_alljobs);
+       pjob != NULL;
+       pjob = (job *)GET_NEXT(pjob->ji_alljobs))
+    {
+    when = 0;
+
+    if ((pjob->ji_qs.ji_substate == JOB_SUBSTATE_MOM_WAIT) &&
+        (pjob->ji_kill_started != 0))
+      {
+      when = pjob->ji_kill_started + job_exit_wait_time + 1;
+      }
+    else if ((pjob->ji_qs.ji_substate == JOB_SUBSTATE_PRERUN) &&
+             (pjob->ji_qs.ji_state == JOB_STATE_RUNNING) &&
+             (am_i_mother_superior(*pjob) == true))
+      {
+      if (pjob->ji_joins_resent == FALSE)
+        when = pjob->ji_joins_sent + MIN(resend_join_job_wait_time, max_join_job_wait_time) + 1;
+      else
+        when = pjob->ji_joins_sent + max_join_job_wait_time + 1;
+      }
+    else if ((pjob->ji_qs.ji_substate == JOB_SUBSTATE_STARTING) &&
+             (pjob->ji_wattr[JOB_ATR_mtime].at_val.at_long > 0))
+      {
+      when = pjob->ji_wattr[JOB_ATR_mtime].at_val.at_long + TJobStartTimeout + 1;
+      }
+
+    if ((when != 0) &&
+        ((deadline == 0) || (when < deadline)))
+      deadline = when;
+    }
+
+  for (unsigned int i = 0; i < exiting_job_list.size(); i++)
+    {
+    when = exiting_job_list[i].obit_sent + OBIT_STATE_RETRY_TIME;
+
+    if ((deadline == 0) || (when < deadline))
+      deadline = when;
+    }
+
+  return(deadline);
+  } /* END next_job_deadline() */
+
+
 //If we have a job that's exiting we should call scan for exiting.
 bool call_scan_for_exiting()
   {
@@ -5988,9 +6166,14 @@ void main_loop(void)
 #endif
       scan_for_terminated();  /* machine dependent (calls mom_get_sample()???) */
 
+    purge_failed_sister_joins();
+
     /* if -p, must poll tasks inside jobs to look for completion */
 
-    if (recover == JOB_RECOV_RUNNING)
+    watch_task_pids();
+
+    if ((recover == JOB_RECOV_RUNNING) &&
+        (task_scan_needed(time_now) == true))
       scan_non_child_tasks();
 
     if (recover == JOB_RECOV_DELETE)
@@ -6016,13 +6199,23 @@ void main_loop(void)
 
     /* unblock signals */
 
-    if (sigprocmask(SIG_UNBLOCK, &allsigs, NULL) == -1)
+    if (sigprocmask(SIG_UNBLOCK, &wait_sigs, NULL) == -1)
       log_err(errno, __func__, "sigprocmask(UNBLOCK)");
 
     time_now = time((time_t *)0);
 
     tmpTime = calculate_select_timeout();
 
+    if (mom_events_active() == true)
+      {
+      time_t deadline = next_job_deadline();
+
+      if (deadline != 0)
+        deadline = MAX(deadline, time_now + 1);
+
+      set_event_timer(deadline);
+      }
+
     resend_things();
 
     /* wait_request does a select and then calls the connection's cn_func for sockets with data */
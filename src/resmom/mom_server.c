@@ -210,6 +210,8 @@
 #include <netinet/in.h>
 #include <sys/time.h>
 #include <sstream>
+#include <pthread.h>
+#include <signal.h>
 #if defined(NTOHL_NEEDS_ARPA_INET_H) && defined(HAVE_ARPA_INET_H)
 #include <arpa/inet.h>
 #endif
@@ -243,6 +245,8 @@
 #include "mom_config.h"
 #include <string>
 #include <vector>
+#include <map>
+#include <set>
 #include "container.hpp"
 #include <arpa/inet.h>
 
@@ -254,6 +258,7 @@
 #define MAX_SERVER_UPDATE_SPACING         40
 #define NO_SERVER_CONFIGURED             -1
 #define COULD_NOT_CONTACT_SERVER         -2
+#define STATUS_SEND_ATTEMPTS              3
 
 #ifdef NUMA_SUPPORT
 extern int numa_index;
@@ -299,6 +304,24 @@ extern u_long              localaddr;
 extern container::item_container<received_node *> received_statuses;
 std::vector<std::string>   global_gpu_status;
 std::vector<std::string>   mom_status;
+std::vector<std::string>   mom_status_delta;
+status_map                 acked_status; /* the status the server last acknowledged */
+std::map<std::string, status_map> acked_cached; /* the same for each node below us */
+int                        server_frame_version = 0; /* status frame version the server advertised, 0 for none */
+int                        server_deltas_version = 0; /* status delta version the server advertised, 0 for none */
+bool                       send_full_status = true;
+int                        updates_since_full_status = 0;
+
+/* the status sender thread takes pending_update and leaves it in finished_update */
+pthread_mutex_t            status_update_mutex = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t             status_update_cond = PTHREAD_COND_INITIALIZER;
+status_update             *pending_update = NULL;
+status_update             *finished_update = NULL;
+bool                       status_sender_started = false;
+
+/* mh is used by the status sender thread and replaced by read_cluster_addresses() */
+pthread_mutex_t            hierarchy_mutex = PTHREAD_MUTEX_INITIALIZER;
+unsigned long              hierarchy_generation = 0; /* bumped each time mh is replaced */
 
 extern struct config *rm_search(struct config *where, const char *what);
 
@@ -588,9 +611,11 @@ void mom_server_stream_error(
   const char *message)
 
   {
-  sprintf(log_buffer, "error %s to server %s", message, name);
+  char log_buf[LOCAL_LOG_BUF_SIZE];
 
-  log_record(PBSEVENT_SYSTEM, 0, id, log_buffer);
+  snprintf(log_buf, sizeof(log_buf), "error %s to server %s", message, name);
+
+  log_record(PBSEVENT_SYSTEM, 0, id, log_buf);
 
   return;
   }  /* END mom_server_stream_error() */
@@ -1090,13 +1115,15 @@ int should_request_cluster_addrs()
 
 
 /* 
- * writes the header for a server status update
+ * writes the header for a server status update. first_update asks the server
+ * for the cluster addresses, see should_request_cluster_addrs().
  */
 int write_update_header(
     
   struct tcp_chan *chan,
   const char *id,
-  char       *name)
+  char       *name,
+  bool        first_update)
 
   {
   int  ret;
@@ -1115,12 +1142,10 @@ int write_update_header(
           
           if ((ret = diswst(chan, buf)) != DIS_SUCCESS)
             mom_server_stream_error(chan->sock, name, id, "writing status string");
-          else if (should_request_cluster_addrs() == TRUE)
+          else if (first_update == true)
             {
             if ((ret = diswst(chan, "first_update=true")) != DIS_SUCCESS)
               mom_server_stream_error(chan->sock, name, id, "writing status string");
-            else
-              requested_cluster_addrs = time_now;
             }
           }
         }
@@ -1143,6 +1168,7 @@ int write_my_server_status(
  
   {
   int          ret = DIS_SUCCESS;
+  char         log_buf[LOCAL_LOG_BUF_SIZE];
 
   mom_server  *pms;
   node_comm_t *nc;
@@ -1152,11 +1178,11 @@ int write_my_server_status(
     {
     if (LOGLEVEL >= 7)
       {
-      sprintf(log_buffer,"%s: sending to server \"%s\"",
+      snprintf(log_buf, sizeof(log_buf), "%s: sending to server \"%s\"",
         id,
         strings[i].c_str());
       
-      log_record(PBSEVENT_SYSTEM,0,id,log_buffer);
+      log_record(PBSEVENT_SYSTEM,0,id,log_buf);
       }
 
     const char *str_to_write = strings[i].c_str();
@@ -1175,10 +1201,12 @@ int write_my_server_status(
           
         case UPDATE_TO_MOM:
           
+          /* the caller closes the stream */
           nc = (node_comm_t *)dest;
-          nc->stream = chan->sock;
           
-          node_comm_error(nc,"Error writing strings to");
+          snprintf(log_buf, sizeof(log_buf), "Error writing strings to %s", nc->name);
+          log_err(-1, "Node communication process", log_buf);
+          nc->bad = TRUE;
           
           break;
         } /* END switch (mode) */
@@ -1193,82 +1221,212 @@ int write_my_server_status(
 
 
 
+/*
+ * write_status_frame()
+ *
+ * writes the statuses cached from the moms below us as a single frame, see
+ * pack_status_frame(), so the receiver gets the whole subtree as one unit.
+ * They are written as plain strings if the server hasn't advertised frames.
+ *
+ * @param frame_version - the status frame version the server advertised
+ */
+
+int write_status_frame(
+
+  struct tcp_chan          *chan,
+  const char               *id,
+  std::vector<std::string> &cached,
+  void                     *dest,
+  int                       mode,
+  int                       frame_version)
+
+  {
+  std::vector<std::string> frame(1);
+
+  if (cached.size() == 0)
+    return(DIS_SUCCESS);
+
+  if (frame_version < STATUS_FRAME_VERSION)
+    return(write_my_server_status(chan, id, cached, dest, mode));
+
+  pack_status_frame(cached, frame[0]);
+
+  return(write_my_server_status(chan, id, frame, dest, mode));
+  } /* END write_status_frame() */
 
-int write_cached_statuses(
+
+
+
+
+/*
+ * take_cached_statuses()
+ *
+ * moves the statuses received from the moms below us in the hierarchy into
+ * cached, to be sent after our own. They are taken out whether or not the
+ * update they go out with succeeds.
+ */
+
+void take_cached_statuses(
  
-  struct tcp_chan *chan,
-  const char      *id,
-  void            *dest,
-  int              mode)
+  std::vector<std::string> &cached)
  
   {
-  int            ret = DIS_SUCCESS;
+  received_node *rn;
+
   received_statuses.lock();
   container::item_container<received_node *>::item_iterator *iter = received_statuses.get_iterator();
-  const char   *cp;
-  received_node *rn;
-  mom_server    *pms;
-  node_comm_t   *nc;
-  bool           error = false;
   
-  /* traverse the received_nodes array and send/clear the updates */
-  while (((rn = iter->get_next_item()) != NULL) &&
-         (error == false))
+  while ((rn = iter->get_next_item()) != NULL)
     {
-    for (unsigned int i = 0; i < rn->statuses.size(); i++)
-      {
-      cp = rn->statuses[i].c_str();
-      if (LOGLEVEL >= 7)
-        {
-        sprintf(log_buffer,"%s: sending to server \"%s\"",
-          id,
-          cp);
-        
-        log_record(PBSEVENT_SYSTEM,0,id,log_buffer);
-        }
-      
-      if ((ret = diswst(chan,cp)) != DIS_SUCCESS)
-        {
-        error = true;
-
-        /* FAILURE */
-        switch (mode)
-          {
-          case UPDATE_TO_SERVER:
-            
-            pms = (mom_server *)dest;
-            
-            mom_server_stream_error(chan->sock, pms->pbs_servername, id, "writing status string");
-            
-            break;
-            
-          case UPDATE_TO_MOM:
-            
-            nc = (node_comm_t *)dest;
-            nc->stream = chan->sock;
-            
-            node_comm_error(nc,"Error writing strings to");
-            
-            break;
-          } /* END switch (mode) */
-        
-        break;
-        }
-      
-      } /* END write each string */
-    
+    cached.insert(cached.end(), rn->statuses.begin(), rn->statuses.end());
     rn->statuses.clear();
-    } /* END iterate over received statuses */
+    }
 
   delete iter;
   
-  if (ret == DIS_SUCCESS)
-    updates_waiting_to_send = 0;
+  updates_waiting_to_send = 0;
 
   received_statuses.unlock();
+  } /* END take_cached_statuses() */
+
+
+
+
+
+/**
+ * send_status_to_server
+ *
+ * Opens a connection to a server and sends it a status update: the strings,
+ * followed by a frame holding the statuses cached from the moms below us in
+ * the hierarchy.
+ * Nothing but the arguments is touched, so the status sender thread can call
+ * this while the main loop runs.
+ *
+ * @param pms the server to send to
+ * @param strings this mom's status
+ * @param cached statuses received from other moms
+ * @param first_update true to ask the server for the cluster addresses
+ * @param frame_version the status frame version the server advertised
+ * @return DIS_SUCCESS or NEED_FULL_STATUS if the server took the update,
+ * COULD_NOT_CONTACT_SERVER if it couldn't be reached, another error otherwise
+ */
+
+int send_status_to_server(
+
+  mom_server               *pms,
+  std::vector<std::string> &strings,
+  std::vector<std::string> &cached,
+  bool                      first_update,
+  int                       frame_version)
+
+  {
+  int              stream;
+  int              ret = -1;
+  struct tcp_chan *chan = NULL;
+  char             log_buf[LOCAL_LOG_BUF_SIZE];
+
+  stream = tcp_connect_sockaddr((struct sockaddr *)&pms->sock_addr, sizeof(pms->sock_addr), false);
+ 
+  if (!IS_VALID_STREAM(stream))
+    return(COULD_NOT_CONTACT_SERVER);
+
+  if ((chan = DIS_tcp_setup(stream)) == NULL)
+    {
+    }
+  else if ((ret = write_update_header(chan, __func__, pms->pbs_servername, first_update)) != DIS_SUCCESS)
+    {
+    }
+  else if ((ret = write_my_server_status(chan, __func__, strings, pms, UPDATE_TO_SERVER)) != DIS_SUCCESS)
+    {
+    }
+  else if ((ret = write_status_frame(chan, __func__, cached, pms, UPDATE_TO_SERVER, frame_version)) != DIS_SUCCESS)
+    {
+    }
+  else if ((ret = diswst(chan, IS_EOL_MESSAGE)) != DIS_SUCCESS)
+    {
+    }
+  else if ((ret = DIS_tcp_wflush(chan)) != DIS_SUCCESS)
+    {
+    }
+  else
+    {
+    read_tcp_reply(chan, IS_PROTOCOL, IS_PROTOCOL_VER, IS_STATUS, &ret);
+    }
+
+  if (chan != NULL)
+    DIS_tcp_cleanup(chan);
+    
+  close(stream);
+
+  if ((ret != DIS_SUCCESS) &&
+      (ret != NEED_FULL_STATUS))
+    {
+    /* FAILURE */
+    if (ret == UNREAD_STATUS)
+      {
+      snprintf(log_buf, sizeof(log_buf), "Couldn't read a reply from the server");
+      }
+    else if (ret >= 0)
+      {
+      snprintf(log_buf, sizeof(log_buf),
+        "Couldn't send update to server: %s",
+        dis_emsg[ret]);
+      }
+    else
+      {
+      snprintf(log_buf, sizeof(log_buf), "Couldn't send update to server");
+      }
+    
+    log_err(-1, __func__, log_buf);
+    }
+  else if (LOGLEVEL >= 3)
+    {
+    snprintf(log_buf, sizeof(log_buf), "status update successfully sent to %s", pms->pbs_servername);
+    
+    log_record(PBSEVENT_SYSTEM, 0, __func__, log_buf);
+    }
+
   return(ret);
-  } /* END write_cached_statuses() */
+  } /* END send_status_to_server() */
+
+
+
+
+/*
+ * returns the milliseconds since start
+ */
+
+long elapsed_ms(
+
+  struct timeval *start)
+
+  {
+  struct timeval now;
 
+  gettimeofday(&now, NULL);
+
+  return((now.tv_sec - start->tv_sec) * 1000 + (now.tv_usec - start->tv_usec) / 1000);
+  } /* END elapsed_ms() */
+
+
+
+
+/*
+ * record_status_latency()
+ *
+ * records how long a status update took to reach pms, for momctl -d
+ */
+
+void record_status_latency(
+
+  mom_server *pms,
+  long        latency)
+
+  {
+  pms->MOMLastStatusLatency = latency;
+  pms->MOMStatusLatencyTotal += latency;
+  pms->MOMStatusUpdateCount++;
+  } /* END record_status_latency() */
 
 
 
@@ -1276,11 +1434,11 @@ int write_cached_statuses(
 /**
  * mom_server_update_stat
  *
- * Send a status update message to a server.
+ * Send a status update message to a server and wait for the reply. Updates
+ * from a non-reporter mom go through the status sender thread instead, see
+ * mom_server_all_update_stat().
  *
- * NOTE:  if interface is bad, try to recover is ???
- *
- * @param mom_server_all_update_stat() - parent
+ * @param send_update_to_a_server() - parent
  * @param pms pointer to mom_server instance
  */
  
@@ -1290,10 +1448,11 @@ int mom_server_update_stat(
   std::vector<std::string> &strings)
  
   {
-  int              stream;
-  int              ret = -1;
-  int              rc  = COULD_NOT_CONTACT_SERVER;
-  struct tcp_chan *chan = NULL;
+  int                      ret;
+  int                      rc  = COULD_NOT_CONTACT_SERVER;
+  bool                     first_update;
+  struct timeval           start;
+  std::vector<std::string> cached;
 
   if ((pms->pbs_servername[0] == '\0') ||
       (time_now < (pms->MOMLastSendToServerTime + get_stat_update_interval())))
@@ -1303,96 +1462,54 @@ int mom_server_update_stat(
     return(NO_SERVER_CONFIGURED);
     }
 
-  stream = tcp_connect_sockaddr((struct sockaddr *)&pms->sock_addr, sizeof(pms->sock_addr), false);
- 
-  if (IS_VALID_STREAM(stream))
-    {
-    if ((chan = DIS_tcp_setup(stream)) == NULL)
-      {
-      }
-    else if ((ret = write_update_header(chan, __func__, pms->pbs_servername)) != DIS_SUCCESS)
-      {
-      }
-    else if ((ret = write_my_server_status(chan, __func__, strings, pms, UPDATE_TO_SERVER)) != DIS_SUCCESS)
-      {
-      }
-    else if ((ret = write_cached_statuses(chan, __func__, pms, UPDATE_TO_SERVER)) != DIS_SUCCESS)
-      {
-      }
-    else if ((ret = diswst(chan, IS_EOL_MESSAGE)) != DIS_SUCCESS)
-      {
-      }
-    else if ((ret = DIS_tcp_wflush(chan)) != DIS_SUCCESS)
-      {
-      }
-    else
-      {
-      read_tcp_reply(chan, IS_PROTOCOL, IS_PROTOCOL_VER, IS_STATUS, &ret);
-      }
+  take_cached_statuses(cached);
 
-    if (chan != NULL)
-      DIS_tcp_cleanup(chan);
-      
-    close(stream);
-  
-    if (ret != DIS_SUCCESS)
-      {
+  /* these go out whole, outside of the updates that track what the server holds */
+  acked_cached.clear();
 
-      /* FAILURE */
-      if (ret == UNREAD_STATUS)
-        {
-        snprintf(log_buffer,sizeof(log_buffer),"Couldn't read a reply from the server");
-        }
-      else
-        {
-        if (ret >= 0)
-          {
-          snprintf(log_buffer,sizeof(log_buffer),
-            "Couldn't send update to server: %s",
-            dis_emsg[ret]);
-          }
-        else
-          {
-          snprintf(log_buffer,sizeof(log_buffer), "Couldn't send update to server");
-          }
-        }
-      
-      log_err(-1,__func__,log_buffer);
+  first_update = (should_request_cluster_addrs() == TRUE);
+
+  if (first_update == true)
+    requested_cluster_addrs = time_now;
+
+  gettimeofday(&start, NULL);
+
+  ret = send_status_to_server(pms, strings, cached, first_update, server_frame_version);
+
+  if (ret == COULD_NOT_CONTACT_SERVER)
+    {
+    UpdateFailCount++;
+    }
+  else if ((ret != DIS_SUCCESS) &&
+           (ret != NEED_FULL_STATUS))
+    {
+    /* force another update to the server so we get this out there */
+    UpdateFailCount++;
+    }
+  else
+    {
+    /* SUCCESS */
+    record_status_latency(pms, elapsed_ms(&start));
       
-      /* force another update to the server so we get this out there */
-      UpdateFailCount++;
-      }
+    /* the server took the update, but wants a full one next time */
+    if (ret == NEED_FULL_STATUS)
+      rc = NEED_FULL_STATUS;
     else
-      {
-      /* SUCCESS */
-      if (LOGLEVEL >= 3)
-        {
-        sprintf(log_buffer, "status update successfully sent to %s", pms->pbs_servername);
-        
-        log_record(PBSEVENT_SYSTEM, 0, __func__, log_buffer);
-
-        }
-        
       rc = PBSE_NONE;
-      
-      /* It would be redundant to send state since it is already in status */  
-      pms->ReportMomState = 0;
+    
+    /* It would be redundant to send state since it is already in status */  
+    pms->ReportMomState = 0;
 
 #ifndef NUMA_SUPPORT      
-      pms->MOMLastSendToServerTime = time_now;
+    pms->MOMLastSendToServerTime = time_now;
 #else
-      if (numa_index + 1 >= num_node_boards)
-        pms->MOMLastSendToServerTime = time_now;
+    if (numa_index + 1 >= num_node_boards)
+      pms->MOMLastSendToServerTime = time_now;
 #endif
-      ForceServerUpdate = false;
-      LastServerUpdateTime = time_now;
-      
-      UpdateFailCount = 0;
-      }
-    } /* END if valid stream */
-  else
-    {
-    UpdateFailCount++;
+    ForceServerUpdate = false;
+    LastServerUpdateTime = time_now;
+    
+    UpdateFailCount = 0;
     }
   
   return(rc);
@@ -1408,8 +1525,10 @@ void node_comm_error(
   const char *message)
  
   {
-  snprintf(log_buffer,sizeof(log_buffer), "%s %s", message, nc->name);
-  log_err(-1, "Node communication process",log_buffer);
+  char log_buf[LOCAL_LOG_BUF_SIZE];
+
+  snprintf(log_buf, sizeof(log_buf), "%s %s", message, nc->name);
+  log_err(-1, "Node communication process", log_buf);
   
   close(nc->stream);
   nc->stream = -1;
@@ -1423,31 +1542,36 @@ void node_comm_error(
 int write_status_strings(
  
   std::vector<std::string> &strings,
-  node_comm_t              *nc)
+  std::vector<std::string> &cached,
+  node_comm_t              *nc,
+  bool                      first_update,
+  int                       frame_version)
  
   {
-  int            fds = nc->stream;
-  int            rc = DIS_SUCCESS;
+  int              fds = nc->stream;
+  int              rc = DIS_SUCCESS;
   struct tcp_chan *chan = NULL;
+  char             log_buf[LOCAL_LOG_BUF_SIZE];
 
   if (LOGLEVEL >= 9)
     {
-    snprintf(log_buffer, sizeof(log_buffer),
+    snprintf(log_buf, sizeof(log_buf),
       "Attempting to send status update to mom %s", nc->name);
-    log_record(PBSEVENT_SYSTEM, PBS_EVENTCLASS_SERVER, __func__, log_buffer);
+    log_record(PBSEVENT_SYSTEM, PBS_EVENTCLASS_SERVER, __func__, log_buf);
     }
  
   if ((chan = DIS_tcp_setup(fds)) == NULL)
     {
+    rc = DIS_NOMALLOC;
     }
   /* write protocol */
-  else if ((rc = write_update_header(chan,__func__,nc->name)) != DIS_SUCCESS)
+  else if ((rc = write_update_header(chan, __func__, nc->name, first_update)) != DIS_SUCCESS)
     {
     }
-  else if ((rc = write_my_server_status(chan,__func__, strings, nc, UPDATE_TO_SERVER)) != DIS_SUCCESS)
+  else if ((rc = write_my_server_status(chan, __func__, strings, nc, UPDATE_TO_MOM)) != DIS_SUCCESS)
     {
     }
-  else if ((rc = write_cached_statuses(chan,__func__,nc,UPDATE_TO_SERVER)) != DIS_SUCCESS)
+  else if ((rc = write_status_frame(chan, __func__, cached, nc, UPDATE_TO_MOM, frame_version)) != DIS_SUCCESS)
     {
     }
   /* write message that we're done */
@@ -1458,9 +1582,9 @@ int write_status_strings(
     {
     if (LOGLEVEL >= 7)
       {
-      snprintf(log_buffer, sizeof(log_buffer),
+      snprintf(log_buf, sizeof(log_buf),
         "Successfully sent status update to mom %s", nc->name);
-      log_record(PBSEVENT_SYSTEM, PBS_EVENTCLASS_SERVER,__func__,log_buffer);
+      log_record(PBSEVENT_SYSTEM, PBS_EVENTCLASS_SERVER, __func__, log_buf);
       }
     }
 
@@ -1544,10 +1668,15 @@ int send_update_to_a_server()
   int rc = NO_SERVER_CONFIGURED;
   char    log_buf[LOCAL_LOG_BUF_SIZE];
 
+  /* send the delta if one was prepared */
+  std::vector<std::string> &strings = (mom_status_delta.size() != 0) ? mom_status_delta : mom_status;
+
   /* now, once we contact one server we stop attempting to report in */
-  for (int sindex = 0; sindex < PBS_MAXSERVER && rc != PBSE_NONE; sindex++)
+  for (int sindex = 0;
+       (sindex < PBS_MAXSERVER) && (rc != PBSE_NONE) && (rc != NEED_FULL_STATUS);
+       sindex++)
     {
-    int tmp_rc = mom_server_update_stat(&mom_servers[sindex], mom_status);
+    int tmp_rc = mom_server_update_stat(&mom_servers[sindex], strings);
 
     if (tmp_rc != NO_SERVER_CONFIGURED)
       rc = tmp_rc;
@@ -1588,177 +1717,903 @@ void update_mom_status()
   } /* update_mom_status() */
 
 
-int send_status_through_hierarchy()
 
-  {
-  node_comm_t *nc = NULL;
-  int          rc = -1;
 
-  if ((nc = update_current_path(mh)) != NULL)
+/* the server acts on these every update, so they go out even when unchanged */
+const char *always_sent_status[] = { "state", "jobs", "message", NULL };
+
+
+
+/*
+ * index_status()
+ *
+ * groups status strings by the text before their '='. A gpu or mic block is
+ * kept whole under its opening marker. If order is given, it receives the keys
+ * in the order they first appear.
+ */
+
+void index_status(
+
+  std::vector<std::string> &status,
+  status_map               &indexed,
+  std::vector<std::string> *order)
+
+  {
+  for (unsigned int i = 0; i < status.size(); i++)
     {
-    /* write to the socket */
-    while (nc != NULL)
+    std::string  key = status[i].substr(0, status[i].find('='));
+    const char  *end = NULL;
+
+    if (key == START_GPU_STATUS)
+      end = END_GPU_STATUS;
+    else if (key == START_MIC_STATUS)
+      end = END_MIC_STATUS;
+
+    if ((order != NULL) &&
+        (indexed.find(key) == indexed.end()))
+      order->push_back(key);
+
+    std::vector<std::string> &unit = indexed[key];
+
+    unit.push_back(status[i]);
+
+    if (end != NULL)
       {
-      if (write_status_strings(mom_status, nc) < 0)
-        {
-        nc->bad = TRUE;
-        nc->mtime = time_now;
-        nc = force_path_update(mh);
-        }
-      else 
-        {
-        rc = PBSE_NONE;
-  
-        close(nc->stream);
-        break;
-        }
+      while ((status[i] != end) &&
+             (i + 1 < status.size()))
+        unit.push_back(status[++i]);
       }
     }
-
-  return(rc);
-  } /* END send_status_through_hierarchy() */
+  } /* END index_status() */
 
 
 
-/**
- * mom_server_all_update_stat
+/*
+ * build_status_delta()
  *
- * This is the former is_update_stat.  It has been reworked to
- * first generate the strings and then walk the server list sending
- * the strings to each server.
+ * fills delta with the parts of status that differ from acked, the status the
+ * server last acknowledged, followed by the keys that are no longer reported.
  */
 
-void mom_server_all_update_stat(void)
- 
+void build_status_delta(
+
+  std::vector<std::string> &status,
+  status_map               &acked,
+  std::vector<std::string> &delta)
+
   {
-  pid_t        pid;
-  int          fd_pipe[2];
-  int          rc;
-  char         buf[LOCAL_LOG_BUF_SIZE];
-  size_t       len;
+  status_map               current;
+  std::vector<std::string> order;
+  std::string              removed;
 
-  time_now = time(NULL);
+  index_status(status, current, &order);
 
-  memset(buf, 0, LOCAL_LOG_BUF_SIZE);
+  delta.clear();
+  delta.push_back(STATUS_DELTA_KEYWORD);
 
-  if (send_update() == FALSE)
+  for (unsigned int i = 0; i < order.size(); i++)
     {
-    /* no update is needed */
-    return;
+    std::vector<std::string> &unit = current[order[i]];
+    status_map::iterator      it = acked.find(order[i]);
+    bool                      send = ((it == acked.end()) || (it->second != unit));
+
+    for (int j = 0; (send == false) && (always_sent_status[j] != NULL); j++)
+      {
+      if (order[i] == always_sent_status[j])
+        send = true;
+      }
+
+    if (send == true)
+      delta.insert(delta.end(), unit.begin(), unit.end());
     }
- 
-  if (PBSNodeCheckInterval > 0)
-    check_state((LastServerUpdateTime == 0));
- 
-  LastUpdateAttempt = time_now;
- 
-  /* We generate the status once, because this might be costly.
-   * The dynamic string mom_status will contain NULL terminated strings.
-   * The end of the buffer is marked with an empty string i.e. NULL NULL.
-   */
- 
-  if (LOGLEVEL >= 6)
+
+  /* gpu and mic blocks aren't part of the node's status list on the server */
+  for (status_map::iterator it = acked.begin(); it != acked.end(); it++)
     {
-    log_record(PBSEVENT_SYSTEM, 0, __func__, "composing status update for server");
+    if ((it->first[0] != '<') &&
+        (current.find(it->first) == current.end()))
+      {
+      if (removed.size() != 0)
+        removed += ",";
+
+      removed += it->first;
+      }
     }
 
-  if (is_reporter_mom == TRUE)
+  if (removed.size() != 0)
+    delta.push_back(STATUS_REMOVED_KEYWORD + removed);
+  } /* END build_status_delta() */
+
+
+
+/*
+ * should_send_full_status()
+ *
+ * a full status goes out every status_refresh_count updates, until the server
+ * has acknowledged one, to a server that hasn't advertised status deltas (it
+ * would take the delta for our whole status), and whenever a delta might land
+ * on the wrong base: a previous update failed, we are still waiting on the
+ * cluster addresses (the server forgets our gpus on a first update), or there
+ * are several servers to fail over between.
+ */
+
+bool should_send_full_status()
+
+  {
+  if ((status_refresh_count <= 0) ||
+      (send_full_status == true) ||
+      (updates_since_full_status >= status_refresh_count) ||
+      (received_cluster_addrs == false) ||
+      (server_deltas_version < STATUS_DELTAS_VERSION) ||
+      (mom_server_count > 1))
+    return(true);
+
+  return(false);
+  } /* END should_send_full_status() */
+
+
+
+/*
+ * prepare_status_update()
+ *
+ * generates this mom's status and, when allowed, the delta against the last
+ * acknowledged status that send_update_to_a_server() sends in its place.
+ */
+
+void prepare_status_update()
+
+  {
+  update_mom_status();
+
+  mom_status_delta.clear();
+
+  if (should_send_full_status() == false)
+    build_status_delta(mom_status, acked_status, mom_status_delta);
+  } /* END prepare_status_update() */
+
+
+
+/*
+ * update_acked_status()
+ *
+ * records the outcome of the update prepared by prepare_status_update(). Once
+ * the server has acknowledged it, mom_status is the base for the next delta.
+ * If it wasn't acknowledged, the server's copy can't be trusted and the next
+ * update is a full one.
+ */
+
+void update_acked_status(
+
+  int rc)
+
+  {
+  if (rc == PBSE_NONE)
     {
-    generate_alps_status(mom_status, apbasil_path, apbasil_protocol);
+    if (mom_status_delta.size() == 0)
+      updates_since_full_status = 0;
+    else
+      updates_since_full_status++;
 
-    if (send_update_to_a_server() == PBSE_NONE)
+    acked_status.clear();
+    index_status(mom_status, acked_status, NULL);
+    send_full_status = false;
+    }
+  else
+    {
+    send_full_status = true;
+
+    /* the server has no base for our deltas, don't leave it that way for long */
+    if (rc == NEED_FULL_STATUS)
+      send_update_soon();
+    }
+  } /* END update_acked_status() */
+
+
+
+/*
+ * build_cached_delta()
+ *
+ * fills delta with the statuses cached from the moms below us, each node's
+ * reduced to what differs from the status the server last acknowledged for it
+ * in acked. A node goes out whole if the server hasn't acknowledged it from us
+ * or it asks for the cluster addresses, and it isn't tracked if its status has
+ * numa boards or already is a delta.
+ * base receives what the server holds for each node once it takes the update.
+ */
+
+void build_cached_delta(
+
+  std::vector<std::string>          &cached,
+  std::map<std::string, status_map> &acked,
+  std::map<std::string, status_map> &base,
+  std::vector<std::string>          &delta)
+
+  {
+  std::set<std::string>    untracked;
+  std::vector<std::string> node_delta;
+
+  delta.clear();
+  base.clear();
+
+  for (unsigned int i = 0; i < cached.size();)
+    {
+    unsigned int end = i + 1;
+    bool         tracked = true;
+    bool         whole = false;
+
+    while ((end < cached.size()) &&
+           (strncmp(cached[end].c_str(), "node=", strlen("node="))))
+      end++;
+
+    if (strncmp(cached[i].c_str(), "node=", strlen("node=")))
       {
-      ForceServerUpdate = false;
-      LastServerUpdateTime = time_now;
+      delta.insert(delta.end(), cached.begin() + i, cached.begin() + end);
+      i = end;
+      continue;
+      }
+
+    std::string              node_name = cached[i].substr(strlen("node="));
+    std::vector<std::string> status(cached.begin() + i + 1, cached.begin() + end);
+    status_map              *prior = NULL;
+
+    for (unsigned int j = 0; j < status.size(); j++)
+      {
+      if ((!strncmp(status[j].c_str(), NUMA_KEYWORD, strlen(NUMA_KEYWORD))) ||
+          (status[j] == STATUS_DELTA_KEYWORD))
+        tracked = false;
+      else if (status[j] == "first_update=true")
+        {
+        /* not part of the node's status */
+        whole = true;
+        status.erase(status.begin() + j--);
+        }
       }
+
+    /* a node reported twice builds on the first report */
+    if (base.find(node_name) != base.end())
+      prior = &base[node_name];
+    else if ((untracked.find(node_name) == untracked.end()) &&
+             (acked.find(node_name) != acked.end()))
+      prior = &acked[node_name];
+
+    if ((tracked == false) ||
+        (whole == true) ||
+        (prior == NULL))
+      delta.insert(delta.end(), cached.begin() + i, cached.begin() + end);
+    else
+      {
+      build_status_delta(status, *prior, node_delta);
+      delta.push_back(cached[i]);
+      delta.insert(delta.end(), node_delta.begin(), node_delta.end());
+      }
+
+    if (tracked == false)
+      {
+      base.erase(node_name);
+      untracked.insert(node_name);
+      }
+    else
+      {
+      status_map &node_base = base[node_name];
+
+      node_base.clear();
+      index_status(status, node_base, NULL);
+      untracked.erase(node_name);
+      }
+
+    i = end;
     }
+  } /* END build_cached_delta() */
+
+
+/*
+ * copy_mom_hierarchy()
+ *
+ * copies mh, node names included, so the status can be sent without holding
+ * hierarchy_mutex.
+ *
+ * @return the generation of mh that was copied
+ */
+
+unsigned long copy_mom_hierarchy(
+
+  mom_hierarchy_t &copy)
+
+  {
+  unsigned long generation;
+
+  pthread_mutex_lock(&hierarchy_mutex);
+
+  if (mh != NULL)
+    copy = *mh;
   else
     {
-    /* The NVIDIA NVML library has a problem when we use it after the first fork. Let's get the gpu status first
-       and then fork */
-#ifdef NVIDIA_GPUS
-    global_gpu_status.clear();
-    add_gpu_status(global_gpu_status);
-#endif
-    /* It is possible that pbs_server may get busy and start queing incoming requests and not be able 
-       to process them right away. If pbs_mom is waiting for a reply to a statuys update that has 
-       been queued and at the same time the server makes a request to the mom we can get stuck
-       in a pseudo live-lock state. That is the server is waiting for a response from the mom and
-       the mom is waiting for a response from the server. neither of which will come until a request times out.
-       If we fork the status updates this alleviates the problem by making one less request from the
-       mom single threaded */
-    rc = pipe(fd_pipe);
-    if (rc != 0)
+    copy.current_path = -1;
+    copy.current_level = -1;
+    copy.current_node = -1;
+    copy.paths.clear();
+    }
+
+  generation = hierarchy_generation;
+
+  pthread_mutex_unlock(&hierarchy_mutex);
+
+  for (unsigned int i = 0; i < copy.paths.size(); i++)
+    for (unsigned int j = 0; j < copy.paths[i].size(); j++)
+      for (unsigned int k = 0; k < copy.paths[i][j].size(); k++)
+        {
+        node_comm_t &nc = copy.paths[i][j][k];
+
+        nc.name = strdup((nc.name != NULL) ? nc.name : "");
+        }
+
+  return(generation);
+  } /* END copy_mom_hierarchy() */
+
+
+
+
+/*
+ * restore_mom_hierarchy_state()
+ *
+ * writes what sending through copy learned about each node (which are bad,
+ * their streams and when they were tried) back to mh, unless mh has been
+ * replaced since it was copied. Frees the names in copy.
+ */
+
+void restore_mom_hierarchy_state(
+
+  mom_hierarchy_t &copy,
+  unsigned long    generation)
+
+  {
+  pthread_mutex_lock(&hierarchy_mutex);
+
+  if ((mh != NULL) &&
+      (generation == hierarchy_generation))
+    {
+    mh->current_path = copy.current_path;
+    mh->current_level = copy.current_level;
+    mh->current_node = copy.current_node;
+
+    for (unsigned int i = 0; i < copy.paths.size(); i++)
+      for (unsigned int j = 0; j < copy.paths[i].size(); j++)
+        for (unsigned int k = 0; k < copy.paths[i][j].size(); k++)
+          {
+          node_comm_t &from = copy.paths[i][j][k];
+          node_comm_t &to = mh->paths[i][j][k];
+
+          to.mtime = from.mtime;
+          to.stream = from.stream;
+          to.bad = from.bad;
+          }
+    }
+
+  pthread_mutex_unlock(&hierarchy_mutex);
+
+  for (unsigned int i = 0; i < copy.paths.size(); i++)
+    for (unsigned int j = 0; j < copy.paths[i].size(); j++)
+      for (unsigned int k = 0; k < copy.paths[i][j].size(); k++)
+        free(copy.paths[i][j][k].name);
+
+  copy.paths.clear();
+  } /* END restore_mom_hierarchy_state() */
+
+
+
+
+/*
+ * send_status_through_hierarchy()
+ *
+ * sends the status to the first mom in the hierarchy that will take it.
+ * The hierarchy is copied so hierarchy_mutex isn't held while we connect
+ * and write to the other moms.
+ *
+ * @return PBSE_NONE if a mom took it, -1 if this mom should go to a server
+ */
+
+int send_status_through_hierarchy(
+
+  std::vector<std::string> &strings,
+  std::vector<std::string> &cached,
+  bool                      first_update,
+  int                       frame_version)
+
+  {
+  node_comm_t     *nc = NULL;
+  int              rc = -1;
+  mom_hierarchy_t  path_copy;
+  unsigned long    generation;
+
+  generation = copy_mom_hierarchy(path_copy);
+
+  if ((nc = update_current_path(&path_copy)) != NULL)
+    {
+    /* write to the socket */
+    while (nc != NULL)
       {
-      sprintf(buf, "pipe creation failed: %d", errno);
-      log_err(-1, __func__, buf);
+      if (write_status_strings(strings, cached, nc, first_update, frame_version) != DIS_SUCCESS)
+        {
+        nc->bad = TRUE;
+        nc->mtime = time(NULL);
+        nc = force_path_update(&path_copy);
+        }
+      else 
+        {
+        rc = PBSE_NONE;
+        break;
+        }
       }
+    }
 
-    pid = fork();
+  restore_mom_hierarchy_state(path_copy, generation);
 
-    if (pid < 0)
+  return(rc);
+  } /* END send_status_through_hierarchy() */
+
+
+
+
+/*
+ * sends strings to the first of su's servers that takes them.
+ * Called by the status sender thread.
+ */
+
+int send_status_to_a_server(
+
+  status_update            *su,
+  std::vector<std::string> &strings,
+  std::vector<std::string> &cached)
+
+  {
+  int rc = NO_SERVER_CONFIGURED;
+
+  /* once we contact one server we stop attempting to report in */
+  for (int sindex = 0;
+       (sindex < PBS_MAXSERVER) && (rc != PBSE_NONE) && (rc != NEED_FULL_STATUS);
+       sindex++)
+    {
+    if (su->servers[sindex].pbs_servername[0] == '\0')
+      continue;
+
+    rc = send_status_to_server(&su->servers[sindex], strings, cached, su->first_update, su->frame_version);
+
+    if ((rc == PBSE_NONE) ||
+        (rc == NEED_FULL_STATUS))
+      su->server_index = sindex;
+    }
+
+  return(rc);
+  } /* END send_status_to_a_server() */
+
+
+
+
+/*
+ * send_status_update()
+ *
+ * sends each node board's status through the hierarchy, or to a server if the
+ * hierarchy won't take it. Servers that can't be reached are retried, backing
+ * off between attempts. The cached statuses go out once, with the first board,
+ * as deltas if they were prepared and the update goes to a server.
+ * Only su is touched, the main loop records the outcome in
+ * collect_status_update().
+ */
+
+void send_status_update(
+
+  status_update *su)
+
+  {
+  struct timeval           start;
+  std::vector<std::string> no_statuses;
+
+  gettimeofday(&start, NULL);
+
+  for (unsigned int i = 0; i < su->boards.size(); i++)
+    {
+    std::vector<std::string> &cached = (i == 0) ? su->cached : no_statuses;
+    std::vector<std::string> &cached_to_send = ((i == 0) && (su->cached_delta.size() != 0)) ? su->cached_delta : cached;
+
+    /* the hierarchy relays whole statuses, so it always gets the full ones */
+    if (send_status_through_hierarchy(su->boards[i], cached, su->first_update, su->frame_version) == PBSE_NONE)
       {
-      log_record(PBSEVENT_SYSTEM, 0, __func__, "Failed to fork stat update process");
-      return;
+      su->rc = PBSE_NONE;
+      continue;
       }
 
-    if (pid > 0)
+    std::vector<std::string> &strings = (su->delta.size() != 0) ? su->delta : su->boards[i];
+
+    if (i == 0)
+      su->cached_to_server = true;
+
+    for (int attempt = 1; ; attempt++)
       {
-      // PARENT 
-      close(fd_pipe[1]);
-      ForceServerUpdate = false;
-      LastServerUpdateTime = time_now;
-      UpdateFailCount = 0;
-    
-      received_node                                             *rn;
-      received_statuses.lock();
-      container::item_container<received_node *>::item_iterator *iter = received_statuses.get_iterator();
-      
-      // clear cached statuses from hierarchy
-      while ((rn = iter->get_next_item()) != NULL)
-        rn->statuses.clear();
+      su->rc = send_status_to_a_server(su, strings, cached_to_send);
+
+      if ((su->rc != COULD_NOT_CONTACT_SERVER) ||
+          (attempt >= STATUS_SEND_ATTEMPTS))
+        break;
+
+      sleep(1 << (attempt - 1));
+      }
+    }
+
+  su->latency = elapsed_ms(&start);
+  } /* END send_status_update() */
+
+
+
+
+/*
+ * the status sender thread. Sends each update handed to it by
+ * dispatch_status_update() and leaves the result for the main loop to collect.
+ */
+
+void *status_sender(
+
+  void *vp)
+
+  {
+  status_update *su;
+
+  pthread_mutex_lock(&status_update_mutex);
+
+  while (true)
+    {
+    while (pending_update == NULL)
+      pthread_cond_wait(&status_update_cond, &status_update_mutex);
+
+    su = pending_update;
+    pthread_mutex_unlock(&status_update_mutex);
+
+    send_status_update(su);
+
+    pthread_mutex_lock(&status_update_mutex);
+    pending_update = NULL;
+    finished_update = su;
+    }
+
+  return(NULL);
+  } /* END status_sender() */
+
+
+
+
+/*
+ * fork() only copies the calling thread, so the log mutex is held across it to
+ * keep a child from starting out with it locked by the status sender thread.
+ */
+
+void lock_log_for_fork()
+
+  {
+  pthread_mutex_lock(&log_mutex);
+  } /* END lock_log_for_fork() */
+
+
+
+void unlock_log_after_fork()
+
+  {
+  pthread_mutex_unlock(&log_mutex);
+  } /* END unlock_log_after_fork() */
+
+
+
+void reset_log_in_child()
+
+  {
+  pthread_mutexattr_t attr;
+
+  /* the child's thread doesn't own the lock its parent took */
+  pthread_mutexattr_init(&attr);
+  pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+  pthread_mutex_init(&log_mutex, &attr);
+  pthread_mutexattr_destroy(&attr);
+  } /* END reset_log_in_child() */
 
-      delete iter;
-      received_statuses.unlock();
 
-      len = read(fd_pipe[0], buf, LOCAL_LOG_BUF_SIZE);
 
-      close(fd_pipe[0]);
 
-      if (len <= 0)
+/*
+ * starts the status sender thread with all signals blocked, so that they
+ * keep going to the main loop.
+ *
+ * @return PBSE_NONE on success, PBSE_SYSTEM if the thread couldn't be started
+ */
+
+int start_status_sender()
+
+  {
+  pthread_t      tid;
+  pthread_attr_t attr;
+  sigset_t       all_signals;
+  sigset_t       old_mask;
+  int            rc;
+
+  if (pthread_atfork(lock_log_for_fork, unlock_log_after_fork, reset_log_in_child) != 0)
+    return(PBSE_SYSTEM);
+
+  pthread_attr_init(&attr);
+  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+
+  sigfillset(&all_signals);
+  pthread_sigmask(SIG_SETMASK, &all_signals, &old_mask);
+
+  rc = pthread_create(&tid, &attr, status_sender, NULL);
+
+  pthread_sigmask(SIG_SETMASK, &old_mask, NULL);
+  pthread_attr_destroy(&attr);
+
+  if (rc != 0)
+    return(PBSE_SYSTEM);
+
+  status_sender_started = true;
+
+  return(PBSE_NONE);
+  } /* END start_status_sender() */
+
+
+
+
+/*
+ * status_update_pending()
+ *
+ * @return true if the status sender thread hasn't finished the last update
+ */
+
+bool status_update_pending()
+
+  {
+  bool pending;
+
+  pthread_mutex_lock(&status_update_mutex);
+  pending = (pending_update != NULL);
+  pthread_mutex_unlock(&status_update_mutex);
+
+  return(pending);
+  } /* END status_update_pending() */
+
+
+
+
+/*
+ * collect_status_update()
+ *
+ * records the outcome of a status update once it has been sent, then frees it.
+ */
+
+void collect_status_update(
+
+  status_update *su)
+
+  {
+  char log_buf[LOCAL_LOG_BUF_SIZE];
+
+  if ((su->rc == PBSE_NONE) ||
+      (su->rc == NEED_FULL_STATUS))
+    {
+    if (su->server_index >= 0)
+      {
+      mom_server *pms = &mom_servers[su->server_index];
+
+      /* make sure the server wasn't replaced while the update was out */
+      if (!strcmp(pms->pbs_servername, su->servers[su->server_index].pbs_servername))
         {
-        log_err(-1, __func__, "read of pipe failed for status update");
-        return;
+        pms->MOMLastSendToServerTime = su->dispatched;
+        record_status_latency(pms, su->latency);
         }
+      }
 
-      if (buf[0] != '0')
-          num_stat_update_failures++;
-      else
-          num_stat_update_failures = 0;
+    UpdateFailCount = 0;
 
-      return;
+    if (num_stat_update_failures != 0)
+      {
+      snprintf(log_buf, sizeof(log_buf), "Status update successfully sent after %d MOM status update intervals", num_stat_update_failures);
+      log_err(-1, __func__, log_buf);
+      num_stat_update_failures = 0;
       }
+    }
+  else if (su->rc != NO_SERVER_CONFIGURED)
+    {
+    UpdateFailCount++;
+    num_stat_update_failures++;
+
+    if (su->rc == COULD_NOT_CONTACT_SERVER)
+      log_err(-1, __func__, "Could not contact any of the servers to send an update");
+
+    snprintf(log_buf, sizeof(log_buf), "Status not successfully updated for %d MOM status update intervals", num_stat_update_failures);
+    log_err(-1, __func__, log_buf);
+    }
+
+#ifndef NUMA_SUPPORT
+  update_acked_status(su->rc);
+#endif /* NUMA_SUPPORT */
+
+  /* the moms above us keep their own record of what the server holds */
+  if ((su->rc == PBSE_NONE) &&
+      (su->cached_to_server == true))
+    acked_cached.swap(su->cached_base);
+  else
+    acked_cached.clear();
+
+  delete su;
+  } /* END collect_status_update() */
+
+
+
+
+/*
+ * collects the update the status sender thread has finished, if there is one
+ */
+
+void collect_finished_update()
+
+  {
+  status_update *su;
+
+  pthread_mutex_lock(&status_update_mutex);
+  su = finished_update;
+  finished_update = NULL;
+  pthread_mutex_unlock(&status_update_mutex);
+
+  if (su != NULL)
+    collect_status_update(su);
+  } /* END collect_finished_update() */
+
+
+
 
-    // CHILD
-    close(fd_pipe[0]);
+/*
+ * dispatch_status_update()
+ *
+ * builds a status update and hands it to the status sender thread. Generating
+ * the status stays here in the main loop, only the sending is done by the thread.
+ */
+
+void dispatch_status_update()
+
+  {
+  status_update *su = new status_update();
 
 #ifdef NUMA_SUPPORT
-    for (numa_index = 0; numa_index < num_node_boards; numa_index++)
+  for (numa_index = 0; numa_index < num_node_boards; numa_index++)
+    {
+    update_mom_status();
+    su->boards.push_back(mom_status);
+    }
+#else
+  /* generate the status here so we know what the server acknowledged */
+  prepare_status_update();
+  su->boards.push_back(mom_status);
+  su->delta = mom_status_delta;
 #endif /* NUMA_SUPPORT */
+
+  take_cached_statuses(su->cached);
+
+  /* a server that doesn't read frames doesn't take per-node deltas either */
+  su->frame_version = server_frame_version;
+
+  /* nodes missing from this update may have reported to the server directly,
+   * so only the ones in it are tracked from here on */
+  build_cached_delta(su->cached, acked_cached, su->cached_base, su->cached_delta);
+
+  if ((should_send_full_status() == true) ||
+      (su->frame_version < STATUS_FRAME_VERSION))
+    su->cached_delta.clear();
+
+  su->cached_to_server = false;
+
+  for (int sindex = 0; sindex < PBS_MAXSERVER; sindex++)
+    {
+    su->servers[sindex] = mom_servers[sindex];
+
+    /* a server that recently got an update is skipped */
+    if (time_now < (mom_servers[sindex].MOMLastSendToServerTime + get_stat_update_interval()))
+      su->servers[sindex].pbs_servername[0] = '\0';
+    }
+
+  su->first_update = (should_request_cluster_addrs() == TRUE);
+
+  if (su->first_update == true)
+    requested_cluster_addrs = time_now;
+
+  su->dispatched = time_now;
+  su->rc = NO_SERVER_CONFIGURED;
+  su->server_index = -1;
+  su->latency = 0;
+
+  ForceServerUpdate = false;
+  LastServerUpdateTime = time_now;
+
+  if ((status_sender_started == false) &&
+      (start_status_sender() != PBSE_NONE))
+    {
+    log_err(-1, __func__, "Could not start the status sender thread, sending the update directly");
+
+    send_status_update(su);
+    collect_status_update(su);
+    return;
+    }
+
+  pthread_mutex_lock(&status_update_mutex);
+  pending_update = su;
+  pthread_cond_signal(&status_update_cond);
+  pthread_mutex_unlock(&status_update_mutex);
+  } /* END dispatch_status_update() */
+
+
+
+/**
+ * mom_server_all_update_stat
+ *
+ * This is the former is_update_stat.  It has been reworked to
+ * first generate the strings and then walk the server list sending
+ * the strings to each server.
+ */
+
+void mom_server_all_update_stat(void)
+ 
+  {
+  time_now = time(NULL);
+
+  collect_finished_update();
+
+  if (send_update() == FALSE)
+    {
+    /* no update is needed */
+    return;
+    }
+
+  /* It is possible that pbs_server may get busy and start queing incoming requests and not be able 
+     to process them right away. If pbs_mom waited for a reply to a status update that has 
+     been queued while the server makes a request to the mom we could get stuck
+     in a pseudo live-lock state. That is the server is waiting for a response from the mom and
+     the mom is waiting for a response from the server. neither of which will come until a request times out.
+     Sending the updates from their own thread keeps the main loop answering requests, so
+     we never wait here for a previous update to go out */
+  if (status_update_pending() == true)
+    {
+    if (LOGLEVEL >= 6)
+      log_record(PBSEVENT_SYSTEM, 0, __func__, "previous status update is still being sent");
+
+    return;
+    }
+ 
+  if (PBSNodeCheckInterval > 0)
+    check_state((LastServerUpdateTime == 0));
+ 
+  LastUpdateAttempt = time_now;
+ 
+  /* We generate the status once, because this might be costly.
+   * The dynamic string mom_status will contain NULL terminated strings.
+   * The end of the buffer is marked with an empty string i.e. NULL NULL.
+   */
+ 
+  if (LOGLEVEL >= 6)
+    {
+    log_record(PBSEVENT_SYSTEM, 0, __func__, "composing status update for server");
+    }
+
+  if (is_reporter_mom == TRUE)
+    {
+    generate_alps_status(mom_status, apbasil_path, apbasil_protocol);
+
+    if (send_update_to_a_server() == PBSE_NONE)
       {
-      update_mom_status();
-  
-      if (send_status_through_hierarchy() != PBSE_NONE)
-        rc = send_update_to_a_server();
+      ForceServerUpdate = false;
+      LastServerUpdateTime = time_now;
       }
+    }
+  else
+    {
+#ifdef NVIDIA_GPUS
+    global_gpu_status.clear();
+    add_gpu_status(global_gpu_status);
+#endif
 
-    sprintf(buf, "%d", rc);
-    len = strlen(buf);
-    write(fd_pipe[1], buf, len);
-
-    exit_called = true;
-  
-    exit(0);
+    dispatch_status_update();
     }
  
   }  /* END mom_server_all_update_stat() */
@@ -1895,6 +2750,16 @@ void mom_server_diag(
 
   output << tmpLine;
 
+  if (pms->MOMStatusUpdateCount > 0)
+    {
+    sprintf(tmpLine, "  Status Update Latency:  %ld ms (average %ld ms over %ld updates)\n",
+            pms->MOMLastStatusLatency,
+            pms->MOMStatusLatencyTotal / pms->MOMStatusUpdateCount,
+            pms->MOMStatusUpdateCount);
+
+    output << tmpLine;
+    }
+
   return;
   }  /* END mom_server_diag() */
 
@@ -2330,10 +3195,14 @@ int read_cluster_addresses(
   long            list_size;
   long            list_len = 0;
 
+  /* the status sender thread may be using the old hierarchy */
+  pthread_mutex_lock(&hierarchy_mutex);
+
   if (mh != NULL)
     free_mom_hierarchy(mh);
 
   mh = initialize_mom_hierarchy();
+  hierarchy_generation++;
   reset_okclients();
 
   while (((str = disrst(chan, &rc)) != NULL) &&
@@ -2416,6 +3285,31 @@ int read_cluster_addresses(
     }
   else
     {
+    /* a server that reads status frames and merges status deltas says so
+     * after the hierarchy. Older servers close the connection instead, which
+     * leaves plain strings and full statuses */
+    server_frame_version = 0;
+    server_deltas_version = 0;
+
+    while ((str = disrst(chan, &rc)) != NULL)
+      {
+      if (rc == DIS_SUCCESS)
+        {
+        if (parse_status_frame_version(str) > 0)
+          server_frame_version = parse_status_frame_version(str);
+        else if (parse_status_deltas_version(str) > 0)
+          server_deltas_version = parse_status_deltas_version(str);
+        }
+
+      free(str);
+      str = NULL;
+
+      if (rc != DIS_SUCCESS)
+        break;
+      }
+
+    rc = DIS_SUCCESS;
+
     received_cluster_addrs = true;
     send_update_soon();
     
@@ -2438,6 +3332,8 @@ int read_cluster_addresses(
     first_update_time = 0;
     }
 
+  pthread_mutex_unlock(&hierarchy_mutex);
+
   return(PBSE_NONE);
   } /* END read_cluster_addresses() */
 
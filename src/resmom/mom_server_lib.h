@@ -7,11 +7,34 @@
 #include "mom_hierarchy.h" /* node_comm_t */
 #include "server_limits.h" /* pbs_net_t. Also defined in net_connect.h */
 #include "tcp.h" /* tcp_chan */
+#include "resmon.h" /* PBS_MAXSERVER */
 #if defined(NVIDIA_GPUS) && defined(NVML_API)
 #include "nvml.h"
 #endif  /* NVIDIA_GPUS and NVML_API */
 #include <string>
 #include <vector>
+#include <map>
+
+/* status strings grouped by key, see index_status() */
+typedef std::map<std::string, std::vector<std::string> > status_map;
+
+/* a status update, built by the main loop and sent by the status sender thread */
+typedef struct status_update
+  {
+  std::vector<std::vector<std::string> > boards;       /* this mom's status, one per node board */
+  std::vector<std::string>               delta;        /* sent to a server in place of boards[0] if not empty */
+  std::vector<std::string>               cached;       /* statuses received from the moms below us */
+  std::vector<std::string>               cached_delta; /* sent to a server in place of cached if not empty */
+  std::map<std::string, status_map>      cached_base;  /* what the server holds for them once it takes cached */
+  bool                                   cached_to_server; /* cached went to a server, not up the hierarchy */
+  mom_server                             servers[PBS_MAXSERVER]; /* the servers it may go to */
+  bool                                   first_update; /* ask for the cluster addresses */
+  int                                    frame_version; /* status frame version the server advertised */
+  time_t                                 dispatched;
+  int                                    rc;
+  int                                    server_index; /* the server that took it, -1 if none did */
+  long                                   latency;      /* milliseconds spent sending it */
+  } status_update;
 
 void mom_server_init(mom_server *pms);
 
@@ -77,18 +100,51 @@ void generate_server_status(std::vector<std::string>& status);
 void generate_server_gpustatus_nvml(std::vector<std::string>& gpu_status);
 #endif /* NVML_API */
 
-int write_update_header(struct tcp_chan *chan, const char *id, char *name);
+int write_update_header(struct tcp_chan *chan, const char *id, char *name, bool first_update);
 
-int write_my_server_status(struct tcp_chan *chan, const char *id, char *status_strings, void *dest, int mode);
+int write_my_server_status(struct tcp_chan *chan, const char *id, std::vector<std::string> &strings, void *dest, int mode);
 
-int write_cached_statuses(struct tcp_chan *chan, const char *id, void *dest, int mode);
+int write_status_frame(struct tcp_chan *chan, const char *id, std::vector<std::string> &cached, void *dest, int mode, int frame_version);
+
+void take_cached_statuses(std::vector<std::string> &cached);
+
+int send_status_to_server(mom_server *pms, std::vector<std::string> &strings, std::vector<std::string> &cached, bool first_update, int frame_version);
+
+long elapsed_ms(struct timeval *start);
+
+void record_status_latency(mom_server *pms, long latency);
 
 void node_comm_error(node_comm_t *nc, const char *message);
 
-int write_status_strings(char *stat_str, node_comm_t *nc);
+int write_status_strings(std::vector<std::string> &strings, std::vector<std::string> &cached, node_comm_t *nc, bool first_update, int frame_version);
 
 int send_update();
 
+void index_status(std::vector<std::string> &status, status_map &indexed, std::vector<std::string> *order);
+
+void build_status_delta(std::vector<std::string> &status, status_map &acked, std::vector<std::string> &delta);
+
+bool should_send_full_status();
+
+void prepare_status_update();
+
+void update_acked_status(int rc);
+
+void build_cached_delta(std::vector<std::string> &cached, std::map<std::string, status_map> &acked, std::map<std::string, status_map> &base, std::vector<std::string> &delta);
+
+
+unsigned long copy_mom_hierarchy(mom_hierarchy_t &copy);
+
+void restore_mom_hierarchy_state(mom_hierarchy_t &copy, unsigned long generation);
+
+int send_status_through_hierarchy(std::vector<std::string> &strings, std::vector<std::string> &cached, bool first_update, int frame_version);
+
+void send_status_update(status_update *su);
+
+void collect_status_update(status_update *su);
+
+bool status_update_pending();
+
 void mom_server_all_update_stat(void);
 
 long power(register int x, register int n);
@@ -123,6 +123,8 @@ double           cputfactor = 1.00;
 float            ideal_load_val = -1.0;
 int              exec_with_exec = 0;
 int              ServerStatUpdateInterval = DEFAULT_SERVER_STAT_UPDATES;
+int              status_refresh_count = DEFAULT_STATUS_REFRESH_COUNT;
+int              use_cgroup_accounting = FALSE;
 float            max_load_val = -1.0;
 char            *auto_ideal_load = NULL;
 char            *auto_max_load   = NULL;
@@ -290,6 +292,9 @@ unsigned long setmaxjoinjobwaittime(const char *);
 unsigned long setresendjoinjobwaittime(const char *);
 unsigned long setmomhierarchyretrytime(const char *);
 unsigned long setjobdirectorysticky(const char *);
+unsigned long setwaitrequestmechanism(const char *);
+unsigned long setstatusrefreshcount(const char *);
+unsigned long setcgroupaccounting(const char *);
 
 struct specials special[] = {
   { "alloc_par_cmd",       setallocparcmd },
@@ -370,6 +375,9 @@ struct specials special[] = {
   { "resend_join_job_wait_time", setresendjoinjobwaittime},
   { "mom_hierarchy_retry_time",  setmomhierarchyretrytime},
   { "jobdirectory_sticky", setjobdirectorysticky},
+  { "wait_request_mechanism", setwaitrequestmechanism},
+  { "status_refresh_count", setstatusrefreshcount},
+  { "cgroup_accounting",    setcgroupaccounting},
   { NULL,                  NULL }
   };
 
@@ -1331,6 +1339,89 @@ u_long setjobdirectorysticky(
 
 
 
+/*
+ * setwaitrequestmechanism - select() or epoll for the main loop's wait_request()
+ */
+
+u_long setwaitrequestmechanism(
+
+  const char *value)  /* I */
+
+  {
+  log_record(PBSEVENT_SYSTEM, PBS_EVENTCLASS_SERVER, __func__, value);
+
+  if (!strcasecmp(value, "epoll"))
+    {
+    if (set_wait_request_mechanism(WAIT_REQUEST_EPOLL) != PBSE_NONE)
+      {
+      log_err(-1, __func__, "epoll is not supported on this system, using select");
+      set_wait_request_mechanism(WAIT_REQUEST_SELECT);
+      }
+    }
+  else if (!strcasecmp(value, "select"))
+    set_wait_request_mechanism(WAIT_REQUEST_SELECT);
+  else
+    {
+    snprintf(log_buffer, sizeof(log_buffer),
+      "Value must be select or epoll but is %s", value);
+    log_err(-1, __func__, log_buffer);
+    }
+
+  return(1);
+  }  /* END setwaitrequestmechanism() */
+
+
+
+
+/*
+ * setstatusrefreshcount - how many status updates may be sent as deltas
+ * before a full status is sent again. 0 always sends the full status.
+ */
+
+u_long setstatusrefreshcount(
+
+  const char *value)  /* I */
+
+  {
+  int i;
+
+  log_record(PBSEVENT_SYSTEM, PBS_EVENTCLASS_SERVER, __func__, value);
+
+  i = (int)atoi(value);
+
+  if (i < 0)
+    return(0); /* error */
+
+  status_refresh_count = i;
+
+  return(1);
+  }  /* END setstatusrefreshcount() */
+
+
+
+/*
+ * setcgroupaccounting - account job usage through a cgroup per job instead of
+ * scanning /proc. Takes effect when pbs_mom starts.
+ */
+
+u_long setcgroupaccounting(
+
+  const char *value)  /* I */
+
+  {
+  int enable;
+
+  log_record(PBSEVENT_SYSTEM, PBS_EVENTCLASS_SERVER, __func__, value);
+
+  if ((enable = setbool(value)) != -1)
+    use_cgroup_accounting = enable;
+
+  return(1);
+  }  /* END setcgroupaccounting() */
+
+
+
+
 u_long addclient(
 
   const char *name)  /* I */
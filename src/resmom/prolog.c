@@ -1074,7 +1074,12 @@ void prepare_and_run_pelog_as_child(
   int   fd_input)
 
   {
-  char *arg[12];
+  char     *arg[12];
+  sigset_t  no_sigs;
+
+  /* the mom keeps SIGCHLD and SIGHUP blocked for its signalfd, the script shouldn't inherit that */
+  sigemptyset(&no_sigs);
+  sigprocmask(SIG_SETMASK, &no_sigs, NULL);
 
   handle_pipes_as_child(parent_read, parent_write, kid_read, kid_write);
 
@@ -132,6 +132,7 @@ extern "C"
 #include "mom_config.h"
 #include "mom_memory.h"
 #include "node_internals.hpp"
+#include "mom_events.h"
 
 #ifdef ENABLE_CPA
   #include "pbs_cpa.h"
@@ -139,6 +140,7 @@ extern "C"
 #ifdef PENABLE_LINUX26_CPUSETS
   #include "pbs_cpuset.h"
 #endif
+#include "pbs_cgroup.h"
 #ifdef HAVE_WORDEXP
 #include <wordexp.h>
 #endif /* HAVE_WORDEXP */
@@ -2570,6 +2572,9 @@ int TMomFinalizeJob2(
 #endif  /* !SHELL_USE_ARGV */
   
   /* SUCCESS:  parent returns */
+
+  /* wake the main loop when the child reports instead of polling for it */
+  watch_starter_pipe(TJE->jsmpipe[0]);
   
   if (LOGLEVEL >= 3)
     {
@@ -3024,6 +3029,34 @@ void handle_cpuset_creation(
 
 
 
+/*
+ * join_job_cgroup()
+ *
+ * moves this process into the job's cgroup, creating it if needed, so that
+ * the job starts in it. A job without a cgroup is sampled from /proc.
+ */
+
+void join_job_cgroup(
+
+  job *pjob)
+
+  {
+  if (job_cgroups_active() == false)
+    return;
+
+  if (LOGLEVEL >= 6)
+    {
+    sprintf(log_buffer, "about to move to cgroup of job %s", pjob->ji_qs.ji_jobid);
+    log_ext(-1, __func__, log_buffer, LOG_DEBUG);
+    }
+
+  if (create_job_cgroup(pjob->ji_qs.ji_jobid) == PBSE_NONE)
+    move_to_job_cgroup(getpid(), pjob->ji_qs.ji_jobid);
+  } /* END join_job_cgroup() */
+
+
+
+
 void handle_reservation(
 
   job                 *pjob,
@@ -4248,6 +4281,8 @@ int TMomFinalizeChild(
 
 #endif  /* (PENABLE_LINUX26_CPUSETS) */
 
+  join_job_cgroup(pjob);
+
   if (site_job_setup(pjob) != 0)
     {
     /* FAILURE */
@@ -4557,6 +4592,8 @@ int TMomFinalizeJob3(
 
   memcpy(&sjr, TJE->sjr, sizeof(sjr));
 
+  unwatch_starter_pipe(TJE->jsmpipe[0]);
+
   close(TJE->jsmpipe[0]);
 
   if (ReadSize != sizeof(sjr))
@@ -5283,6 +5320,8 @@ int start_process(
     }
 #endif  /* (PENABLE_LINUX26_CPUSETS) */
 
+  join_job_cgroup(pjob);
+
   if (pjob->ji_numnodes > 1)
     {
     /*
@@ -8896,9 +8935,10 @@ int exec_job_on_ms(
     return(SC);
     }
 
-  /* block, wait for child to complete indicating success/failure of job launch */
+  /* block, wait for child to complete indicating success/failure of job launch.
+     With the pipe watched the main loop is woken when it does, so don't wait */
 
-  if (TMomCheckJobChild(TJE, TJobStartBlockTime, &Count, &RC) == FAILURE)
+  if (TMomCheckJobChild(TJE, (mom_events_active() == true) ? 0 : TJobStartBlockTime, &Count, &RC) == FAILURE)
     {
     if (LOGLEVEL >= 3)
       {
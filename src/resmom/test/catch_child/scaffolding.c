@@ -1125,6 +1125,10 @@ pid_t fork_me(int conn)
       rc = -1;
       }
     } 
+  else if (func_num == EXIT_MOM_JOB)
+    {
+    rc = (tc == 8) ? -1 : 1;
+    }
   return rc;
   }
 
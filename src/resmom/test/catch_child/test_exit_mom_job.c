@@ -66,6 +66,54 @@ START_TEST(test_exit_mom_job_momradix3)
   }
 END_TEST
 
+START_TEST(test_exit_mom_job_epilogue_subtask)
+  {
+  job *pjob = (job *)calloc(1, sizeof(job));
+  int mom_radix = 0;
+  func_num = EXIT_MOM_JOB;
+  tc = 7;
+  ran_one = 0;
+  LOGLEVEL = 6;
+  pjob->ji_hosts = (hnodent *)calloc(2, sizeof(hnodent));
+  pjob->ji_hosts[0].hn_stream = 1;
+  pjob->ji_obit = TM_TASKS;
+
+  /* the epilogues are forked and the obit waits for them */
+  exit_mom_job(pjob, mom_radix);
+  fail_unless(pjob->ji_momsubt == 1);
+  fail_unless(pjob->ji_mompost == post_sister_epilogue);
+  fail_unless((pjob->ji_flags & MOM_EPILOGUE_RUN) != 0);
+  fail_unless((pjob->ji_flags & MOM_EPILOGUE_DONE) == 0);
+
+  /* they aren't forked again while the subtask runs */
+  pjob->ji_momsubt = 2;
+  exit_mom_job(pjob, mom_radix);
+  fail_unless(pjob->ji_momsubt == 2);
+
+  fail_unless(post_sister_epilogue(pjob, 0) == PBSE_NONE);
+  fail_unless((pjob->ji_flags & MOM_EPILOGUE_DONE) != 0);
+  }
+END_TEST
+
+START_TEST(test_exit_mom_job_epilogue_nofork)
+  {
+  job *pjob = (job *)calloc(1, sizeof(job));
+  int mom_radix = 0;
+  func_num = EXIT_MOM_JOB;
+  tc = 8;
+  ran_one = 0;
+  LOGLEVEL = 6;
+  pjob->ji_hosts = (hnodent *)calloc(2, sizeof(hnodent));
+  pjob->ji_hosts[0].hn_stream = 1;
+  pjob->ji_obit = TM_TASKS;
+
+  /* without a subtask the epilogues run in line */
+  start_sister_epilogue(pjob);
+  fail_unless(pjob->ji_momsubt == 0);
+  fail_unless((pjob->ji_flags & MOM_EPILOGUE_DONE) != 0);
+  }
+END_TEST
+
 Suite *exit_mom_job_suite(void)
   {
   Suite *s = suite_create("exit_mom_job methods");
@@ -74,6 +122,8 @@ Suite *exit_mom_job_suite(void)
   tcase_add_test(tc_core, test_exit_mom_job_tmnullevent);
   tcase_add_test(tc_core, test_exit_mom_job_atrvflag);
   tcase_add_test(tc_core, test_exit_mom_job_momradix3);
+  tcase_add_test(tc_core, test_exit_mom_job_epilogue_subtask);
+  tcase_add_test(tc_core, test_exit_mom_job_epilogue_nofork);
   suite_add_tcase(s, tc_core);
   return s;
   }
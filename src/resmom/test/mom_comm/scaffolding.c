@@ -17,6 +17,9 @@
 #include "pbs_job.h" /* job */
 #include "mom_func.h" /* radix_buf */
 #include "dis.h"
+#include <sstream>
+#include <string>
+#include <vector>
 
 int create_job_cpuset(job *pj) { return 0; }
 int use_cpusets(job *pj) { return 0; }
@@ -513,3 +516,16 @@ bool am_i_mother_superior(const job &pjob)
 
 void create_cpuset_reservation_if_needed(job &pjob){}
 
+
+void unpack_status_frame(
+
+  const char               *frame,
+  std::vector<std::string> &strings)
+
+  {
+  std::stringstream packed(frame);
+  std::string       str;
+
+  while (std::getline(packed, str))
+    strings.push_back(str);
+  }
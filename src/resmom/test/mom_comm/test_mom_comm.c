@@ -12,6 +12,8 @@
 #include "test_mom_comm.h"
 #include "resmon.h"
 #include "mom_server.h"
+#include "mom_hierarchy.h"
+#include "container.hpp"
 
 extern int disrsi_return_index;
 extern int disrst_return_index;
@@ -24,6 +26,7 @@ extern int ServerStatUpdateInterval;
 extern time_t LastServerUpdateTime;
 extern time_t time_now;
 extern bool ForceServerUpdate;
+extern container::item_container<received_node *> received_statuses;
 
 #define IM_DONE                     0
 #define IM_FAILURE                 -1
@@ -190,6 +193,40 @@ START_TEST(test_read_status_strings_loop)
   }
 END_TEST
 
+START_TEST(test_read_status_strings_frame)
+  {
+  struct tcp_chan  chan;
+  received_node   *rn;
+
+  disrst_return_index = 0;
+  disrsi_return_index = 0;
+  disrsi_array[0] = DIS_SUCCESS;
+  disrsi_array[1] = DIS_SUCCESS;
+  disrst_array[0] = strdup("node=napali");
+  disrst_array[1] = strdup("state=free");
+  disrst_array[2] = strdup(STATUS_FRAME_KEYWORD "node=waimea\nstate=busy\nnode=kauai\n");
+  disrst_array[3] = strdup(IS_EOL_MESSAGE);
+  read_status_strings(&chan, 1);
+
+  /* the framed statuses are filed under their own nodes */
+  rn = received_statuses.find("napali");
+  fail_unless(rn != NULL);
+  fail_unless(rn->statuses.size() == 2);
+
+  rn = received_statuses.find("waimea");
+  fail_unless(rn != NULL);
+  fail_unless(rn->statuses.size() == 2);
+  fail_unless(rn->statuses[1] == "state=busy");
+
+  rn = received_statuses.find("kauai");
+  fail_unless(rn != NULL);
+  fail_unless(rn->statuses.size() == 1);
+
+  for (int i = 0; i < 4; i++)
+    disrst_array[i] = NULL;
+  }
+END_TEST
+
 START_TEST(test_get_received_node_entry)
   {
   fail_unless(get_received_node_entry(strdup("pickle")) != NULL);
@@ -408,6 +445,50 @@ START_TEST(im_join_job_as_sister_test)
   }
 END_TEST
 
+START_TEST(post_sister_prologue_test)
+  {
+  extern job *mock_mom_find_job_return;
+  job        *pjob = (job *)calloc(1, sizeof(job));
+
+  strcpy(pjob->ji_qs.ji_jobid, "jobid");
+  pjob->ji_hosts = (hnodent *)calloc(1, sizeof(hnodent));
+  pjob->ji_momsubt = 100;
+  mock_mom_find_job_return = pjob;
+
+  /* nothing is waiting on this job */
+  fail_unless(post_sister_prologue(pjob, 1) == 0);
+  fail_unless(sister_joins.size() == 0);
+
+  /* not the subtask we started */
+  sister_joins["jobid"].subtask = 99;
+  sister_joins["jobid"].failed = false;
+  post_sister_prologue(pjob, 1);
+  fail_unless(sister_joins["jobid"].failed == false);
+
+  /* a failed prologue leaves the job for the main loop to purge */
+  sister_joins["jobid"].subtask = 100;
+  post_sister_prologue(pjob, 1);
+  fail_unless(sister_joins["jobid"].failed == true);
+  fail_unless(sister_joins["jobid"].subtask == 0);
+
+  purge_failed_sister_joins();
+  fail_unless(sister_joins.size() == 0);
+
+  /* still running */
+  sister_joins["jobid"].subtask = 100;
+  sister_joins["jobid"].failed = false;
+  purge_failed_sister_joins();
+  fail_unless(sister_joins.size() == 1);
+
+  /* the subtask went away without reaching the post routine */
+  pjob->ji_momsubt = 0;
+  purge_failed_sister_joins();
+  fail_unless(sister_joins.size() == 0);
+
+  mock_mom_find_job_return = NULL;
+  }
+END_TEST
+
 START_TEST(tm_spawn_request_test)
   {
   struct tcp_chan test_chan;
@@ -525,6 +606,10 @@ Suite *mom_comm_suite(void)
   tcase_add_test(tc_core, handle_im_obit_task_response_test);
   suite_add_tcase(s, tc_core);
 
+  tc_core = tcase_create("test_read_status_strings_frame");
+  tcase_add_test(tc_core, test_read_status_strings_frame);
+  suite_add_tcase(s, tc_core);
+
   tc_core = tcase_create("test_get_received_node_entry");
   tcase_add_test(tc_core, test_get_received_node_entry);
   suite_add_tcase(s, tc_core);
@@ -541,6 +626,7 @@ Suite *mom_comm_suite(void)
   tc_core = tcase_create("im_join_job_as_sister_test");
   tcase_add_test(tc_core, im_join_job_as_sister_test);
   tcase_add_test(tc_core, handle_im_poll_job_response_test);
+  tcase_add_test(tc_core, post_sister_prologue_test);
   suite_add_tcase(s, tc_core);
 
   tc_core = tcase_create("tm_spawn_request_test");
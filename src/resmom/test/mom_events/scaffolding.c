@@ -0,0 +1,59 @@
+#include "license_pbs.h" /* See here for the software license */
+#include <pbs_config.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include "server_limits.h" /* PBS_NET_MAX_CONNECTIONS */
+#include "net_connect.h" /* conn_type */
+#include "log.h" /* LOG_BUF_SIZE */
+#include "list_link.h" /* tlist_head */
+#include "pbs_error.h"
+
+tlist_head svr_alljobs;
+int LOGLEVEL = 7; /* force logging code to be exercised as tests run */
+char log_buffer[LOG_BUF_SIZE];
+
+int children_caught = 0;
+int hups_caught = 0;
+
+void *(*conn_funcs[PBS_NET_MAX_CONNECTIONS])(void *);
+
+void catch_child(int sig)
+  {
+  children_caught++;
+  }
+
+void catch_hup(int sig)
+  {
+  hups_caught++;
+  }
+
+int add_conn(int sock, enum conn_type type, pbs_net_t addr, unsigned int port, unsigned int socktype, void *(*func)(void *))
+  {
+  conn_funcs[sock] = func;
+  return(PBSE_NONE);
+  }
+
+void close_conn(int sd, int has_mutex)
+  {
+  conn_funcs[sd] = NULL;
+  close(sd);
+  }
+
+void clear_conn(int sd, int has_mutex)
+  {
+  conn_funcs[sd] = NULL;
+  }
+
+void *get_next(list_link pl, char *file, int line)
+  {
+  if ((pl.ll_next == NULL) ||
+      ((pl.ll_next == &pl) && (pl.ll_struct != NULL)))
+    {
+    return NULL;
+    }
+  return(pl.ll_next->ll_struct);
+  }
+
+void log_err(int errnum, const char *routine, const char *text) {}
@@ -0,0 +1,344 @@
+#include "license_pbs.h" /* See here for the software license */
+#include <pbs_config.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <signal.h>
+#include <poll.h>
+#include <sys/wait.h>
+
+#include "pbs_error.h"
+#include "pbs_job.h"
+#include "server_limits.h"
+#include "net_connect.h"
+#include "mom_events.h"
+#include "test_mom_events.h"
+
+extern tlist_head svr_alljobs;
+extern int children_caught;
+extern int hups_caught;
+extern void *(*conn_funcs[PBS_NET_MAX_CONNECTIONS])(void *);
+
+
+int find_conn(
+
+  void *(*func)(void *))
+
+  {
+  for (int i = 0; i < PBS_NET_MAX_CONNECTIONS; i++)
+    {
+    if (conn_funcs[i] == func)
+      return(i);
+    }
+
+  return(-1);
+  }
+
+
+bool readable(
+
+  int fd,
+  int timeout_ms)
+
+  {
+  struct pollfd pfd;
+
+  pfd.fd = fd;
+  pfd.events = POLLIN;
+  pfd.revents = 0;
+
+  return((poll(&pfd, 1, timeout_ms) == 1) && (pfd.revents & POLLIN));
+  }
+
+
+void fire(
+
+  int fd)
+
+  {
+  int args[3];
+
+  args[0] = fd;
+  args[1] = 0;
+  args[2] = 0;
+  conn_funcs[fd]((void *)args);
+  }
+
+
+START_TEST(test_no_events)
+  {
+  /* without init_mom_events() the tasks are scanned every time */
+  fail_unless(mom_events_active() == false);
+  fail_unless(task_scan_needed(1000) == true);
+  fail_unless(task_scan_needed(1000) == true);
+
+  watch_task_pids();
+  fail_unless(find_conn(read_task_pidfd) == -1);
+  }
+END_TEST
+
+
+START_TEST(test_signal_events)
+  {
+  sigset_t wait_sigs;
+  sigset_t blocked;
+  int      fd;
+
+  sigemptyset(&wait_sigs);
+  sigaddset(&wait_sigs, SIGCHLD);
+  sigaddset(&wait_sigs, SIGHUP);
+  sigaddset(&wait_sigs, SIGTERM);
+
+  fail_unless(init_mom_events(&wait_sigs) == PBSE_NONE);
+  fail_unless(mom_events_active() == true);
+  fail_unless(sigismember(&wait_sigs, SIGCHLD) == 0);
+  fail_unless(sigismember(&wait_sigs, SIGHUP) == 0);
+  fail_unless(sigismember(&wait_sigs, SIGTERM) == 1);
+
+  fail_unless((fd = find_conn(read_signal_event)) >= 0);
+  fail_unless(find_conn(read_timer_event) >= 0);
+
+  /* the main loop keeps them blocked, so they queue on the descriptor */
+  sigemptyset(&blocked);
+  sigaddset(&blocked, SIGCHLD);
+  sigaddset(&blocked, SIGHUP);
+  sigprocmask(SIG_BLOCK, &blocked, NULL);
+
+  fail_unless(readable(fd, 0) == false);
+  kill(getpid(), SIGCHLD);
+  kill(getpid(), SIGHUP);
+  fail_unless(readable(fd, 1000) == true);
+
+  fire(fd);
+  fail_unless(children_caught == 1);
+  fail_unless(hups_caught == 1);
+  fail_unless(readable(fd, 0) == false);
+  }
+END_TEST
+
+
+START_TEST(test_event_timer)
+  {
+  sigset_t wait_sigs;
+  int      fd;
+
+  sigemptyset(&wait_sigs);
+  fail_unless(init_mom_events(&wait_sigs) == PBSE_NONE);
+  fail_unless((fd = find_conn(read_timer_event)) >= 0);
+
+  set_event_timer(time(NULL) + 3600);
+  fail_unless(readable(fd, 0) == false);
+
+  /* a deadline that has passed fires right away */
+  set_event_timer(time(NULL) - 1);
+  fail_unless(readable(fd, 1000) == true);
+  fire(fd);
+  fail_unless(readable(fd, 0) == false);
+
+  /* it can be armed again for the same time once it has fired */
+  set_event_timer(time(NULL) - 1);
+  fail_unless(readable(fd, 1000) == true);
+  fire(fd);
+
+  set_event_timer(time(NULL) + 1);
+  set_event_timer(0);
+  fail_unless(readable(fd, 1500) == false);
+  }
+END_TEST
+
+
+START_TEST(test_task_pidfds)
+  {
+  sigset_t  wait_sigs;
+  job      *pjob = (job *)calloc(1, sizeof(job));
+  task     *ptask = (task *)calloc(1, sizeof(task));
+  pid_t     pid;
+  int       fd;
+  time_t    now = time(NULL);
+
+  sigemptyset(&wait_sigs);
+  fail_unless(init_mom_events(&wait_sigs) == PBSE_NONE);
+
+  if ((pid = fork()) == 0)
+    {
+    pause();
+    exit(0);
+    }
+
+  CLEAR_HEAD(svr_alljobs);
+  CLEAR_HEAD(pjob->ji_tasks);
+  pjob->ji_alljobs.ll_next = &svr_alljobs;
+  pjob->ji_alljobs.ll_prior = &svr_alljobs;
+  pjob->ji_alljobs.ll_struct = pjob;
+  svr_alljobs.ll_next = &pjob->ji_alljobs;
+  svr_alljobs.ll_prior = &pjob->ji_alljobs;
+
+  ptask->ti_jobtask.ll_next = &pjob->ji_tasks;
+  ptask->ti_jobtask.ll_prior = &pjob->ji_tasks;
+  ptask->ti_jobtask.ll_struct = ptask;
+  pjob->ji_tasks.ll_next = &ptask->ti_jobtask;
+  pjob->ji_tasks.ll_prior = &ptask->ti_jobtask;
+
+  ptask->ti_qs.ti_sid = pid;
+  ptask->ti_qs.ti_status = TI_STATE_RUNNING;
+
+  watch_task_pids();
+  fail_unless((fd = find_conn(read_task_pidfd)) >= 0);
+
+  /* the first pass always scans, then only the sweep interval does */
+  fail_unless(task_scan_needed(now) == true);
+  fail_unless(task_scan_needed(now + 1) == false);
+  fail_unless(task_scan_needed(now + TASK_SCAN_INTERVAL) == true);
+  fail_unless(task_scan_needed(now + TASK_SCAN_INTERVAL + 1) == false);
+
+  /* a task is only watched once */
+  watch_task_pids();
+  fail_unless(find_conn(read_task_pidfd) == fd);
+  fail_unless(readable(fd, 0) == false);
+
+  kill(pid, SIGKILL);
+  waitpid(pid, NULL, 0);
+  fail_unless(readable(fd, 1000) == true);
+
+  fire(fd);
+  fail_unless(find_conn(read_task_pidfd) == -1);
+  fail_unless(task_scan_needed(now + TASK_SCAN_INTERVAL + 2) == true);
+
+  /* the session may live on, so the task is scanned for until it's marked exited */
+  watch_task_pids();
+  fail_unless(find_conn(read_task_pidfd) == -1);
+  fail_unless(task_scan_needed(now + TASK_SCAN_INTERVAL + 3) == true);
+
+  ptask->ti_qs.ti_status = TI_STATE_EXITED;
+  watch_task_pids();
+  fail_unless(task_scan_needed(now + TASK_SCAN_INTERVAL + 4) == false);
+  }
+END_TEST
+
+
+START_TEST(test_task_gone)
+  {
+  sigset_t  wait_sigs;
+  job      *pjob = (job *)calloc(1, sizeof(job));
+  task     *ptask = (task *)calloc(1, sizeof(task));
+  pid_t     pid;
+  time_t    now = time(NULL);
+
+  sigemptyset(&wait_sigs);
+  fail_unless(init_mom_events(&wait_sigs) == PBSE_NONE);
+
+  /* a session leader that is already reaped can't be watched */
+  if ((pid = fork()) == 0)
+    exit(0);
+
+  waitpid(pid, NULL, 0);
+
+  CLEAR_HEAD(svr_alljobs);
+  CLEAR_HEAD(pjob->ji_tasks);
+  pjob->ji_alljobs.ll_next = &svr_alljobs;
+  pjob->ji_alljobs.ll_prior = &svr_alljobs;
+  pjob->ji_alljobs.ll_struct = pjob;
+  svr_alljobs.ll_next = &pjob->ji_alljobs;
+  svr_alljobs.ll_prior = &pjob->ji_alljobs;
+
+  ptask->ti_jobtask.ll_next = &pjob->ji_tasks;
+  ptask->ti_jobtask.ll_prior = &pjob->ji_tasks;
+  ptask->ti_jobtask.ll_struct = ptask;
+  pjob->ji_tasks.ll_next = &ptask->ti_jobtask;
+  pjob->ji_tasks.ll_prior = &ptask->ti_jobtask;
+
+  ptask->ti_qs.ti_sid = pid;
+  ptask->ti_qs.ti_status = TI_STATE_RUNNING;
+
+  fail_unless(task_scan_needed(now) == true);
+  watch_task_pids();
+  fail_unless(find_conn(read_task_pidfd) == -1);
+  fail_unless(task_scan_needed(now + 1) == true);
+  fail_unless(task_scan_needed(now + 2) == true);
+  }
+END_TEST
+
+
+START_TEST(test_starter_pipe)
+  {
+  sigset_t wait_sigs;
+  int      pipes[2];
+  int      rc = 0;
+
+  fail_unless(pipe(pipes) == 0);
+
+  /* without the event descriptors the starters are still polled */
+  fail_unless(watch_starter_pipe(pipes[0]) == false);
+  fail_unless(find_conn(read_starter_pipe) == -1);
+
+  sigemptyset(&wait_sigs);
+  fail_unless(init_mom_events(&wait_sigs) == PBSE_NONE);
+
+  fail_unless(watch_starter_pipe(-1) == false);
+  fail_unless(watch_starter_pipe(pipes[0]) == true);
+  fail_unless(find_conn(read_starter_pipe) == pipes[0]);
+
+  fail_unless(write(pipes[1], &rc, sizeof(rc)) == sizeof(rc));
+  fire(pipes[0]);
+  fail_unless(find_conn(read_starter_pipe) == -1);
+
+  /* the pipe is left open for the starter's result to be read */
+  fail_unless(readable(pipes[0], 0) == true);
+
+  fail_unless(watch_starter_pipe(pipes[0]) == true);
+  unwatch_starter_pipe(pipes[0]);
+  fail_unless(find_conn(read_starter_pipe) == -1);
+
+  close(pipes[0]);
+  close(pipes[1]);
+  }
+END_TEST
+
+
+Suite *mom_events_suite(void)
+  {
+  Suite *s = suite_create("mom_events_suite methods");
+  TCase *tc_core = tcase_create("test_no_events");
+  tcase_add_test(tc_core, test_no_events);
+  suite_add_tcase(s, tc_core);
+
+  tc_core = tcase_create("test_signal_events");
+  tcase_add_test(tc_core, test_signal_events);
+  suite_add_tcase(s, tc_core);
+
+  tc_core = tcase_create("test_event_timer");
+  tcase_add_test(tc_core, test_event_timer);
+  suite_add_tcase(s, tc_core);
+
+  tc_core = tcase_create("test_task_pidfds");
+  tcase_add_test(tc_core, test_task_pidfds);
+  suite_add_tcase(s, tc_core);
+
+  tc_core = tcase_create("test_task_gone");
+  tcase_add_test(tc_core, test_task_gone);
+  suite_add_tcase(s, tc_core);
+
+  tc_core = tcase_create("test_starter_pipe");
+  tcase_add_test(tc_core, test_starter_pipe);
+  suite_add_tcase(s, tc_core);
+
+  return s;
+  }
+
+void rundebug()
+  {
+  }
+
+int main(void)
+  {
+  int number_failed = 0;
+  SRunner *sr = NULL;
+  rundebug();
+  sr = srunner_create(mom_events_suite());
+  srunner_set_log(sr, "mom_events_suite.log");
+  srunner_run_all(sr, CK_NORMAL);
+  number_failed = srunner_ntests_failed(sr);
+  srunner_free(sr);
+  return number_failed;
+  }
@@ -0,0 +1,8 @@
+#include "license_pbs.h" /* See here for the software license */
+#ifndef _MOM_EVENTS_CT_H
+#define _MOM_EVENTS_CT_H
+#include <check.h>
+
+Suite *mom_events_suite();
+
+#endif /* _MOM_EVENTS_CT_H */
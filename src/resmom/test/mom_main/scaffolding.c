@@ -589,6 +589,19 @@ void close_conn(int sd, int has_mutex)
   exit(1);
   }
 
+int set_wait_request_mechanism(enum wait_request_type type)
+  {
+  return(0);
+  }
+
+pid_t fork_me(int conn)
+  {
+  fprintf(stderr, "The call to fork_me needs to be mocked!!\n");
+  exit(1);
+  }
+
+void purge_failed_sister_joins() {}
+
 void catch_child(int sig)
   {
   fprintf(stderr, "The call to catch_child needs to be mocked!!\n");
@@ -763,6 +776,37 @@ char *pbse_to_txt(int err)
   exit(1);
   }
 
+int init_job_cgroups(const char *root)
+  {
+  return 0;
+  }
+
+int init_mom_events(sigset_t *wait_sigs)
+  {
+  return 0;
+  }
+
+bool mom_events_active(void)
+  {
+  return(false);
+  }
+
+void set_event_timer(time_t when) {}
+
+void watch_task_pids(void) {}
+
+bool task_scan_needed(time_t now)
+  {
+  return(true);
+  }
+
+bool watch_starter_pipe(int fd)
+  {
+  return(false);
+  }
+
+void unwatch_starter_pipe(int fd) {}
+
 
 #ifdef PENABLE_LINUX26_CPUSETS
 
@@ -5,6 +5,7 @@
 #include "mom_main.h"
 #include "mom_config.h"
 #include "pbs_error.h"
+#include "mom_job_cleanup.h"
 #include "test_mom_main.h"
 
 extern bool parsing_hierarchy;
@@ -15,6 +16,7 @@ extern time_t time_now;
 extern time_t wait_time;
 extern time_t LastServerUpdateTime;
 extern time_t last_poll_time;
+extern long   TJobStartTimeout;
 extern bool ForceServerUpdate;
 
 void read_mom_hierarchy();
@@ -24,7 +26,9 @@ time_t calculate_select_timeout();
 extern int  exiting_tasks;
 
 bool call_scan_for_exiting();
+time_t next_job_deadline(void);
 extern tlist_head svr_alljobs;
+extern std::vector<exiting_job_info> exiting_job_list;
 
 START_TEST(test_read_mom_hierarchy)
   {
@@ -220,6 +224,60 @@ START_TEST(calculate_select_timeout_test)
 END_TEST
 
 
+START_TEST(test_next_job_deadline)
+  {
+  job              job1;
+  job              job2;
+  exiting_job_info eji("3.napali");
+
+  memset(&job1, 0, sizeof(job1));
+  memset(&job2, 0, sizeof(job2));
+  svr_alljobs.ll_prior = &job2.ji_alljobs;
+  svr_alljobs.ll_next = &job1.ji_alljobs;
+  svr_alljobs.ll_struct = NULL;
+
+  job1.ji_alljobs.ll_prior = &svr_alljobs;
+  job1.ji_alljobs.ll_next = &job2.ji_alljobs;
+  job1.ji_alljobs.ll_struct = &job1;
+
+  job2.ji_alljobs.ll_prior = &job1.ji_alljobs;
+  job2.ji_alljobs.ll_next = &svr_alljobs;
+  job2.ji_alljobs.ll_struct = &job2;
+
+  exiting_job_list.clear();
+  fail_unless(next_job_deadline() == 0);
+
+  /* check_jobs_in_mom_wait() acts once more than job_exit_wait_time has passed */
+  job_exit_wait_time = 60;
+  job1.ji_qs.ji_substate = JOB_SUBSTATE_MOM_WAIT;
+  job1.ji_kill_started = 1000;
+  fail_unless(next_job_deadline() == 1061);
+
+  job2.ji_qs.ji_substate = JOB_SUBSTATE_MOM_WAIT;
+  job2.ji_kill_started = 990;
+  fail_unless(next_job_deadline() == 1051);
+
+  /* TMOMScanForStarting() gives up on a starter after TJobStartTimeout */
+  TJobStartTimeout = 300;
+  job1.ji_qs.ji_substate = JOB_SUBSTATE_STARTING;
+  job1.ji_wattr[JOB_ATR_mtime].at_val.at_long = 700;
+  fail_unless(next_job_deadline() == 1001);
+
+  job1.ji_wattr[JOB_ATR_mtime].at_val.at_long = 0;
+  fail_unless(next_job_deadline() == 1051);
+
+  /* the earliest obit retry wins */
+  eji.obit_sent = 1000;
+  exiting_job_list.push_back(eji);
+  fail_unless(next_job_deadline() == 1030);
+
+  exiting_job_list.clear();
+  svr_alljobs.ll_prior = &svr_alljobs;
+  svr_alljobs.ll_next = &svr_alljobs;
+  }
+END_TEST
+
+
 Suite *mom_main_suite(void)
   {
   Suite *s = suite_create("mom_main_suite methods");
@@ -240,6 +298,10 @@ Suite *mom_main_suite(void)
   tcase_add_test(tc_core, test_call_scan_for_exiting);
   suite_add_tcase(s, tc_core);
 
+  tc_core = tcase_create("test_next_job_deadline");
+  tcase_add_test(tc_core, test_next_job_deadline);
+  suite_add_tcase(s, tc_core);
+
   return s;
   }
 
@@ -36,6 +36,7 @@ time_t time_now;
 unsigned int pbs_mom_port = 0;
 unsigned int default_server_port = 0;
 int ServerStatUpdateInterval = DEFAULT_SERVER_STAT_UPDATES;
+int status_refresh_count = 10;
 float ideal_load_val = -1.0;
 int updates_waiting_to_send = 0;
 const char *PBSServerCmds[] = { "NULL", "HELLO", "CLUSTER_ADDRS", "UPDATE", "STATUS", "GPU_STATUS", NULL };
@@ -64,6 +65,8 @@ time_t       first_update_time = 0;
 container::item_container<received_node *> received_statuses;
 bool exit_called = false;
 bool ForceServerUpdate = false;
+int connect_failures = 0;
+pthread_mutex_t log_mutex = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
 
 
 char  ret_string[MAXLINE];
@@ -123,8 +126,9 @@ const char *dependent(const char *res, struct rm_attribute *attr)
 
 char * netaddr(struct sockaddr_in *ap)
   {
-  fprintf(stderr, "The call to netaddr needs to be mocked!!\n");
-  exit(1);
+  static char addr[] = "127.0.0.1";
+
+  return(addr);
   }
 
 int MUStrNCat(char **BPtr, int *BSpace, const char *Src)
@@ -191,8 +195,11 @@ int DIS_tcp_wflush(tcp_chan *chan)
   return DIS_SUCCESS;
   }
 
+std::vector<std::string> dis_written;
+
 int diswcs(tcp_chan *chan, const char *value, size_t nchars)
   {
+  dis_written.push_back(std::string(value, nchars));
   return DIS_SUCCESS;
   }
 
@@ -245,6 +252,12 @@ int rpp_close(int index)
 
 int tcp_connect_sockaddr(struct sockaddr *sa, size_t sa_size, bool use_log)
   {
+  if (connect_failures > 0)
+    {
+    connect_failures--;
+    return(-1);
+    }
+
   return 0;
   }
 
@@ -373,8 +386,7 @@ int delete_last_word_from_dynamic_string(dynamic_string *ds)
 
 void send_update_soon()
   {
-  fprintf(stderr, "The call to send_update_soon needs to be mocked!!\n");
-  exit(1);
+  ForceServerUpdate = true;
   }
 
 int AVL_list(AvlTree tree, char **Buf, long *current_len, long *max_len)
@@ -427,3 +439,31 @@ bool overwrite_cache(
   {
   return(true);
   }
+
+void pack_status_frame(
+
+  std::vector<std::string> &strings,
+  std::string              &frame)
+
+  {
+  frame = STATUS_FRAME_KEYWORD;
+
+  for (unsigned int i = 0; i < strings.size(); i++)
+    frame += strings[i] + "\n";
+  }
+
+int parse_status_frame_version(
+
+  const char *str)
+
+  {
+  return(0);
+  }
+
+int parse_status_deltas_version(
+
+  const char *str)
+
+  {
+  return(0);
+  }
@@ -1,15 +1,23 @@
 #include "license_pbs.h" /* See here for the software license */
+#include <sstream>
 #include "mom_server_lib.h"
 #include "test_mom_server.h"
 #include <stdlib.h>
 #include <stdio.h>
+#include <unistd.h>
 
 #include "pbs_error.h"
 #include "mom_server.h"
 #include "resmon.h"
+#include "pbs_nodes.h"
+#include "mom_hierarchy.h"
+#include "dis.h"
 
 #define MAXLINE 1024
 #define NO_SERVER_CONFIGURED -1
+#define COULD_NOT_CONTACT_SERVER -2
+#define STATUS_SEND_ATTEMPTS 3
+#define UPDATE_TO_MOM 1
 
 extern mom_hierarchy_t *mh;
 
@@ -31,6 +39,19 @@ extern int    UpdateFailCount;
 extern time_t LastServerUpdateTime;
 extern int    is_reporter_mom;
 extern mom_server mom_servers[PBS_MAXSERVER];
+extern int    received_cluster_addrs;
+extern int    status_refresh_count;
+extern std::vector<std::string> dis_written;
+extern int    mom_server_count;
+extern bool   send_full_status;
+extern int    updates_since_full_status;
+extern int    server_deltas_version;
+extern std::vector<std::string> mom_status;
+extern std::vector<std::string> mom_status_delta;
+extern std::map<std::string, status_map> acked_cached;
+extern int    connect_failures;
+
+void mom_server_diag(mom_server *pms, int sindex, std::stringstream &output);
 
 
 START_TEST(test_sort_paths)
@@ -211,10 +232,347 @@ START_TEST(test_mom_server_all_update_stat_clear_force)
   mom_server_all_update_stat();
   fail_unless(!ForceServerUpdate);
 
+  /* the update is sent by the status sender thread */
+  while (status_update_pending() == true)
+    usleep(1000);
+
   LastServerUpdateTime = time(NULL) - 100;
   ForceServerUpdate = true;
   mom_server_all_update_stat();
   fail_unless(!ForceServerUpdate);
+
+  while (status_update_pending() == true)
+    usleep(1000);
+  }
+END_TEST
+
+
+status_update *new_test_update()
+  {
+  status_update *su = new status_update();
+
+  su->boards.push_back(std::vector<std::string>(2, "Think of a status line"));
+  su->first_update = false;
+  su->dispatched = time(NULL) - 10;
+  su->rc = NO_SERVER_CONFIGURED;
+  su->server_index = -1;
+  su->latency = -1;
+  su->cached_to_server = false;
+  memset(su->servers, 0, sizeof(su->servers));
+  strcpy(su->servers[1].pbs_servername, "test");
+
+  return(su);
+  }
+
+
+START_TEST(test_send_status_update)
+  {
+  status_update *su = new_test_update();
+
+  connect_failures = 0;
+  send_status_update(su);
+  fail_unless(su->rc == PBSE_NONE);
+  fail_unless(su->server_index == 1);
+  fail_unless(su->latency >= 0);
+  fail_unless(su->cached_to_server == true);
+
+  /* the outcome is recorded on the real server entry */
+  memset(mom_servers, 0, sizeof(mom_server) * PBS_MAXSERVER);
+  strcpy(mom_servers[1].pbs_servername, "test");
+  UpdateFailCount = 2;
+  time_t dispatched = su->dispatched;
+
+  collect_status_update(su);
+  fail_unless(UpdateFailCount == 0);
+  fail_unless(mom_servers[1].MOMLastSendToServerTime == dispatched);
+  fail_unless(mom_servers[1].MOMStatusUpdateCount == 1);
+
+  /* a server that can't be reached is tried again */
+  su = new_test_update();
+  connect_failures = 1;
+  send_status_update(su);
+  fail_unless(su->rc == PBSE_NONE);
+  fail_unless(connect_failures == 0);
+  delete su;
+
+  /* nothing to send to */
+  su = new_test_update();
+  su->servers[1].pbs_servername[0] = '\0';
+  send_status_update(su);
+  fail_unless(su->rc == NO_SERVER_CONFIGURED);
+  fail_unless(su->server_index == -1);
+
+  collect_status_update(su);
+  fail_unless(UpdateFailCount == 0);
+  fail_unless(mom_servers[1].MOMStatusUpdateCount == 1);
+
+  su = new_test_update();
+  su->rc = COULD_NOT_CONTACT_SERVER;
+  collect_status_update(su);
+  fail_unless(UpdateFailCount == 1);
+  }
+END_TEST
+
+
+START_TEST(test_send_status_update_gives_up)
+  {
+  status_update *su = new_test_update();
+
+  connect_failures = 10;
+  send_status_update(su);
+  fail_unless(su->rc == COULD_NOT_CONTACT_SERVER);
+  fail_unless(connect_failures == 10 - STATUS_SEND_ATTEMPTS);
+  fail_unless(su->server_index == -1);
+  connect_failures = 0;
+  delete su;
+  }
+END_TEST
+
+
+START_TEST(test_status_latency_diag)
+  {
+  mom_server        pms;
+  std::stringstream output;
+
+  memset(&pms, 0, sizeof(pms));
+  strcpy(pms.pbs_servername, "test");
+
+  mom_server_diag(&pms, 0, output);
+  fail_unless(output.str().find("Status Update Latency") == std::string::npos);
+
+  record_status_latency(&pms, 3);
+  record_status_latency(&pms, 5);
+  mom_server_diag(&pms, 0, output);
+  fail_unless(output.str().find("Status Update Latency:  5 ms (average 4 ms over 2 updates)") != std::string::npos, output.str().c_str());
+  }
+END_TEST
+
+
+START_TEST(test_build_status_delta)
+  {
+  const char *first[] = { "arch=x86_64", "state=free", "jobs=", "varattr=a", "<gpu_status>",
+                          "gpuid=0", "</gpu_status>", "availmem=10kb" };
+  const char *second[] = { "arch=x86_64", "state=free", "jobs=", "<gpu_status>",
+                           "gpuid=0", "</gpu_status>", "availmem=20kb" };
+  std::vector<std::string> status(first, first + 8);
+  std::vector<std::string> order;
+  std::vector<std::string> delta;
+  status_map               acked;
+
+  index_status(status, acked, &order);
+  fail_unless(order.size() == 6);
+  fail_unless(order[4] == "<gpu_status>");
+  fail_unless(acked["<gpu_status>"].size() == 3);
+  fail_unless(acked["availmem"][0] == "availmem=10kb");
+
+  /* unchanged keys are left out, except the ones the server always acts on */
+  build_status_delta(status, acked, delta);
+  fail_unless(delta.size() == 3);
+  fail_unless(delta[0] == "status_delta=true");
+  fail_unless(delta[1] == "state=free");
+  fail_unless(delta[2] == "jobs=");
+
+  status.assign(second, second + 7);
+  build_status_delta(status, acked, delta);
+  fail_unless(delta.size() == 5);
+  fail_unless(delta[3] == "availmem=20kb");
+  fail_unless(delta[4] == "status_removed=varattr");
+
+  /* a changed gpu block goes out whole */
+  status[4] = "gpuid=1";
+  build_status_delta(status, acked, delta);
+  fail_unless(delta.size() == 8);
+  fail_unless(delta[3] == "<gpu_status>");
+  fail_unless(delta[5] == "</gpu_status>");
+  }
+END_TEST
+
+
+START_TEST(test_full_status_refresh)
+  {
+  received_cluster_addrs = true;
+  server_deltas_version = STATUS_DELTAS_VERSION;
+  mom_server_count = 1;
+  status_refresh_count = 2;
+  send_full_status = true;
+  updates_since_full_status = 0;
+  mom_status.clear();
+  mom_status.push_back("state=free");
+  mom_status_delta.clear();
+
+  /* nothing acknowledged yet */
+  fail_unless(should_send_full_status() == true);
+
+  update_acked_status(PBSE_NONE);
+  fail_unless(should_send_full_status() == false);
+
+  mom_status_delta.push_back("status_delta=true");
+  update_acked_status(PBSE_NONE);
+  fail_unless(should_send_full_status() == false);
+  update_acked_status(PBSE_NONE);
+  fail_unless(should_send_full_status() == true);
+
+  mom_status_delta.clear();
+  update_acked_status(PBSE_NONE);
+  fail_unless(should_send_full_status() == false);
+
+  update_acked_status(NEED_FULL_STATUS);
+  fail_unless(should_send_full_status() == true);
+  update_acked_status(PBSE_NONE);
+
+  mom_server_count = 2;
+  fail_unless(should_send_full_status() == true);
+  mom_server_count = 1;
+
+  /* a server that doesn't merge deltas */
+  server_deltas_version = 0;
+  fail_unless(should_send_full_status() == true);
+  server_deltas_version = STATUS_DELTAS_VERSION;
+
+  status_refresh_count = 0;
+  fail_unless(should_send_full_status() == true);
+  }
+END_TEST
+
+
+START_TEST(test_build_cached_delta)
+  {
+  const char *first[] = { "node=a", "state=free", "jobs=", "availmem=10kb",
+                          "node=b", "first_update=true", "state=free", "jobs=" };
+  const char *twice[] = { "node=a", "state=free", "node=a", "state=busy" };
+  std::vector<std::string>          cached(first, first + 8);
+  std::vector<std::string>          delta;
+  std::map<std::string, status_map> acked;
+  std::map<std::string, status_map> base;
+
+  /* nothing acknowledged yet, so everything goes out whole */
+  build_cached_delta(cached, acked, base, delta);
+  fail_unless(delta == cached);
+  fail_unless(base.size() == 2);
+  fail_unless(base["a"]["availmem"][0] == "availmem=10kb");
+  fail_unless(base["b"].find("first_update") == base["b"].end());
+
+  acked.swap(base);
+  cached[3] = "availmem=20kb";
+  cached.erase(cached.begin() + 5);
+  build_cached_delta(cached, acked, base, delta);
+  fail_unless(delta.size() == 9, "%d strings", (int)delta.size());
+  fail_unless(delta[0] == "node=a");
+  fail_unless(delta[1] == STATUS_DELTA_KEYWORD);
+  fail_unless(delta[4] == "availmem=20kb");
+  fail_unless(delta[5] == "node=b");
+  fail_unless(delta[6] == STATUS_DELTA_KEYWORD);
+
+  /* numa boards aren't tracked */
+  cached.push_back("numa_board=0");
+  build_cached_delta(cached, acked, base, delta);
+  fail_unless(delta.size() == 9);
+  fail_unless(delta[6] == "state=free");
+  fail_unless(base.find("b") == base.end());
+
+  /* a node reported twice builds on its first report */
+  cached.assign(twice, twice + 4);
+  acked.clear();
+  build_cached_delta(cached, acked, base, delta);
+  fail_unless(delta.size() == 5);
+  fail_unless(delta[3] == STATUS_DELTA_KEYWORD);
+  fail_unless(delta[4] == "state=busy");
+  fail_unless(base["a"]["state"][0] == "state=busy");
+
+  /* the bases are kept only once a server takes them */
+  status_update *su = new_test_update();
+  su->cached_base = base;
+  su->cached_to_server = true;
+  su->rc = PBSE_NONE;
+  collect_status_update(su);
+  fail_unless(acked_cached.size() == 1);
+
+  su = new_test_update();
+  su->cached_base = base;
+  su->rc = PBSE_NONE;
+  collect_status_update(su);
+  fail_unless(acked_cached.size() == 0);
+  }
+END_TEST
+
+
+START_TEST(test_write_status_frame_version)
+  {
+  const char               *statuses[] = { "node=a", "state=free", "node=b", "state=busy" };
+  std::vector<std::string>  cached(statuses, statuses + 4);
+  std::vector<std::string>  none;
+  struct tcp_chan           chan;
+  node_comm_t               nc;
+
+  memset(&chan, 0, sizeof(chan));
+  memset(&nc, 0, sizeof(nc));
+
+  /* a server that didn't advertise frames gets the plain strings */
+  dis_written.clear();
+  fail_unless(write_status_frame(&chan, __func__, cached, &nc, UPDATE_TO_MOM, 0) == DIS_SUCCESS);
+  fail_unless(dis_written == cached);
+
+  dis_written.clear();
+  fail_unless(write_status_frame(&chan, __func__, cached, &nc, UPDATE_TO_MOM, STATUS_FRAME_VERSION) == DIS_SUCCESS);
+  fail_unless(dis_written.size() == 1);
+  fail_unless(!strncmp(dis_written[0].c_str(), STATUS_FRAME_KEYWORD, strlen(STATUS_FRAME_KEYWORD)));
+
+  dis_written.clear();
+  fail_unless(write_status_frame(&chan, __func__, none, &nc, UPDATE_TO_MOM, STATUS_FRAME_VERSION) == DIS_SUCCESS);
+  fail_unless(dis_written.size() == 0);
+  }
+END_TEST
+
+
+START_TEST(test_copy_mom_hierarchy)
+  {
+  extern pthread_mutex_t  hierarchy_mutex;
+  extern unsigned long    hierarchy_generation;
+  mom_hierarchy_t         copy;
+  mom_levels              levels;
+  mom_nodes               nodes;
+  node_comm_t             nc;
+  unsigned long           generation;
+
+  memset(&nc, 0, sizeof(nc));
+  nc.stream = -1;
+  nc.name = strdup("napali");
+  nodes.push_back(nc);
+  nc.name = strdup("waimea");
+  nodes.push_back(nc);
+  levels.push_back(nodes);
+
+  mh = initialize_mom_hierarchy();
+  mh->paths.push_back(levels);
+
+  generation = copy_mom_hierarchy(copy);
+
+  /* the copy is used without the lock */
+  fail_unless(pthread_mutex_trylock(&hierarchy_mutex) == 0);
+  pthread_mutex_unlock(&hierarchy_mutex);
+
+  fail_unless(copy.paths[0][0].size() == 2);
+  fail_unless(!strcmp(copy.paths[0][0][1].name, "waimea"));
+  fail_unless(copy.paths[0][0][1].name != mh->paths[0][0][1].name);
+
+  copy.paths[0][0][1].bad = TRUE;
+  copy.paths[0][0][1].mtime = 5;
+  copy.current_node = 1;
+  restore_mom_hierarchy_state(copy, generation);
+
+  fail_unless(mh->paths[0][0][1].bad == TRUE);
+  fail_unless(mh->paths[0][0][1].mtime == 5);
+  fail_unless(mh->current_node == 1);
+  fail_unless(copy.paths.size() == 0);
+
+  /* a hierarchy that was replaced meanwhile isn't touched */
+  generation = copy_mom_hierarchy(copy);
+  hierarchy_generation++;
+
+  copy.paths[0][0][0].bad = TRUE;
+  restore_mom_hierarchy_state(copy, generation);
+
+  fail_unless(mh->paths[0][0][0].bad == FALSE);
   }
 END_TEST
 
@@ -242,6 +600,24 @@ Suite *mom_server_suite(void)
   tcase_add_test(tc_core, test_mom_server_all_update_stat_clear_force);
   suite_add_tcase(s, tc_core);
 
+  tc_core = tcase_create("test_send_status_update");
+  tcase_add_test(tc_core, test_send_status_update);
+  tcase_add_test(tc_core, test_status_latency_diag);
+  suite_add_tcase(s, tc_core);
+
+  tc_core = tcase_create("test_send_status_update_gives_up");
+  tcase_add_test(tc_core, test_send_status_update_gives_up);
+  tcase_set_timeout(tc_core, 10);
+  suite_add_tcase(s, tc_core);
+
+  tc_core = tcase_create("test_build_status_delta");
+  tcase_add_test(tc_core, test_build_status_delta);
+  tcase_add_test(tc_core, test_full_status_refresh);
+  tcase_add_test(tc_core, test_build_cached_delta);
+  tcase_add_test(tc_core, test_write_status_frame_version);
+  tcase_add_test(tc_core, test_copy_mom_hierarchy);
+  suite_add_tcase(s, tc_core);
+
   return s;
   }
 
@@ -201,3 +201,7 @@ void memcheck(const char *buf) {}
 
 void log_err(int errnum, const char *routine, const char *text) {}
 
+int set_wait_request_mechanism(enum wait_request_type type)
+  {
+  return(0);
+  }
@@ -92,6 +92,9 @@ int diswcs (struct tcp_chan *chan, const char *value,size_t nchars)
 int create_job_cpuset(job * pj) { return 0; }
 int DIS_tcp_wflush (struct tcp_chan *chan) { return 0; }
 int move_to_job_cpuset(pid_t, job *) { return 0; }
+bool job_cgroups_active(void) { return false; }
+int create_job_cgroup(const char *jobid) { return 0; }
+int move_to_job_cgroup(pid_t pid, const char *jobid) { return 0; }
 int diswsi(tcp_chan *chan, int i) { return 0; }
 int encode_DIS_svrattrl(tcp_chan *chan, svrattrl *s) { return 0; }
 int im_compose(tcp_chan *chan, char *arg2, char *a3, int a4, int a5, unsigned int a6) { return 0; }
@@ -666,3 +669,14 @@ int csv_length(const char *csv_str)
   exit(1);
   }
 
+bool mom_events_active(void)
+  {
+  return(false);
+  }
+
+bool watch_starter_pipe(int fd)
+  {
+  return(false);
+  }
+
+void unwatch_starter_pipe(int fd) {}
@@ -56,9 +56,11 @@
 #include "mutex_mgr.hpp"
 #include "batch_request.h"
 #include "alps_constants.h"
+#include "threadpool.h"
 
 #ifndef PBS_MOM
 #include "../lib/Libutils/u_lock_ctl.h" /* lock_ss, unlock_ss */
+#include "group_commit.h" /* mark_file_dirty */
 #endif /* PBS_MOM */
 
 
@@ -426,6 +428,8 @@ int array_save(
     return -1;
     }
 
+  mark_file_dirty(namebuf);
+
   return(PBSE_NONE);
   } /* END array_save() */
 
@@ -1602,6 +1606,400 @@ int parse_array_request(
 
 
 
+/*
+ * use_virtual_subjobs() - true if queued array subjobs should stay in the
+ * array's request tokens until they are needed, set with the
+ * virtual_array_subjobs server attribute
+ */
+
+bool use_virtual_subjobs()
+
+  {
+  long virtual_subjobs = FALSE;
+
+  get_svr_attr_l(SRV_ATR_VirtualArraySubjobs, &virtual_subjobs);
+
+  return(virtual_subjobs != FALSE);
+  } /* END use_virtual_subjobs() */
+
+
+
+
+/*
+ * array_next_virtual_index()
+ *
+ * removes the lowest index that hasn't been made into a job yet from the
+ * array's request tokens
+ *
+ * @param pa - the array, locked
+ * @return the index or -1 if every index has been made into a job
+ */
+
+int array_next_virtual_index(
+
+  job_array *pa)
+
+  {
+  array_request_node *rn;
+  int                 index;
+
+  if ((rn = (array_request_node *)GET_NEXT(pa->request_tokens)) == NULL)
+    return(-1);
+
+  index = rn->start++;
+
+  if (rn->start > rn->end)
+    {
+    delete_link(&rn->request_tokens_link);
+    free(rn);
+    }
+
+  return(index);
+  } /* END array_next_virtual_index() */
+
+
+
+
+/*
+ * array_count_virtual_indices()
+ *
+ * @param pa - the array, locked
+ * @return how many indices haven't been made into jobs yet
+ */
+
+int array_count_virtual_indices(
+
+  job_array *pa)
+
+  {
+  array_request_node *rn;
+  int                 count = 0;
+
+  for (rn = (array_request_node *)GET_NEXT(pa->request_tokens);
+       rn != NULL;
+       rn = (array_request_node *)GET_NEXT(rn->request_tokens_link))
+    count += rn->end - rn->start + 1;
+
+  return(count);
+  } /* END array_count_virtual_indices() */
+
+
+
+
+/*
+ * array_index_is_virtual()
+ *
+ * @param pa - the array, locked
+ * @param index - the index
+ * @return true if index is still only in the array's request tokens
+ */
+
+bool array_index_is_virtual(
+
+  job_array *pa,
+  int        index)
+
+  {
+  array_request_node *rn;
+
+  /* the tokens are in order, so stop at the first that ends past index */
+  for (rn = (array_request_node *)GET_NEXT(pa->request_tokens);
+       rn != NULL;
+       rn = (array_request_node *)GET_NEXT(rn->request_tokens_link))
+    {
+    if (index <= rn->end)
+      return(index >= rn->start);
+    }
+
+  return(false);
+  } /* END array_index_is_virtual() */
+
+
+
+
+/*
+ * array_restore_virtual_index()
+ *
+ * puts an index taken by array_next_virtual_index() back into the array's
+ * request tokens when it couldn't be made into a job, so a later pass does
+ * not lose it and tries again
+ *
+ * @param pa - the array, locked
+ * @param index - the index
+ * @return PBSE_NONE or PBSE_SYSTEM if there is no memory for a new token
+ */
+
+int array_restore_virtual_index(
+
+  job_array *pa,
+  int        index)
+
+  {
+  array_request_node *rn;
+  array_request_node *added;
+
+  for (rn = (array_request_node *)GET_NEXT(pa->request_tokens);
+       rn != NULL;
+       rn = (array_request_node *)GET_NEXT(rn->request_tokens_link))
+    {
+    if ((index >= rn->start) &&
+        (index <= rn->end))
+      return(PBSE_NONE);
+
+    if (index == rn->start - 1)
+      {
+      rn->start = index;
+      return(PBSE_NONE);
+      }
+
+    if (index == rn->end + 1)
+      {
+      rn->end = index;
+      return(PBSE_NONE);
+      }
+
+    if (index < rn->start)
+      break;
+    }
+
+  if ((added = (array_request_node *)calloc(1, sizeof(array_request_node))) == NULL)
+    return(PBSE_SYSTEM);
+
+  added->start = index;
+  added->end = index;
+  CLEAR_LINK(added->request_tokens_link);
+
+  if (rn != NULL)
+    insert_link(&rn->request_tokens_link, &added->request_tokens_link, (void *)added,
+                LINK_INSET_BEFORE);
+  else
+    append_link(&pa->request_tokens, &added->request_tokens_link, (void *)added);
+
+  return(PBSE_NONE);
+  } /* END array_restore_virtual_index() */
+
+
+
+
+/*
+ * array_drop_virtual_range()
+ *
+ * removes the indices from start to end that haven't been made into jobs
+ * from the array's request tokens, splitting a token if needed
+ *
+ * @param pa - the array, locked
+ * @param start - the first index to remove
+ * @param end - the last index to remove
+ * @return the number of indices removed
+ */
+
+int array_drop_virtual_range(
+
+  job_array *pa,
+  int        start,
+  int        end)
+
+  {
+  array_request_node *rn;
+  array_request_node *next;
+  array_request_node *split;
+  int                 dropped = 0;
+
+  for (rn = (array_request_node *)GET_NEXT(pa->request_tokens);
+       rn != NULL;
+       rn = next)
+    {
+    next = (array_request_node *)GET_NEXT(rn->request_tokens_link);
+
+    if ((rn->end < start) ||
+        (rn->start > end))
+      continue;
+
+    if ((rn->start >= start) &&
+        (rn->end <= end))
+      {
+      /* the whole token is in the range */
+      dropped += rn->end - rn->start + 1;
+
+      delete_link(&rn->request_tokens_link);
+      free(rn);
+      }
+    else if (rn->start >= start)
+      {
+      /* the range covers the front of the token */
+      dropped += end - rn->start + 1;
+      rn->start = end + 1;
+      }
+    else if (rn->end <= end)
+      {
+      /* the range covers the back of the token */
+      dropped += rn->end - start + 1;
+      rn->end = start - 1;
+      }
+    else
+      {
+      /* the range is inside the token */
+      split = (array_request_node *)calloc(1, sizeof(array_request_node));
+
+      if (split == NULL)
+        break;
+
+      split->start = end + 1;
+      split->end = rn->end;
+      CLEAR_LINK(split->request_tokens_link);
+      insert_link(&rn->request_tokens_link, &split->request_tokens_link, (void *)split,
+                  LINK_INSET_AFTER);
+
+      dropped += end - start + 1;
+      rn->end = start - 1;
+      }
+    }
+
+  return(dropped);
+  } /* END array_drop_virtual_range() */
+
+
+
+
+/*
+ * array_materialize_budget()
+ *
+ * @param pa - the array, locked
+ * @return how many more subjobs should be made into jobs now. This is
+ * unlimited unless virtual subjobs are enabled, in which case only enough
+ * are made to keep VIRTUAL_SUBJOB_WINDOW queued, and never more than the
+ * slot limit allows to be queued or running. Subjobs that are cloned but
+ * neither running nor done count as queued, held ones included.
+ */
+
+int array_materialize_budget(
+
+  job_array *pa)
+
+  {
+  int queued;
+  int dropped;
+  int budget;
+
+  if (use_virtual_subjobs() == false)
+    return(INT_MAX);
+
+  /* every index is cloned, still virtual, or was deleted while virtual.
+   * Those last are counted in jobs_done without ever having been cloned. */
+  dropped = pa->ai_qs.num_jobs - pa->ai_qs.num_cloned - array_count_virtual_indices(pa);
+
+  queued = pa->ai_qs.num_cloned - pa->ai_qs.jobs_running - (pa->ai_qs.jobs_done - dropped);
+
+  if (queued < 0)
+    queued = 0;
+
+  budget = VIRTUAL_SUBJOB_WINDOW - queued;
+
+  if ((pa->ai_qs.slot_limit != NO_SLOT_LIMIT) &&
+      (pa->ai_qs.slot_limit - pa->ai_qs.jobs_running - queued < budget))
+    budget = pa->ai_qs.slot_limit - pa->ai_qs.jobs_running - queued;
+
+  return(budget);
+  } /* END array_materialize_budget() */
+
+
+
+
+/*
+ * materialize_virtual_index()
+ *
+ * makes index of the array into a job if it has so far only existed in the
+ * array's request tokens, so that it can be acted on like any other job
+ *
+ * @param pa_ptr - the array, locked. See materialize_array_index().
+ * @param index - the index
+ * @return PBSE_NONE or PBSE_UNKARRAYID if the array went away
+ */
+
+int materialize_virtual_index(
+
+  job_array **pa_ptr,
+  int         index)
+
+  {
+  job *pjob;
+
+  if (((*pa_ptr)->job_ids[index] != NULL) ||
+      (array_drop_virtual_range(*pa_ptr, index, index) == 0))
+    return(PBSE_NONE);
+
+  if ((pjob = materialize_array_index(pa_ptr, index)) != NULL)
+    unlock_ji_mutex(pjob, __func__, "1", LOGLEVEL);
+
+  if (*pa_ptr == NULL)
+    return(PBSE_UNKARRAYID);
+
+  return(PBSE_NONE);
+  } /* END materialize_virtual_index() */
+
+
+
+
+/*
+ * materialize_virtual_subjobs()
+ *
+ * makes every subjob of the array that has so far only existed in the
+ * request tokens into a job, for operations on the whole array
+ *
+ * @param pa_ptr - the array, locked. See materialize_array_index().
+ * @return PBSE_NONE or PBSE_UNKARRAYID if the array went away
+ */
+
+int materialize_virtual_subjobs(
+
+  job_array **pa_ptr)
+
+  {
+  job *pjob;
+  int  index;
+
+  while ((index = array_next_virtual_index(*pa_ptr)) >= 0)
+    {
+    if ((*pa_ptr)->job_ids[index] != NULL)
+      continue;
+
+    if ((pjob = materialize_array_index(pa_ptr, index)) != NULL)
+      unlock_ji_mutex(pjob, __func__, "1", LOGLEVEL);
+
+    if (*pa_ptr == NULL)
+      return(PBSE_UNKARRAYID);
+    }
+
+  return(PBSE_NONE);
+  } /* END materialize_virtual_subjobs() */
+
+
+
+
+/*
+ * drop_virtual_subjobs()
+ *
+ * counts subjobs that were deleted before they were made into jobs as
+ * deleted and purged
+ *
+ * @param pa - the array, locked
+ * @param count - the number of subjobs dropped from the request tokens
+ */
+
+void drop_virtual_subjobs(
+
+  job_array *pa,
+  int        count)
+
+  {
+  pa->ai_qs.num_failed += count;
+  pa->ai_qs.jobs_done += count;
+  pa->ai_qs.num_purged += count;
+  } /* END drop_virtual_subjobs() */
+
+
+
+
 /*
  * delete_array_range()
  *
@@ -1609,7 +2007,8 @@ int parse_array_request(
  *
  * @param pa - the array whose jobs are deleted
  * @param range_str - the user-given range to delete 
- * @return - the number of jobs skipped, -1 if range error 
+ * @return - the number of jobs skipped, -1 if range error, NO_JOBS_IN_ARRAY
+ * if nothing is left of the array and it was deleted
  */
 int delete_array_range(
 
@@ -1626,6 +2025,7 @@ int delete_array_range(
   int                 i;
   int                 num_skipped = 0;
   int                 num_deleted = 0;
+  int                 num_virtual = 0;
   int                 deleted;
   int                 running;
 
@@ -1694,6 +2094,9 @@ int delete_array_range(
         }
       }
 
+    /* subjobs that were never made into jobs are just dropped */
+    num_virtual += array_drop_virtual_range(pa, rn->start, rn->end);
+
     to_free = rn;
     rn = (array_request_node*)GET_NEXT(rn->request_tokens_link);
 
@@ -1703,6 +2106,21 @@ int delete_array_range(
 
   pa->ai_qs.num_failed += num_deleted;
 
+  if (num_virtual > 0)
+    {
+    drop_virtual_subjobs(pa, num_virtual);
+
+    if (pa->ai_qs.num_purged == pa->ai_qs.num_jobs)
+      {
+      /* that was the last of the array */
+      array_delete(pa);
+
+      return(NO_JOBS_IN_ARRAY);
+      }
+
+    array_save(pa);
+    }
+
   return(num_skipped);
   } /* END delete_array_range() */
 
@@ -1749,11 +2167,19 @@ int delete_whole_array(
   int num_skipped = 0;
   int num_jobs = 0;
   int num_deleted = 0;
+  int num_virtual;
   int deleted;
   int running;
 
   job *pjob;
 
+  /* subjobs that were never made into jobs are just dropped */
+  if ((num_virtual = array_drop_virtual_range(pa, 0, pa->ai_qs.array_size - 1)) > 0)
+    {
+    drop_virtual_subjobs(pa, num_virtual);
+    array_save(pa);
+    }
+
   for (i = 0; i < pa->ai_qs.array_size; i++)
     {
     if (pa->job_ids[i] == NULL)
@@ -1857,6 +2283,9 @@ int hold_array_range(
         if (i >= pa->ai_qs.array_size)
           continue;
         
+        if (materialize_virtual_index(&pa, i) != PBSE_NONE)
+          return(PBSE_UNKARRAYID);
+
         if (pa->job_ids[i] == NULL)
           continue;
 
@@ -1926,6 +2355,9 @@ int release_array_range(
       if (i >= pa->ai_qs.array_size)
         continue;
 
+      if (materialize_virtual_index(&pa, i) != PBSE_NONE)
+        return(PBSE_UNKARRAYID);
+
       if (pa->job_ids[i] == NULL)
         continue;
 
@@ -1994,8 +2426,16 @@ int modify_array_range(
         {
         for (i = rn->start; i <= rn->end; i++)
           {
-          if ((i >= pa->ai_qs.array_size) ||
-              (pa->job_ids[i] == NULL))
+          if (i >= pa->ai_qs.array_size)
+            continue;
+
+          if (materialize_virtual_index(&pa, i) != PBSE_NONE)
+            {
+            array_gone = TRUE;
+            break;
+            }
+
+          if (pa->job_ids[i] == NULL)
             continue;
 
           if ((pjob = svr_find_job(pa->job_ids[i], FALSE)) == NULL)
@@ -2169,6 +2609,12 @@ void update_array_values(
   set_array_depend_holds(pa);
   array_save(pa);
 
+  /* a subjob started or finished, clone more virtual subjobs to replace it */
+  if ((event != aeQueue) &&
+      (GET_NEXT(pa->request_tokens) != NULL) &&
+      (use_virtual_subjobs() == true))
+    enqueue_threadpool_request(job_clone_wt, strdup(pa->ai_qs.parent_id), task_pool);
+
   } /* END update_array_values() */
 
 
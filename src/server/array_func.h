@@ -32,6 +32,24 @@ int delete_array_range(job_array *pa, char *range_str);
 
 int first_job_index(job_array *pa);
 
+bool use_virtual_subjobs();
+
+int array_next_virtual_index(job_array *pa);
+
+int array_count_virtual_indices(job_array *pa);
+
+bool array_index_is_virtual(job_array *pa, int index);
+
+int array_restore_virtual_index(job_array *pa, int index);
+
+int array_drop_virtual_range(job_array *pa, int start, int end);
+
+int array_materialize_budget(job_array *pa);
+
+int materialize_virtual_index(job_array **pa_ptr, int index);
+
+int materialize_virtual_subjobs(job_array **pa_ptr);
+
 int delete_whole_array(job_array *pa);
 
 int hold_array_range(job_array *pa, char *range_str, pbs_attribute *temphold);
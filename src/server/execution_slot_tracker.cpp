@@ -1,5 +1,6 @@
 #include <stdexcept>
 #include <iostream>
+#include <limits.h>
 
 #include "execution_slot_tracker.hpp"
 #include "pbs_error.h"
@@ -11,9 +12,13 @@ const int  SUBSET_TOO_LARGE = -3;
 const bool OCCUPIED = true;
 const bool FREE = false;
 
+#define SLOTS_PER_WORD  ((int)(sizeof(unsigned long) * CHAR_BIT))
+
 execution_slot_tracker::execution_slot_tracker(const execution_slot_tracker& est)
   {
-  this->slots = est.slots;
+  this->words = est.words;
+  this->first_word = est.first_word;
+  this->slot_count = est.slot_count;
   this->open_count = est.open_count;
   } /* END copy constructor */
 
@@ -21,6 +26,8 @@ execution_slot_tracker::execution_slot_tracker(const execution_slot_tracker& est
 
 execution_slot_tracker::execution_slot_tracker()
   {
+  this->first_word = 0;
+  this->slot_count = 0;
   this->open_count = 0;
   } /* END default contructor */
 
@@ -31,10 +38,11 @@ execution_slot_tracker::execution_slot_tracker(
   const int size)
 
   {
+  this->first_word = 0;
+  this->slot_count = 0;
   this->open_count = 0;
   
-  for (int i = 0; i < size; i++)
-    this->add_execution_slot();
+  this->resize_to(size);
   }
 
 
@@ -46,13 +54,104 @@ execution_slot_tracker& execution_slot_tracker::operator= (
   if (this == &est)
     return(*this);
 
-  this->slots = est.slots;
+  this->words = est.words;
+  this->first_word = est.first_word;
+  this->slot_count = est.slot_count;
   this->open_count = est.open_count;
   return(*this);
   } /* END = operator */
 
 
 
+/*
+ * word_for()
+ * @return a pointer to the word holding slot index, or NULL if it's outside the stored
+ * window and create is false. If create is true the window is grown to hold it.
+ */
+unsigned long *execution_slot_tracker::word_for(
+
+  int  index,
+  bool create)
+
+  {
+  int w = index / SLOTS_PER_WORD;
+
+  if (this->words.empty())
+    {
+    if (create == false)
+      return(NULL);
+
+    this->first_word = w;
+    this->words.push_back(0);
+    }
+  else if (w < this->first_word)
+    {
+    if (create == false)
+      return(NULL);
+
+    this->words.insert(this->words.begin(), this->first_word - w, 0);
+    this->first_word = w;
+    }
+  else if (w >= this->first_word + (int)this->words.size())
+    {
+    if (create == false)
+      return(NULL);
+
+    this->words.resize(w - this->first_word + 1, 0);
+    }
+
+  return(&this->words[w - this->first_word]);
+  } /* END word_for() */
+
+
+
+/*
+ * trim()
+ * drops the words at either end of the window that have no occupied slots
+ */
+void execution_slot_tracker::trim()
+
+  {
+  while ((this->words.empty() == false) &&
+         (this->words.back() == 0))
+    this->words.pop_back();
+
+  unsigned int lead = 0;
+
+  while ((lead < this->words.size()) &&
+         (this->words[lead] == 0))
+    lead++;
+
+  if (lead > 0)
+    {
+    this->words.erase(this->words.begin(), this->words.begin() + lead);
+    this->first_word += lead;
+    }
+
+  if (this->words.empty())
+    this->first_word = 0;
+  } /* END trim() */
+
+
+
+/*
+ * resize_to()
+ * adds free slots until there are size of them
+ */
+void execution_slot_tracker::resize_to(
+
+  int size)
+
+  {
+  if (size > this->slot_count)
+    {
+    this->open_count += size - this->slot_count;
+    this->slot_count = size;
+    }
+  } /* END resize_to() */
+
+
+
 /*
  * unset_subset()
  * @pre-cond: subset must be of an equal or smaller size than this execution slot tracker object
@@ -66,12 +165,21 @@ int execution_slot_tracker::unset_subset(
   if (subset.get_total_execution_slots() > this->get_total_execution_slots())
     return(SUBSET_TOO_LARGE);
 
-  for (int i = 0; i < subset.get_total_execution_slots(); i++)
+  for (unsigned int i = 0; i < subset.words.size(); i++)
     {
-    if (subset.slots[i] == OCCUPIED)
-      this->mark_as_free(i);
+    unsigned long *w = this->word_for((subset.first_word + i) * SLOTS_PER_WORD, false);
+
+    if (w != NULL)
+      {
+      unsigned long both = *w & subset.words[i];
+
+      this->open_count += __builtin_popcountl(both);
+      *w &= ~both;
+      }
     }
 
+  this->trim();
+
   return(PBSE_NONE);
   }
 
@@ -80,8 +188,8 @@ int execution_slot_tracker::unset_subset(
 /*
  * mark_as_used() 
  * marks the slot at index index as currently occupied
- * @pre-cond: index must be a valid index into the vector
- * @post-cond: slots[index] will be occupied and open_count will be updated if needed
+ * @pre-cond: index must be a valid index into the tracker
+ * @post-cond: slot index will be occupied and open_count will be updated if needed
  * @return PBSE_NONE on success or OUT_OF_RANGE if index isn't a valid index
  */
 int execution_slot_tracker::mark_as_used (
@@ -89,26 +197,20 @@ int execution_slot_tracker::mark_as_used (
   int index)
 
   {
-  int size = this->slots.size();
-
   if ((index < 0) ||
-      (index >= size))
+      (index >= this->slot_count))
     return(OUT_OF_RANGE);
 
-  try 
-    {
-    if (this->slots[index] == FREE)
-      {
-      this->slots[index] = OCCUPIED;
-      this->open_count--;
-      }
+  unsigned long *w = this->word_for(index, true);
+  unsigned long  bit = 1UL << (index % SLOTS_PER_WORD);
 
-    return(PBSE_NONE);
-    }
-  catch (std::out_of_range &oor)
+  if ((*w & bit) == 0)
     {
-    return(OUT_OF_RANGE);
+    *w |= bit;
+    this->open_count--;
     }
+
+  return(PBSE_NONE);
   }
 
 
@@ -116,8 +218,8 @@ int execution_slot_tracker::mark_as_used (
 /*
  * mark_as_free() 
  * marks the slot at index index as free 
- * @pre-cond: index must be a valid index into the vector
- * @post-cond: slots[index] will be free and open_count will be updated if needed
+ * @pre-cond: index must be a valid index into the tracker
+ * @post-cond: slot index will be free and open_count will be updated if needed
  * @return PBSE_NONE on success or OUT_OF_RANGE if index isn't a valid index
  */
 int execution_slot_tracker::mark_as_free (
@@ -125,26 +227,24 @@ int execution_slot_tracker::mark_as_free (
   int index)
 
   {
-  int size = this->slots.size();
-
   if ((index < 0) ||
-      (index >= size))
+      (index >= this->slot_count))
     return(OUT_OF_RANGE);
   
-  try
-    {
-    if (this->slots[index] == OCCUPIED)
-      {
-      this->slots[index] = FREE;
-      this->open_count++;
-      }
+  unsigned long *w = this->word_for(index, false);
+  unsigned long  bit = 1UL << (index % SLOTS_PER_WORD);
 
-    return(PBSE_NONE);
-    }
-  catch (std::out_of_range &oor)
+  if ((w != NULL) &&
+      ((*w & bit) != 0))
     {
-    return(OUT_OF_RANGE);
+    *w &= ~bit;
+    this->open_count++;
+
+    if (*w == 0)
+      this->trim();
     }
+
+  return(PBSE_NONE);
   }
   
 
@@ -157,8 +257,7 @@ int execution_slot_tracker::reserve_execution_slot(
   {
   int rc;
  
-  while (subset.get_total_execution_slots() < this->get_total_execution_slots())
-    subset.add_execution_slot();
+  subset.resize_to(this->slot_count);
 
   if ((rc = this->mark_as_used(index)) == PBSE_NONE)
     {
@@ -178,7 +277,8 @@ int execution_slot_tracker::reserve_execution_slot(
 
 /*
  * reserve_execution_slots()
- * reserves num_slots_to_reserve from this and marks the same ones as occupied in est
+ * reserves num_slots_to_reserve from this and marks the same ones as occupied in est.
+ * The lowest numbered free slots are taken, a word at a time.
  * @pre-cond: est must be a valid execution_slot_tracker object
  * @post-cond: both this and est will have num_slots_to_reserve more slots set as
  * occupied. est will be resized if necessary to accomodate this functionality.
@@ -192,22 +292,49 @@ int execution_slot_tracker::reserve_execution_slots(
 
   {
   int reserved_so_far = 0;
+  int num_words = (this->slot_count + SLOTS_PER_WORD - 1) / SLOTS_PER_WORD;
 
   if (this->open_count < num_slots_to_reserve)
     return(INSUFFICIENT_FREE_EXECUTION_SLOTS);
 
-  while (est.get_total_execution_slots() < this->get_total_execution_slots())
-    est.add_execution_slot();
+  est.resize_to(this->slot_count);
 
-  for (int i = 0; i < this->slots.size() && reserved_so_far < num_slots_to_reserve; i++)
+  for (int w = 0; (w < num_words) && (reserved_so_far < num_slots_to_reserve); w++)
     {
-    if (this->slots[i] == FREE)
-      {
-      reserved_so_far++;
-      this->mark_as_used(i);
+    unsigned long *mine = this->word_for(w * SLOTS_PER_WORD, false);
+    unsigned long  free_bits = ~((mine != NULL) ? *mine : 0UL);
+    unsigned long  taken = 0;
+    int            in_word = this->slot_count - w * SLOTS_PER_WORD;
+
+    /* slots past the end of the tracker aren't free */
+    if (in_word < SLOTS_PER_WORD)
+      free_bits &= (1UL << in_word) - 1;
 
-      est.mark_as_used(i);
+    if (free_bits == 0)
+      continue;
+
+    if (__builtin_popcountl(free_bits) <= num_slots_to_reserve - reserved_so_far)
+      taken = free_bits;
+    else
+      {
+      while (reserved_so_far + __builtin_popcountl(taken) < num_slots_to_reserve)
+        {
+        taken |= free_bits & -free_bits; /* lowest free slot */
+        free_bits &= free_bits - 1;
+        }
       }
+
+    int count = __builtin_popcountl(taken);
+
+    *this->word_for(w * SLOTS_PER_WORD, true) |= taken;
+    this->open_count -= count;
+
+    unsigned long *theirs = est.word_for(w * SLOTS_PER_WORD, true);
+
+    est.open_count -= __builtin_popcountl(taken & ~*theirs);
+    *theirs |= taken;
+
+    reserved_so_far += count;
     }
 
   return(PBSE_NONE);
@@ -227,16 +354,7 @@ int execution_slot_tracker::unreserve_execution_slots(
   const execution_slot_tracker &subset)
 
   {
-  if (this->slots.size() < subset.slots.size())
-    return(SUBSET_TOO_LARGE);
-
-  for (int i = 0; i < subset.slots.size(); i++)
-    {
-    if (subset.slots[i] == OCCUPIED)
-      this->mark_as_free(i);
-    }
-
-  return(PBSE_NONE);
+  return(this->unset_subset(subset));
   }
 
 
@@ -250,7 +368,7 @@ int execution_slot_tracker::get_number_free() const
 
 int execution_slot_tracker::get_total_execution_slots() const
   {
-  return(this->slots.size());
+  return(this->slot_count);
   }
 
 
@@ -258,7 +376,7 @@ int execution_slot_tracker::get_total_execution_slots() const
 void execution_slot_tracker::add_execution_slot ()
 
   {
-  this->slots.push_back(FREE);
+  this->slot_count++;
   this->open_count++;
   }
 
@@ -266,19 +384,22 @@ void execution_slot_tracker::add_execution_slot ()
 
 int execution_slot_tracker::remove_execution_slot ()
   {
-  try
-    {
-    if (this->slots[this->slots.size() - 1] == FREE)
-      this->open_count--;
+  if (this->slot_count == 0)
+    return(-4);
 
-    this->slots.pop_back();
+  int last = this->slot_count - 1;
 
-    return(PBSE_NONE);
-    }
-  catch (...)
+  if (this->is_occupied(last) == false)
+    this->open_count--;
+  else
     {
-    return(-4);
+    *this->word_for(last, false) &= ~(1UL << (last % SLOTS_PER_WORD));
+    this->trim();
     }
+
+  this->slot_count--;
+
+  return(PBSE_NONE);
   }
 
 
@@ -293,24 +414,40 @@ int execution_slot_tracker::get_next_occupied_index(
   int &iterator) const
 
   {
-  int occupied_index = -1;
-
   if (iterator == -1)
     iterator = 0;
 
-  while (iterator < this->slots.size())
+  if (iterator < this->first_word * SLOTS_PER_WORD)
+    iterator = this->first_word * SLOTS_PER_WORD;
+
+  while (iterator < this->slot_count)
     {
-    if (this->slots[iterator] == OCCUPIED)
-      {
-      occupied_index = iterator;
-      iterator++;
+    int           i = iterator / SLOTS_PER_WORD - this->first_word;
+
+    if (i >= (int)this->words.size())
       break;
+
+    /* mask off the slots before iterator */
+    unsigned long w = this->words[i] & (~0UL << (iterator % SLOTS_PER_WORD));
+
+    if (w != 0)
+      {
+      int occupied_index = (i + this->first_word) * SLOTS_PER_WORD + __builtin_ctzl(w);
+
+      if (occupied_index >= this->slot_count)
+        break;
+
+      iterator = occupied_index + 1;
+      return(occupied_index);
       }
-    else
-      iterator++;
+
+    iterator = (i + this->first_word + 1) * SLOTS_PER_WORD;
     }
 
-  return(occupied_index);
+  if (iterator < this->slot_count)
+    iterator = this->slot_count;
+
+  return(-1);
   }
 
 bool execution_slot_tracker::is_occupied(
@@ -318,21 +455,15 @@ bool execution_slot_tracker::is_occupied(
   int index) const
 
   {
-  int  size = this->slots.size();
-  bool occupied = false;
-
   if ((index < 0) ||
-      (index >= size))
+      (index >= this->slot_count))
     return(false);
   
-  try
-    {
-    occupied = this->slots[index] == OCCUPIED;
-    }
-  catch (std::out_of_range &oor)
-    {
+  int i = index / SLOTS_PER_WORD - this->first_word;
+
+  if ((i < 0) ||
+      (i >= (int)this->words.size()))
     return(false);
-    }
 
-  return(occupied);
+  return((this->words[i] & (1UL << (index % SLOTS_PER_WORD))) != 0);
   }
@@ -0,0 +1,452 @@
+/*
+*         OpenPBS (Portable Batch System) v2.3 Software License
+*
+* Copyright (c) 1999-2000 Veridian Information Solutions, Inc.
+* All rights reserved.
+*
+* ---------------------------------------------------------------------------
+* For a license to use or redistribute the OpenPBS software under conditions
+* other than those described below, or to purchase support for this software,
+* please contact Veridian Systems, PBS Products Department ("Licensor") at:
+*
+*    www.OpenPBS.org  +1 650 967-4675                  sales@OpenPBS.org
+*                        877 902-4PBS (US toll-free)
+* ---------------------------------------------------------------------------
+*
+* This license covers use of the OpenPBS v2.3 software (the "Software") at
+* your site or location, and, for certain users, redistribution of the
+* Software to other sites and locations.  Use and redistribution of
+* OpenPBS v2.3 in source and binary forms, with or without modification,
+* are permitted provided that all of the following conditions are met.
+* After December 31, 2001, only conditions 3-6 must be met:
+*
+* 1. Commercial and/or non-commercial use of the Software is permitted
+*    provided a current software registration is on file at www.OpenPBS.org.
+*    If use of this software contributes to a publication, product, or
+*    service, proper attribution must be given; see www.OpenPBS.org/credit.html
+*
+* 2. Redistribution in any form is only permitted for non-commercial,
+*    non-profit purposes.  There can be no charge for the Software or any
+*    software incorporating the Software.  Further, there can be no
+*    expectation of revenue generated as a consequence of redistributing
+*    the Software.
+*
+* 3. Any Redistribution of source code must retain the above copyright notice
+*    and the acknowledgment contained in paragraph 6, this list of conditions
+*    and the disclaimer contained in paragraph 7.
+*
+* 4. Any Redistribution in binary form must reproduce the above copyright
+*    notice and the acknowledgment contained in paragraph 6, this list of
+*    conditions and the disclaimer contained in paragraph 7 in the
+*    documentation and/or other materials provided with the distribution.
+*
+* 5. Redistributions in any form must be accompanied by information on how to
+*    obtain complete source code for the OpenPBS software and any
+*    modifications and/or additions to the OpenPBS software.  The source code
+*    must either be included in the distribution or be available for no more
+*    than the cost of distribution plus a nominal fee, and all modifications
+*    and additions to the Software must be freely redistributable by any party
+*    (including Licensor) without restriction.
+*
+* 6. All advertising materials mentioning features or use of the Software must
+*    display the following acknowledgment:
+*
+*     "This product includes software developed by NASA Ames Research Center,
+*     Lawrence Livermore National Laboratory, and Veridian Information
+*     Solutions, Inc.
+*     Visit www.OpenPBS.org for OpenPBS software support,
+*     products, and information."
+*
+* 7. DISCLAIMER OF WARRANTY
+*
+* THIS SOFTWARE IS PROVIDED "AS IS" WITHOUT WARRANTY OF ANY KIND. ANY EXPRESS
+* OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+* OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE, AND NON-INFRINGEMENT
+* ARE EXPRESSLY DISCLAIMED.
+*
+* IN NO EVENT SHALL VERIDIAN CORPORATION, ITS AFFILIATED COMPANIES, OR THE
+* U.S. GOVERNMENT OR ANY OF ITS AGENCIES BE LIABLE FOR ANY DIRECT OR INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+* OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+* LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+* EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* This license will be governed by the laws of the Commonwealth of Virginia,
+* without reference to its choice of law rules.
+*/
+
+/*
+ * group_commit.c - make the server's saved files durable in batches
+ *
+ * The save routines (job_save(), array_save(), que_save(), svr_save())
+ * write their files without O_SYNC and then mark them dirty here.  Dirty
+ * files, and the directories holding them, are fsync'ed together in one
+ * group commit when the commit task's interval expires, when
+ * commit_batch_size files are waiting, or when a caller waits on its
+ * ticket, whichever comes first.  A caller that must not reply until its
+ * data is on disk (req_commit()) waits on the ticket from its save.
+ *
+ * Syncing only happens in servers configured with --enable-filesync. In
+ * the default build TDISABLEFILESYNC is set, sync_path() does nothing and
+ * a commit only hands out and retires tickets.
+ */
+
+#include <pbs_config.h>   /* the master config generated by configure */
+
+#include <pthread.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+#include <map>
+#include <set>
+#include <string>
+
+#include "pbs_error.h"
+#include "svrfunc.h"
+#include "server.h"
+#include "log.h"
+#include "../lib/Liblog/pbs_log.h"
+#include "group_commit.h"
+
+
+static pthread_mutex_t        commit_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t         commit_done = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t         commit_wakeup = PTHREAD_COND_INITIALIZER;
+
+static std::set<std::string>  dirty_files;
+static commit_ticket          last_ticket = 0;
+static commit_ticket          committed_ticket = 0;
+static std::map<commit_ticket, commit_ticket> failed_batches; /* last ticket -> first ticket */
+static bool                   flushing = false;
+static bool                   commit_task_running = false;
+static long                   commit_interval = DEFAULT_COMMIT_INTERVAL;
+static long                   commit_batch_size = DEFAULT_COMMIT_BATCH_SIZE;
+
+
+
+/*
+ * set_group_commit_params() - how long a dirty file may wait for its commit
+ * (in milliseconds) and how many dirty files start a commit early.
+ * Values <= 0 restore the defaults.
+ */
+
+void set_group_commit_params(
+
+  long interval,
+  long batch_size)
+
+  {
+  pthread_mutex_lock(&commit_mutex);
+
+  commit_interval = (interval > 0) ? interval : DEFAULT_COMMIT_INTERVAL;
+  commit_batch_size = (batch_size > 0) ? batch_size : DEFAULT_COMMIT_BATCH_SIZE;
+
+  pthread_mutex_unlock(&commit_mutex);
+  } /* END set_group_commit_params() */
+
+
+
+/*
+ * sync_path() - fsync a file or directory
+ *
+ * A file that no longer exists was removed after it was marked and has
+ * nothing left to commit.
+ */
+
+static int sync_path(
+
+  const char *path)
+
+  {
+#if TDISABLEFILESYNC
+  return(PBSE_NONE);
+#else
+  int fds;
+  int rc = PBSE_NONE;
+
+  if ((fds = open(path, O_RDONLY)) < 0)
+    {
+    if (errno == ENOENT)
+      return(PBSE_NONE);
+
+    log_err(errno, __func__, path);
+    return(-1);
+    }
+
+  if (fsync(fds) != 0)
+    {
+    log_err(errno, __func__, path);
+    rc = -1;
+    }
+
+  close(fds);
+
+  return(rc);
+#endif /* TDISABLEFILESYNC */
+  } /* END sync_path() */
+
+
+
+/*
+ * record_failed_batch() - remember that tickets first through last were
+ * not made durable
+ *
+ * Every failed flush is kept so a waiter finds out about its own batch no
+ * matter how many flushes finished before it woke up. Consecutive failures,
+ * as from a dead disk, are merged into one range. Called with commit_mutex
+ * held.
+ */
+
+static void record_failed_batch(
+
+  commit_ticket first,
+  commit_ticket last)
+
+  {
+  std::map<commit_ticket, commit_ticket>::iterator prev;
+
+  if (failed_batches.empty() == false)
+    {
+    prev = failed_batches.end();
+    prev--;
+
+    if (prev->first + 1 == first)
+      {
+      first = prev->second;
+      failed_batches.erase(prev);
+      }
+    }
+
+  failed_batches[last] = first;
+  } /* END record_failed_batch() */
+
+
+
+/*
+ * batch_failed() - true if ticket belongs to a flush that failed. Called
+ * with commit_mutex held.
+ */
+
+static bool batch_failed(
+
+  commit_ticket ticket)
+
+  {
+  std::map<commit_ticket, commit_ticket>::iterator it;
+
+  if (ticket == 0)
+    return(false);
+
+  it = failed_batches.lower_bound(ticket);
+
+  return((it != failed_batches.end()) &&
+         (it->second <= ticket));
+  } /* END batch_failed() */
+
+
+
+/*
+ * flush_locked() - commit every file marked so far
+ *
+ * Called with commit_mutex held and no flush in progress. The mutex is
+ * released while syncing so other threads can keep marking files for the
+ * next commit.
+ */
+
+static int flush_locked()
+
+  {
+  std::set<std::string>           batch;
+  std::set<std::string>           dirs;
+  std::set<std::string>::iterator it;
+  commit_ticket                   first = committed_ticket + 1;
+  commit_ticket                   last = last_ticket;
+  int                             rc = PBSE_NONE;
+
+  flushing = true;
+  batch.swap(dirty_files);
+
+  pthread_mutex_unlock(&commit_mutex);
+
+  for (it = batch.begin(); it != batch.end(); it++)
+    {
+    size_t slash = it->rfind('/');
+
+    if (sync_path(it->c_str()) != PBSE_NONE)
+      rc = -1;
+
+    /* creates, renames and unlinks are only durable once the directory is */
+    if (slash != std::string::npos)
+      dirs.insert(it->substr(0, slash + 1));
+    }
+
+  for (it = dirs.begin(); it != dirs.end(); it++)
+    {
+    if (sync_path(it->c_str()) != PBSE_NONE)
+      rc = -1;
+    }
+
+  pthread_mutex_lock(&commit_mutex);
+
+  if ((rc != PBSE_NONE) &&
+      (last >= first))
+    record_failed_batch(first, last);
+
+  committed_ticket = last;
+  flushing = false;
+
+  pthread_cond_broadcast(&commit_done);
+
+  return(rc);
+  } /* END flush_locked() */
+
+
+
+/*
+ * mark_file_dirty() - queue path to be synced in the next group commit
+ *
+ * @param path - the file that was just written, renamed or linked
+ * @return the ticket to pass to wait_for_commit()
+ */
+
+commit_ticket mark_file_dirty(
+
+  const char *path)
+
+  {
+  commit_ticket ticket;
+
+  pthread_mutex_lock(&commit_mutex);
+
+  dirty_files.insert(path);
+  ticket = ++last_ticket;
+
+  if ((long)dirty_files.size() >= commit_batch_size)
+    {
+    if (commit_task_running == true)
+      pthread_cond_signal(&commit_wakeup);
+    else if (flushing == false)
+      {
+      /* nothing else will commit these, such as during recovery at startup */
+      flush_locked();
+      }
+    }
+
+  pthread_mutex_unlock(&commit_mutex);
+
+  return(ticket);
+  } /* END mark_file_dirty() */
+
+
+
+/*
+ * wait_for_commit() - block until everything marked up to ticket is on disk
+ *
+ * If no commit is in progress the caller commits the waiting files itself,
+ * so a waiter never sleeps out the commit interval.
+ *
+ * @return PBSE_NONE, or -1 if syncing a file in the ticket's commit failed
+ */
+
+int wait_for_commit(
+
+  commit_ticket ticket)
+
+  {
+  int rc = PBSE_NONE;
+
+  pthread_mutex_lock(&commit_mutex);
+
+  while (committed_ticket < ticket)
+    {
+    if (flushing == false)
+      flush_locked();
+    else
+      pthread_cond_wait(&commit_done, &commit_mutex);
+    }
+
+  if (batch_failed(ticket) == true)
+    rc = -1;
+
+  pthread_mutex_unlock(&commit_mutex);
+
+  return(rc);
+  } /* END wait_for_commit() */
+
+
+
+/*
+ * flush_dirty_files() - commit everything marked so far, used at shutdown
+ */
+
+int flush_dirty_files()
+
+  {
+  commit_ticket ticket;
+
+  pthread_mutex_lock(&commit_mutex);
+  ticket = last_ticket;
+  pthread_mutex_unlock(&commit_mutex);
+
+  return(wait_for_commit(ticket));
+  } /* END flush_dirty_files() */
+
+
+
+/*
+ * group_commit_task() - commits dirty files every commit_interval
+ * milliseconds, or sooner when commit_batch_size files are waiting
+ */
+
+void *group_commit_task(
+
+  void *vp)
+
+  {
+  long            interval;
+  long            batch_size;
+  struct timespec deadline;
+
+  pthread_mutex_lock(&commit_mutex);
+  commit_task_running = true;
+  pthread_mutex_unlock(&commit_mutex);
+
+  for (;;)
+    {
+    interval = DEFAULT_COMMIT_INTERVAL;
+    batch_size = DEFAULT_COMMIT_BATCH_SIZE;
+
+    get_svr_attr_l(SRV_ATR_CommitInterval, &interval);
+    get_svr_attr_l(SRV_ATR_CommitBatchSize, &batch_size);
+    set_group_commit_params(interval, batch_size);
+
+    pthread_mutex_lock(&commit_mutex);
+
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += commit_interval / 1000;
+    deadline.tv_nsec += (commit_interval % 1000) * 1000000;
+
+    if (deadline.tv_nsec >= 1000000000)
+      {
+      deadline.tv_sec++;
+      deadline.tv_nsec -= 1000000000;
+      }
+
+    if ((long)dirty_files.size() < commit_batch_size)
+      pthread_cond_timedwait(&commit_wakeup, &commit_mutex, &deadline);
+
+    if ((dirty_files.size() > 0) &&
+        (flushing == false))
+      flush_locked();
+
+    pthread_mutex_unlock(&commit_mutex);
+    }
+
+  return(NULL);
+  } /* END group_commit_task() */
+
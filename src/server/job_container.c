@@ -337,16 +337,24 @@ job *find_job_by_array(
     return(NULL);
     }
 
-  if (locked == false)
-    aj->lock();
-  
-  pj = aj->find(job_id);
+  if (locked == true)
+    {
+    pj = aj->find(job_id);
 
-  if (pj != NULL)
-    lock_ji_mutex(pj, __func__, NULL, LOGLEVEL);
+    if (pj != NULL)
+      lock_ji_mutex(pj, __func__, NULL, LOGLEVEL);
+    }
+  else
+    {
+    /* the sharded index is searched without the container lock, so the job
+     * can be removed before we lock it. Purged jobs sit in the recycler for
+     * MINIMUM_RECYCLE_TIME before being freed and are caught by the
+     * ji_being_recycled check below */
+    pj = aj->lookup(job_id);
 
-  if (locked == false)
-    aj->unlock();
+    if (pj != NULL)
+      lock_ji_mutex(pj, __func__, NULL, LOGLEVEL);
+    }
   
   if (pj != NULL)
     {
@@ -871,9 +879,15 @@ job *next_job(
     return(NULL);
     }
 
-  aj->lock();
-  pjob = iter->get_next_item();
-  aj->unlock();
+  /* snapshot iterators are walked without the container lock */
+  if (iter->is_snapshot())
+    pjob = iter->get_next_item();
+  else
+    {
+    aj->lock();
+    pjob = iter->get_next_item();
+    aj->unlock();
+    }
 
   if (pjob != NULL)
     {
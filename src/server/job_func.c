@@ -151,6 +151,7 @@
 #include "mutex_mgr.hpp"
 #include "job_route.h" /* job_route */
 #include "id_map.hpp"
+#include "job_journal.h" /* job_journal_remove */
 
 #ifndef TRUE
 #define TRUE 1
@@ -814,6 +815,12 @@ void free_job_allocation(
     delete pjob->ji_rejectdest;
     pjob->ji_rejectdest = NULL;
     }
+
+  if (pjob->ji_journal_sums != NULL)
+    {
+    free(pjob->ji_journal_sums);
+    pjob->ji_journal_sums = NULL;
+    }
   } /* END free_job_allocation() */
 
 
@@ -925,6 +932,142 @@ job *copy_job(
 
 
 
+/*
+ * subjob_id()
+ *
+ * makes the id of one of an array's subjobs from the array's id, e.g.
+ * 12[].napali and 3 make 12[3].napali
+ *
+ * @param array_id - the id of the array's template job
+ * @param taskid - the index of the subjob
+ * @param buf - the buffer for the id
+ * @param buflen - the size of buf
+ */
+
+void subjob_id(
+
+  const char *array_id,
+  int         taskid,
+  char       *buf,
+  size_t      buflen)
+
+  {
+  const char *bracket = strchr(array_id, '[');
+  const char *hostname = strchr(array_id, '.');
+  int         idlen;
+
+  if (bracket != NULL)
+    idlen = bracket - array_id;
+  else if (hostname != NULL)
+    idlen = hostname - array_id;
+  else
+    idlen = strlen(array_id);
+
+  if (hostname != NULL)
+    snprintf(buf, buflen, "%.*s[%d]%s", idlen, array_id, taskid, hostname);
+  else
+    snprintf(buf, buflen, "%.*s[%d]", idlen, array_id, taskid);
+  } /* END subjob_id() */
+
+
+
+
+/*
+ * clone_subjob_attributes()
+ *
+ * sets wattr to the attributes a subjob of template_job has once it is
+ * cloned: the template's, with the name and output paths suffixed with the
+ * index, the index in job_array_id and PBS_ARRAYID in the environment
+ *
+ * @param template_job - the array's template job
+ * @param wattr - cleared attributes to fill in, freed with at_free()
+ * @param taskid - the index of the subjob
+ */
+
+void clone_subjob_attributes(
+
+  job           *template_job,
+  pbs_attribute *wattr,
+  int            taskid)
+
+  {
+  pbs_attribute  tempattr;
+  char          *tmpstr;
+  char           buf[256];
+  int            i;
+  int            slen;
+
+  for (i = 0; i < JOB_ATR_LAST; i++)
+    {
+    if ((template_job->ji_wattr[i].at_flags & ATR_VFLAG_SET) &&
+        (i != JOB_ATR_job_array_request))
+      {
+      if ((i == JOB_ATR_errpath) || (i == JOB_ATR_outpath) || (i == JOB_ATR_jobname))
+        {
+        /* modify the errpath and outpath */
+
+        slen = strlen(template_job->ji_wattr[i].at_val.at_str);
+
+        tmpstr = (char*)calloc(sizeof(char), (slen + PBS_MAXJOBARRAYLEN + 1));
+
+        sprintf(tmpstr, "%s-%d",
+                template_job->ji_wattr[i].at_val.at_str,
+                taskid);
+
+        clear_attr(&tempattr, &job_attr_def[i]);
+
+        job_attr_def[i].at_decode(
+          &tempattr,
+          NULL,
+          NULL,
+          tmpstr,
+          ATR_DFLAG_ACCESS);
+
+        job_attr_def[i].at_set(
+          &wattr[i],
+          &tempattr,
+          SET);
+
+        job_attr_def[i].at_free(&tempattr);
+
+        free(tmpstr);
+        }
+      else
+        {
+        job_attr_def[i].at_set(
+          &wattr[i],
+          &(template_job->ji_wattr[i]),
+          SET);
+        }
+      }
+    }
+
+  /* set JOB_ATR_job_array_id */
+  wattr[JOB_ATR_job_array_id].at_val.at_long = taskid;
+  wattr[JOB_ATR_job_array_id].at_flags |= ATR_VFLAG_SET;
+
+  /* set PBS_ARRAYID enironment variable */
+  clear_attr(&tempattr, &job_attr_def[JOB_ATR_variables]);
+
+  sprintf(buf, "PBS_ARRAYID=%d", taskid);
+
+  job_attr_def[JOB_ATR_variables].at_decode(&tempattr,
+      NULL,
+      NULL,
+      buf,
+      0);
+
+  job_attr_def[JOB_ATR_variables].at_set(
+    &wattr[JOB_ATR_variables],
+    &tempattr,
+    INCR);
+
+  job_attr_def[JOB_ATR_variables].at_free(&tempattr);
+  } /* END clone_subjob_attributes() */
+
+
+
+
 /*
  * job_clone - create a clone of a job for use with job arrays
  */
@@ -939,19 +1082,14 @@ job *job_clone(
   char           log_buf[LOCAL_LOG_BUF_SIZE];
 
   job           *pnewjob;
-  pbs_attribute  tempattr;
 
   char          *oldid;
   char          *hostname;
   char          *bracket;
-  char          *tmpstr;
   char           basename[PBS_JOBBASE+1];
   char           namebuf[MAXPATHLEN + 1];
-  char           buf[256];
   int            fds;
 
-  int            i;
-  int            slen;
   int            release_mutex = FALSE;
 
   if (LOGLEVEL >= 7)
@@ -1007,18 +1145,9 @@ job *job_clone(
     }
 
   if (hostname != NULL)
-    {
     hostname++;
-    snprintf(pnewjob->ji_qs.ji_jobid, sizeof(pnewjob->ji_qs.ji_jobid), 
-      "%s[%d].%s",
-      oldid, taskid, hostname);
-    }
-  else
-    {
-    snprintf(pnewjob->ji_qs.ji_jobid, sizeof(pnewjob->ji_qs.ji_jobid),
-      "%s[%d]",
-      oldid, taskid);
-    }
+
+  subjob_id(template_job->ji_qs.ji_jobid, taskid, pnewjob->ji_qs.ji_jobid, sizeof(pnewjob->ji_qs.ji_jobid));
 
   /* update the job filename
    * We could optimize the sub-jobs to all use the same file. We would need a
@@ -1069,51 +1198,7 @@ job *job_clone(
   strcpy(pnewjob->ji_qs.ji_fileprefix, basename);
 
   /* copy job attributes. some of these are going to have to be modified */
-
-  for (i = 0; i < JOB_ATR_LAST; i++)
-    {
-    if ((template_job->ji_wattr[i].at_flags & ATR_VFLAG_SET) &&
-        (i != JOB_ATR_job_array_request))
-      {
-      if ((i == JOB_ATR_errpath) || (i == JOB_ATR_outpath) || (i == JOB_ATR_jobname))
-        {
-        /* modify the errpath and outpath */
-
-        slen = strlen(template_job->ji_wattr[i].at_val.at_str);
-
-        tmpstr = (char*)calloc(sizeof(char), (slen + PBS_MAXJOBARRAYLEN + 1));
-
-        sprintf(tmpstr, "%s-%d",
-                template_job->ji_wattr[i].at_val.at_str,
-                taskid);
-
-        clear_attr(&tempattr, &job_attr_def[i]);
-
-        job_attr_def[i].at_decode(
-          &tempattr,
-          NULL,
-          NULL,
-          tmpstr,
-          ATR_DFLAG_ACCESS);
-
-        job_attr_def[i].at_set(
-          &pnewjob->ji_wattr[i],
-          &tempattr,
-          SET);
-
-        job_attr_def[i].at_free(&tempattr);
-
-        free(tmpstr);
-        }
-      else
-        {
-        job_attr_def[i].at_set(
-          &(pnewjob->ji_wattr[i]),
-          &(template_job->ji_wattr[i]),
-          SET);
-        }
-      }
-    }
+  clone_subjob_attributes(template_job, pnewjob->ji_wattr, taskid);
 
   /* put a system hold on the job.  we'll take the hold off once the
    * entire array is cloned. We don't want any of the jobs to run and
@@ -1123,28 +1208,6 @@ job *job_clone(
   pnewjob->ji_wattr[JOB_ATR_hold].at_val.at_long |= HOLD_a;
   pnewjob->ji_wattr[JOB_ATR_hold].at_flags |= ATR_VFLAG_SET;
 
-  /* set JOB_ATR_job_array_id */
-  pnewjob->ji_wattr[JOB_ATR_job_array_id].at_val.at_long = taskid;
-  pnewjob->ji_wattr[JOB_ATR_job_array_id].at_flags |= ATR_VFLAG_SET;
-
-  /* set PBS_ARRAYID enironment variable */
-  clear_attr(&tempattr, &job_attr_def[JOB_ATR_variables]);
-
-  sprintf(buf, "PBS_ARRAYID=%d", taskid);
-
-  job_attr_def[JOB_ATR_variables].at_decode(&tempattr,
-      NULL,
-      NULL,
-      buf,
-      0);
-
-  job_attr_def[JOB_ATR_variables].at_set(
-    &pnewjob->ji_wattr[JOB_ATR_variables],
-    &tempattr,
-    INCR);
-
-  job_attr_def[JOB_ATR_variables].at_free(&tempattr);
-
   /* we need to put the cloned job into the array */
   if (pa == NULL)
     {
@@ -1204,9 +1267,10 @@ void *job_clone_wt(
   struct pbs_queue   *pque;
   char               log_buf[LOCAL_LOG_BUF_SIZE];
 
-  array_request_node *rn;
-  int                 start;
-  int                 end;
+  int                 budget;
+  int                 first_index = -1;
+  int                 last_index = -1;
+  int                 scan_end;
 
   jobid = (char *)cloned_id;
 
@@ -1248,134 +1312,133 @@ void *job_clone_wt(
     path_jobs, template_job->ji_qs.ji_fileprefix);
   template_job_mgr.unlock();
 
-  while ((rn = (array_request_node *)GET_NEXT(pa->request_tokens)) != NULL)
-    {
-    start = rn->start;
-    end = rn->end;
+  /* with virtual subjobs only part of the array is cloned now, the rest is
+   * cloned as these jobs start or finish */
+  budget = array_materialize_budget(pa);
 
-    for (i = start; i <= end; i++)
-      {
-      if (pa->job_ids[i] != NULL)
-        {
-        /* This job already exists. This can happen when trying to recover a job
-         * array that wasn't fully cloned. */
-        rn->start++;
-        continue;
-        }
+  while ((budget > 0) &&
+         ((i = array_next_virtual_index(pa)) >= 0))
+    {
+    if (first_index < 0)
+      first_index = i;
 
-      template_job_mgr.lock();
-      pjobclone = job_clone(template_job, pa, i);
-      template_job_mgr.unlock();
+    last_index = i;
 
-      if (pjobclone == NULL)
-        {
-        log_err(-1, __func__, "unable to clone job in job_clone_wt");
-        continue;
-        }
-      else if (pjobclone == (job *)1)
-        {
-        /* this happens if we attempted to clone an existing job */
-        rn->start++;
-        continue;
-        }
+    if (pa->job_ids[i] != NULL)
+      {
+      /* This job already exists. This can happen when trying to recover a job
+       * array that wasn't fully cloned. */
+      continue;
+      }
 
-      mutex_mgr clone_mgr(pjobclone->ji_mutex, true);
+    template_job_mgr.lock();
+    pjobclone = job_clone(template_job, pa, i);
+    template_job_mgr.unlock();
 
-      svr_evaljobstate(*pjobclone, newstate, newsub, 1);
+    if (pjobclone == NULL)
+      {
+      log_err(-1, __func__, "unable to clone job in job_clone_wt");
 
-      /* do this so that  svr_setjobstate() doesn't alter sv_jobstates,
-       * these are set later in svr_enquejob() */
-      pjobclone->ji_qs.ji_state = newstate;
-      pjobclone->ji_qs.ji_substate = newsub;
+      /* keep the index for the next pass instead of losing the subjob */
+      array_restore_virtual_index(pa, i);
+      break;
+      }
+    else if (pjobclone == (job *)1)
+      {
+      /* this happens if we attempted to clone an existing job */
+      continue;
+      }
 
-      svr_setjobstate(pjobclone, newstate, newsub, FALSE);
+    mutex_mgr clone_mgr(pjobclone->ji_mutex, true);
 
-      pjobclone->ji_wattr[JOB_ATR_qrank].at_val.at_long = ++queue_rank;
-      pjobclone->ji_wattr[JOB_ATR_qrank].at_flags |= ATR_VFLAG_SET;
+    svr_evaljobstate(*pjobclone, newstate, newsub, 1);
 
-      array_mgr.unlock();
+    /* do this so that  svr_setjobstate() doesn't alter sv_jobstates,
+     * these are set later in svr_enquejob() */
+    pjobclone->ji_qs.ji_state = newstate;
+    pjobclone->ji_qs.ji_substate = newsub;
 
-      if ((rc = svr_enquejob(pjobclone, FALSE, prev_job_id, false)))
-        {
-        /* XXX need more robust error handling */
-        clone_mgr.set_unlock_on_exit(false);
+    svr_setjobstate(pjobclone, newstate, newsub, FALSE);
 
-        if (rc != PBSE_JOB_RECYCLED)
-          {
-          svr_job_purge(pjobclone);
-          }
+    pjobclone->ji_wattr[JOB_ATR_qrank].at_val.at_long = ++queue_rank;
+    pjobclone->ji_wattr[JOB_ATR_qrank].at_flags |= ATR_VFLAG_SET;
 
-        if ((pa = get_array(arrayid)) == NULL)
-          {
-          if(prev_job_id != NULL) 
-            free(prev_job_id);
-          sem_wait(job_clone_semaphore);
-          return(NULL);
-          }
+    array_mgr.unlock();
 
-        array_mgr.mark_as_locked();
+    if ((rc = svr_enquejob(pjobclone, FALSE, prev_job_id, false)))
+      {
+      /* XXX need more robust error handling */
+      clone_mgr.set_unlock_on_exit(false);
 
-        continue;
+      if (rc != PBSE_JOB_RECYCLED)
+        {
+        svr_job_purge(pjobclone);
         }
 
-      if ((pa = get_jobs_array(&pjobclone)) == NULL)
+      if ((pa = get_array(arrayid)) == NULL)
         {
-        if (pjobclone == NULL)
-          {
-          /* pjobclone has been released. No mutex left to unlock */
-          clone_mgr.set_unlock_on_exit(false);
-          }
-
         if(prev_job_id != NULL) 
           free(prev_job_id);
         sem_wait(job_clone_semaphore);
         return(NULL);
         }
-      
+
       array_mgr.mark_as_locked();
 
-      if (job_save(pjobclone, SAVEJOB_FULL, 0) != 0)
-        {
-        /* XXX need more robust error handling */
-        array_mgr.unlock();
-        svr_job_purge(pjobclone);
-        
-        if ((pa = get_array(arrayid)) == NULL)
-          {
-          if(prev_job_id != NULL) 
-            free(prev_job_id);
-          sem_wait(job_clone_semaphore);
-          return(NULL);
-          }
+      continue;
+      }
 
-        array_mgr.mark_as_locked();
-        
-        continue;
+    if ((pa = get_jobs_array(&pjobclone)) == NULL)
+      {
+      if (pjobclone == NULL)
+        {
+        /* pjobclone has been released. No mutex left to unlock */
+        clone_mgr.set_unlock_on_exit(false);
         }
+
+      if(prev_job_id != NULL) 
+        free(prev_job_id);
+      sem_wait(job_clone_semaphore);
+      return(NULL);
+      }
+    
+    array_mgr.mark_as_locked();
+
+    if (job_save(pjobclone, SAVEJOB_FULL, 0) != 0)
+      {
+      /* XXX need more robust error handling */
+      array_mgr.unlock();
+      svr_job_purge(pjobclone);
       
-      if(prev_job_id != NULL) free(prev_job_id);
-      prev_job_id = NULL;
-      alljobs.lock();
-      if(alljobs.find(pjobclone->ji_qs.ji_jobid) != NULL)
+      if ((pa = get_array(arrayid)) == NULL)
         {
-        prev_job_id = strdup(pjobclone->ji_qs.ji_jobid);
+        if(prev_job_id != NULL) 
+          free(prev_job_id);
+        sem_wait(job_clone_semaphore);
+        return(NULL);
         }
-      alljobs.unlock();
-      
-      pa->ai_qs.num_cloned++;
-      
-      rn->start++;
-      
-      /* index below 0 means the job no longer exists */
-      if (prev_job_id == NULL)
-        clone_mgr.set_unlock_on_exit(false);
-      }  /* END for (i) */
 
-    if (rn->start > rn->end)
+      array_mgr.mark_as_locked();
+      
+      continue;
+      }
+    
+    if(prev_job_id != NULL) free(prev_job_id);
+    prev_job_id = NULL;
+    alljobs.lock();
+    if(alljobs.find(pjobclone->ji_qs.ji_jobid) != NULL)
       {
-      delete_link(&rn->request_tokens_link);
-      free(rn);
+      prev_job_id = strdup(pjobclone->ji_qs.ji_jobid);
       }
+    alljobs.unlock();
+    
+    pa->ai_qs.num_cloned++;
+
+    budget--;
+    
+    /* index below 0 means the job no longer exists */
+    if (prev_job_id == NULL)
+      clone_mgr.set_unlock_on_exit(false);
     }    /* END while (loop) */
       
   if(prev_job_id != NULL) free(prev_job_id);
@@ -1383,8 +1446,21 @@ void *job_clone_wt(
 
   array_save(pa);
 
-  /* scan over all the jobs in the array and unset the hold */
-  for (i = 0; i < pa->ai_qs.array_size; i++)
+  /* with virtual subjobs only the indices this pass took can still be held,
+   * the rest of the array isn't walked on every start or finish */
+  if (use_virtual_subjobs() == true)
+    {
+    i = (first_index < 0) ? 0 : first_index;
+    scan_end = last_index;
+    }
+  else
+    {
+    i = 0;
+    scan_end = pa->ai_qs.array_size - 1;
+    }
+
+  /* scan over the jobs in the array and unset the hold */
+  for (; i <= scan_end; i++)
     {
     if (pa->job_ids[i] == NULL)
       continue;
@@ -1402,10 +1478,17 @@ void *job_clone_wt(
       {
       mutex_mgr job_mutex(pjob->ji_mutex,true);
       long moab_compatible = FALSE;;
+
+      /* jobs cloned by an earlier pass are already released and may be running */
+      if ((pjob->ji_wattr[JOB_ATR_hold].at_val.at_long & HOLD_a) == 0)
+        continue;
+
       get_svr_attr_l(SRV_ATR_MoabArrayCompatible, &moab_compatible);
       pjob->ji_wattr[JOB_ATR_hold].at_val.at_long &= ~HOLD_a;
       
-      if (moab_compatible != FALSE)
+      /* virtual subjobs are never cloned past the slot limit */
+      if ((moab_compatible != FALSE) &&
+          (use_virtual_subjobs() == false))
         {
         /* if configured and necessary, apply a slot limit hold to all
          * jobs above the slot limit threshold */
@@ -1473,6 +1556,168 @@ void *job_clone_wt(
 
 
 
+/*
+ * materialize_array_index()
+ *
+ * makes the job for an array index that has so far only existed in the
+ * array's request tokens. The caller has already taken index out of the
+ * tokens.
+ *
+ * @param pa_ptr - the array, locked. The lock is dropped while the job is
+ * queued; *pa_ptr comes back locked, or NULL if the array went away.
+ * @param index - the index to make a job for
+ * @return the new job, locked, or NULL on failure
+ */
+
+job *materialize_array_index(
+
+  job_array **pa_ptr,
+  int         index)
+
+  {
+  job_array *pa = *pa_ptr;
+  job       *template_job;
+  job       *pjob;
+  int        newstate;
+  int        newsub;
+  int        rc;
+  char       arrayid[PBS_MAXSVRJOBID + 1];
+  char       log_buf[LOCAL_LOG_BUF_SIZE];
+
+  strcpy(arrayid, pa->ai_qs.parent_id);
+
+  if ((template_job = svr_find_job(arrayid, TRUE)) == NULL)
+    return(NULL);
+
+  pjob = job_clone(template_job, pa, index);
+  unlock_ji_mutex(template_job, __func__, "1", LOGLEVEL);
+
+  if ((pjob == NULL) ||
+      (pjob == (job *)1))
+    {
+    snprintf(log_buf, sizeof(log_buf), "unable to create the job for array index %d", index);
+    log_event(PBSEVENT_JOB, PBS_EVENTCLASS_JOB, arrayid, log_buf);
+
+    return(NULL);
+    }
+
+  mutex_mgr job_mutex(pjob->ji_mutex, true);
+
+  /* this job isn't cloned together with the rest of the array, so it
+   * doesn't need the array's system hold */
+  pjob->ji_wattr[JOB_ATR_hold].at_val.at_long &= ~HOLD_a;
+
+  if (pjob->ji_wattr[JOB_ATR_hold].at_val.at_long == 0)
+    pjob->ji_wattr[JOB_ATR_hold].at_flags &= ~ATR_VFLAG_SET;
+
+  svr_evaljobstate(*pjob, newstate, newsub, 1);
+
+  /* svr_enquejob() sets sv_jobstates */
+  pjob->ji_qs.ji_state = newstate;
+  pjob->ji_qs.ji_substate = newsub;
+
+  svr_setjobstate(pjob, newstate, newsub, FALSE);
+
+  pjob->ji_wattr[JOB_ATR_qrank].at_val.at_long = ++queue_rank;
+  pjob->ji_wattr[JOB_ATR_qrank].at_flags |= ATR_VFLAG_SET;
+
+  unlock_ai_mutex(pa, __func__, "1", LOGLEVEL);
+
+  if ((rc = svr_enquejob(pjob, FALSE, NULL, false)) != PBSE_NONE)
+    {
+    job_mutex.set_unlock_on_exit(false);
+
+    if (rc != PBSE_JOB_RECYCLED)
+      svr_job_purge(pjob);
+
+    *pa_ptr = get_array(arrayid);
+
+    return(NULL);
+    }
+
+  if ((*pa_ptr = get_jobs_array(&pjob)) == NULL)
+    {
+    if (pjob == NULL)
+      job_mutex.set_unlock_on_exit(false);
+
+    return(NULL);
+    }
+
+  pa = *pa_ptr;
+
+  if (job_save(pjob, SAVEJOB_FULL, 0) != PBSE_NONE)
+    {
+    unlock_ai_mutex(pa, __func__, "2", LOGLEVEL);
+
+    job_mutex.set_unlock_on_exit(false);
+    svr_job_purge(pjob);
+
+    *pa_ptr = get_array(arrayid);
+
+    return(NULL);
+    }
+
+  pa->ai_qs.num_cloned++;
+  array_save(pa);
+
+  pjob->ji_commit_done = 1;
+
+  job_mutex.set_unlock_on_exit(false);
+
+  return(pjob);
+  } /* END materialize_array_index() */
+
+
+
+
+/*
+ * materialize_subjob()
+ *
+ * makes the job for jobid if it is an array subjob that so far has only
+ * existed in its array's request tokens
+ *
+ * @param jobid - the id of the subjob
+ * @return the job, locked, or NULL if jobid isn't a virtual subjob
+ */
+
+job *materialize_subjob(
+
+  const char *jobid)
+
+  {
+  job_array *pa;
+  job       *pjob = NULL;
+  char      *bracket;
+  char       parent_id[PBS_MAXSVRJOBID + 1];
+  char       subjob_id[PBS_MAXSVRJOBID + 1];
+  int        index;
+
+  if (((bracket = strchr((char *)jobid, '[')) == NULL) ||
+      (!isdigit(bracket[1])))
+    return(NULL);
+
+  index = atoi(bracket + 1);
+
+  snprintf(subjob_id, sizeof(subjob_id), "%s", jobid);
+  array_get_parent_id(subjob_id, parent_id);
+
+  if ((pa = get_array(parent_id)) == NULL)
+    return(NULL);
+
+  if ((index < pa->ai_qs.array_size) &&
+      (pa->job_ids[index] == NULL) &&
+      (array_drop_virtual_range(pa, index, index) == 1))
+    pjob = materialize_array_index(&pa, index);
+
+  if (pa != NULL)
+    unlock_ai_mutex(pa, __func__, "1", LOGLEVEL);
+
+  return(pjob);
+  } /* END materialize_subjob() */
+
+
+
+
 /*
  * job_init_wattr - initialize job working pbs_attribute array
  * set the types and the "unspecified value" flag
@@ -2108,6 +2353,9 @@ int svr_job_purge(
     }
   else
     {
+    /* remove the journal first so it is never left without its job file */
+    job_journal_remove(job_fileprefix);
+
     snprintf(namebuf, sizeof(namebuf), "%s%s%s", 
       path_jobs, job_fileprefix, JOB_FILE_SUFFIX);
     }
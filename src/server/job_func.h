@@ -12,10 +12,18 @@ int conn_qsub(char *hostname, long port, char *EMsg);
 
 struct job *copy_job(struct job *parent);
 
+void subjob_id(const char *array_id, int taskid, char *buf, size_t buflen);
+
+void clone_subjob_attributes(struct job *template_job, pbs_attribute *wattr, int taskid);
+
 struct job *job_clone(struct job *template_job, struct job_array *pa, int taskid);
 
 void *job_clone_wt(void *vp);
 
+struct job *materialize_array_index(struct job_array **pa_ptr, int index);
+
+struct job *materialize_subjob(const char *jobid);
+
 struct batch_request *cpy_checkpoint(struct batch_request *preq, struct job *pjob, enum job_atr ati, int direction);
 
 void remove_checkpoint(struct job **pjob);
@@ -0,0 +1,550 @@
+/*
+*         OpenPBS (Portable Batch System) v2.3 Software License
+*
+* Copyright (c) 1999-2000 Veridian Information Solutions, Inc.
+* All rights reserved.
+*
+* ---------------------------------------------------------------------------
+* For a license to use or redistribute the OpenPBS software under conditions
+* other than those described below, or to purchase support for this software,
+* please contact Veridian Systems, PBS Products Department ("Licensor") at:
+*
+*    www.OpenPBS.org  +1 650 967-4675                  sales@OpenPBS.org
+*                        877 902-4PBS (US toll-free)
+* ---------------------------------------------------------------------------
+*
+* This license covers use of the OpenPBS v2.3 software (the "Software") at
+* your site or location, and, for certain users, redistribution of the
+* Software to other sites and locations.  Use and redistribution of
+* OpenPBS v2.3 in source and binary forms, with or without modification,
+* are permitted provided that all of the following conditions are met.
+* After December 31, 2001, only conditions 3-6 must be met:
+*
+* 1. Commercial and/or non-commercial use of the Software is permitted
+*    provided a current software registration is on file at www.OpenPBS.org.
+*    If use of this software contributes to a publication, product, or
+*    service, proper attribution must be given; see www.OpenPBS.org/credit.html
+*
+* 2. Redistribution in any form is only permitted for non-commercial,
+*    non-profit purposes.  There can be no charge for the Software or any
+*    software incorporating the Software.  Further, there can be no
+*    expectation of revenue generated as a consequence of redistributing
+*    the Software.
+*
+* 3. Any Redistribution of source code must retain the above copyright notice
+*    and the acknowledgment contained in paragraph 6, this list of conditions
+*    and the disclaimer contained in paragraph 7.
+*
+* 4. Any Redistribution in binary form must reproduce the above copyright
+*    notice and the acknowledgment contained in paragraph 6, this list of
+*    conditions and the disclaimer contained in paragraph 7 in the
+*    documentation and/or other materials provided with the distribution.
+*
+* 5. Redistributions in any form must be accompanied by information on how to
+*    obtain complete source code for the OpenPBS software and any
+*    modifications and/or additions to the OpenPBS software.  The source code
+*    must either be included in the distribution or be available for no more
+*    than the cost of distribution plus a nominal fee, and all modifications
+*    and additions to the Software must be freely redistributable by any party
+*    (including Licensor) without restriction.
+*
+* 6. All advertising materials mentioning features or use of the Software must
+*    display the following acknowledgment:
+*
+*     "This product includes software developed by NASA Ames Research Center,
+*     Lawrence Livermore National Laboratory, and Veridian Information
+*     Solutions, Inc.
+*     Visit www.OpenPBS.org for OpenPBS software support,
+*     products, and information."
+*
+* 7. DISCLAIMER OF WARRANTY
+*
+* THIS SOFTWARE IS PROVIDED "AS IS" WITHOUT WARRANTY OF ANY KIND. ANY EXPRESS
+* OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+* OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE, AND NON-INFRINGEMENT
+* ARE EXPRESSLY DISCLAIMED.
+*
+* IN NO EVENT SHALL VERIDIAN CORPORATION, ITS AFFILIATED COMPANIES, OR THE
+* U.S. GOVERNMENT OR ANY OF ITS AGENCIES BE LIABLE FOR ANY DIRECT OR INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+* OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+* LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+* EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* This license will be governed by the laws of the Commonwealth of Virginia,
+* without reference to its choice of law rules.
+*/
+/*
+ * job_image.c - a compact binary format for job save files
+ *
+ * A job image holds the same fields and encoded attributes as the xml
+ * job file, as length-prefixed strings after a small header.  Recovery
+ * maps the file and decodes the strings in place instead of building
+ * and walking an xml DOM.
+ *
+ * The following public functions are provided:
+ *  job_image_begin()    - start building an image
+ *  job_image_add()      - add a field or attribute to an image
+ *  job_image_write()    - write a built image to a file
+ *  job_image_open()     - map an image file for reading
+ *  job_image_next()     - read the next entry of a mapped image
+ *  job_image_close()    - unmap an image file
+ *  job_image_from_xml() - convert an xml job file to an image
+ *  job_image_to_xml()   - convert an image to an xml job file
+ */
+
+#include <pbs_config.h>   /* the master config generated by configure */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <string>
+#include <libxml/parser.h>
+#include <libxml/tree.h>
+
+#include "pbs_ifl.h"
+#include "pbs_error.h"
+#include "job_recovery.h"
+#include "job_image.h"
+#include "../lib/Libifl/lib_ifl.h"
+
+
+
+static size_t image_pad(
+
+  size_t len)
+
+  {
+  return((JOB_IMAGE_ALIGN - (len % JOB_IMAGE_ALIGN)) % JOB_IMAGE_ALIGN);
+  } /* END image_pad() */
+
+
+
+/*
+ * job_image_begin() - start a new image in image, discarding its contents
+ */
+
+void job_image_begin(
+
+  std::string &image)
+
+  {
+  job_image_header hdr;
+
+  memset(&hdr, 0, sizeof(hdr));
+  hdr.jh_magic = JOB_IMAGE_MAGIC;
+  hdr.jh_version = JOB_IMAGE_VERSION;
+
+  image.assign((char *)&hdr, sizeof(hdr));
+  } /* END job_image_begin() */
+
+
+
+/*
+ * job_image_add() - append an entry to an image started with job_image_begin()
+ *
+ * @param type - JOB_IMAGE_FIELD or JOB_IMAGE_ATTR
+ * @param resc - the resource name for a resource list entry, otherwise NULL
+ * @param value - may be NULL for an empty value
+ */
+
+void job_image_add(
+
+  std::string  &image,
+  int           type,
+  const char   *name,
+  const char   *resc,
+  const char   *value,
+  unsigned int  flags)
+
+  {
+  job_image_header hdr;
+  job_image_entry  entry;
+  size_t           start = image.size();
+
+  if (resc == NULL)
+    resc = "";
+
+  if (value == NULL)
+    value = "";
+
+  memset(&entry, 0, sizeof(entry));
+  entry.je_type = type;
+  entry.je_name_len = strlen(name);
+  entry.je_resc_len = strlen(resc);
+  entry.je_value_len = strlen(value);
+  entry.je_flags = flags;
+
+  image.append((char *)&entry, sizeof(entry));
+  image.append(name, entry.je_name_len + 1);
+  image.append(resc, entry.je_resc_len + 1);
+  image.append(value, entry.je_value_len + 1);
+  image.append(image_pad(image.size()), '\0');
+
+  memcpy(&hdr, image.data(), sizeof(hdr));
+  hdr.jh_count++;
+  hdr.jh_length += image.size() - start;
+  memcpy(&image[0], &hdr, sizeof(hdr));
+  } /* END job_image_add() */
+
+
+
+/*
+ * job_image_write() - write image to path, replacing any existing file
+ *
+ * @return PBSE_NONE on success, -1 on failure
+ */
+
+int job_image_write(
+
+  std::string &image,
+  const char  *path)
+
+  {
+  int fds;
+  int rc = PBSE_NONE;
+
+  if ((fds = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0600)) < 0)
+    return(-1);
+
+  if (write_ac_socket(fds, image.data(), image.size()) != (ssize_t)image.size())
+    rc = -1;
+
+  if (close(fds) != 0)
+    rc = -1;
+
+  return(rc);
+  } /* END job_image_write() */
+
+
+
+/*
+ * job_image_open() - map the image in path for reading with job_image_next()
+ *
+ * The file is mapped private and writable so decoders can modify the
+ * strings in place without changing the file.
+ *
+ * @return PBSE_NONE on success, PBSE_INVALID_SYNTAX if path isn't a job
+ * image, -1 if it can't be read or is from an unknown version
+ */
+
+int job_image_open(
+
+  const char    *path,
+  job_image_map *map)
+
+  {
+  int               fds;
+  struct stat       statbuf;
+  job_image_header  hdr;
+  void             *base;
+
+  memset(map, 0, sizeof(job_image_map));
+
+  if ((fds = open(path, O_RDONLY, 0)) < 0)
+    return(-1);
+
+  if (fstat(fds, &statbuf) != 0)
+    {
+    close(fds);
+    return(-1);
+    }
+
+  if ((size_t)statbuf.st_size < sizeof(hdr))
+    {
+    close(fds);
+    return(PBSE_INVALID_SYNTAX);
+    }
+
+  base = mmap(NULL, statbuf.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fds, 0);
+
+  close(fds);
+
+  if (base == MAP_FAILED)
+    return(-1);
+
+  memcpy(&hdr, base, sizeof(hdr));
+
+  if (hdr.jh_magic != JOB_IMAGE_MAGIC)
+    {
+    munmap(base, statbuf.st_size);
+    return(PBSE_INVALID_SYNTAX);
+    }
+
+  if ((hdr.jh_version != JOB_IMAGE_VERSION) ||
+      (hdr.jh_length != statbuf.st_size - sizeof(hdr)))
+    {
+    munmap(base, statbuf.st_size);
+    return(-1);
+    }
+
+  map->jm_base = (char *)base;
+  map->jm_size = statbuf.st_size;
+  map->jm_offset = sizeof(hdr);
+  map->jm_remaining = hdr.jh_count;
+
+  return(PBSE_NONE);
+  } /* END job_image_open() */
+
+
+
+/*
+ * job_image_next() - read the next entry of a mapped image
+ *
+ * @return 1 if item was filled in, 0 at the end of the image, -1 if the
+ * image is corrupt
+ */
+
+int job_image_next(
+
+  job_image_map  *map,
+  job_image_item *item)
+
+  {
+  job_image_entry  entry;
+  size_t           len;
+  char            *pos;
+
+  if (map->jm_remaining == 0)
+    return((map->jm_offset == map->jm_size) ? 0 : -1);
+
+  if (map->jm_size - map->jm_offset < sizeof(entry))
+    return(-1);
+
+  memcpy(&entry, map->jm_base + map->jm_offset, sizeof(entry));
+
+  len = sizeof(entry) + (size_t)entry.je_name_len + entry.je_resc_len + entry.je_value_len + 3;
+  len += image_pad(len);
+
+  if (map->jm_size - map->jm_offset < len)
+    return(-1);
+
+  pos = map->jm_base + map->jm_offset + sizeof(entry);
+
+  item->it_type = entry.je_type;
+  item->it_flags = entry.je_flags;
+  item->it_name = pos;
+  pos += entry.je_name_len + 1;
+  item->it_resc = pos;
+  pos += entry.je_resc_len + 1;
+  item->it_value = pos;
+
+  /* the strings must be terminated where the lengths say they end */
+  if ((item->it_resc[-1] != '\0') ||
+      (item->it_value[-1] != '\0') ||
+      (item->it_value[entry.je_value_len] != '\0'))
+    return(-1);
+
+  map->jm_offset += len;
+  map->jm_remaining--;
+
+  return(1);
+  } /* END job_image_next() */
+
+
+
+void job_image_close(
+
+  job_image_map *map)
+
+  {
+  if (map->jm_base != NULL)
+    munmap(map->jm_base, map->jm_size);
+
+  memset(map, 0, sizeof(job_image_map));
+  } /* END job_image_close() */
+
+
+
+static void add_xml_attribute(
+
+  std::string &image,
+  xmlNodePtr   node,
+  const char  *resc)
+
+  {
+  xmlChar      *value = xmlNodeGetContent(node);
+  xmlChar      *attr_flags;
+  unsigned int  flags = 0;
+
+  if ((attr_flags = xmlGetProp(node, (xmlChar *)AL_FLAGS_ATTR)))
+    {
+    flags = (unsigned int)atoi((char *)attr_flags);
+    xmlFree(attr_flags);
+    }
+
+  if (resc != NULL)
+    job_image_add(image, JOB_IMAGE_ATTR, (const char *)node->parent->name, resc, (const char *)value, flags);
+  else
+    job_image_add(image, JOB_IMAGE_ATTR, (const char *)node->name, NULL, (const char *)value, flags);
+
+  if (value)
+    xmlFree(value);
+  } /* END add_xml_attribute() */
+
+
+
+/*
+ * job_image_from_xml() - write the xml job file in xml_path as a job image
+ * in image_path
+ *
+ * The xml is converted as is, it isn't decoded into a job.
+ *
+ * @return PBSE_NONE on success, PBSE_INVALID_SYNTAX if xml_path isn't an
+ * xml job file, -1 if the image can't be written
+ */
+
+int job_image_from_xml(
+
+  const char *xml_path,
+  const char *image_path)
+
+  {
+  xmlDocPtr    doc;
+  xmlNodePtr   root;
+  xmlNodePtr   cur;
+  xmlNodePtr   attr;
+  xmlNodePtr   resc;
+  std::string  image;
+  int          rc;
+
+  if ((doc = xmlReadFile(xml_path, NULL, XML_PARSE_NOERROR | XML_PARSE_NOWARNING)) == NULL)
+    return(PBSE_INVALID_SYNTAX);
+
+  root = xmlDocGetRootElement(doc);
+
+  if ((root == NULL) ||
+      (strcmp((const char *)root->name, JOB_TAG)))
+    {
+    xmlFreeDoc(doc);
+    return(PBSE_INVALID_SYNTAX);
+    }
+
+  job_image_begin(image);
+
+  for (cur = root->children; cur != NULL; cur = cur->next)
+    {
+    if (cur->type != XML_ELEMENT_NODE)
+      continue;
+
+    if (strcmp((const char *)cur->name, ATTRIB_TAG))
+      {
+      xmlChar *content = xmlNodeGetContent(cur);
+
+      job_image_add(image, JOB_IMAGE_FIELD, (const char *)cur->name, NULL, (const char *)content, 0);
+
+      if (content)
+        xmlFree(content);
+
+      continue;
+      }
+
+    for (attr = cur->children; attr != NULL; attr = attr->next)
+      {
+      if (attr->type != XML_ELEMENT_NODE)
+        continue;
+
+      if ((strcmp((const char *)attr->name, ATTR_l)) &&
+          (strcmp((const char *)attr->name, ATTR_used)))
+        {
+        add_xml_attribute(image, attr, NULL);
+        continue;
+        }
+
+      for (resc = attr->children; resc != NULL; resc = resc->next)
+        {
+        if (resc->type == XML_ELEMENT_NODE)
+          add_xml_attribute(image, resc, (const char *)resc->name);
+        }
+      }
+    }
+
+  xmlFreeDoc(doc);
+
+  rc = job_image_write(image, image_path);
+
+  return(rc);
+  } /* END job_image_from_xml() */
+
+
+
+/*
+ * job_image_to_xml() - write the job image in image_path as an xml job
+ * file in xml_path, laid out the way saveJobToXML() writes it
+ *
+ * @return PBSE_NONE on success, PBSE_INVALID_SYNTAX if image_path isn't a
+ * job image, -1 if the image is corrupt or the xml can't be written
+ */
+
+int job_image_to_xml(
+
+  const char *image_path,
+  const char *xml_path)
+
+  {
+  job_image_map   map;
+  job_image_item  item;
+  xmlDocPtr       doc;
+  xmlNodePtr      root;
+  xmlNodePtr      attributes = NULL;
+  xmlNodePtr      resc_list = NULL;
+  xmlNodePtr      node;
+  char            buf[32];
+  int             rc;
+
+  if ((rc = job_image_open(image_path, &map)) != PBSE_NONE)
+    return(rc);
+
+  doc = xmlNewDoc((const xmlChar *)"1.0");
+  root = xmlNewNode(NULL, (const xmlChar *)JOB_TAG);
+  xmlDocSetRootElement(doc, root);
+
+  while ((rc = job_image_next(&map, &item)) == 1)
+    {
+    if (item.it_type == JOB_IMAGE_FIELD)
+      {
+      xmlNewChild(root, NULL, (xmlChar *)item.it_name, (xmlChar *)item.it_value);
+      continue;
+      }
+
+    if (attributes == NULL)
+      {
+      attributes = xmlNewNode(NULL, (xmlChar *)ATTRIB_TAG);
+      xmlAddChild(root, attributes);
+      }
+
+    if (item.it_resc[0] == '\0')
+      {
+      node = xmlNewChild(attributes, NULL, (xmlChar *)item.it_name, (xmlChar *)item.it_value);
+      resc_list = NULL;
+      }
+    else
+      {
+      if ((resc_list == NULL) ||
+          (strcmp((const char *)resc_list->name, item.it_name)))
+        resc_list = xmlNewChild(attributes, NULL, (xmlChar *)item.it_name, NULL);
+
+      node = xmlNewChild(resc_list, NULL, (xmlChar *)item.it_resc, (xmlChar *)item.it_value);
+      }
+
+    snprintf(buf, sizeof(buf), "%u", item.it_flags);
+    xmlSetProp(node, (const xmlChar *)AL_FLAGS_ATTR, (const xmlChar *)buf);
+    }
+
+  job_image_close(&map);
+
+  if ((rc == 0) &&
+      (xmlSaveFormatFileEnc(xml_path, doc, NULL, 1) <= 0))
+    rc = -1;
+
+  xmlFreeDoc(doc);
+
+  return((rc == 0) ? PBSE_NONE : -1);
+  } /* END job_image_to_xml() */
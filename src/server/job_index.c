@@ -0,0 +1,324 @@
+/*
+*         OpenPBS (Portable Batch System) v2.3 Software License
+*
+* Copyright (c) 1999-2000 Veridian Information Solutions, Inc.
+* All rights reserved.
+*
+* ---------------------------------------------------------------------------
+* For a license to use or redistribute the OpenPBS software under conditions
+* other than those described below, or to purchase support for this software,
+* please contact Veridian Systems, PBS Products Department ("Licensor") at:
+*
+*    www.OpenPBS.org  +1 650 967-4675                  sales@OpenPBS.org
+*                        877 902-4PBS (US toll-free)
+* ---------------------------------------------------------------------------
+*
+* This license covers use of the OpenPBS v2.3 software (the "Software") at
+* your site or location, and, for certain users, redistribution of the
+* Software to other sites and locations.  Use and redistribution of
+* OpenPBS v2.3 in source and binary forms, with or without modification,
+* are permitted provided that all of the following conditions are met.
+* After December 31, 2001, only conditions 3-6 must be met:
+*
+* 1. Commercial and/or non-commercial use of the Software is permitted
+*    provided a current software registration is on file at www.OpenPBS.org.
+*    If use of this software contributes to a publication, product, or
+*    service, proper attribution must be given; see www.OpenPBS.org/credit.html
+*
+* 2. Redistribution in any form is only permitted for non-commercial,
+*    non-profit purposes.  There can be no charge for the Software or any
+*    software incorporating the Software.  Further, there can be no
+*    expectation of revenue generated as a consequence of redistributing
+*    the Software.
+*
+* 3. Any Redistribution of source code must retain the above copyright notice
+*    and the acknowledgment contained in paragraph 6, this list of conditions
+*    and the disclaimer contained in paragraph 7.
+*
+* 4. Any Redistribution in binary form must reproduce the above copyright
+*    notice and the acknowledgment contained in paragraph 6, this list of
+*    conditions and the disclaimer contained in paragraph 7 in the
+*    documentation and/or other materials provided with the distribution.
+*
+* 5. Redistributions in any form must be accompanied by information on how to
+*    obtain complete source code for the OpenPBS software and any
+*    modifications and/or additions to the OpenPBS software.  The source code
+*    must either be included in the distribution or be available for no more
+*    than the cost of distribution plus a nominal fee, and all modifications
+*    and additions to the Software must be freely redistributable by any party
+*    (including Licensor) without restriction.
+*
+* 6. All advertising materials mentioning features or use of the Software must
+*    display the following acknowledgment:
+*
+*     "This product includes software developed by NASA Ames Research Center,
+*     Lawrence Livermore National Laboratory, and Veridian Information
+*     Solutions, Inc.
+*     Visit www.OpenPBS.org for OpenPBS software support,
+*     products, and information."
+*
+* 7. DISCLAIMER OF WARRANTY
+*
+* THIS SOFTWARE IS PROVIDED "AS IS" WITHOUT WARRANTY OF ANY KIND. ANY EXPRESS
+* OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+* OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE, AND NON-INFRINGEMENT
+* ARE EXPRESSLY DISCLAIMED.
+*
+* IN NO EVENT SHALL VERIDIAN CORPORATION, ITS AFFILIATED COMPANIES, OR THE
+* U.S. GOVERNMENT OR ANY OF ITS AGENCIES BE LIABLE FOR ANY DIRECT OR INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+* OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+* LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+* EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* This license will be governed by the laws of the Commonwealth of Virginia,
+* without reference to its choice of law rules.
+*/
+
+/*
+ * job_index.c - secondary indexes of the server's jobs by owner and state
+ *
+ * qselect -u and -s used to walk every job in alljobs and test each one
+ * with select_job(). These indexes track, for every job in alljobs, the
+ * user name of its owner and its state letter, so req_selectjobs() can
+ * start from only the jobs that may match. Each candidate is still tested
+ * by select_job(), so the index only has to return a superset. Jobs by
+ * queue already have an index of their own: the queue's qu_jobs list.
+ *
+ * Jobs are added by svr_enquejob() and removed by svr_dequejob() along
+ * with alljobs, and set_statechar() moves them between states. Job ids
+ * come back ordered by queue rank, like alljobs.
+ */
+
+#include <pbs_config.h>   /* the master config generated by configure */
+
+#include <pthread.h>
+#include <string.h>
+#include <set>
+#include <string>
+#include <vector>
+#include <boost/unordered_map.hpp>
+
+#include "pbs_job.h"
+#include "job_index.h"
+
+
+typedef std::pair<long, std::string> ranked_id;   /* queue rank, job id */
+typedef std::set<ranked_id>          ranked_ids;
+
+typedef struct indexed_job
+  {
+  std::string owner;
+  char        state;
+  long        qrank;
+  } indexed_job;
+
+static pthread_mutex_t                                  job_index_mutex = PTHREAD_MUTEX_INITIALIZER;
+static boost::unordered_map<std::string, indexed_job>   indexed_jobs;
+static boost::unordered_map<std::string, ranked_ids>    jobs_by_owner;
+static boost::unordered_map<char, ranked_ids>           jobs_by_state;
+
+
+
+/*
+ * owner_key() - the user name part of user@host
+ */
+
+static std::string owner_key(
+
+  const char *owner)
+
+  {
+  const char *at;
+
+  if (owner == NULL)
+    return(std::string());
+
+  if ((at = strchr(owner, '@')) == NULL)
+    return(std::string(owner));
+
+  return(std::string(owner, at - owner));
+  } /* END owner_key() */
+
+
+
+/*
+ * unindex_locked() - drop jobid from all indexes
+ * Called with job_index_mutex held.
+ */
+
+static void unindex_locked(
+
+  const std::string &jobid)
+
+  {
+  boost::unordered_map<std::string, indexed_job>::iterator it = indexed_jobs.find(jobid);
+
+  if (it == indexed_jobs.end())
+    return;
+
+  ranked_id key(it->second.qrank, jobid);
+
+  jobs_by_owner[it->second.owner].erase(key);
+  if (jobs_by_owner[it->second.owner].empty())
+    jobs_by_owner.erase(it->second.owner);
+
+  jobs_by_state[it->second.state].erase(key);
+
+  indexed_jobs.erase(it);
+  } /* END unindex_locked() */
+
+
+
+/*
+ * job_index_add() - index a job that has just been placed in alljobs
+ * Re-adding a job that's already indexed refreshes its entry.
+ * The caller holds pjob's mutex.
+ */
+
+void job_index_add(
+
+  job *pjob)
+
+  {
+  indexed_job entry;
+  std::string jobid(pjob->ji_qs.ji_jobid);
+
+  entry.owner = owner_key(pjob->ji_wattr[JOB_ATR_job_owner].at_val.at_str);
+  entry.state = pjob->ji_wattr[JOB_ATR_state].at_val.at_char;
+  entry.qrank = pjob->ji_wattr[JOB_ATR_qrank].at_val.at_long;
+
+  ranked_id key(entry.qrank, jobid);
+
+  pthread_mutex_lock(&job_index_mutex);
+
+  unindex_locked(jobid);
+
+  indexed_jobs[jobid] = entry;
+  jobs_by_owner[entry.owner].insert(key);
+  jobs_by_state[entry.state].insert(key);
+
+  pthread_mutex_unlock(&job_index_mutex);
+  } /* END job_index_add() */
+
+
+
+/*
+ * job_index_remove() - forget a job that has been removed from alljobs
+ */
+
+void job_index_remove(
+
+  const char *jobid)
+
+  {
+  pthread_mutex_lock(&job_index_mutex);
+  unindex_locked(jobid);
+  pthread_mutex_unlock(&job_index_mutex);
+  } /* END job_index_remove() */
+
+
+
+/*
+ * job_index_set_state() - move an indexed job to its current state letter.
+ * Jobs that aren't in alljobs aren't indexed and are ignored.
+ * The caller holds pjob's mutex.
+ */
+
+void job_index_set_state(
+
+  job *pjob)
+
+  {
+  char state = pjob->ji_wattr[JOB_ATR_state].at_val.at_char;
+
+  pthread_mutex_lock(&job_index_mutex);
+
+  boost::unordered_map<std::string, indexed_job>::iterator it = indexed_jobs.find(pjob->ji_qs.ji_jobid);
+
+  if ((it != indexed_jobs.end()) &&
+      (it->second.state != state))
+    {
+    ranked_id key(it->second.qrank, it->first);
+
+    jobs_by_state[it->second.state].erase(key);
+    jobs_by_state[state].insert(key);
+    it->second.state = state;
+    }
+
+  pthread_mutex_unlock(&job_index_mutex);
+  } /* END job_index_set_state() */
+
+
+
+/*
+ * job_index_lookup() - the ids of the jobs owned by one of users and in one
+ * of the state letters in states, ordered by queue rank
+ *
+ * @param users - user names or user@host entries, NULL for any owner
+ * @param states - state letters, NULL for any state
+ * @param jobids - O, the matching job ids
+ * @return false if neither filter was given, in which case the caller
+ * must scan instead
+ */
+
+bool job_index_lookup(
+
+  const std::vector<std::string> *users,
+  const char                     *states,
+  std::vector<std::string>       &jobids)
+
+  {
+  ranked_ids matched;
+
+  jobids.clear();
+
+  if ((users == NULL) &&
+      (states == NULL))
+    return(false);
+
+  pthread_mutex_lock(&job_index_mutex);
+
+  if (users != NULL)
+    {
+    /* a user's jobs are usually far fewer than the jobs in a state, so
+     * start from the owners and check the state of each of their jobs */
+    for (unsigned int i = 0; i < users->size(); i++)
+      {
+      boost::unordered_map<std::string, ranked_ids>::iterator it = jobs_by_owner.find(owner_key(users->at(i).c_str()));
+
+      if (it == jobs_by_owner.end())
+        continue;
+
+      for (ranked_ids::iterator id = it->second.begin(); id != it->second.end(); id++)
+        {
+        if ((states == NULL) ||
+            (strchr(states, indexed_jobs[id->second].state) != NULL))
+          matched.insert(*id);
+        }
+      }
+    }
+  else
+    {
+    for (const char *ps = states; *ps != '\0'; ps++)
+      {
+      boost::unordered_map<char, ranked_ids>::iterator it = jobs_by_state.find(*ps);
+
+      if (it != jobs_by_state.end())
+        matched.insert(it->second.begin(), it->second.end());
+      }
+    }
+
+  pthread_mutex_unlock(&job_index_mutex);
+
+  jobids.reserve(matched.size());
+
+  for (ranked_ids::iterator it = matched.begin(); it != matched.end(); it++)
+    jobids.push_back(it->second);
+
+  return(true);
+  } /* END job_index_lookup() */
+
+/* END job_index.c */
@@ -0,0 +1,791 @@
+/*
+*         OpenPBS (Portable Batch System) v2.3 Software License
+*
+* Copyright (c) 1999-2000 Veridian Information Solutions, Inc.
+* All rights reserved.
+*
+* ---------------------------------------------------------------------------
+* For a license to use or redistribute the OpenPBS software under conditions
+* other than those described below, or to purchase support for this software,
+* please contact Veridian Systems, PBS Products Department ("Licensor") at:
+*
+*    www.OpenPBS.org  +1 650 967-4675                  sales@OpenPBS.org
+*                        877 902-4PBS (US toll-free)
+* ---------------------------------------------------------------------------
+*
+* This license covers use of the OpenPBS v2.3 software (the "Software") at
+* your site or location, and, for certain users, redistribution of the
+* Software to other sites and locations.  Use and redistribution of
+* OpenPBS v2.3 in source and binary forms, with or without modification,
+* are permitted provided that all of the following conditions are met.
+* After December 31, 2001, only conditions 3-6 must be met:
+*
+* 1. Commercial and/or non-commercial use of the Software is permitted
+*    provided a current software registration is on file at www.OpenPBS.org.
+*    If use of this software contributes to a publication, product, or
+*    service, proper attribution must be given; see www.OpenPBS.org/credit.html
+*
+* 2. Redistribution in any form is only permitted for non-commercial,
+*    non-profit purposes.  There can be no charge for the Software or any
+*    software incorporating the Software.  Further, there can be no
+*    expectation of revenue generated as a consequence of redistributing
+*    the Software.
+*
+* 3. Any Redistribution of source code must retain the above copyright notice
+*    and the acknowledgment contained in paragraph 6, this list of conditions
+*    and the disclaimer contained in paragraph 7.
+*
+* 4. Any Redistribution in binary form must reproduce the above copyright
+*    notice and the acknowledgment contained in paragraph 6, this list of
+*    conditions and the disclaimer contained in paragraph 7 in the
+*    documentation and/or other materials provided with the distribution.
+*
+* 5. Redistributions in any form must be accompanied by information on how to
+*    obtain complete source code for the OpenPBS software and any
+*    modifications and/or additions to the OpenPBS software.  The source code
+*    must either be included in the distribution or be available for no more
+*    than the cost of distribution plus a nominal fee, and all modifications
+*    and additions to the Software must be freely redistributable by any party
+*    (including Licensor) without restriction.
+*
+* 6. All advertising materials mentioning features or use of the Software must
+*    display the following acknowledgment:
+*
+*     "This product includes software developed by NASA Ames Research Center,
+*     Lawrence Livermore National Laboratory, and Veridian Information
+*     Solutions, Inc.
+*     Visit www.OpenPBS.org for OpenPBS software support,
+*     products, and information."
+*
+* 7. DISCLAIMER OF WARRANTY
+*
+* THIS SOFTWARE IS PROVIDED "AS IS" WITHOUT WARRANTY OF ANY KIND. ANY EXPRESS
+* OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+* OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE, AND NON-INFRINGEMENT
+* ARE EXPRESSLY DISCLAIMED.
+*
+* IN NO EVENT SHALL VERIDIAN CORPORATION, ITS AFFILIATED COMPANIES, OR THE
+* U.S. GOVERNMENT OR ANY OF ITS AGENCIES BE LIABLE FOR ANY DIRECT OR INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+* OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+* LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+* EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* This license will be governed by the laws of the Commonwealth of Virginia,
+* without reference to its choice of law rules.
+*/
+
+/*
+ * job_journal.c - an append-only journal of job attribute changes
+ *
+ * Once a job has a full image on disk (the .JB file), job_save() appends
+ * a record of only the attributes that changed to the job's .JL file
+ * instead of rewriting the whole image.  Changes are found by comparing a
+ * cheap fingerprint of each attribute's value with the one taken when it
+ * was last persisted, so only changed attributes are encoded.  Each
+ * record is checksummed and numbered; the .JB image stores the number of
+ * the last record it contains, so a journal left behind by a crash during
+ * compaction is skipped on replay instead of applied twice.
+ *
+ * The following public functions are provided:
+ *  job_journal_append() - append the job's changed attributes
+ *  job_journal_replay() - apply the journal to a recovered job
+ *  job_journal_reset()  - discard the journal after a full save
+ *  job_journal_remove() - delete a job's journal
+ */
+
+#include <pbs_config.h>   /* the master config generated by configure */
+
+#include <pthread.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <sys/stat.h>
+#include <string>
+
+#include "pbs_ifl.h"
+#include "list_link.h"
+#include "attribute.h"
+#include "pbs_job.h"
+#include "pbs_error.h"
+#include "log.h"
+#include "../lib/Liblog/pbs_log.h"
+#include "../lib/Libifl/lib_ifl.h"
+#include "job_journal.h"
+#include "job_recov.h"
+#include "group_commit.h"
+#include "resource.h"
+
+
+extern char *path_jobs;
+extern int   LOGLEVEL;
+
+static uint32_t         crc_table[256];
+static pthread_once_t   crc_table_once = PTHREAD_ONCE_INIT;
+
+
+
+static void build_crc_table()
+
+  {
+  for (uint32_t i = 0; i < 256; i++)
+    {
+    uint32_t c = i;
+
+    for (int k = 0; k < 8; k++)
+      c = (c & 1) ? (0xedb88320 ^ (c >> 1)) : (c >> 1);
+
+    crc_table[i] = c;
+    }
+  } /* END build_crc_table() */
+
+
+
+/*
+ * journal_crc32() - the standard (zlib compatible) crc32 of buf
+ *
+ * @param crc - the crc of any preceding data, 0 to start
+ */
+
+uint32_t journal_crc32(
+
+  uint32_t    crc,
+  const char *buf,
+  size_t      len)
+
+  {
+  pthread_once(&crc_table_once, build_crc_table);
+
+  crc = crc ^ 0xffffffff;
+
+  for (size_t i = 0; i < len; i++)
+    crc = crc_table[(crc ^ (unsigned char)buf[i]) & 0xff] ^ (crc >> 8);
+
+  return(crc ^ 0xffffffff);
+  } /* END journal_crc32() */
+
+
+
+static void journal_path(
+
+  const char *fileprefix,
+  char       *path,
+  size_t      len)
+
+  {
+  snprintf(path, len, "%s%s%s", path_jobs, fileprefix, JOB_FILE_JOURNAL);
+  } /* END journal_path() */
+
+
+
+static void add_journal_entry(
+
+  std::string &entry,
+  char         op,
+  const char  *name,
+  const char  *resc,
+  const char  *value,
+  uint32_t     flags)
+
+  {
+  entry += op;
+  entry.append(name, strlen(name) + 1);
+
+  if (resc != NULL)
+    entry.append(resc, strlen(resc) + 1);
+  else
+    entry += '\0';
+
+  if (value != NULL)
+    entry.append(value, strlen(value) + 1);
+  else
+    entry += '\0';
+
+  entry.append((char *)&flags, sizeof(flags));
+  } /* END add_journal_entry() */
+
+
+
+/*
+ * encode_journal_attr() - build the journal entries that would restore
+ * one job attribute, encoded the same way saveJobToXML() encodes it
+ *
+ * @param pattr - the job's attribute array
+ * @param index - the attribute to encode
+ * @param entry - the entries are appended here
+ * @return the crc of the entries, or 0 if the attribute isn't saved
+ */
+
+static uint32_t encode_journal_attr(
+
+  pbs_attribute *pattr,
+  int            index,
+  std::string   &entry)
+
+  {
+  uint32_t crc;
+  uint32_t flags = pattr[index].at_flags & ~ATR_VFLAG_MODIFY;
+
+  if ((job_attr_def[index].at_type == ATR_TYPE_ACL) ||
+      ((pattr[index].at_flags & ATR_VFLAG_SET) == 0))
+    return(0);
+
+  if ((index != JOB_ATR_resource) &&
+      (index != JOB_ATR_resc_used))
+    {
+    std::string value;
+
+    encode_job_attr_value(pattr, index, value);
+
+    if (value.size() == 0)
+      return(0);
+
+    add_journal_entry(entry, JOURNAL_SET_ATTR, job_attr_def[index].at_name, NULL, value.c_str(), flags);
+    }
+  else
+    {
+    tlist_head  lhead;
+    svrattrl   *pal;
+
+    CLEAR_HEAD(lhead);
+
+    if (job_attr_def[index].at_encode(pattr + index,
+          &lhead,
+          job_attr_def[index].at_name,
+          NULL,
+          ATR_ENCODE_SAVE,
+          ATR_DFLAG_ACCESS) < 0)
+      return(0);
+
+    /* a resource list is always replaced as a whole */
+    add_journal_entry(entry, JOURNAL_CLEAR_ATTR, job_attr_def[index].at_name, NULL, NULL, 0);
+
+    while ((pal = (svrattrl *)GET_NEXT(lhead)) != NULL)
+      {
+      add_journal_entry(entry, JOURNAL_SET_ATTR, pal->al_name, pal->al_resc, pal->al_value, pal->al_flags);
+
+      delete_link(&pal->al_link);
+      free(pal);
+      }
+    }
+
+  crc = journal_crc32(0, entry.c_str(), entry.size());
+
+  /* 0 means not saved */
+  if (crc == 0)
+    crc = 1;
+
+  return(crc);
+  } /* END encode_journal_attr() */
+
+
+
+/*
+ * value_fingerprint() - fold an attribute value of the given type, and its
+ * flags, into crc without encoding it
+ *
+ * @return false for types that have to be encoded to be compared
+ */
+
+static bool value_fingerprint(
+
+  pbs_attribute *pattr,
+  int            type,
+  uint32_t      &crc)
+
+  {
+  uint32_t flags = pattr->at_flags & ~ATR_VFLAG_MODIFY;
+  long     size[3];
+  long     tv[2];
+
+  crc = journal_crc32(crc, (char *)&flags, sizeof(flags));
+
+  switch (type)
+    {
+    case ATR_TYPE_LONG:
+
+      crc = journal_crc32(crc, (char *)&pattr->at_val.at_long, sizeof(pattr->at_val.at_long));
+      break;
+
+    case ATR_TYPE_LL:
+
+      crc = journal_crc32(crc, (char *)&pattr->at_val.at_ll, sizeof(pattr->at_val.at_ll));
+      break;
+
+    case ATR_TYPE_SHORT:
+
+      crc = journal_crc32(crc, (char *)&pattr->at_val.at_short, sizeof(pattr->at_val.at_short));
+      break;
+
+    case ATR_TYPE_CHAR:
+
+      crc = journal_crc32(crc, &pattr->at_val.at_char, 1);
+      break;
+
+    case ATR_TYPE_SIZE:
+
+      size[0] = pattr->at_val.at_size.atsv_num;
+      size[1] = pattr->at_val.at_size.atsv_shift;
+      size[2] = pattr->at_val.at_size.atsv_units;
+      crc = journal_crc32(crc, (char *)size, sizeof(size));
+      break;
+
+    case ATR_TYPE_TV:
+
+      tv[0] = pattr->at_val.at_timeval.tv_sec;
+      tv[1] = pattr->at_val.at_timeval.tv_usec;
+      crc = journal_crc32(crc, (char *)tv, sizeof(tv));
+      break;
+
+    case ATR_TYPE_STR:
+
+      if (pattr->at_val.at_str != NULL)
+        crc = journal_crc32(crc, pattr->at_val.at_str, strlen(pattr->at_val.at_str) + 1);
+      break;
+
+    case ATR_TYPE_ARST:
+
+      if (pattr->at_val.at_arst != NULL)
+        {
+        for (int i = 0; i < pattr->at_val.at_arst->as_usedptr; i++)
+          {
+          const char *str = pattr->at_val.at_arst->as_string[i];
+
+          crc = journal_crc32(crc, str, strlen(str) + 1);
+          }
+        }
+      break;
+
+    default:
+
+      return(false);
+    }
+
+  return(true);
+  } /* END value_fingerprint() */
+
+
+
+/*
+ * attr_fingerprint() - a checksum of one job attribute that changes
+ * whenever what encode_journal_attr() would record for it changes
+ *
+ * Plain values and resource lists are checksummed in place. Other types
+ * fall back to the checksum of their encoding.
+ *
+ * @return the checksum, or 0 if the attribute isn't saved
+ */
+
+static uint32_t attr_fingerprint(
+
+  pbs_attribute *pattr,
+  int            index)
+
+  {
+  uint32_t     crc = 0;
+  bool         in_place = true;
+  std::string  entry;
+
+  if ((job_attr_def[index].at_type == ATR_TYPE_ACL) ||
+      ((pattr[index].at_flags & ATR_VFLAG_SET) == 0))
+    return(0);
+
+  if (job_attr_def[index].at_type == ATR_TYPE_RESC)
+    {
+    resource *prc = (resource *)GET_NEXT(pattr[index].at_val.at_list);
+    uint32_t  flags = pattr[index].at_flags & ~ATR_VFLAG_MODIFY;
+
+    crc = journal_crc32(crc, (char *)&flags, sizeof(flags));
+
+    while ((prc != NULL) &&
+           (in_place == true))
+      {
+      crc = journal_crc32(crc, prc->rs_defin->rs_name, strlen(prc->rs_defin->rs_name) + 1);
+      in_place = value_fingerprint(&prc->rs_value, prc->rs_defin->rs_type, crc);
+
+      prc = (resource *)GET_NEXT(prc->rs_link);
+      }
+    }
+  else
+    in_place = value_fingerprint(pattr + index, job_attr_def[index].at_type, crc);
+
+  if (in_place == false)
+    return(encode_journal_attr(pattr, index, entry));
+
+  /* 0 means not saved */
+  if (crc == 0)
+    crc = 1;
+
+  return(crc);
+  } /* END attr_fingerprint() */
+
+
+
+/*
+ * job_journal_append() - append a record of the attributes that changed
+ * since pjob was last saved to its journal
+ *
+ * Must be called with the job's mutex held and only after pjob has a full
+ * image on disk (job_journal_reset() has been called).
+ *
+ * @param pjob - the job to save
+ * @param compact - set to true if the journal should be folded into a new
+ * full image
+ * @return PBSE_NONE on success, -1 if the record couldn't be written
+ */
+
+int job_journal_append(
+
+  job  *pjob,
+  bool &compact)
+
+  {
+  char                   path[MAXPATHLEN];
+  char                   log_buf[LOCAL_LOG_BUF_SIZE];
+  uint32_t               sums[JOB_ATR_LAST];
+  std::string            record;
+  journal_record_header  hdr;
+  struct stat            statbuf;
+  int                    fds;
+  ssize_t                written;
+
+  compact = false;
+
+  if (pjob->ji_journal_sums == NULL)
+    return(-1);
+
+  record.reserve(sizeof(hdr) + sizeof(pjob->ji_qs) + 256);
+  record.append(sizeof(hdr), '\0');
+  record.append((char *)&pjob->ji_qs, sizeof(pjob->ji_qs));
+
+  for (int i = 0; i < JOB_ATR_LAST; i++)
+    {
+    std::string entry;
+
+    sums[i] = attr_fingerprint(pjob->ji_wattr, i);
+
+    if (sums[i] == pjob->ji_journal_sums[i])
+      continue;
+
+    /* only the attributes that changed are encoded */
+    if ((sums[i] == 0) ||
+        (encode_journal_attr(pjob->ji_wattr, i, entry) == 0))
+      add_journal_entry(record, JOURNAL_CLEAR_ATTR, job_attr_def[i].at_name, NULL, NULL, 0);
+    else
+      record += entry;
+    }
+
+  memset(&hdr, 0, sizeof(hdr));
+  hdr.jr_magic = JOURNAL_MAGIC;
+  hdr.jr_length = record.size() - sizeof(hdr);
+  hdr.jr_seq = pjob->ji_journal_seq + 1;
+  hdr.jr_crc = journal_crc32(0, record.c_str() + sizeof(hdr), hdr.jr_length);
+  record.replace(0, sizeof(hdr), (char *)&hdr, sizeof(hdr));
+
+  journal_path(pjob->ji_qs.ji_fileprefix, path, sizeof(path));
+
+  if ((fds = open(path, O_WRONLY | O_APPEND | O_CREAT, 0600)) < 0)
+    {
+    snprintf(log_buf, sizeof(log_buf), "cannot open journal %s", path);
+    log_err(errno, __func__, log_buf);
+    return(-1);
+    }
+
+  written = write(fds, record.c_str(), record.size());
+
+  if ((written != (ssize_t)record.size()) ||
+      (fstat(fds, &statbuf) != 0))
+    {
+    snprintf(log_buf, sizeof(log_buf), "cannot append to journal %s", path);
+    log_err(errno, __func__, log_buf);
+    close(fds);
+
+    /* the caller's full save discards the partial record */
+    return(-1);
+    }
+
+  close(fds);
+
+  pjob->ji_journal_seq = hdr.jr_seq;
+  pjob->ji_commit_ticket = mark_file_dirty(path);
+  memcpy(pjob->ji_journal_sums, sums, sizeof(sums));
+
+  for (int i = 0; i < JOB_ATR_LAST; i++)
+    pjob->ji_wattr[i].at_flags &= ~ATR_VFLAG_MODIFY;
+
+  if (statbuf.st_size >= JOURNAL_COMPACT_SIZE)
+    compact = true;
+
+  return(PBSE_NONE);
+  } /* END job_journal_append() */
+
+
+
+/*
+ * next_journal_string() - return the nul-terminated string at *pos and
+ * advance past it, or NULL if it runs past end
+ */
+
+static const char *next_journal_string(
+
+  const char **pos,
+  const char  *end)
+
+  {
+  const char *str = *pos;
+  const char *nul = (const char *)memchr(str, '\0', end - str);
+
+  if (nul == NULL)
+    return(NULL);
+
+  *pos = nul + 1;
+
+  return(str);
+  } /* END next_journal_string() */
+
+
+
+/*
+ * apply_journal_record() - apply one record's payload to pjob
+ *
+ * @param apply - false to only check that the payload is well formed and
+ * belongs to pjob, so a bad record isn't half applied
+ * @return PBSE_NONE on success, -1 if the payload is malformed
+ */
+
+static int apply_journal_record(
+
+  job        *pjob,
+  const char *payload,
+  size_t      len,
+  bool        apply)
+
+  {
+  const char    *pos = payload + sizeof(struct jobfix);
+  const char    *end = payload + len;
+  struct jobfix  qs;
+
+  if (len < sizeof(struct jobfix))
+    return(-1);
+
+  memcpy(&qs, payload, sizeof(qs));
+
+  if ((qs.qs_version != PBS_QS_VERSION) ||
+      (strcmp(qs.ji_jobid, pjob->ji_qs.ji_jobid) != 0))
+    return(-1);
+
+  if (apply == true)
+    memcpy(&pjob->ji_qs, &qs, sizeof(qs));
+
+  while (pos < end)
+    {
+    char        op = *pos++;
+    const char *name;
+    const char *resc;
+    const char *value;
+    uint32_t    flags;
+    int         index;
+
+    if (((name = next_journal_string(&pos, end)) == NULL) ||
+        ((resc = next_journal_string(&pos, end)) == NULL) ||
+        ((value = next_journal_string(&pos, end)) == NULL) ||
+        (end - pos < (ssize_t)sizeof(flags)))
+      return(-1);
+
+    memcpy(&flags, pos, sizeof(flags));
+    pos += sizeof(flags);
+
+    if ((op != JOURNAL_CLEAR_ATTR) &&
+        (op != JOURNAL_SET_ATTR))
+      return(-1);
+
+    if (apply == false)
+      continue;
+
+    if (op == JOURNAL_CLEAR_ATTR)
+      {
+      if ((index = find_attr(job_attr_def, name, JOB_ATR_LAST)) < 0)
+        continue;
+
+      job_attr_def[index].at_free(&pjob->ji_wattr[index]);
+      pjob->ji_wattr[index].at_flags &= ~(ATR_VFLAG_SET | ATR_VFLAG_MODIFY);
+      }
+    else if (op == JOURNAL_SET_ATTR)
+      {
+      char      log_buf[LOCAL_LOG_BUF_SIZE];
+      svrattrl *pal;
+
+      if ((pal = fill_svrattr_info(name, value, (*resc != '\0') ? resc : NULL, log_buf, sizeof(log_buf))) == NULL)
+        return(-1);
+
+      pal->al_flags = flags;
+
+      /* resource list entries follow a clear of the whole list */
+      decode_attribute(pal, &pjob, (*resc == '\0'));
+      free(pal);
+      }
+    }
+
+  return(PBSE_NONE);
+  } /* END apply_journal_record() */
+
+
+
+/*
+ * job_journal_replay() - apply the records in pjob's journal that are newer
+ * than its recovered image
+ *
+ * Replay stops at the first record that is truncated, fails its checksum or
+ * doesn't belong to pjob. The journal is cut back to the last good record
+ * so records appended later aren't hidden behind the bad one, and the job
+ * keeps the state of its image plus the records before it. A journal that
+ * can't be read is left alone and the job keeps its image.
+ */
+
+void job_journal_replay(
+
+  job    *pjob,
+  char   *log_buf,
+  size_t  buf_len)
+
+  {
+  char                   path[MAXPATHLEN];
+  struct stat            statbuf;
+  journal_record_header  hdr;
+  char                  *buf;
+  size_t                 offset = 0;
+  int                    fds;
+  int                    applied = 0;
+  const char            *bad = NULL;
+
+  journal_path(pjob->ji_qs.ji_fileprefix, path, sizeof(path));
+
+  if ((fds = open(path, O_RDONLY, 0)) < 0)
+    return;
+
+  if ((fstat(fds, &statbuf) != 0) ||
+      ((buf = (char *)malloc(statbuf.st_size + 1)) == NULL))
+    {
+    close(fds);
+    snprintf(log_buf, buf_len, "unable to read journal %s, recovering the job from its image", path);
+    log_err(errno, __func__, log_buf);
+    return;
+    }
+
+  if (read_ac_socket(fds, buf, statbuf.st_size) != statbuf.st_size)
+    {
+    free(buf);
+    close(fds);
+    snprintf(log_buf, buf_len, "unable to read journal %s, recovering the job from its image", path);
+    log_err(errno, __func__, log_buf);
+    return;
+    }
+
+  close(fds);
+
+  while (offset + sizeof(hdr) <= (size_t)statbuf.st_size)
+    {
+    const char *payload = buf + offset + sizeof(hdr);
+
+    memcpy(&hdr, buf + offset, sizeof(hdr));
+
+    if ((hdr.jr_magic != JOURNAL_MAGIC) ||
+        (hdr.jr_length > statbuf.st_size - offset - sizeof(hdr)) ||
+        (journal_crc32(0, payload, hdr.jr_length) != hdr.jr_crc))
+      {
+      bad = "incomplete";
+      break;
+      }
+
+    /* records at or below the image's sequence number are already in it */
+    if (hdr.jr_seq > pjob->ji_journal_seq)
+      {
+      if (apply_journal_record(pjob, payload, hdr.jr_length, false) != PBSE_NONE)
+        {
+        bad = "mismatched";
+        break;
+        }
+
+      apply_journal_record(pjob, payload, hdr.jr_length, true);
+
+      pjob->ji_journal_seq = hdr.jr_seq;
+      applied++;
+      }
+
+    offset += sizeof(hdr) + hdr.jr_length;
+    }
+
+  free(buf);
+
+  if (offset != (size_t)statbuf.st_size)
+    {
+    snprintf(log_buf, buf_len, "discarding %lu bytes of %s journal records from %s",
+      (unsigned long)(statbuf.st_size - offset),
+      (bad != NULL) ? bad : "incomplete",
+      path);
+    log_event(PBSEVENT_JOB, PBS_EVENTCLASS_JOB, pjob->ji_qs.ji_jobid, log_buf);
+
+    if (truncate(path, offset) != 0)
+      log_err(errno, __func__, path);
+    else
+      mark_file_dirty(path);
+    }
+
+  if ((applied > 0) &&
+      (LOGLEVEL >= 6))
+    {
+    snprintf(log_buf, buf_len, "replayed %d journal records", applied);
+    log_event(PBSEVENT_JOB, PBS_EVENTCLASS_JOB, pjob->ji_qs.ji_jobid, log_buf);
+    }
+  } /* END job_journal_replay() */
+
+
+
+/*
+ * job_journal_reset() - called once a full image of pjob has been written.
+ * Discards the journal and records what was saved so the next job_save()
+ * only journals what changes after this.
+ */
+
+void job_journal_reset(
+
+  job *pjob)
+
+  {
+  job_journal_remove(pjob->ji_qs.ji_fileprefix);
+
+  if (pjob->ji_journal_sums == NULL)
+    {
+    pjob->ji_journal_sums = (unsigned int *)calloc(JOB_ATR_LAST, sizeof(unsigned int));
+
+    /* without the sums every save is a full save */
+    if (pjob->ji_journal_sums == NULL)
+      return;
+    }
+
+  for (int i = 0; i < JOB_ATR_LAST; i++)
+    pjob->ji_journal_sums[i] = attr_fingerprint(pjob->ji_wattr, i);
+  } /* END job_journal_reset() */
+
+
+
+void job_journal_remove(
+
+  const char *fileprefix)
+
+  {
+  char path[MAXPATHLEN];
+
+  journal_path(fileprefix, path, sizeof(path));
+
+  if ((unlink(path) < 0) &&
+      (errno != ENOENT))
+    log_err(errno, __func__, path);
+  } /* END job_journal_remove() */
+
@@ -121,6 +121,9 @@
 #include "array.h"
 #include "../lib/Libutils/u_lock_ctl.h" /* lock_ss, unlock_ss */
 #include "job_func.h"
+#include "job_journal.h"
+#include "group_commit.h"
+#include "job_image.h"
 #else
 #include "../resmom/mom_job_func.h"
 #endif
@@ -328,6 +331,10 @@ int assign_tag_len_11(
     pjob->ji_qs.ji_un.ji_exect.ji_momaddr = (unsigned long) atol((const char*)content);
   else if (!(strncmp((const char *)tag, EXIT_STAT_TAG, 11)))
     pjob->ji_qs.ji_un.ji_momt.ji_exitstat = atoi((const char*)content);
+#ifndef PBS_MOM
+  else if (!(strncmp((const char *)tag, JRNL_SEQ_TAG, 11)))
+    pjob->ji_journal_seq = strtoul((const char*)content, NULL, 10);
+#endif /* !PBS_MOM */
   else
     rc = -1;
 
@@ -399,6 +406,64 @@ int assign_tag_len_17(
   return rc;
   } /* END assign_tag_len_17 */
 
+/*
+ * assign_job_tag() - set the job field saved under tag to content
+ */
+
+int assign_job_tag(
+
+  job        **pjob,    /* M */ /* job information to fill into */
+  const char  *tag,     /* I */ /* field's xml tag */
+  const char  *content, /* I */ /* field's value */
+  char        *log_buf, /* O */ /* error message buffer */
+  size_t       buf_len) /* I */ /* size of error message buffer */
+
+  {
+  xmlChar *xtag = (xmlChar *)tag;
+  xmlChar *xcontent = (xmlChar *)content;
+  int      rc = -1;
+
+  switch (strlen(tag))
+    {
+    case 5:
+      rc = assign_tag_len_5(pjob, xtag, xcontent);
+      break;
+    case 6:
+      rc = assign_tag_len_6(pjob, xtag, xcontent);
+      break;
+    case 7:
+      rc = assign_tag_len_7(pjob, xtag, xcontent);
+      break;
+    case 8:
+      rc = assign_tag_len_8(pjob, xtag, xcontent);
+      break;
+    case 9:
+      rc = assign_tag_len_9(pjob, xtag, xcontent);
+      break;
+    case 10:
+      rc = assign_tag_len_10(pjob, xtag, xcontent);
+      break;
+    case 11:
+      rc = assign_tag_len_11(pjob, xtag, xcontent);
+      break;
+    case 12:
+      rc = assign_tag_len_12(pjob, xtag, xcontent);
+      break;
+    case 13:
+      rc = assign_tag_len_13(pjob, xtag, xcontent);
+      break;
+    case 17:
+      rc = assign_tag_len_17(pjob, xtag, xcontent);
+      break;
+    }
+
+  if (rc == -1) 
+    snprintf(log_buf, buf_len, "error: invalid tag found %s", tag);
+
+  return(rc);
+  } /* END assign_job_tag() */
+
+
 int assign_job_field(
 
   job     **pjob,    /* M */ /* job information to fill into */
@@ -409,51 +474,15 @@ int assign_job_field(
   {
   xmlChar  *tag = (xmlChar *)xml_node->name;
   xmlChar  *content;
-  size_t    len;
   int rc = -1;
 
   content = xmlNodeGetContent(xml_node);
 
   if (content)
     {
-    len = strlen((char *)tag);
-    switch (len)
-      {
-      case 5:
-        rc = assign_tag_len_5(pjob, tag, content);
-        break;
-      case 6:
-        rc = assign_tag_len_6(pjob, tag, content);
-        break;
-      case 7:
-        rc = assign_tag_len_7(pjob, tag, content);
-        break;
-      case 8:
-        rc = assign_tag_len_8(pjob, tag, content);
-        break;
-      case 9:
-        rc = assign_tag_len_9(pjob, tag, content);
-        break;
-      case 10:
-        rc = assign_tag_len_10(pjob, tag, content);
-        break;
-      case 11:
-        rc = assign_tag_len_11(pjob, tag, content);
-        break;
-      case 12:
-        rc = assign_tag_len_12(pjob, tag, content);
-        break;
-      case 13:
-        rc = assign_tag_len_13(pjob, tag, content);
-        break;
-      case 17:
-        rc = assign_tag_len_17(pjob, tag, content);
-        break;
-      }
-      if (rc == -1) 
-        snprintf(log_buf, buf_len, "error: invalid tag found %s", tag);
+    rc = assign_job_tag(pjob, (const char *)tag, (const char *)content, log_buf, buf_len);
 
-      xmlFree(content);
+    xmlFree(content);
     }
     else
       snprintf(log_buf, buf_len, "Error: xml tag %s did not have a value", tag);
@@ -750,6 +779,15 @@ void add_fix_fields(
  xmlNewChild(root_node, NULL, (xmlChar *)FPREFIX_TAG, (xmlChar *)pjob->ji_qs.ji_fileprefix); 
  xmlNewChild(root_node, NULL, (xmlChar *)QUEUE_TAG, (xmlChar *)pjob->ji_qs.ji_queue);
  xmlNewChild(root_node, NULL, (xmlChar *)DST_QUEUE, (xmlChar *)pjob->ji_qs.ji_destin);
+
+#ifndef PBS_MOM
+ /* journal records up to this one are already folded into this file */
+ if (pjob->ji_journal_seq != 0)
+   {
+   snprintf(buf, sizeof(buf), "%lu", pjob->ji_journal_seq);
+   xmlNewChild(root_node, NULL, (xmlChar *)JRNL_SEQ_TAG, (xmlChar *)buf);
+   }
+#endif /* !PBS_MOM */
  } /* END add_fix_fields */
 
 
@@ -913,6 +951,28 @@ void translate_dependency_to_string(
 
 
 
+/*
+ * encode_job_attr_value() - the string saved to disk for a job attribute
+ * that is not a resource list
+ */
+
+void encode_job_attr_value(
+
+  pbs_attribute *pattr,  /* I ptr to pbs_attribute value array */
+  int            index,  /* I which attribute */
+  std::string   &value)  /* O the encoded value */
+
+  {
+#ifndef PBS_MOM
+  if (index == JOB_ATR_depend)
+    translate_dependency_to_string(pattr + index, value);
+  else
+#endif
+    attr_to_str(value, job_attr_def + index, pattr[index], false);
+  } /* END encode_job_attr_value() */
+
+
+
 /*
  * add_encoded_attributes () - add encoded job attributes xml nodes. 
  */
@@ -946,12 +1006,7 @@ int add_encoded_attributes(
         {
         std::string value;
 
-#ifndef PBS_MOM
-        if (i == JOB_ATR_depend)
-          translate_dependency_to_string(pattr + i, value);
-        else
-#endif
-          attr_to_str(value, job_attr_def + i, pattr[i], false);
+        encode_job_attr_value(pattr, i, value);
 
         if (value.size() == 0)
           continue;
@@ -1137,6 +1192,195 @@ int saveJobToXML(
   } /* saveJobToXML */
 
 
+#ifndef PBS_MOM
+/*
+ * add_image_fields() - add the fields saveJobToXML() writes as xml nodes
+ * (see add_fix_fields() and add_union_fields()) to a job image
+ */
+
+void add_image_fields(
+
+  std::string &image, /* M job image */
+  const job   *pjob)  /* I job to save */
+
+  {
+  char buf[BUFSIZE];
+
+  snprintf(buf, sizeof(buf), "%d", pjob->ji_qs.qs_version);
+  job_image_add(image, JOB_IMAGE_FIELD, VERSION_TAG, NULL, buf, 0);
+  snprintf(buf, sizeof(buf), "%d", pjob->ji_qs.ji_state);
+  job_image_add(image, JOB_IMAGE_FIELD, STATE_TAG, NULL, buf, 0);
+  snprintf(buf, sizeof(buf), "%d", pjob->ji_qs.ji_substate);
+  job_image_add(image, JOB_IMAGE_FIELD, SUBSTATE_TAG, NULL, buf, 0);
+  snprintf(buf, sizeof(buf), "%d", pjob->ji_qs.ji_svrflags);
+  job_image_add(image, JOB_IMAGE_FIELD, SRV_FLAGS_TAG, NULL, buf, 0);
+  snprintf(buf, sizeof(buf), "%ld", pjob->ji_qs.ji_stime);
+  job_image_add(image, JOB_IMAGE_FIELD, STIME_TAG, NULL, buf, 0);
+  job_image_add(image, JOB_IMAGE_FIELD, JOBID_TAG, NULL, pjob->ji_qs.ji_jobid, 0);
+  job_image_add(image, JOB_IMAGE_FIELD, FPREFIX_TAG, NULL, pjob->ji_qs.ji_fileprefix, 0);
+  job_image_add(image, JOB_IMAGE_FIELD, QUEUE_TAG, NULL, pjob->ji_qs.ji_queue, 0);
+  job_image_add(image, JOB_IMAGE_FIELD, DST_QUEUE, NULL, pjob->ji_qs.ji_destin, 0);
+
+  if (pjob->ji_journal_seq != 0)
+    {
+    snprintf(buf, sizeof(buf), "%lu", pjob->ji_journal_seq);
+    job_image_add(image, JOB_IMAGE_FIELD, JRNL_SEQ_TAG, NULL, buf, 0);
+    }
+
+  snprintf(buf, sizeof(buf), "%d", pjob->ji_qs.ji_un_type);
+  job_image_add(image, JOB_IMAGE_FIELD, REC_TYPE_TAG, NULL, buf, 0);
+
+  switch (pjob->ji_qs.ji_un_type)
+    {
+    case JOB_UNION_TYPE_NEW:
+      snprintf(buf, sizeof(buf), "%lu", pjob->ji_qs.ji_un.ji_newt.ji_fromaddr);
+      job_image_add(image, JOB_IMAGE_FIELD, FROM_HOST_TAG, NULL, buf, 0);
+      snprintf(buf, sizeof(buf), "%d", pjob->ji_qs.ji_un.ji_newt.ji_fromsock);
+      job_image_add(image, JOB_IMAGE_FIELD, FROM_SOCK_TAG, NULL, buf, 0);
+      snprintf(buf, sizeof(buf), "%d", pjob->ji_qs.ji_un.ji_newt.ji_scriptsz);
+      job_image_add(image, JOB_IMAGE_FIELD, SCRT_SIZE_TAG, NULL, buf, 0);
+      break;
+    case JOB_UNION_TYPE_EXEC:
+      snprintf(buf, sizeof(buf), "%lu", pjob->ji_qs.ji_un.ji_exect.ji_momaddr);
+      job_image_add(image, JOB_IMAGE_FIELD, MOM_ADDR_TAG, NULL, buf, 0);
+      snprintf(buf, sizeof(buf), "%d", pjob->ji_qs.ji_un.ji_exect.ji_momport);
+      job_image_add(image, JOB_IMAGE_FIELD, MOM_PORT_TAG, NULL, buf, 0);
+      snprintf(buf, sizeof(buf), "%d", pjob->ji_qs.ji_un.ji_exect.ji_mom_rmport);
+      job_image_add(image, JOB_IMAGE_FIELD, MOM_RPORT_TAG, NULL, buf, 0);
+      break;
+    case JOB_UNION_TYPE_ROUTE:
+      snprintf(buf, sizeof(buf), "%ld", pjob->ji_qs.ji_un.ji_routet.ji_quetime);
+      job_image_add(image, JOB_IMAGE_FIELD, QUE_TIME_TAG, NULL, buf, 0);
+      snprintf(buf, sizeof(buf), "%ld", pjob->ji_qs.ji_un.ji_routet.ji_rteretry);
+      job_image_add(image, JOB_IMAGE_FIELD, RQUE_TIME_TAG, NULL, buf, 0);
+      break;
+    case JOB_UNION_TYPE_MOM:
+      snprintf(buf, sizeof(buf), "%lu", pjob->ji_qs.ji_un.ji_momt.ji_svraddr);
+      job_image_add(image, JOB_IMAGE_FIELD, SVR_ADDR_TAG, NULL, buf, 0);
+      snprintf(buf, sizeof(buf), "%d", pjob->ji_qs.ji_un.ji_momt.ji_exitstat);
+      job_image_add(image, JOB_IMAGE_FIELD, EXIT_STAT_TAG, NULL, buf, 0);
+      snprintf(buf, sizeof(buf), "%u", pjob->ji_qs.ji_un.ji_momt.ji_exuid);
+      job_image_add(image, JOB_IMAGE_FIELD, EXEC_UID_TAG, NULL, buf, 0);
+      snprintf(buf, sizeof(buf), "%u", pjob->ji_qs.ji_un.ji_momt.ji_exgid);
+      job_image_add(image, JOB_IMAGE_FIELD, EXEC_GID_TAG, NULL, buf, 0);
+      break;
+    }
+  } /* END add_image_fields() */
+
+
+
+/*
+ * add_image_attributes() - add the job's attributes to a job image,
+ * encoded the same way add_encoded_attributes() encodes them
+ */
+
+int add_image_attributes(
+
+  std::string   &image, /* M job image */
+  pbs_attribute *pattr) /* M ptr to pbs_attribute value array */
+
+  {
+  tlist_head  lhead;
+  svrattrl   *pal;
+  int         i;
+
+  CLEAR_HEAD(lhead);
+
+  for (i = 0; i < JOB_ATR_LAST; i++)
+    {
+    if ((job_attr_def[i].at_type == ATR_TYPE_ACL) ||
+        ((pattr[i].at_flags & ATR_VFLAG_SET) == 0))
+      continue;
+
+    if ((i != JOB_ATR_resource) &&
+        (i != JOB_ATR_resc_used))
+      {
+      std::string value;
+
+      encode_job_attr_value(pattr, i, value);
+
+      if (value.size() == 0)
+        continue;
+
+      job_image_add(image, JOB_IMAGE_ATTR, job_attr_def[i].at_name, NULL, value.c_str(), pattr[i].at_flags);
+      pattr[i].at_flags &= ~ATR_VFLAG_MODIFY;
+      }
+    else
+      {
+      if (job_attr_def[i].at_encode(pattr + i,
+            &lhead,
+            job_attr_def[i].at_name,
+            NULL,
+            ATR_ENCODE_SAVE,
+            ATR_DFLAG_ACCESS) < 0)
+        return(-1);
+
+      pattr[i].at_flags &= ~ATR_VFLAG_MODIFY;
+
+      while ((pal = (svrattrl *)GET_NEXT(lhead)) != NULL)
+        {
+        job_image_add(image, JOB_IMAGE_ATTR, pal->al_name, pal->al_resc, pal->al_value, pal->al_flags);
+
+        delete_link(&pal->al_link);
+        free(pal);
+        }
+      }
+    }
+
+  return(PBSE_NONE);
+  } /* END add_image_attributes() */
+
+
+
+/*
+ * saveJobToImage() - save job to disk as a job image (see job_image.c)
+ */
+
+int saveJobToImage(
+
+  job        *pjob,      /* I - pointer to job */
+  const char *filename)  /* I - filename to save to */
+
+  {
+  std::string image;
+  char        log_buf[LOCAL_LOG_BUF_SIZE];
+
+  job_image_begin(image);
+  add_image_fields(image, pjob);
+
+  if ((add_image_attributes(image, pjob->ji_wattr) != PBSE_NONE) ||
+      (job_image_write(image, filename) != PBSE_NONE))
+    {
+    snprintf(log_buf, sizeof(log_buf), "failed writing job to the image file %s", filename);
+    log_event(PBSEVENT_JOB, PBS_EVENTCLASS_JOB, pjob->ji_qs.ji_jobid, log_buf);
+
+    return(-1);
+    }
+
+  return(PBSE_NONE);
+  } /* END saveJobToImage() */
+#endif /* !PBS_MOM */
+
+
+#ifndef PBS_MOM
+/*
+ * use_job_images() - true if jobs are saved as job images instead of xml,
+ * set with the binary_job_images server attribute
+ */
+
+bool use_job_images()
+
+  {
+  long binary = FALSE;
+
+  get_svr_attr_l(SRV_ATR_BinaryJobImages, &binary);
+
+  return(binary != FALSE);
+  } /* END use_job_images() */
+#endif /* !PBS_MOM */
+
+
+
 /*
  * job_save() - Saves (or updates) a job structure image on disk
  *
@@ -1157,6 +1401,11 @@ int saveJobToXML(
  * For a new file write, first time, the data is written directly to
  * the file.
  *
+ * On the server, once a job has a full image on disk, quick and full
+ * updates only append the attributes that changed to the job's journal
+ * (see job_journal.c).  The journal is folded back into a new full image
+ * once it grows past JOURNAL_COMPACT_SIZE.
+ *
  *      RETURN:  0 - success, -1 - failure
  */
 
@@ -1170,6 +1419,7 @@ int job_save(
   char    namebuf1[MAXPATHLEN];
   char    namebuf2[MAXPATHLEN];
   const char   *tmp_ptr = NULL;
+  int           save_rc;
 
   time_t  time_now = time(NULL);
 
@@ -1205,7 +1455,30 @@ int job_save(
     pjob->ji_wattr[JOB_ATR_mtime].at_val.at_long = time_now;
     }
 
-  if (!(saveJobToXML(pjob, namebuf2)))
+#ifndef PBS_MOM
+  if ((updatetype != SAVEJOB_NEW) &&
+      (mom_port == 0) &&
+      (pjob->ji_is_array_template == FALSE) &&
+      (pjob->ji_journal_sums != NULL))
+    {
+    bool compact = false;
+
+    if ((job_journal_append(pjob, compact) == PBSE_NONE) &&
+        (compact == false))
+      return(PBSE_NONE);
+
+    /* the journal is full or could not be written, save the whole job */
+    }
+#endif /* !PBS_MOM */
+
+#ifndef PBS_MOM
+  if (use_job_images() == true)
+    save_rc = saveJobToImage(pjob, namebuf2);
+  else
+#endif /* !PBS_MOM */
+    save_rc = saveJobToXML(pjob, namebuf2);
+
+  if (save_rc == PBSE_NONE)
     {
     unlink(namebuf1);
 
@@ -1220,15 +1493,23 @@ int job_save(
     else
       {
       unlink(namebuf2);
+
+#ifndef PBS_MOM
+      pjob->ji_commit_ticket = mark_file_dirty(namebuf1);
+
+      if ((mom_port == 0) &&
+          (pjob->ji_is_array_template == FALSE))
+        job_journal_reset(pjob);
+#endif /* !PBS_MOM */
       }
     }
-  else /* saveJobToXML failed */
+  else /* saving the job failed */
     {
     log_event(
     PBSEVENT_ERROR | PBSEVENT_SECURITY,
     PBS_EVENTCLASS_JOB,
     pjob->ji_qs.ji_jobid,
-    (char *)"call to saveJobToXML in job_save failed");
+    (char *)"writing the job file in job_save failed");
     return -1;
     }
   return(PBSE_NONE);
@@ -1338,6 +1619,101 @@ int job_recov_xml(
   } /* END job_recov_xml */
 
 
+
+#ifndef PBS_MOM
+/*
+ * job_recov_image() - recover a job from a job image (see job_image.c)
+ *
+ * The image is mapped and its strings are decoded in place.
+ *
+ * @return PBSE_NONE on success, PBSE_INVALID_SYNTAX if the file isn't a
+ * job image, -1 on failure
+ */
+
+int job_recov_image(
+
+  char   *filename,  /* I */   /* pathname to job save file */
+  job   **pjob,      /* M */   /* pointer to a pointer of job structure to fill info */
+  char   *log_buf,   /* O */   /* buffer to hold error message */
+  size_t  buf_len)   /* I */   /* len of the error buffer */
+
+  {
+  job_image_map   map;
+  job_image_item  item;
+  svrattrl        pal;
+  const char     *prev_name = NULL;
+  bool            prefix_checked = false;
+  int             rc;
+
+  if ((rc = job_image_open(filename, &map)) != PBSE_NONE)
+    {
+    if (rc != PBSE_INVALID_SYNTAX)
+      snprintf(log_buf, buf_len, "unable to map job image %s", filename);
+
+    return(rc);
+    }
+
+  memset(&pal, 0, sizeof(pal));
+  CLEAR_LINK(pal.al_link);
+
+  while ((rc = job_image_next(&map, &item)) == 1)
+    {
+    if (item.it_type == JOB_IMAGE_FIELD)
+      {
+      if (assign_job_tag(pjob, item.it_name, item.it_value, log_buf, buf_len) != PBSE_NONE)
+        break;
+
+      continue;
+      }
+
+    if (item.it_type != JOB_IMAGE_ATTR)
+      {
+      snprintf(log_buf, buf_len, "unknown entry type %d in %s", item.it_type, filename);
+      break;
+      }
+
+    /* the fields come first, check them before decoding attributes */
+    if (prefix_checked == false)
+      {
+      if (check_fileprefix(filename, pjob, log_buf, buf_len) != PBSE_NONE)
+        break;
+
+      prefix_checked = true;
+      }
+
+    pal.al_name = item.it_name;
+    pal.al_resc = (item.it_resc[0] != '\0') ? item.it_resc : NULL;
+    pal.al_value = item.it_value;
+    pal.al_flags = item.it_flags;
+
+    /* a resource list's entries are consecutive, only free it on the first */
+    decode_attribute(&pal, pjob,
+      ((pal.al_resc == NULL) || (prev_name == NULL) || (strcmp(prev_name, item.it_name))));
+
+    prev_name = item.it_name;
+    }
+
+  job_image_close(&map);
+
+  if (rc != 0)
+    {
+    if (rc == -1)
+      snprintf(log_buf, buf_len, "job image %s is corrupt", filename);
+
+    return(-1);
+    }
+
+  if (prefix_checked == false)
+    {
+    snprintf(log_buf, buf_len, "no job attributes found in %s", filename);
+    return(-1);
+    }
+
+  return(PBSE_NONE);
+  } /* END job_recov_image() */
+#endif /* !PBS_MOM */
+
+
 /*
  * binary_job_recov() - recover (read in) a job from its save file
  *
@@ -1491,6 +1867,9 @@ job *job_recov(
   char  namebuf[MAXPATHLEN];
   char  log_buf[LOCAL_LOG_BUF_SIZE];
   int   rc;
+#ifndef PBS_MOM
+  bool  current_format = false;
+#endif
 
   pj = job_alloc(); /* allocate & initialize job structure space */
 
@@ -1504,9 +1883,35 @@ job *job_recov(
   snprintf(namebuf, MAXPATHLEN, "%s%s", path_jobs, filename); /* job directory path, filename */
   size_t logBufLen = sizeof(log_buf);
 
+#ifndef PBS_MOM
+  if ((rc = job_recov_image(namebuf, &pj, log_buf, logBufLen)) == PBSE_NONE)
+    current_format = use_job_images();
+  else if (rc == PBSE_INVALID_SYNTAX)
+    {
+    if ((rc = job_recov_xml(namebuf, &pj, log_buf, logBufLen)) == PBSE_NONE)
+      current_format = !use_job_images();
+    }
+
+  if (rc == PBSE_INVALID_SYNTAX)
+#else
   if ((rc = job_recov_xml(namebuf, &pj, log_buf, logBufLen)) && rc == PBSE_INVALID_SYNTAX)
+#endif /* !PBS_MOM */
     rc = job_recov_binary(namebuf, &pj, log_buf, logBufLen);
 
+#ifndef PBS_MOM
+  /* apply any changes recorded since the image was last written */
+  if (rc == PBSE_NONE)
+    {
+    unsigned long image_seq = pj->ji_journal_seq;
+
+    /* a bad journal is logged and cut back, the job keeps its image */
+    job_journal_replay(pj, log_buf, logBufLen);
+
+    if (pj->ji_journal_seq != image_seq)
+      current_format = false;
+    }
+#endif /* !PBS_MOM */
+
   if (rc == PBSE_NONE)
     rc = set_array_job_ids(&pj, log_buf, logBufLen);
 
@@ -1533,7 +1938,9 @@ job *job_recov(
 #ifdef PBS_MOM
   job_save(pj, SAVEJOB_FULL, (multi_mom == 0)?0:pbs_rm_port);
 #else
-  job_save(pj, SAVEJOB_FULL, 0);
+  /* rewrite the file only to fold in a journal or change its format */
+  if (current_format == false)
+    job_save(pj, SAVEJOB_FULL, 0);
 #endif
 
   return(pj);
@@ -1,6 +1,7 @@
 #ifndef _JOB_RECOV_H
 #define _JOB_RECOV_H
 #include "license_pbs.h" /* See here for the software license */
+#include <string>
 #include "job_recovery.h"
 
 
@@ -12,5 +13,14 @@ job *job_recov(char *filename);
 void   add_fix_fields(xmlNodePtr *rnode, const job *pjob);
 void   add_union_fields(xmlNodePtr *rnode, const job *pjob);
 int    saveJobToXML(job *pjob, const char *filename);
+int    assign_job_tag(job **pjob, const char *tag, const char *content, char *log_buf, size_t buf_len);
+#ifndef PBS_MOM
+bool   use_job_images();
+int    saveJobToImage(job *pjob, const char *filename);
+int    job_recov_image(char *filename, job **pjob, char *log_buf, size_t buf_len);
+#endif /* !PBS_MOM */
+void   encode_job_attr_value(pbs_attribute *pattr, int index, std::string &value);
+void   decode_attribute(svrattrl *pal, job **pjob, bool freeExisting);
+svrattrl *fill_svrattr_info(const char *aname, const char *avalue, const char *rname, char *log_buf, size_t buf_len);
 
 #endif /* _JOB_RECOV_H */
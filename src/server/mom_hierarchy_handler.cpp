@@ -474,6 +474,7 @@ void mom_hierarchy_handler::initialLoadHierarchy(void)
       pnode->nd_lastHierarchySent = 0;
       pnode->nd_state &= ~INUSE_NOHIERARCHY;
       }
+    update_node_capacity(pnode);
     unlock_node(pnode, __func__, NULL, LOGLEVEL);
     }
   pthread_mutex_unlock(&hierarchy_mutex);
@@ -541,6 +542,7 @@ int mom_hierarchy_handler::sendHierarchyToNode(
 
   {
   char                log_buf[LOCAL_LOG_BUF_SIZE];
+  char                frame_version[MAXLINE];
   const char        *string;
   int                 ret = PBSE_NONE;
   int                 sock;
@@ -618,6 +620,25 @@ int mom_hierarchy_handler::sendHierarchyToNode(
 
     ret = diswst(chan, IS_EOL_MESSAGE);
 
+    /* tell the mom it may send status frames. This follows the end of the
+     * hierarchy, so moms that don't know about frames never read it. */
+    if (ret == DIS_SUCCESS)
+      {
+      snprintf(frame_version, sizeof(frame_version), "%s%d",
+        STATUS_FRAME_VERSION_KEYWORD, STATUS_FRAME_VERSION);
+
+      ret = diswst(chan, frame_version);
+      }
+
+    /* and that it merges status deltas into the statuses it has */
+    if (ret == DIS_SUCCESS)
+      {
+      snprintf(frame_version, sizeof(frame_version), "%s%d",
+        STATUS_DELTAS_KEYWORD, STATUS_DELTAS_VERSION);
+
+      ret = diswst(chan, frame_version);
+      }
+
     DIS_tcp_wflush(chan);
     }
 
@@ -703,6 +724,7 @@ void mom_hierarchy_handler::checkAndSendHierarchy(void)
           pnode->nd_state = INUSE_FREE; //This was created as a dynamic node and
                                         //it now has a good ok host list so mark
                                         //it ready for use.
+          update_node_capacity(pnode);
           }
         unlock_node(pnode, __func__, NULL, LOGLEVEL);
         }
@@ -792,6 +792,7 @@ int initialize_pbsnode(
   pnode->nd_state           = INUSE_DOWN;
   pnode->nd_first           = init_prop(pnode->nd_name);
   pnode->nd_last            = pnode->nd_first;
+  update_prop_bits(pnode);
   pnode->nd_f_st            = init_prop(pnode->nd_name);
   pnode->nd_l_st            = pnode->nd_f_st;
   pnode->nd_hierarchy_level = -1; /* maximum unsigned short */
@@ -888,6 +889,10 @@ void effective_node_delete(
 
   pnode->nd_first = NULL;
 
+  update_prop_bits(pnode);
+
+  node_capacity.set_node_free(pnode->nd_id, -1);
+
   if (pnode->nd_addrs != NULL)
     {
     for (up = pnode->nd_addrs;*up != 0;up++)
@@ -1456,6 +1461,58 @@ struct prop *init_prop(
 
 
 
+/*
+ * update_prop_bits - rebuild pnode's interned property bits from nd_first
+ * and move the node between the property index's node sets to match.
+ * Must be called whenever nd_first is rebuilt.
+ */
+
+void update_prop_bits(
+
+  struct pbsnode *pnode) /* I/O */
+
+  {
+  prop_bitset  bits;
+  struct prop *pp;
+
+  for (pp = pnode->nd_first; pp != NULL; pp = pp->next)
+    {
+    if (pp->name != NULL)
+      prop_bitset_set(bits, node_props.intern(pp->name));
+    }
+
+  node_props.set_node_props(pnode->nd_id, pnode->nd_prop_bits, bits);
+
+  pnode->nd_prop_bits.swap(bits);
+  }  /* END update_prop_bits() */
+
+
+
+
+/*
+ * update_node_capacity - refresh pnode's entry in the free capacity index.
+ * Must be called, with pnode locked, whenever its state, power state or
+ * free execution slots change.
+ */
+
+void update_node_capacity(
+
+  struct pbsnode *pnode) /* I */
+
+  {
+  int free_slots = -1;
+
+  /* the same states node_is_spec_acceptable() turns away */
+  if (((pnode->nd_state & (INUSE_OFFLINE | INUSE_NOT_READY | INUSE_RESERVE | INUSE_JOB)) == 0) &&
+      (pnode->nd_power_state == POWER_STATE_RUNNING))
+    free_slots = pnode->nd_slots.get_number_free();
+
+  node_capacity.set_node_free(pnode->nd_id, free_slots);
+  }  /* END update_node_capacity() */
+
+
+
+
 /*
  * add_execution_slot - create a subnode entry and link to parent node
  *
@@ -1482,6 +1539,8 @@ int add_execution_slot(
        (!job_exclusive_on_use))
     pnode->nd_state &= ~INUSE_JOB;
 
+  update_node_capacity(pnode);
+
   return(PBSE_NONE);
   }  /* END add_execution_slot() */
 
@@ -1622,6 +1681,8 @@ int copy_properties(
   *plink = pdest;
   dest->nd_last = pdest;
 
+  update_prop_bits(dest);
+
   return(PBSE_NONE);
   } /* END copy_properties() */
 
@@ -2629,6 +2690,8 @@ int setup_nodes(void)
           /* exclusive bits are calculated later in set_old_nodes() */
           np->nd_state &= ~INUSE_JOB;
 
+          update_node_capacity(np);
+
           unlock_node(np, __func__, "match", LOGLEVEL);
 
           break;
@@ -2660,6 +2723,8 @@ int setup_nodes(void)
           {
           np->nd_power_state = num;
 
+          update_node_capacity(np);
+
           unlock_node(np, __func__, "match", LOGLEVEL);
 
           break;
@@ -2739,6 +2804,7 @@ void delete_a_subnode(
 
   {
   pnode->nd_slots.remove_execution_slot();
+  update_node_capacity(pnode);
   return;
   }  /* END delete_a_subnode() */
 
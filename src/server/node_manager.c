@@ -384,6 +384,8 @@ void update_node_state(
     np->nd_state |= INUSE_UNKNOWN;
     }
 
+  update_node_capacity(np);
+
   if ((LOGLEVEL >= 2) && (log_buf[0] != '\0'))
     {
     log_record(PBSEVENT_SCHED, PBS_EVENTCLASS_REQUEST, __func__, log_buf);
@@ -1019,6 +1021,7 @@ void setup_notification(
       {
       /* call it offline until after all nodes get the new ipaddr */
       pnode->nd_state |= INUSE_OFFLINE;
+      update_node_capacity(pnode);
       
       nnew = (new_node *)calloc(1, sizeof(new_node));
       
@@ -2185,6 +2188,40 @@ int procs_available(
 
 
 
+/*
+ * node_is_spec_eligible()
+ *
+ * @return true if pnode has the properties and the total slots, gpus and mics spec asks for,
+ * whether or not they are free right now
+ */
+
+bool node_is_spec_eligible(
+
+  struct pbsnode   *pnode,
+  single_spec_data *spec)
+
+  {
+  /* make sure that the node has properties */
+  if (spec->prop_bits != NULL)
+    {
+    if ((spec->prop_unknown == true) ||
+        (prop_bitset_contains(pnode->nd_prop_bits, *spec->prop_bits) == false))
+      return(false);
+    }
+  else if (hasprop(pnode, spec->prop) == FALSE)
+    return(false);
+
+  if ((hasppn(pnode, spec->ppn, SKIP_NONE) == FALSE) ||
+      (gpu_count(pnode, FALSE) < spec->gpu) ||
+      (pnode->nd_nmics < spec->mic))
+    return(false);
+
+  return(true);
+  } /* END node_is_spec_eligible() */
+
+
+
+
 bool node_is_spec_acceptable(
 
   struct pbsnode   *pnode,
@@ -2194,8 +2231,6 @@ bool node_is_spec_acceptable(
   bool              job_is_exclusive)
 
   {
-  struct prop    *prop = spec->prop;
-
   int             ppn_req = spec->ppn;
   int             gpu_req = spec->gpu;
   int             mic_req = spec->mic;
@@ -2217,13 +2252,7 @@ bool node_is_spec_acceptable(
   /* NYI: check if these are necessary */
   pnode->nd_flag = okay;
 
-  /* make sure that the node has properties */
-  if (hasprop(pnode, prop) == FALSE)
-    return(false);
-
-  if ((hasppn(pnode, ppn_req, SKIP_NONE) == FALSE) ||
-      (gpu_count(pnode, FALSE) < gpu_req) ||
-      (pnode->nd_nmics < mic_req))
+  if (node_is_spec_eligible(pnode, spec) == false)
     return(false);
 
   (*eligible_nodes)++;
@@ -2253,6 +2282,41 @@ bool node_is_spec_acceptable(
 
 
 
+/*
+ * set_req_prop_bits() - translate the marked properties of req into
+ * interned ids so node_is_spec_acceptable() can check them against
+ * each node's nd_prop_bits without comparing names
+ */
+
+void set_req_prop_bits(
+
+  single_spec_data *req)
+
+  {
+  struct prop *pp;
+  int          id;
+
+  if (req->prop == NULL)
+    return;
+
+  req->prop_bits = new prop_bitset();
+
+  for (pp = req->prop; pp != NULL; pp = pp->next)
+    {
+    if (pp->mark == 0)
+      continue;
+
+    /* a property no node has ever had can't be satisfied */
+    if ((id = node_props.get_id(pp->name)) < 0)
+      req->prop_unknown = true;
+    else
+      prop_bitset_set(*req->prop_bits, id);
+    }
+  } /* END set_req_prop_bits() */
+
+
+
+
 int parse_req_data(
     
   complete_spec_data *all_reqs)
@@ -2274,6 +2338,8 @@ int parse_req_data(
     req->gpu   = 0;
     req->ppn   = 1;
     req->prop  = NULL;
+    req->prop_bits    = NULL;
+    req->prop_unknown = false;
 
     if ((cray_enabled == FALSE) ||
         (is_compute_node(all_reqs->req_start[i]) == FALSE))
@@ -2303,6 +2369,8 @@ int parse_req_data(
         }
       }
 
+    set_req_prop_bits(req);
+
     all_reqs->total_nodes += req->nodes;
     }
 
@@ -2719,6 +2787,8 @@ int add_login_node_if_needed(
         req.gpu = 0;
         req.mic = 0;
         req.prop = NULL;
+        req.prop_bits = NULL;
+        req.prop_unknown = false;
         save_node_for_adding(naji, login, &req, login->nd_id, FALSE, -1);
         first_node_id = login->nd_id;
         }
@@ -2891,6 +2961,198 @@ int select_nodes_using_hostlist(
 
 
 
+/*
+ * get_candidate_nodes()
+ *
+ * When every req that still needs nodes names at least one property, only the nodes that have
+ * all of some req's properties can be selected. Those come from the property index.
+ *
+ * @param candidates - set to the union over the reqs of the ids of the nodes that fit
+ * @return true if candidates can be used, false if every node has to be checked
+ */
+
+bool get_candidate_nodes(
+
+  complete_spec_data *all_reqs,   /* I */
+  prop_bitset        &candidates) /* O */
+
+  {
+  prop_bitset with;
+
+  candidates.clear();
+
+  for (int i = 0; i < all_reqs->num_reqs; i++)
+    {
+    single_spec_data *req = all_reqs->reqs + i;
+
+    if (req->nodes <= 0)
+      continue;
+
+    if (req->prop_bits == NULL)
+      return(false);
+
+    if (req->prop_unknown == true)
+      continue;
+
+    if (node_props.nodes_with_all(*req->prop_bits, with) == false)
+      return(false);
+
+    if (with.size() > candidates.size())
+      candidates.resize(with.size(), 0);
+
+    for (unsigned int w = 0; w < with.size(); w++)
+      candidates[w] |= with[w];
+    }
+
+  return(true);
+  } /* END get_candidate_nodes() */
+
+
+
+/*
+ * min_ppn_needed()
+ *
+ * @return the fewest free slots a node needs to satisfy any req that still needs nodes
+ */
+
+int min_ppn_needed(
+
+  complete_spec_data *all_reqs)
+
+  {
+  int min_ppn = -1;
+
+  for (int i = 0; i < all_reqs->num_reqs; i++)
+    {
+    single_spec_data *req = all_reqs->reqs + i;
+
+    if ((req->nodes > 0) &&
+        ((min_ppn == -1) ||
+         (req->ppn < min_ppn)))
+      min_ppn = req->ppn;
+    }
+
+  return((min_ppn < 0) ? 0 : min_ppn);
+  } /* END min_ppn_needed() */
+
+
+
+/*
+ * count_eligible_nodes()
+ *
+ * Adds to eligible_nodes the nodes, other than those in visited, that could ever satisfy a req,
+ * the way node_is_spec_acceptable() would have counted them. Stops once needed is reached.
+ *
+ * @param feature_nodes - if not NULL, the only nodes that can be eligible
+ */
+
+void count_eligible_nodes(
+
+  complete_spec_data *all_reqs,       /* I */
+  prop_bitset        *feature_nodes,  /* I (optional) */
+  const prop_bitset  &visited,        /* I */
+  int                *eligible_nodes, /* I/O */
+  int                 needed)         /* I */
+
+  {
+  struct pbsnode *pnode = NULL;
+
+  if (feature_nodes != NULL)
+    {
+    for (int id = prop_bitset_next(*feature_nodes, -1);
+         (id >= 0) && (*eligible_nodes < needed);
+         id = prop_bitset_next(*feature_nodes, id))
+      {
+      if ((prop_bitset_test(visited, id) == true) ||
+          ((pnode = find_nodebyid(id)) == NULL))
+        continue;
+
+      if (pnode->num_node_boards == 0)
+        {
+        for (int i = 0; i < all_reqs->num_reqs; i++)
+          {
+          if ((all_reqs->reqs[i].nodes > 0) &&
+              (node_is_spec_eligible(pnode, all_reqs->reqs + i) == true))
+            (*eligible_nodes)++;
+          }
+        }
+
+      unlock_node(pnode, __func__, NULL, LOGLEVEL);
+      }
+
+    return;
+    }
+
+  node_iterator iter;
+
+  reinitialize_node_iterator(&iter);
+
+  while ((pnode = next_node(&allnodes, pnode, &iter)) != NULL)
+    {
+    if (prop_bitset_test(visited, pnode->nd_id) == false)
+      {
+      for (int i = 0; i < all_reqs->num_reqs; i++)
+        {
+        if ((all_reqs->reqs[i].nodes > 0) &&
+            (node_is_spec_eligible(pnode, all_reqs->reqs + i) == true))
+          (*eligible_nodes)++;
+        }
+      }
+
+    if (*eligible_nodes >= needed)
+      {
+      unlock_node(pnode, __func__, NULL, LOGLEVEL);
+      break;
+      }
+    }
+
+  if (iter.node_index != NULL)
+    delete iter.node_index;
+  } /* END count_eligible_nodes() */
+
+
+
+/*
+ * fit_node_to_reqs()
+ *
+ * Checks each req against pnode and records pnode for every req it satisfies.
+ */
+
+void fit_node_to_reqs(
+
+  int                &num,
+  struct pbsnode     *pnode,
+  complete_spec_data *all_reqs,
+  node_job_add_info  *naji,
+  int                *eligible_nodes,
+  alps_req_data     **ard_array,
+  int                 first_node_id,
+  int                 num_alps_reqs,
+  enum job_types      job_type,
+  char               *ProcBMStr,
+  bool                job_is_exclusive)
+
+  {
+  for (int i = 0; i < all_reqs->num_reqs; i++)
+    {
+    single_spec_data *req = all_reqs->reqs + i;
+
+    if (req->nodes > 0)
+      {
+      if (node_is_spec_acceptable(pnode, req, ProcBMStr, eligible_nodes,job_is_exclusive) == true)
+        {
+        record_fitting_node(num, pnode, naji, req, first_node_id, i, num_alps_reqs, job_type, all_reqs, ard_array);
+
+        /* are all reqs satisfied? */
+        if (all_reqs->total_nodes == 0)
+          break;
+        }
+      }
+    }
+  } /* END fit_node_to_reqs() */
+
+
+
 /*
  * select_from_all_nodes()
  *
@@ -2898,6 +3160,11 @@ int select_nodes_using_hostlist(
  * node(s) that we are searching for. This is O(N) with respect to the number of nodes in the system
  * as each request is checked against each node at locking time.
  *
+ * Unless cray is enabled, only the nodes the capacity index says are up with enough free slots,
+ * and that the property index says have the properties every req asks for, are visited, in node
+ * id order. Busy and down nodes are only counted towards eligible_nodes, and only when the job
+ * can't be placed now.
+ *
  * @pre-cond: all_reqs, eligible_nodes, and first_node_name must all be valid parameters
  * @post-cond: the nodes in the list are saved in naji to be added for the job later
  */
@@ -2918,6 +3185,50 @@ int select_from_all_nodes(
   node_iterator   iter;
   struct pbsnode *pnode = NULL;
   int             num = 0;
+  long            cray_enabled = FALSE;
+
+  /* alps subnodes aren't in allnodes and are found through their reporter */
+  get_svr_attr_l(SRV_ATR_CrayEnabled, &cray_enabled);
+
+  if (cray_enabled != TRUE)
+    {
+    prop_bitset candidates;
+    prop_bitset feature_nodes;
+    bool        by_feature = get_candidate_nodes(all_reqs, feature_nodes);
+    int         needed = all_reqs->total_nodes;
+
+    node_capacity.nodes_with_free(min_ppn_needed(all_reqs), candidates);
+
+    if (by_feature == true)
+      {
+      if (feature_nodes.size() < candidates.size())
+        candidates.resize(feature_nodes.size());
+
+      for (unsigned int w = 0; w < candidates.size(); w++)
+        candidates[w] &= feature_nodes[w];
+      }
+
+    for (int id = prop_bitset_next(candidates, -1);
+         (id >= 0) && (all_reqs->total_nodes != 0);
+         id = prop_bitset_next(candidates, id))
+      {
+      if ((pnode = find_nodebyid(id)) == NULL)
+        continue;
+
+      /* next_node() never returns these, only their node boards */
+      if (pnode->num_node_boards == 0)
+        fit_node_to_reqs(num, pnode, all_reqs, naji, eligible_nodes, ard_array, first_node_id, num_alps_reqs, job_type, ProcBMStr, job_is_exclusive);
+
+      unlock_node(pnode, __func__, NULL, LOGLEVEL);
+      }
+
+    /* node_spec() tells a job that has to wait from one that never fits by eligible_nodes */
+    if ((all_reqs->total_nodes > 0) &&
+        (*eligible_nodes < needed))
+      count_eligible_nodes(all_reqs, (by_feature == true) ? &feature_nodes : NULL, candidates, eligible_nodes, needed);
+
+    return(num);
+    }
   
   reinitialize_node_iterator(&iter);
 
@@ -2925,22 +3236,7 @@ int select_from_all_nodes(
   while ((pnode = next_node(&allnodes,pnode,&iter)) != NULL)
     {
     /* check each req against this node to see if it satisfies it */
-    for (int i = 0; i < all_reqs->num_reqs; i++)
-      {
-      single_spec_data *req = all_reqs->reqs + i;
-
-      if (req->nodes > 0)
-        {
-        if (node_is_spec_acceptable(pnode, req, ProcBMStr, eligible_nodes,job_is_exclusive) == true)
-          {
-          record_fitting_node(num, pnode, naji, req, first_node_id, i, num_alps_reqs, job_type, all_reqs, ard_array);
-
-          /* are all reqs satisfied? */
-          if (all_reqs->total_nodes == 0)
-            break;
-          }
-        }
-      }
+    fit_node_to_reqs(num, pnode, all_reqs, naji, eligible_nodes, ard_array, first_node_id, num_alps_reqs, job_type, ProcBMStr, job_is_exclusive);
 
     /* are all reqs satisfied? */
     if (all_reqs->total_nodes == 0)
@@ -3222,7 +3518,12 @@ int node_spec(
     {
     /* FAILURE */
     for (i = 0; i < all_reqs.num_reqs; i++)
+      {
       free_prop(all_reqs.reqs[i].prop);
+
+      if (all_reqs.reqs[i].prop_bits != NULL)
+        delete all_reqs.reqs[i].prop_bits;
+      }
     
     free(all_reqs.reqs);
     free(all_reqs.req_start);
@@ -3335,8 +3636,13 @@ int node_spec(
     select_from_all_nodes(&all_reqs, naji, &eligible_nodes, ard_array, first_node_id, num_alps_reqs, job_type, ProcBMStr,job_is_exclusive);
 
   for (i = 0; i < all_reqs.num_reqs; i++)
+    {
     if (all_reqs.reqs[i].prop != NULL)
       free_prop(all_reqs.reqs[i].prop);
+
+    if (all_reqs.reqs[i].prop_bits != NULL)
+      delete all_reqs.reqs[i].prop_bits;
+    }
   
   free(all_reqs.reqs);
   free(all_reqs.req_start);
@@ -3590,6 +3896,7 @@ int reserve_node(
     
   /* mark the node as exclusive */
   pnode->nd_state = INUSE_JOB;
+  update_node_capacity(pnode);
 
   return(PBSE_NONE);
   }
@@ -3654,6 +3961,8 @@ int add_job_to_node(
         (pjob->ji_wattr[JOB_ATR_node_exclusive].at_val.at_long == TRUE))
       pnode->nd_state = newstate;
 
+    update_node_capacity(pnode);
+
     if (snp->inuse == INUSE_FREE)
       {
       snp->inuse = newstate;
@@ -4090,6 +4399,8 @@ int place_subnodes_in_hostlist(
         (pjob->ji_wattr[JOB_ATR_node_exclusive].at_val.at_long == TRUE) ||
         (job_exclusive_on_use))
       pnode->nd_state |= INUSE_JOB;
+
+    update_node_capacity(pnode);
     }
   else
     {
@@ -4530,6 +4841,7 @@ int build_hostlist_procs_req(
         if (pnode->nd_slots.reserve_execution_slots(execution_slots_free, node_info.est) == PBSE_NONE)
           {
           procs_needed -= execution_slots_free;
+          update_node_capacity(pnode);
 
           host_info.push_back(node_info);
           node_info.port = pnode->nd_mom_rm_port;
@@ -5222,7 +5534,10 @@ int node_reserve(
 
 
       if (pnode->nd_np_to_be_used == pnode->nd_slots.get_total_execution_slots())
+        {
         pnode->nd_state |= INUSE_RESERVE;
+        update_node_capacity(pnode);
+        }
       } /* END for each node */
     }
   else
@@ -5387,6 +5702,8 @@ int remove_job_from_node(
       i--; /* the array has shrunk by 1 so we need to reduce i by one */
       }
     }
+
+  update_node_capacity(pnode);
   
   return(PBSE_NONE);
   } /* END remove_job_from_node() */
@@ -5587,6 +5904,8 @@ int set_one_old(
     if (pnode->nd_slots.get_number_free() <= 0)
       pnode->nd_state |= INUSE_JOB;
 
+    update_node_capacity(pnode);
+
     unlock_node(pnode, __func__, NULL, LOGLEVEL);
     }
   else
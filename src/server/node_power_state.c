@@ -281,6 +281,7 @@ int set_node_power_state(
   if ((rc == PBSE_NONE)&&(pNode != NULL))
     {
     pNode->nd_power_state = newState;
+    update_node_capacity(pNode);
     }
 
   return(rc);
@@ -0,0 +1,552 @@
+/*
+*         OpenPBS (Portable Batch System) v2.3 Software License
+*
+* Copyright (c) 1999-2000 Veridian Information Solutions, Inc.
+* All rights reserved.
+*
+* ---------------------------------------------------------------------------
+* For a license to use or redistribute the OpenPBS software under conditions
+* other than those described below, or to purchase support for this software,
+* please contact Veridian Systems, PBS Products Department ("Licensor") at:
+*
+*    www.OpenPBS.org  +1 650 967-4675                  sales@OpenPBS.org
+*                        877 902-4PBS (US toll-free)
+* ---------------------------------------------------------------------------
+*
+* This license covers use of the OpenPBS v2.3 software (the "Software") at
+* your site or location, and, for certain users, redistribution of the
+* Software to other sites and locations.  Use and redistribution of
+* OpenPBS v2.3 in source and binary forms, with or without modification,
+* are permitted provided that all of the following conditions are met.
+* After December 31, 2001, only conditions 3-6 must be met:
+*
+* 1. Commercial and/or non-commercial use of the Software is permitted
+*    provided a current software registration is on file at www.OpenPBS.org.
+*    If use of this software contributes to a publication, product, or
+*    service, proper attribution must be given; see www.OpenPBS.org/credit.html
+*
+* 2. Redistribution in any form is only permitted for non-commercial,
+*    non-profit purposes.  There can be no charge for the Software or any
+*    software incorporating the Software.  Further, there can be no
+*    expectation of revenue generated as a consequence of redistributing
+*    the Software.
+*
+* 3. Any Redistribution of source code must retain the above copyright notice
+*    and the acknowledgment contained in paragraph 6, this list of conditions
+*    and the disclaimer contained in paragraph 7.
+*
+* 4. Any Redistribution in binary form must reproduce the above copyright
+*    notice and the acknowledgment contained in paragraph 6, this list of
+*    conditions and the disclaimer contained in paragraph 7 in the
+*    documentation and/or other materials provided with the distribution.
+*
+* 5. Redistributions in any form must be accompanied by information on how to
+*    obtain complete source code for the OpenPBS software and any
+*    modifications and/or additions to the OpenPBS software.  The source code
+*    must either be included in the distribution or be available for no more
+*    than the cost of distribution plus a nominal fee, and all modifications
+*    and additions to the Software must be freely redistributable by any party
+*    (including Licensor) without restriction.
+*
+* 6. All advertising materials mentioning features or use of the Software must
+*    display the following acknowledgment:
+*
+*     "This product includes software developed by NASA Ames Research Center,
+*     Lawrence Livermore National Laboratory, and Veridian Information
+*     Solutions, Inc.
+*     Visit www.OpenPBS.org for OpenPBS software support,
+*     products, and information."
+*
+* 7. DISCLAIMER OF WARRANTY
+*
+* THIS SOFTWARE IS PROVIDED "AS IS" WITHOUT WARRANTY OF ANY KIND. ANY EXPRESS
+* OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+* OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE, AND NON-INFRINGEMENT
+* ARE EXPRESSLY DISCLAIMED.
+*
+* IN NO EVENT SHALL VERIDIAN CORPORATION, ITS AFFILIATED COMPANIES, OR THE
+* U.S. GOVERNMENT OR ANY OF ITS AGENCIES BE LIABLE FOR ANY DIRECT OR INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+* OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+* LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+* EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* This license will be governed by the laws of the Commonwealth of Virginia,
+* without reference to its choice of law rules.
+*/
+
+/*
+ * node_status.cpp - the parsed form of a node's status update
+ *
+ * process_status_info() in process_mom_update.c fills in a node_status for
+ * each node an update reports on, acts on its typed fields and then has
+ * encode() build the node's status attribute from it.
+ */
+
+#include <pbs_config.h>   /* the master config generated by configure */
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <set>
+#include "node_status.hpp"
+#include "pbs_nodes.h" /* INUSE_* */
+#include "pbs_error.h"
+
+
+
+bool status_view::starts_with(
+
+  const char *prefix) const
+
+  {
+  size_t prefix_len = strlen(prefix);
+
+  return((prefix_len <= len) &&
+         (!strncmp(ptr, prefix, prefix_len)));
+  } /* END starts_with() */
+
+
+
+bool status_view::operator <(
+
+  const status_view &other) const
+
+  {
+  size_t shorter = std::min(len, other.len);
+  int    rc = 0;
+
+  if (shorter > 0)
+    rc = memcmp(ptr, other.ptr, shorter);
+
+  if (rc != 0)
+    return(rc < 0);
+
+  return(len < other.len);
+  } /* END operator <() */
+
+
+
+std::string status_view::to_string() const
+
+  {
+  if (ptr == NULL)
+    return(std::string());
+
+  return(std::string(ptr, len));
+  } /* END to_string() */
+
+
+
+
+/*
+ * status_entry_key()
+ *
+ * @return the part of a status string before its '=', or an unset view if
+ * it doesn't have one
+ */
+
+status_view status_entry_key(
+
+  const status_view &entry)
+
+  {
+  const char *eq = (const char *)memchr(entry.ptr, '=', entry.len);
+
+  if (eq == NULL)
+    return(status_view());
+
+  return(status_view(entry.ptr, eq - entry.ptr));
+  } /* END status_entry_key() */
+
+
+
+
+/*
+ * parse_status_long()
+ *
+ * reads a count the way decode_l() would
+ * @return the count, or -1 if value isn't a non-negative number
+ */
+
+long parse_status_long(
+
+  const status_view &value)
+
+  {
+  size_t i = 0;
+  long   count = 0;
+
+  if ((value.len > 0) &&
+      (value.ptr[0] == '+'))
+    i++;
+
+  if (i == value.len)
+    return(-1);
+
+  for (; i < value.len; i++)
+    {
+    if (isdigit(value.ptr[i]) == 0)
+      return(-1);
+
+    count = (count * 10) + (value.ptr[i] - '0');
+    }
+
+  return(count);
+  } /* END parse_status_long() */
+
+
+
+
+node_status::node_status()
+
+  {
+  clear();
+  } /* END node_status() */
+
+
+
+
+void node_status::clear()
+
+  {
+  state = -1;
+  ncpus = -1;
+  first_update = false;
+  delta = false;
+  state_str = status_view();
+  jobs = status_view();
+  jobdata = status_view();
+  message = status_view();
+  macaddr = status_view();
+  uname = status_view();
+  removed = status_view();
+  others.clear();
+  entries.clear();
+  } /* END clear() */
+
+
+
+
+/*
+ * add()
+ *
+ * files one status string under its key. str must be NUL terminated; since
+ * a value runs to the end of its string, value.ptr is then a C string too.
+ *
+ * @param str - the status string, which must outlive this node_status
+ * @param len - strlen(str)
+ * @return the key str was filed under
+ */
+
+status_key node_status::add(
+
+  const char *str,
+  size_t      len)
+
+  {
+  status_view entry(str, len);
+  status_view key = status_entry_key(entry);
+  status_view value;
+  status_key  which = STATUS_OTHER;
+
+  if (key.is_set() == false)
+    {
+    entries.push_back(entry);
+
+    return(STATUS_OTHER);
+    }
+
+  value = status_view(str + key.len + 1, len - key.len - 1);
+
+  switch (key.len)
+    {
+    case 4:
+
+      if (!memcmp(str, "jobs", 4))
+        {
+        jobs = value;
+        which = STATUS_JOBS;
+        }
+
+      break;
+
+    case 5:
+
+      if (!memcmp(str, "state", 5))
+        {
+        if (value.starts_with("down"))
+          state = INUSE_DOWN;
+        else if (value.starts_with("busy"))
+          state = INUSE_BUSY;
+        else if (value.starts_with("free"))
+          state = INUSE_FREE;
+        else
+          state = INUSE_UNKNOWN;
+
+        state_str = entry;
+        which = STATUS_STATE;
+        }
+      else if (!memcmp(str, "ncpus", 5))
+        {
+        ncpus = parse_status_long(value);
+        which = STATUS_NCPUS;
+        }
+      else if (!memcmp(str, "uname", 5))
+        {
+        uname = value;
+        which = STATUS_UNAME;
+        }
+
+      break;
+
+    case 7:
+
+      if (!memcmp(str, "jobdata", 7))
+        {
+        jobdata = value;
+        which = STATUS_JOBDATA;
+        }
+      else if (!memcmp(str, "message", 7))
+        {
+        message = value;
+        which = STATUS_MESSAGE;
+        }
+      else if (!memcmp(str, "macaddr", 7))
+        {
+        macaddr = value;
+        which = STATUS_MACADDR;
+        }
+
+      break;
+
+    case 12:
+
+      if (!strcmp(str, "first_update=true"))
+        {
+        /* a request for the hierarchy, not part of the node's status */
+        first_update = true;
+
+        return(STATUS_FIRST_UPDATE);
+        }
+      else if (!strcmp(str, STATUS_DELTA_KEYWORD))
+        {
+        /* a delta only says which keys changed, it isn't stored */
+        delta = true;
+        removed = status_view();
+
+        return(STATUS_DELTA);
+        }
+
+      break;
+
+    case 14:
+
+      if (!memcmp(str, STATUS_REMOVED_KEYWORD, 14))
+        {
+        removed = value;
+
+        return(STATUS_REMOVED);
+        }
+
+      break;
+
+    default:
+
+      break;
+    }
+
+  if (which == STATUS_OTHER)
+    others[key] = value;
+
+  entries.push_back(entry);
+
+  return(which);
+  } /* END add() */
+
+
+
+
+/*
+ * copy_status_entry()
+ *
+ * copies entry into stp's buffer at pc the way decode_arst() would: split at
+ * each unescaped comma or newline, trim the white space around each piece
+ * and drop the escapes
+ *
+ * @return where the next string goes in the buffer
+ */
+
+char *copy_status_entry(
+
+  const status_view    &entry,
+  struct array_strings *stp,
+  char                 *pc)
+
+  {
+  const char *c = entry.ptr;
+  const char *end = entry.ptr + entry.len;
+
+  if (entry.len == 0)
+    return(pc);
+
+  /* a trailing terminator doesn't start another, empty, piece */
+  if (((end[-1] == ',') || (end[-1] == '\n')) &&
+      ((entry.len < 2) || (end[-2] != '\\')))
+    end--;
+
+  while (c < end)
+    {
+    const char *start;
+    const char *stop;
+
+    while ((c < end) && (*c != '\n') && (isspace(*c)))
+      c++;
+
+    start = c;
+
+    while (c < end)
+      {
+      if (*c == '\\')
+        {
+        if (++c == end)
+          break;
+        }
+      else if ((*c == ',') || (*c == '\n'))
+        break;
+
+      c++;
+      }
+
+    stop = c;
+
+    while ((stop > start) && (isspace(stop[-1])))
+      stop--;
+
+    stp->as_string[stp->as_usedptr++] = pc;
+
+    for (const char *s = start; s < stop; s++)
+      {
+      if ((*s == '\\') &&
+          (++s == stop))
+        break;
+
+      *pc++ = *s;
+      }
+
+    *pc++ = '\0';
+
+    /* step over the terminator */
+    if (c < end)
+      c++;
+    }
+
+  return(pc);
+  } /* END copy_status_entry() */
+
+
+
+
+/*
+ * encode()
+ *
+ * builds the status attribute in one allocation, the way a decode_arst() of
+ * each string in turn would have left it: the strings in kept come first, as
+ * they are, then the entries with the last one received first. A key that
+ * was received again later replaces the earlier one.
+ *
+ * @param pattr - an empty attribute to fill in
+ * @param kept - already decoded strings carried over from the stored status
+ * @return PBSE_NONE or PBSE_SYSTEM if the allocation fails
+ */
+
+int node_status::encode(
+
+  pbs_attribute                   *pattr,
+  const std::vector<const char *> &kept) const
+
+  {
+  struct array_strings  *stp;
+  std::set<status_view>  seen;
+  size_t                 bufsize = 0;
+  int                    npointers = 0;
+  char                  *pc;
+
+  /* every piece needs at most its own length and a NUL */
+  for (unsigned int i = 0; i < entries.size(); i++)
+    {
+    bufsize += entries[i].len + 1;
+    npointers += 1 + std::count(entries[i].ptr, entries[i].ptr + entries[i].len, ',') +
+                 std::count(entries[i].ptr, entries[i].ptr + entries[i].len, '\n');
+    }
+
+  for (unsigned int i = 0; i < kept.size(); i++)
+    {
+    bufsize += strlen(kept[i]) + 1;
+    npointers++;
+    }
+
+  if (npointers == 0)
+    return(PBSE_NONE);
+
+  if ((stp = (struct array_strings *)calloc(1, sizeof(struct array_strings) + (npointers - 1) * sizeof(char *))) == NULL)
+    return(PBSE_SYSTEM);
+
+  if ((stp->as_buf = (char *)calloc(1, bufsize)) == NULL)
+    {
+    free(stp);
+
+    return(PBSE_SYSTEM);
+    }
+
+  stp->as_npointers = npointers;
+  stp->as_bufsize = bufsize;
+  pc = stp->as_buf;
+
+  for (unsigned int i = 0; i < kept.size(); i++)
+    {
+    stp->as_string[stp->as_usedptr++] = pc;
+    strcpy(pc, kept[i]);
+    pc += strlen(kept[i]) + 1;
+    }
+
+  for (int i = (int)entries.size() - 1; i >= 0; i--)
+    {
+    int first = stp->as_usedptr;
+    int used = first;
+
+    pc = copy_status_entry(entries[i], stp, pc);
+
+    /* drop the pieces whose key a later string has */
+    for (int j = first; j < stp->as_usedptr; j++)
+      {
+      const char *eq = strchr(stp->as_string[j], '=');
+
+      if ((eq != NULL) &&
+          (seen.find(status_view(stp->as_string[j], eq - stp->as_string[j])) != seen.end()))
+        continue;
+
+      stp->as_string[used++] = stp->as_string[j];
+      }
+
+    stp->as_usedptr = used;
+
+    for (int j = first; j < used; j++)
+      {
+      const char *eq = strchr(stp->as_string[j], '=');
+
+      if (eq != NULL)
+        seen.insert(status_view(stp->as_string[j], eq - stp->as_string[j]));
+      }
+    }
+
+  stp->as_next = pc;
+
+  pattr->at_val.at_arst = stp;
+  pattr->at_flags |= ATR_VFLAG_SET | ATR_VFLAG_MODIFY;
+
+  return(PBSE_NONE);
+  } /* END encode() */
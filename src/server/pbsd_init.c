@@ -68,6 +68,7 @@
 #include <sstream>
 #include <string>
 #include <map>
+#include <algorithm>
 #include <pbs_config.h>   /* the master config generated by configure */
 #include "pbsd_init.h"
 
@@ -204,7 +205,7 @@ extern char *path_jobinfo_log;
 extern int                      queue_rank;
 extern char                     server_name[];
 extern tlist_head               svr_newnodes;
-extern std::list<timed_task>   *task_list_timed;
+extern timed_task_heap         *task_list_timed;
 extern pthread_mutex_t          task_list_timed_mutex;
 task_recycler                   tr;
 extern all_jobs                alljobs;
@@ -274,6 +275,8 @@ int run_change_logs = FALSE;
 #define CHANGE_STATE 1
 #define KEEP_STATE   0
 
+#define MAX_RECOVERY_THREADS 64
+
 /**
  * Initialize a dynamic array to a specific size
  * @param Array (O) Assumed to be uninitialized struct
@@ -826,7 +829,7 @@ int initialize_data_structures_and_mutexes()
 
   initialize_recycler();
 
-  task_list_timed = new std::list<timed_task>();
+  task_list_timed = new timed_task_heap();
   pthread_mutex_init(&task_list_timed_mutex, NULL);
 
   initialize_task_recycler();
@@ -1098,6 +1101,111 @@ void mark_as_badjob(
 
 
 
+/*
+ * recovery_work is shared by the threads of one parallel recovery phase.
+ * Each thread claims the next unclaimed file until all are recovered, and
+ * stores what it recovered at the file's index in results.
+ */
+
+typedef struct recovery_work
+  {
+  std::vector<std::string>  *files;
+  std::vector<void *>       *results;
+  void                    *(*recover)(const char *);
+  int                        next;
+  } recovery_work;
+
+
+
+void *recovery_worker(
+
+  void *vp)
+
+  {
+  recovery_work *work = (recovery_work *)vp;
+  int            count = work->files->size();
+  int            i;
+
+  while ((i = __sync_fetch_and_add(&work->next, 1)) < count)
+    (*work->results)[i] = work->recover((*work->files)[i].c_str());
+
+  return(NULL);
+  } /* END recovery_worker() */
+
+
+
+/*
+ * recover_in_parallel() - call recover on each file in files, spread over
+ * one thread per core
+ *
+ * results[i] is what recover returned for files[i], so the caller can
+ * process the results in a deterministic order afterwards.
+ *
+ * @return the number of threads used
+ */
+
+int recover_in_parallel(
+
+  std::vector<std::string>  &files,
+  std::vector<void *>       &results,
+  void                    *(*recover)(const char *))
+
+  {
+  recovery_work           work;
+  std::vector<pthread_t>  threads;
+  long                    thread_count = sysconf(_SC_NPROCESSORS_ONLN);
+  pthread_t               tid;
+
+  work.files = &files;
+  work.results = &results;
+  work.recover = recover;
+  work.next = 0;
+
+  results.assign(files.size(), NULL);
+
+  if (thread_count > MAX_RECOVERY_THREADS)
+    thread_count = MAX_RECOVERY_THREADS;
+
+  if (thread_count > (long)files.size())
+    thread_count = files.size();
+
+  /* this thread is one of the workers */
+  for (long i = 1; i < thread_count; i++)
+    {
+    if (pthread_create(&tid, NULL, recovery_worker, &work) != 0)
+      break;
+
+    threads.push_back(tid);
+    }
+
+  recovery_worker(&work);
+
+  for (unsigned int i = 0; i < threads.size(); i++)
+    pthread_join(threads[i], NULL);
+
+  return(threads.size() + 1);
+  } /* END recover_in_parallel() */
+
+
+
+void *recover_array_file(
+
+  const char *filename)
+
+  {
+  job_array *pa = NULL;
+
+  if (array_recov((char *)filename, &pa) != PBSE_NONE)
+    return(NULL);
+
+  pa->jobs_recovered = 0;
+  unlock_ai_mutex(pa, __func__, "1", LOGLEVEL);
+
+  return(pa);
+  } /* END recover_array_file() */
+
+
+
 int handle_array_recovery(
     
   int type)
@@ -1108,11 +1216,13 @@ int handle_array_recovery(
   DIR              *dir;
   int               rc = PBSE_NONE;
   int               rc2 = PBSE_NONE;
-  job_array        *pa = NULL;
   int               baselen = 0;
   int               array_suf_len = strlen(ARRAY_FILE_SUFFIX);
   char             *psuffix;
 
+  std::vector<std::string> files;
+  std::vector<void *>      arrays;
+
   if (chdir(path_arrays) != 0)
     {
     sprintf(log_buf, msg_init_chdir, path_arrays);
@@ -1144,25 +1254,7 @@ int handle_array_recovery(
         if (strcmp(psuffix, ARRAY_FILE_SUFFIX))
           continue;
 
-        if ((rc = array_recov(pdirent->d_name, &pa)) != PBSE_NONE)
-          {
-          sprintf(log_buf,
-            "could not recover array-struct from file %s--skipping. job array can not be recovered.",
-            pdirent->d_name);
-
-          log_err(errno, __func__, log_buf);
-
-          sprintf(log_buf, "%s:3", __func__);
-          unlock_sv_qs_mutex(server.sv_qs_mutex, log_buf);
-
-          mark_as_badjob(pdirent->d_name);
-          rc2 = rc; /* rc2 captures the latest error in rc */
-          }
-        else
-          {
-          pa->jobs_recovered = 0;
-          unlock_ai_mutex(pa, __func__, "2", LOGLEVEL);
-          }
+        files.push_back(pdirent->d_name);
         }
       else
         {
@@ -1173,6 +1265,26 @@ int handle_array_recovery(
 
   closedir(dir);
 
+  recover_in_parallel(files, arrays, recover_array_file);
+
+  for (unsigned int i = 0; i < files.size(); i++)
+    {
+    if (arrays[i] == NULL)
+      {
+      sprintf(log_buf,
+        "could not recover array-struct from file %s--skipping. job array can not be recovered.",
+        files[i].c_str());
+
+      log_err(errno, __func__, log_buf);
+
+      sprintf(log_buf, "%s:3", __func__);
+      unlock_sv_qs_mutex(server.sv_qs_mutex, log_buf);
+
+      mark_as_badjob(files[i].c_str());
+      rc2 = -1; /* rc2 captures the latest error */
+      }
+    }
+
   if (rc2 != PBSE_NONE)
     rc = rc2;
   return(rc);
@@ -1251,6 +1363,51 @@ struct sort_string_by_number
 
 
 
+/*
+ * sort_job_by_qrank orders recovered jobs the way they were queued, so
+ * recovery requeues them in the same order no matter which thread decoded
+ * them.  Jobs with the same rank fall back to job id order, which keeps an
+ * array's template ahead of its subjobs.
+ */
+
+struct sort_job_by_qrank
+  {
+  bool operator()(const job *a, const job *b) const
+    {
+    long rank_a = a->ji_wattr[JOB_ATR_qrank].at_val.at_long;
+    long rank_b = b->ji_wattr[JOB_ATR_qrank].at_val.at_long;
+
+    if (rank_a != rank_b)
+      return(rank_a < rank_b);
+
+    return(sort_string_by_number()(a->ji_qs.ji_jobid, b->ji_qs.ji_jobid));
+    }
+  };
+
+
+
+void *recover_job_file(
+
+  const char *filename)
+
+  {
+  job    *pjob;
+  size_t  len = strlen(filename);
+
+  if ((pjob = job_recov((char *)filename)) == NULL)
+    return(NULL);
+
+  if ((len > strlen(JOB_FILE_TMP_SUFFIX)) &&
+      (!strcmp(filename + len - strlen(JOB_FILE_TMP_SUFFIX), JOB_FILE_TMP_SUFFIX)))
+    pjob->ji_is_array_template = TRUE;
+
+  unlock_ji_mutex(pjob, __func__, "1", LOGLEVEL);
+
+  return(pjob);
+  } /* END recover_job_file() */
+
+
+
 int handle_job_recovery(
 
   int type)
@@ -1267,6 +1424,9 @@ int handle_job_recovery(
   int               baselen = 0;
   char             *psuffix;
   int               job_count = 0; /* Count of recovered jobs */
+  int               recovered = 0; /* Count of jobs read successfully */
+  struct timeval    start_time;
+  struct timeval    end_time;
   const char       *job_suffix = JOB_FILE_SUFFIX;
   int               job_suf_len = strlen(job_suffix);
   char              basen[MAXPATHLEN+1];
@@ -1310,7 +1470,13 @@ int handle_job_recovery(
     }
   else
     {
-    std::map<std::string, job *, sort_string_by_number> Array;
+    std::vector<std::string> files;
+    std::vector<void *>      jobs;
+    std::vector<job *>       Array;
+    int                      thread_count;
+
+    gettimeofday(&start_time, NULL);
+
     /* Now, for each job found ... */
 
     while ((pdirent = readdir(dir)) != NULL)
@@ -1329,61 +1495,76 @@ int handle_job_recovery(
 
         psuffix = pdirent->d_name + baselen;
 
-        if (!strcmp(psuffix, ".TA"))
-          {
-          if ((pjob = job_recov(pdirent->d_name)) != NULL)
-            {
-            pjob->ji_is_array_template = TRUE;
+        if ((strcmp(psuffix, ".TA")) &&
+            (strcmp(psuffix, job_suffix)))
+          continue;
 
+        files.push_back(pdirent->d_name);
+        }
+      }    /* END while ((pdirent = readdir(dir)) != NULL) */
 
-            Array[pjob->ji_qs.ji_jobid] = pjob;
- 
-            unlock_ji_mutex(pjob, __func__, "1", LOGLEVEL);
-            }
+    snprintf(log_buf, LOCAL_LOG_BUF_SIZE, "%d total files read from disk", job_count);
+    log_event(PBSEVENT_DEBUG, PBS_EVENTCLASS_SERVER, msg_daemonname, log_buf);
+    closedir(dir);
 
-          continue;
-          }
+    /* decode the job files on all cores, then queue the jobs in order */
+    thread_count = recover_in_parallel(files, jobs, recover_job_file);
 
-        if (strcmp(psuffix, job_suffix))
-          continue;
+    for (unsigned int i = 0; i < files.size(); i++)
+      {
+      if (jobs[i] != NULL)
+        {
+        Array.push_back((job *)jobs[i]);
+        recovered++;
 
-        if ((pjob = job_recov(pdirent->d_name)) != NULL)
-          {
-          Array[pjob->ji_qs.ji_jobid] = pjob;
+        continue;
+        }
 
-          unlock_ji_mutex(pjob, __func__, "2", LOGLEVEL);
-          }
-        else
-          {
-          sprintf(log_buf, msg_init_badjob, pdirent->d_name);
+      /* templates that can't be recovered are left for cleanup_recovered_arrays() */
+      if (files[i].compare(files[i].size() - job_suf_len, job_suf_len, job_suffix))
+        continue;
 
-          log_err(-1, __func__, log_buf);
+      sprintf(log_buf, msg_init_badjob, files[i].c_str());
 
-          /* remove corrupt job */
-          snprintf(basen, sizeof(basen), "%s%s", pdirent->d_name, JOB_BAD_SUFFIX);
+      log_err(-1, __func__, log_buf);
 
-          if (link(pdirent->d_name, basen) < 0)
-            {
-            log_err(errno, __func__, "failed to link corrupt .JB file to .BD");
-            }
-          else
-            {
-            unlink(pdirent->d_name);
-            }
-          }
+      /* remove corrupt job */
+      snprintf(basen, sizeof(basen), "%s%s", files[i].c_str(), JOB_BAD_SUFFIX);
+
+      if (link(files[i].c_str(), basen) < 0)
+        {
+        log_err(errno, __func__, "failed to link corrupt .JB file to .BD");
         }
-      }    /* END while ((pdirent = readdir(dir)) != NULL) */
+      else
+        {
+        unlink(files[i].c_str());
+        }
+      }
 
-    snprintf(log_buf, LOCAL_LOG_BUF_SIZE, "%d total files read from disk", job_count);
-    log_event(PBSEVENT_DEBUG, PBS_EVENTCLASS_SERVER, msg_daemonname, log_buf);
-    closedir(dir);
+    std::sort(Array.begin(), Array.end(), sort_job_by_qrank());
+
+    if (recovered > 0)
+      {
+      double elapsed;
+
+      gettimeofday(&end_time, NULL);
+      elapsed = (end_time.tv_sec - start_time.tv_sec) +
+                (end_time.tv_usec - start_time.tv_usec) / 1000000.0;
+
+      snprintf(log_buf, LOCAL_LOG_BUF_SIZE,
+        "recovered %d jobs in %.3f seconds (%.3f seconds per 100000 jobs) using %d threads",
+        recovered,
+        elapsed,
+        elapsed * 100000 / recovered,
+        thread_count);
+      log_event(PBSEVENT_SYSTEM, PBS_EVENTCLASS_SERVER, msg_daemonname, log_buf);
+      }
 
     int Index = 0;
-    std::map<std::string, job *>::iterator Array_iter;
-    /*for (Index = 0; Index < Array.AppendIndex; Index++)*/
-    for (Array_iter = Array.begin(); Array_iter != Array.end(); Array_iter++)
+
+    for (unsigned int i = 0; i < Array.size(); i++)
       {
-      job *pjob = Array_iter->second;
+      job *pjob = Array[i];
 
       lock_ji_mutex(pjob, __func__, NULL, LOGLEVEL);
 
@@ -1510,8 +1691,10 @@ int cleanup_recovered_arrays()
       job_template_exists = TRUE;
       }
 
-    /* if no jobs were recovered, delete this array */
-    if (pa->jobs_recovered == 0)
+    /* if no jobs were recovered and none are left to clone, delete this array */
+    if ((pa->jobs_recovered == 0) &&
+        ((GET_NEXT(pa->request_tokens) == NULL) ||
+         (job_template_exists == FALSE)))
       {
       if ((pjob = svr_find_job(pa->ai_qs.parent_id, FALSE)) != NULL)
         svr_job_purge(pjob);
@@ -147,6 +147,7 @@
 #include "node_func.h"
 #include "mom_hierarchy_handler.h"
 #include "track_alps_reservations.h"
+#include "group_commit.h"
 
 
 #define TASK_CHECK_INTERVAL      10
@@ -890,8 +891,10 @@ pthread_t      route_retry_thread_id = -1;
 void *check_tasks(void *notUsed)
 
   {
-  work_task *ptask;
-  int        rc = PBSE_NONE;
+  work_task               *ptask;
+  int                      rc = PBSE_NONE;
+  std::vector<work_task *> expired;
+  size_t                   i;
 
   time_t     time_now;
 
@@ -900,8 +903,16 @@ void *check_tasks(void *notUsed)
   time_now = time(NULL);
   last_task_check_time = time_now;
 
-  while ((ptask = pop_timed_task(time_now)) != NULL)
+  pop_expired_timed_tasks(time_now, expired);
+
+  for (i = 0; i < expired.size(); i++)
     {
+    ptask = expired[i];
+
+    /* skip the tasks deleted since they were popped */
+    if (claim_timed_task(ptask) == false)
+      continue;
+
     rc = dispatch_timed_task(ptask); /* will delete link */
 
     /* if dispatch_task does not return PBSE_NONE 
@@ -912,6 +923,17 @@ void *check_tasks(void *notUsed)
     if (rc != PBSE_NONE)
       {
       pthread_mutex_unlock(ptask->wt_mutex);
+
+      /* dispatch_timed_task() requeued ptask, requeue the rest of the batch */
+      for (i++; i < expired.size(); i++)
+        {
+        if (claim_timed_task(expired[i]) == true)
+          {
+          insert_timed_task(expired[i]);
+          pthread_mutex_unlock(expired[i]->wt_mutex);
+          }
+        }
+
       break;
       }
     }
@@ -1334,6 +1356,7 @@ void main_loop(void)
   start_routing_retry_thread();
   start_exiting_retry_thread();
   start_generic_thread(NULL, remove_extra_recycle_jobs);
+  start_generic_thread(NULL, group_commit_task);
 
   while (state != SV_STATE_DOWN)
     {
@@ -1496,6 +1519,9 @@ void main_loop(void)
 
     update_nodes_file(NULL);
     }
+
+  /* make sure everything saved above reaches the disk */
+  flush_dirty_files();
   } /* END main_loop() */
 
 
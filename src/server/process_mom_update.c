@@ -81,6 +81,7 @@
 #include <ctype.h>
 #include <string>
 #include <vector>
+#include <set>
 #include <sstream>
 
 #include "pbs_config.h"
@@ -96,6 +97,7 @@
 #include "../lib/Libutils/u_lock_ctl.h"
 #include "mutex_mgr.hpp"
 #include "id_map.hpp"
+#include "node_status.hpp"
 
 
 extern attribute_def    node_attr_def[];   /* node attributes defs */
@@ -355,24 +357,23 @@ struct pbsnode *get_node_from_str(
 
 int handle_auto_np(
 
-  struct pbsnode *np,  /* M */
-  const char     *str) /* I */
+  struct pbsnode *np,     /* M */
+  long            ncpus)  /* I */
 
   {
   pbs_attribute nattr;
   
-  /* first we decode str into nattr... + 6 is because str has format
-   * ncpus=X, and 6 = strlen(ncpus=) */  
-  if ((node_attr_def + ND_ATR_np)->at_decode(&nattr, ATTR_NODE_np, NULL, str + 6, 0) == 0)
+  /* if MOM's ncpus is different than our np... */
+  if (ncpus != np->nd_slots.get_total_execution_slots())
     {
-    /* ... and if MOM's ncpus is different than our np... */
-    if (nattr.at_val.at_long != np->nd_slots.get_total_execution_slots())
-      {
-      /* ... then we do the defined magic to create new subnodes */
-      (node_attr_def + ND_ATR_np)->at_action(&nattr, (void *)np, ATR_ACTION_ALTER);
-      
-      update_nodes_file(np);
-      }
+    memset(&nattr, 0, sizeof(nattr));
+    nattr.at_val.at_long = ncpus;
+    nattr.at_flags = ATR_VFLAG_SET | ATR_VFLAG_MODIFY;
+
+    /* ... then we do the defined magic to create new subnodes */
+    (node_attr_def + ND_ATR_np)->at_action(&nattr, (void *)np, ATR_ACTION_ALTER);
+    
+    update_nodes_file(np);
     }
 
   return(PBSE_NONE);
@@ -391,8 +392,8 @@ int handle_auto_np(
 
 void update_job_data(
 
-  struct pbsnode *np,            /* I */
-  const char     *jobstring_in)  /* I (changed attributes sent by mom) */
+  struct pbsnode    *np,            /* I */
+  const status_view &jobstring_in)  /* I (changed attributes sent by mom) */
 
   {
   char  *jobdata;
@@ -405,7 +406,7 @@ void update_job_data(
   job   *pjob = NULL;
   int    on_node = FALSE;
 
-  if ((jobstring_in == NULL) || (!isdigit(*jobstring_in)))
+  if ((jobstring_in.len == 0) || (!isdigit(*jobstring_in.ptr)))
     {
     /* NO-OP */
 
@@ -414,7 +415,7 @@ void update_job_data(
 
   /* FORMAT <JOBID>:<atrtributename=value>,<atrtributename=value>... */
 
-  jobdata = strdup(jobstring_in);
+  jobdata = strndup(jobstring_in.ptr, jobstring_in.len);
   jobdata_ptr = jobdata;
 
   jobidstr = threadsafe_tokenizer(&jobdata_ptr, ":");
@@ -513,6 +514,7 @@ int process_uname_str(
     np->nd_name = (char *)cp;
     np->nd_first = init_prop(np->nd_name);
     np->nd_last = np->nd_first;
+    update_prop_bits(np);
     np->nd_f_st = init_prop(np->nd_name);
     np->nd_l_st = np->nd_f_st;
     }
@@ -525,8 +527,8 @@ int process_uname_str(
 
 int process_state_str(
 
-  struct pbsnode *np,
-  const char    *str)
+  struct pbsnode    *np,
+  const node_status &ns)
 
   {
   char            log_buf[LOCAL_LOG_BUF_SIZE];
@@ -540,28 +542,16 @@ int process_state_str(
     log_err(-1, __func__, log_buf);
     return PBSE_HIERARCHY_NOT_SENT;
     }
-  if (!strncmp(str, "state=down", 10))
-    {
-    update_node_state(np, INUSE_DOWN);
-    }
-  else if (!strncmp(str, "state=busy", 10))
+  if (ns.state == INUSE_UNKNOWN)
     {
-    update_node_state(np, INUSE_BUSY);
-    }
-  else if (!strncmp(str, "state=free", 10))
-    {
-    update_node_state(np, INUSE_FREE);
-    }
-  else
-    {
-    sprintf(log_buf, "unknown %s from node %s",
-      str,
+    snprintf(log_buf, sizeof(log_buf), "unknown %s from node %s",
+      ns.state_str.to_string().c_str(),
       (np->nd_name != NULL) ? np->nd_name : "NULL");
     
     log_err(-1, __func__, log_buf);
-    
-    update_node_state(np, INUSE_UNKNOWN);
     }
+
+  update_node_state(np, ns.state);
   
   if (LOGLEVEL >= 9)
     {
@@ -636,6 +626,167 @@ int save_node_status(
 
 
 
+/*
+ * merge_status_delta()
+ *
+ * a mom that sends a status delta only reports what changed since its last
+ * update, so carry the rest of np's stored status over. Keys ns already has,
+ * and keys the delta removed, are left out.
+ *
+ * @param kept - gets the stored strings to keep, which point into np's status
+ */
+
+void merge_status_delta(
+
+  struct pbsnode            *np,
+  const node_status         &ns,
+  std::vector<const char *> &kept)
+
+  {
+  struct array_strings  *stored = np->nd_status;
+  std::set<status_view>  skip;
+  bool                   keep = false;
+
+  if (stored == NULL)
+    return;
+
+  for (unsigned int i = 0; i < ns.entries.size(); i++)
+    {
+    status_view key = status_entry_key(ns.entries[i]);
+
+    if (key.is_set())
+      skip.insert(key);
+    }
+
+  for (size_t start = 0; start < ns.removed.len;)
+    {
+    const char *comma = (const char *)memchr(ns.removed.ptr + start, ',', ns.removed.len - start);
+    size_t      end = (comma != NULL) ? comma - ns.removed.ptr : ns.removed.len;
+
+    skip.insert(status_view(ns.removed.ptr + start, end - start));
+    start = end + 1;
+    }
+
+  /* save_node_status() adds a new one */
+  skip.insert(status_view("rectime", strlen("rectime")));
+
+  for (int i = 0; i < stored->as_usedptr; i++)
+    {
+    const char *eq = strchr(stored->as_string[i], '=');
+
+    /* a string without a key was split off the end of the one before it */
+    if (eq != NULL)
+      keep = (skip.find(status_view(stored->as_string[i], eq - stored->as_string[i])) == skip.end());
+
+    if (keep == true)
+      kept.push_back(stored->as_string[i]);
+    }
+  } /* END merge_status_delta() */
+
+
+
+
+/*
+ * apply_node_status()
+ *
+ * acts on the status np's mom reported and stores it as np's status
+ */
+
+int apply_node_status(
+
+  struct pbsnode *np,
+  node_status    &ns,
+  int             dont_change_state,
+  long            mom_job_sync,
+  long            auto_np,
+  long            down_on_error)
+
+  {
+  pbs_attribute             temp;
+  std::vector<const char *> kept;
+  int                       rc;
+
+  if ((ns.message.starts_with("ERROR")) &&
+      (down_on_error == TRUE))
+    {
+    update_node_state(np, INUSE_DOWN);
+    dont_change_state = TRUE;
+    }
+
+  if ((ns.state_str.is_set()) &&
+      (dont_change_state == FALSE))
+    process_state_str(np, ns);
+
+  if ((allow_any_mom == TRUE) &&
+      (ns.uname.is_set()))
+    process_uname_str(np, ns.uname.ptr);
+
+  if (ns.macaddr.is_set())
+    update_node_mac_addr(np, ns.macaddr.ptr);
+
+  if ((mom_job_sync == TRUE) &&
+      (ns.jobdata.is_set()))
+    {
+    /* update job attributes based on what the MOM gives us */      
+    update_job_data(np, ns.jobdata);
+    }
+
+  if ((mom_job_sync == TRUE) &&
+      (ns.jobs.is_set()))
+    {
+    /* walk job list reported by mom */
+    size_t         name_len = strlen(np->nd_name);
+    char          *jobstr = (char *)calloc(1, name_len + ns.jobs.len + 2);
+    sync_job_info *sji = (sync_job_info *)calloc(1, sizeof(sync_job_info));
+
+    if ((jobstr != NULL) &&
+        (sji != NULL))
+      {
+      memcpy(jobstr, np->nd_name, name_len);
+      jobstr[name_len] = ':';
+      memcpy(jobstr + name_len + 1, ns.jobs.ptr, ns.jobs.len);
+      sji->input = jobstr;
+      sji->timestamp = time(NULL);
+
+      /* sji must be freed in sync_node_jobs */
+      enqueue_threadpool_request(sync_node_jobs, sji, task_pool);
+      }
+    else
+      {
+      if (jobstr != NULL)
+        {
+        free(jobstr);
+        }
+      if (sji != NULL)
+        {
+        free(sji);
+        }
+      }
+    }
+
+  if ((auto_np) &&
+      (ns.ncpus >= 0))
+    handle_auto_np(np, ns.ncpus);
+
+  memset(&temp, 0, sizeof(temp));
+
+  if (ns.delta == true)
+    merge_status_delta(np, ns, kept);
+
+  if ((rc = ns.encode(&temp, kept)) != PBSE_NONE)
+    {
+    log_record(PBSEVENT_DEBUG, PBS_EVENTCLASS_NODE, __func__, "cannot encode the node's status");
+    return(rc);
+    }
+
+  save_node_status(np, &temp);
+
+  return(PBSE_NONE);
+  } /* END apply_node_status() */
+
+
+
+
 int process_status_info(
 
   char                     *nd_name,
@@ -648,25 +799,15 @@ int process_status_info(
   long            auto_np = FALSE;
   long            down_on_error = FALSE;
   int             dont_change_state = FALSE;
-  pbs_attribute   temp;
   int             rc = PBSE_NONE;
   bool            send_hello = false;
+  bool            need_full = false;
+  node_status     ns;
 
   get_svr_attr_l(SRV_ATR_MomJobSync, &mom_job_sync);
   get_svr_attr_l(SRV_ATR_AutoNodeNP, &auto_np);
   get_svr_attr_l(SRV_ATR_DownOnError, &down_on_error);
 
-  /* Before filling the "temp" pbs_attribute, initialize it.
-   * The second and third parameter to decode_arst are never
-   * used, so just leave them empty. (GBS) */
-  memset(&temp, 0, sizeof(temp));
-
-  if ((rc = decode_arst(&temp, NULL, NULL, NULL, 0)) != PBSE_NONE)
-    {
-    log_record(PBSEVENT_DEBUG, PBS_EVENTCLASS_NODE, __func__, "cannot initialize attribute");
-    return(rc);
-    }
-
   /* if original node cannot be found do not process the update */
   if ((current = find_nodebyname(nd_name)) == NULL)
     return(PBSE_NONE);
@@ -679,11 +820,12 @@ int process_status_info(
     if((current->nd_power_state_change_time + NODE_POWER_CHANGE_TIMEOUT) < time(NULL))
       {
       current->nd_power_state = POWER_STATE_RUNNING;
+      update_node_capacity(current);
       write_node_power_state();
       }
     }
   /* loop over each string */
-  for (unsigned int i = 0; i != status_info.size(); i++)
+  for (unsigned int i = 0; i < status_info.size(); i++)
     {
     const char *str = status_info[i].c_str();
     /* these two options are for switching nodes */
@@ -691,9 +833,10 @@ int process_status_info(
       {
       /* if we've already processed some, save this before moving on */
       if (i != 0)
-        save_node_status(current, &temp);
+        apply_node_status(current, ns, dont_change_state, mom_job_sync, auto_np, down_on_error);
       
       dont_change_state = FALSE;
+      ns.clear();
 
       if ((current = get_numa_from_str(str, current)) == NULL)
         break;
@@ -704,9 +847,10 @@ int process_status_info(
       {
       /* if we've already processed some, save this before moving on */
       if (i != 0)
-        save_node_status(current, &temp);
+        apply_node_status(current, ns, dont_change_state, mom_job_sync, auto_np, down_on_error);
 
       dont_change_state = FALSE;
+      ns.clear();
 
       if ((current = get_node_from_str(str, name, current)) == NULL)
         break;
@@ -729,112 +873,61 @@ int process_status_info(
         }
       }
 
-    /* add the info to the "temp" pbs_attribute */
+    /* the gpu and mic blocks are handled as they come, i is left on their end markers */
     else if (!strcmp(str, START_GPU_STATUS))
       {
       is_gpustat_get(current, i, status_info);
-      str = status_info[i].c_str();
+
+      continue;
       }
     else if (!strcmp(str, START_MIC_STATUS))
       {
       process_mic_status(current, i, status_info);
-      str = status_info[i].c_str();
-      }
-    else if (!strcmp(str, "first_update=true"))
-      {
-      /* mom is requesting that we send the mom hierarchy file to her */
-      //remove_hello(&hellos, current->nd_id);
-      send_hello = true;
-      
-      /* reset gpu data in case mom reconnects with changed gpus */
-      clear_nvidia_gpus(current);
+
+      continue;
       }
-    else if ((rc = decode_arst(&temp, NULL, NULL, str, 0)) != PBSE_NONE)
+
+    switch (ns.add(status_info[i].c_str(), status_info[i].size()))
       {
-      DBPRT(("is_stat_get: cannot add attributes\n"));
+      case STATUS_FIRST_UPDATE:
 
-      free_arst(&temp);
+        /* mom is requesting that we send the mom hierarchy file to her */
+        send_hello = true;
 
-      break;
-      }
+        /* reset gpu data in case mom reconnects with changed gpus */
+        clear_nvidia_gpus(current);
 
-    if (!strncmp(str, "state", 5))
-      {
-      if (dont_change_state == FALSE)
-        process_state_str(current, str);
-      }
-    else if ((allow_any_mom == TRUE) &&
-             (!strncmp(str, "uname", 5))) 
-      {
-      process_uname_str(current, str);
-      }
-    else if (!strncmp(str, "me", 2))  /* shorter str compare than "message" */
-      {
-      if ((!strncmp(str, "message=ERROR", 13)) &&
-          (down_on_error == TRUE))
-        {
-        update_node_state(current, INUSE_DOWN);
-        dont_change_state = TRUE;
-        }
-      }
-    else if (!strncmp(str,"macaddr=",8))
-      {
-      update_node_mac_addr(current,str + 8);
-      }
-    else if ((mom_job_sync == TRUE) &&
-             (!strncmp(str, "jobdata=", 8)))
-      {
-      /* update job attributes based on what the MOM gives us */      
-      update_job_data(current, str + strlen("jobdata="));
-      }
-    else if ((mom_job_sync == TRUE) &&
-             (!strncmp(str, "jobs=", 5)))
-      {
-      /* walk job list reported by mom */
-      size_t         len = strlen(str) + strlen(current->nd_name) + 2;
-      char          *jobstr = (char *)calloc(1, len);
-      sync_job_info *sji = (sync_job_info *)calloc(1, sizeof(sync_job_info));
+        break;
 
-      if ((jobstr != NULL) &&
-          (sji != NULL))
-        {
-        sprintf(jobstr, "%s:%s", current->nd_name, str+5);
-        sji->input = jobstr;
-        sji->timestamp = time(NULL);
+      case STATUS_DELTA:
 
-        /* sji must be freed in sync_node_jobs */
-        enqueue_threadpool_request(sync_node_jobs, sji, task_pool);
-        }
-      else
-        {
-        if (jobstr != NULL)
-          {
-          free(jobstr);
-          }
-        if (sji != NULL)
-          {
-          free(sji);
-          }
-        }
-      }
-    else if (auto_np)
-      {
-      if (!(strncmp(str, "ncpus=", 6)))
-        {
-        handle_auto_np(current, str);
-        }
+        /* the rest of this node's status is what it sent last time */
+        if ((current->nd_status == NULL) ||
+            (current->nd_status->as_usedptr == 0))
+          need_full = true;
+
+        break;
+
+      default:
+
+        break;
       }
     } /* END processing strings */
 
   if (current != NULL)
     {
-    save_node_status(current, &temp);
+    rc = apply_node_status(current, ns, dont_change_state, mom_job_sync, auto_np, down_on_error);
     unlock_node(current, __func__, NULL, LOGLEVEL);
     }
   
-  if ((rc == PBSE_NONE) &&
-      (send_hello == true))
-    rc = SEND_HELLO;
+  if (rc == PBSE_NONE)
+    {
+    /* a mom never sends a delta with its first update, so these don't overlap */
+    if (need_full == true)
+      rc = NEED_FULL_STATUS;
+    else if (send_hello == true)
+      rc = SEND_HELLO;
+    }
     
   return(rc);
   } /* END process_status_info() */
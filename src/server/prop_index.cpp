@@ -0,0 +1,330 @@
+/*
+*         OpenPBS (Portable Batch System) v2.3 Software License
+*
+* Copyright (c) 1999-2000 Veridian Information Solutions, Inc.
+* All rights reserved.
+*
+* ---------------------------------------------------------------------------
+* For a license to use or redistribute the OpenPBS software under conditions
+* other than those described below, or to purchase support for this software,
+* please contact Veridian Systems, PBS Products Department ("Licensor") at:
+*
+*    www.OpenPBS.org  +1 650 967-4675                  sales@OpenPBS.org
+*                        877 902-4PBS (US toll-free)
+* ---------------------------------------------------------------------------
+*
+* This license covers use of the OpenPBS v2.3 software (the "Software") at
+* your site or location, and, for certain users, redistribution of the
+* Software to other sites and locations.  Use and redistribution of
+* OpenPBS v2.3 in source and binary forms, with or without modification,
+* are permitted provided that all of the following conditions are met.
+* After December 31, 2001, only conditions 3-6 must be met:
+*
+* 1. Commercial and/or non-commercial use of the Software is permitted
+*    provided a current software registration is on file at www.OpenPBS.org.
+*    If use of this software contributes to a publication, product, or
+*    service, proper attribution must be given; see www.OpenPBS.org/credit.html
+*
+* 2. Redistribution in any form is only permitted for non-commercial,
+*    non-profit purposes.  There can be no charge for the Software or any
+*    software incorporating the Software.  Further, there can be no
+*    expectation of revenue generated as a consequence of redistributing
+*    the Software.
+*
+* 3. Any Redistribution of source code must retain the above copyright notice
+*    and the acknowledgment contained in paragraph 6, this list of conditions
+*    and the disclaimer contained in paragraph 7.
+*
+* 4. Any Redistribution in binary form must reproduce the above copyright
+*    notice and the acknowledgment contained in paragraph 6, this list of
+*    conditions and the disclaimer contained in paragraph 7 in the
+*    documentation and/or other materials provided with the distribution.
+*
+* 5. Redistributions in any form must be accompanied by information on how to
+*    obtain complete source code for the OpenPBS software and any
+*    modifications and/or additions to the OpenPBS software.  The source code
+*    must either be included in the distribution or be available for no more
+*    than the cost of distribution plus a nominal fee, and all modifications
+*    and additions to the Software must be freely redistributable by any party
+*    (including Licensor) without restriction.
+*
+* 6. All advertising materials mentioning features or use of the Software must
+*    display the following acknowledgment:
+*
+*     "This product includes software developed by NASA Ames Research Center,
+*     Lawrence Livermore National Laboratory, and Veridian Information
+*     Solutions, Inc.
+*     Visit www.OpenPBS.org for OpenPBS software support,
+*     products, and information."
+*
+* 7. DISCLAIMER OF WARRANTY
+*
+* THIS SOFTWARE IS PROVIDED "AS IS" WITHOUT WARRANTY OF ANY KIND. ANY EXPRESS
+* OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+* OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE, AND NON-INFRINGEMENT
+* ARE EXPRESSLY DISCLAIMED.
+*
+* IN NO EVENT SHALL VERIDIAN CORPORATION, ITS AFFILIATED COMPANIES, OR THE
+* U.S. GOVERNMENT OR ANY OF ITS AGENCIES BE LIABLE FOR ANY DIRECT OR INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+* LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+* OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+* LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+* NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+* EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* This license will be governed by the laws of the Commonwealth of Virginia,
+* without reference to its choice of law rules.
+*/
+
+/*
+ * prop_index.cpp - interned node properties and the property -> node index
+ *
+ * node_spec() used to match every requested feature against every node's
+ * nd_first list with strcmp(). Property names are now interned once into
+ * ids and each node carries an nd_prop_bits bitset that update_prop_bits()
+ * rebuilds whenever its property list is. node_props keeps the inverse,
+ * the set of node ids carrying each property, for select_from_all_nodes().
+ */
+
+#include <pbs_config.h>   /* the master config generated by configure */
+
+#include <limits.h>
+#include "prop_index.hpp"
+
+#define BITS_PER_WORD  (sizeof(unsigned long) * CHAR_BIT)
+
+property_index node_props;
+
+
+
+void prop_bitset_set(
+
+  prop_bitset &bits,
+  int          id)
+
+  {
+  unsigned int word = id / BITS_PER_WORD;
+
+  if (word >= bits.size())
+    bits.resize(word + 1, 0);
+
+  bits[word] |= 1UL << (id % BITS_PER_WORD);
+  } /* END prop_bitset_set() */
+
+
+
+bool prop_bitset_test(
+
+  const prop_bitset &bits,
+  int                id)
+
+  {
+  unsigned int word = id / BITS_PER_WORD;
+
+  if ((id < 0) ||
+      (word >= bits.size()))
+    return(false);
+
+  return((bits[word] & (1UL << (id % BITS_PER_WORD))) != 0);
+  } /* END prop_bitset_test() */
+
+
+
+/*
+ * prop_bitset_contains() - true if every bit set in need is set in have
+ */
+
+bool prop_bitset_contains(
+
+  const prop_bitset &have,
+  const prop_bitset &need)
+
+  {
+  for (unsigned int i = 0; i < need.size(); i++)
+    {
+    unsigned long have_word = (i < have.size()) ? have[i] : 0;
+
+    if ((need[i] & have_word) != need[i])
+      return(false);
+    }
+
+  return(true);
+  } /* END prop_bitset_contains() */
+
+
+
+/*
+ * prop_bitset_next() - the lowest set bit above after, or -1 if none.
+ * Pass -1 to get the first one.
+ */
+
+int prop_bitset_next(
+
+  const prop_bitset &bits,
+  int                after)
+
+  {
+  unsigned int  id = after + 1;
+  unsigned int  word = id / BITS_PER_WORD;
+
+  if (word >= bits.size())
+    return(-1);
+
+  /* mask off the bits at or below after in the first word */
+  unsigned long w = bits[word] & (~0UL << (id % BITS_PER_WORD));
+
+  while (w == 0)
+    {
+    if (++word >= bits.size())
+      return(-1);
+
+    w = bits[word];
+    }
+
+  return(word * BITS_PER_WORD + __builtin_ctzl(w));
+  } /* END prop_bitset_next() */
+
+
+
+property_index::property_index()
+
+  {
+  pthread_mutex_init(&this->mutex, NULL);
+  }
+
+
+
+/*
+ * intern() - the id of property name, allocating one if it's new
+ */
+
+int property_index::intern(
+
+  const char *name)
+
+  {
+  int id = this->names.get_new_id(name);
+
+  pthread_mutex_lock(&this->mutex);
+
+  if ((unsigned int)id >= this->nodes_with.size())
+    this->nodes_with.resize(id + 1);
+
+  pthread_mutex_unlock(&this->mutex);
+
+  return(id);
+  } /* END intern() */
+
+
+
+/*
+ * get_id() - the id of property name, or -1 if no node has ever had it
+ */
+
+int property_index::get_id(
+
+  const char *name)
+
+  {
+  return(this->names.get_id(name));
+  } /* END get_id() */
+
+
+
+/*
+ * set_node_props() - move node_id from the properties in old_props to
+ * those in new_props
+ */
+
+void property_index::set_node_props(
+
+  int                node_id,
+  const prop_bitset &old_props,
+  const prop_bitset &new_props)
+
+  {
+  int id;
+
+  if (node_id < 0)
+    return;
+
+  pthread_mutex_lock(&this->mutex);
+
+  for (id = prop_bitset_next(old_props, -1); id >= 0; id = prop_bitset_next(old_props, id))
+    {
+    if ((prop_bitset_test(new_props, id) == false) &&
+        ((unsigned int)id < this->nodes_with.size()))
+      {
+      prop_bitset  &nodes = this->nodes_with[id];
+      unsigned int  word = node_id / BITS_PER_WORD;
+
+      if (word < nodes.size())
+        nodes[word] &= ~(1UL << (node_id % BITS_PER_WORD));
+      }
+    }
+
+  for (id = prop_bitset_next(new_props, -1); id >= 0; id = prop_bitset_next(new_props, id))
+    {
+    if ((unsigned int)id >= this->nodes_with.size())
+      this->nodes_with.resize(id + 1);
+
+    prop_bitset_set(this->nodes_with[id], node_id);
+    }
+
+  pthread_mutex_unlock(&this->mutex);
+  } /* END set_node_props() */
+
+
+
+/*
+ * nodes_with_all() - the ids of the nodes that have every property in props
+ *
+ * @return false if props is empty, true otherwise
+ */
+
+bool property_index::nodes_with_all(
+
+  const prop_bitset &props,
+  prop_bitset       &nodes)
+
+  {
+  int  id;
+  bool first = true;
+
+  nodes.clear();
+
+  pthread_mutex_lock(&this->mutex);
+
+  for (id = prop_bitset_next(props, -1); id >= 0; id = prop_bitset_next(props, id))
+    {
+    if ((unsigned int)id >= this->nodes_with.size())
+      {
+      /* nobody has this property */
+      nodes.clear();
+      break;
+      }
+
+    prop_bitset const &with = this->nodes_with[id];
+
+    if (first == true)
+      {
+      nodes = with;
+      first = false;
+      }
+    else
+      {
+      if (with.size() < nodes.size())
+        nodes.resize(with.size());
+
+      for (unsigned int i = 0; i < nodes.size(); i++)
+        nodes[i] &= with[i];
+      }
+    }
+
+  pthread_mutex_unlock(&this->mutex);
+
+  return(first == false);
+  } /* END nodes_with_all() */
+
+/* END prop_index.cpp */
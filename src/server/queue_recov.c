@@ -110,6 +110,7 @@
 #include "utils.h"
 #include <pthread.h>
 #include "queue_func.h" /* que_alloc, que_free */
+#include "group_commit.h" /* mark_file_dirty */
 
 /* data global to this file */
 
@@ -149,7 +150,7 @@ int que_save(
     pque->qu_qs.qu_name);
   snprintf(namebuf2,sizeof(namebuf2),"%s.new",namebuf1);
 
-  fds = open(namebuf2, O_CREAT | O_WRONLY | O_Sync, 0600);
+  fds = open(namebuf2, O_CREAT | O_WRONLY, 0600);
 
   if (fds < 0)
     {
@@ -205,6 +206,8 @@ int que_save(
     return(-1);
     }
 
+  mark_file_dirty(namebuf1);
+
   return(0);
   } /* END que_save_xml() */
 
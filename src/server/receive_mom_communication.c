@@ -84,6 +84,11 @@
 #include <errno.h>
 #include <vector>
 #include <string>
+#include <map>
+#include <set>
+#include <deque>
+#include <sstream>
+#include <sys/time.h>
 
 #include "pbs_nodes.h"
 #include "log.h"
@@ -101,6 +106,9 @@
 #include "mom_hierarchy_handler.h"
 
 
+#define STATUS_QUEUE_WORKERS  4  /* most task_pool threads applying queued statuses at once */
+#define STATUS_QUEUE_BATCH   32  /* nodes applied before the thread is given back */
+
 extern int              allow_any_mom;
 extern AvlTree          ipaddrs;
 
@@ -111,7 +119,8 @@ int  unlock_ji_mutex(job *, const char *, const char *, int);
 
 /* 
  * reads all of the status information from stream
- * and stores it in a dynamic string
+ * and stores it in a dynamic string. A frame of statuses relayed
+ * through the mom hierarchy is unpacked in place.
  */
 
 void get_status_info(
@@ -133,7 +142,11 @@ void get_status_info(
       break;
       }
 
-    status.push_back(ret_info);
+    if (!strncmp(ret_info, STATUS_FRAME_KEYWORD, strlen(STATUS_FRAME_KEYWORD)))
+      unpack_status_frame(ret_info + strlen(STATUS_FRAME_KEYWORD), status);
+    else
+      status.push_back(ret_info);
+
     free(ret_info);
     ret_info = NULL;
     }
@@ -145,6 +158,511 @@ void get_status_info(
 
 
 
+/* statuses waiting to be applied, by node. A node rarely has more than one,
+ * see fold_node_status() */
+std::map<std::string, std::deque<queued_status> > queued_statuses;
+/* nodes with statuses waiting that no thread is applying, oldest first */
+std::deque<std::string>  ready_nodes;
+/* nodes a thread is applying a status to. Their next status waits for it */
+std::set<std::string>    busy_nodes;
+int                      queued_status_count = 0;
+int                      status_queue_workers = 0;
+pthread_mutex_t          status_queue_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* status strings grouped by the text before their '=', in the order they came */
+typedef std::vector<std::pair<std::string, std::vector<std::string> > > status_entries;
+
+
+
+/*
+ * groups strings into entries by key. A gpu or mic block is kept whole under
+ * its opening marker.
+ */
+
+void split_status_entries(
+
+  std::vector<std::string> &strings,
+  status_entries           &entries)
+
+  {
+  for (unsigned int i = 0; i < strings.size(); i++)
+    {
+    std::string  key = strings[i].substr(0, strings[i].find('='));
+    const char  *end = NULL;
+    unsigned int e;
+
+    if (key == START_GPU_STATUS)
+      end = END_GPU_STATUS;
+    else if (key == START_MIC_STATUS)
+      end = END_MIC_STATUS;
+
+    for (e = 0; e < entries.size(); e++)
+      {
+      if (entries[e].first == key)
+        break;
+      }
+
+    if (e == entries.size())
+      entries.push_back(std::make_pair(key, std::vector<std::string>()));
+
+    entries[e].second.push_back(strings[i]);
+
+    if (end != NULL)
+      {
+      while ((strings[i] != end) &&
+             (i + 1 < strings.size()))
+        entries[e].second.push_back(strings[++i]);
+      }
+    }
+  } /* END split_status_entries() */
+
+
+
+
+bool has_status_string(
+
+  std::vector<std::string> &strings,
+  const char               *str)
+
+  {
+  for (unsigned int i = 0; i < strings.size(); i++)
+    {
+    if (strings[i] == str)
+      return(true);
+    }
+
+  return(false);
+  } /* END has_status_string() */
+
+
+
+
+/*
+ * fold_node_status()
+ *
+ * folds newer, a node's latest status, into queued, the one it has waiting to
+ * be applied, so that only one is applied. A full status replaces the one
+ * waiting. A delta is laid over it: its keys replace the waiting ones and the
+ * keys it removes are dropped, or passed on if the waiting status is a delta
+ * too. A request for the mom hierarchy is never dropped.
+ *
+ * @return false if newer can't be folded in and has to wait its own turn
+ */
+
+bool fold_node_status(
+
+  queued_status &queued,
+  queued_status &newer)
+
+  {
+  bool                   first_update = has_status_string(queued.strings, "first_update=true");
+  bool                   queued_delta;
+  status_entries         entries;
+  status_entries         newer_entries;
+  std::set<std::string>  removed;
+  std::string            key;
+
+  if (has_status_string(newer.strings, STATUS_DELTA_KEYWORD) == false)
+    {
+    queued.strings.swap(newer.strings);
+
+    if ((first_update == true) &&
+        (has_status_string(queued.strings, "first_update=true") == false))
+      queued.strings.insert(queued.strings.begin() + 1, "first_update=true");
+
+    queued.sender = newer.sender;
+
+    return(true);
+    }
+
+  /* the numa boards of a node share their keys */
+  for (unsigned int i = 0; i < queued.strings.size(); i++)
+    {
+    if (!strncmp(queued.strings[i].c_str(), NUMA_KEYWORD, strlen(NUMA_KEYWORD)))
+      return(false);
+    }
+
+  split_status_entries(queued.strings, entries);
+  split_status_entries(newer.strings, newer_entries);
+
+  queued_delta = has_status_string(queued.strings, STATUS_DELTA_KEYWORD);
+
+  for (unsigned int i = 0; i < entries.size(); i++)
+    {
+    if (entries[i].first == "status_removed")
+      {
+      std::stringstream removed_keys(entries[i].second[0].substr(strlen(STATUS_REMOVED_KEYWORD)));
+
+      while (std::getline(removed_keys, key, ','))
+        removed.insert(key);
+      }
+
+    if ((entries[i].first == "status_delta") ||
+        (entries[i].first == "status_removed"))
+      entries.erase(entries.begin() + i--);
+    }
+
+  for (unsigned int i = 0; i < newer_entries.size(); i++)
+    {
+    unsigned int e;
+
+    if (newer_entries[i].first == "status_removed")
+      {
+      std::stringstream removed_keys(newer_entries[i].second[0].substr(strlen(STATUS_REMOVED_KEYWORD)));
+
+      while (std::getline(removed_keys, key, ','))
+        {
+        for (e = 0; e < entries.size(); e++)
+          {
+          if (entries[e].first == key)
+            {
+            entries.erase(entries.begin() + e);
+            break;
+            }
+          }
+
+        if (queued_delta == true)
+          removed.insert(key);
+        }
+
+      continue;
+      }
+
+    if ((newer_entries[i].first == "status_delta") ||
+        (newer_entries[i].first == "node"))
+      continue;
+
+    removed.erase(newer_entries[i].first);
+
+    for (e = 0; e < entries.size(); e++)
+      {
+      if (entries[e].first == newer_entries[i].first)
+        break;
+      }
+
+    if (e == entries.size())
+      entries.push_back(newer_entries[i]);
+    else
+      entries[e].second.swap(newer_entries[i].second);
+    }
+
+  /* node= stays first */
+  queued.strings.clear();
+
+  for (unsigned int i = 0; i < entries.size(); i++)
+    {
+    queued.strings.insert(queued.strings.end(), entries[i].second.begin(), entries[i].second.end());
+
+    if ((i == 0) &&
+        (queued_delta == true))
+      queued.strings.push_back(STATUS_DELTA_KEYWORD);
+    }
+
+  if ((queued_delta == true) &&
+      (removed.size() != 0))
+    {
+    std::string removed_str(STATUS_REMOVED_KEYWORD);
+
+    for (std::set<std::string>::iterator it = removed.begin(); it != removed.end(); it++)
+      {
+      if (it != removed.begin())
+        removed_str += ",";
+
+      removed_str += *it;
+      }
+
+    queued.strings.push_back(removed_str);
+    }
+
+  queued.sender = newer.sender;
+
+  return(true);
+  } /* END fold_node_status() */
+
+
+
+
+/*
+ * @return true if a status delta for node_name has something to be applied to
+ */
+
+bool has_status_base(
+
+  std::string &node_name)
+
+  {
+  bool            base = false;
+  struct pbsnode *pnode;
+
+  pthread_mutex_lock(&status_queue_mutex);
+
+  std::map<std::string, std::deque<queued_status> >::iterator it = queued_statuses.find(node_name);
+
+  if (it != queued_statuses.end())
+    {
+    for (unsigned int i = 0; i < it->second.size(); i++)
+      {
+      if (has_status_string(it->second[i].strings, STATUS_DELTA_KEYWORD) == false)
+        base = true;
+      }
+    }
+
+  pthread_mutex_unlock(&status_queue_mutex);
+
+  if ((base == false) &&
+      ((pnode = find_nodebyname(node_name.c_str())) != NULL))
+    {
+    base = ((pnode->nd_status != NULL) &&
+            (pnode->nd_status->as_usedptr != 0));
+
+    unlock_node(pnode, __func__, NULL, LOGLEVEL);
+    }
+
+  return(base);
+  } /* END has_status_base() */
+
+
+
+
+/*
+ * applies a node's queued status and, if the mom asked for it, sends it
+ * the mom hierarchy
+ */
+
+void apply_node_status(
+
+  queued_status &qs,
+  std::string   &node_name)
+
+  {
+  int             rc;
+  char            log_buf[LOCAL_LOG_BUF_SIZE];
+  struct pbsnode *pnode;
+
+  rc = process_status_info((char *)qs.sender.c_str(), qs.strings);
+
+  if (rc == SEND_HELLO)
+    {
+    if ((pnode = find_nodebyname(node_name.c_str())) != NULL)
+      {
+      hierarchy_handler.sendHierarchyToANode(pnode);
+      unlock_node(pnode, __func__, NULL, LOGLEVEL);
+      }
+    }
+  else if ((rc != PBSE_NONE) &&
+           (rc != NEED_FULL_STATUS))
+    {
+    snprintf(log_buf, sizeof(log_buf),
+      "IS_STATUS error %d on node %s", rc, node_name.c_str());
+    log_err(rc, __func__, log_buf);
+    }
+  } /* END apply_node_status() */
+
+
+
+
+/*
+ * apply_queued_statuses()
+ *
+ * a task_pool task that applies queued statuses, a batch of nodes at a time,
+ * until none are left. Up to STATUS_QUEUE_WORKERS of these run at once, and
+ * a node is only ever applied by one of them at a time, so its statuses are
+ * applied in the order they came.
+ */
+
+void *apply_queued_statuses(
+
+  void *vp)
+
+  {
+  std::string   node_name;
+  queued_status qs;
+
+  while (true)
+    {
+    pthread_mutex_lock(&status_queue_mutex);
+
+    for (int applied = 0; (ready_nodes.size() != 0) && (applied < STATUS_QUEUE_BATCH); applied++)
+      {
+      node_name = ready_nodes.front();
+      ready_nodes.pop_front();
+
+      std::deque<queued_status> &waiting = queued_statuses[node_name];
+
+      qs.sender.swap(waiting.front().sender);
+      qs.strings.swap(waiting.front().strings);
+      waiting.pop_front();
+      queued_status_count--;
+
+      busy_nodes.insert(node_name);
+      pthread_mutex_unlock(&status_queue_mutex);
+
+      apply_node_status(qs, node_name);
+
+      pthread_mutex_lock(&status_queue_mutex);
+      busy_nodes.erase(node_name);
+
+      if (queued_statuses[node_name].size() != 0)
+        ready_nodes.push_back(node_name);
+      else
+        queued_statuses.erase(node_name);
+      }
+
+    if (ready_nodes.size() == 0)
+      {
+      status_queue_workers--;
+      pthread_mutex_unlock(&status_queue_mutex);
+      break;
+      }
+
+    pthread_mutex_unlock(&status_queue_mutex);
+
+    /* give the thread back between batches */
+    if (enqueue_threadpool_request(apply_queued_statuses, NULL, task_pool) == PBSE_NONE)
+      break;
+    }
+
+  return(NULL);
+  } /* END apply_queued_statuses() */
+
+
+
+
+/*
+ * queue_status_info()
+ *
+ * splits a status update into each node's part and queues them to be applied
+ * by apply_queued_statuses(), instead of applying them while the mom waits.
+ * When the server falls behind, a node's newer status is folded into the one
+ * it already has waiting, so stale updates aren't applied one after another.
+ *
+ * @return NEED_FULL_STATUS if a delta has nothing to be applied to,
+ * PBSE_NONE otherwise
+ */
+
+int queue_status_info(
+
+  char                     *sender,
+  std::vector<std::string> &status_info)
+
+  {
+  int                        rc = PBSE_NONE;
+  bool                       start_worker = false;
+  struct timeval             now;
+  std::vector<queued_status> parts;
+
+  gettimeofday(&now, NULL);
+
+  for (unsigned int i = 0; i < status_info.size(); i++)
+    {
+    if ((parts.size() == 0) ||
+        (!strncmp(status_info[i].c_str(), "node=", strlen("node="))))
+      {
+      parts.push_back(queued_status());
+      parts.back().sender = sender;
+      parts.back().received = now;
+
+      if (strncmp(status_info[i].c_str(), "node=", strlen("node=")))
+        parts.back().strings.push_back(std::string("node=") + sender);
+      }
+
+    parts.back().strings.push_back(status_info[i]);
+    }
+
+  for (unsigned int i = 0; i < parts.size(); i++)
+    {
+    std::string node_name = parts[i].strings[0].substr(strlen("node="));
+
+    if ((has_status_string(parts[i].strings, STATUS_DELTA_KEYWORD) == true) &&
+        (has_status_base(node_name) == false))
+      rc = NEED_FULL_STATUS;
+    }
+
+  pthread_mutex_lock(&status_queue_mutex);
+
+  for (unsigned int i = 0; i < parts.size(); i++)
+    {
+    std::string                node_name = parts[i].strings[0].substr(strlen("node="));
+    std::deque<queued_status> &waiting = queued_statuses[node_name];
+
+    if (waiting.size() == 0)
+      {
+      waiting.push_back(parts[i]);
+      queued_status_count++;
+
+      if (busy_nodes.find(node_name) == busy_nodes.end())
+        ready_nodes.push_back(node_name);
+      }
+    else if (fold_node_status(waiting.back(), parts[i]) == false)
+      {
+      waiting.push_back(parts[i]);
+      queued_status_count++;
+      }
+    }
+
+  /* one thread per node that's ready, up to STATUS_QUEUE_WORKERS */
+  if ((ready_nodes.size() > (unsigned int)status_queue_workers) &&
+      (status_queue_workers < STATUS_QUEUE_WORKERS))
+    {
+    status_queue_workers++;
+    start_worker = true;
+    }
+
+  pthread_mutex_unlock(&status_queue_mutex);
+
+  if ((start_worker == true) &&
+      (enqueue_threadpool_request(apply_queued_statuses, NULL, task_pool) != PBSE_NONE))
+    apply_queued_statuses(NULL);
+
+  return(rc);
+  } /* END queue_status_info() */
+
+
+
+
+/*
+ * get_status_queue_stats()
+ *
+ * @param depth (O) the number of node statuses waiting to be applied
+ * @param lag (O) how long the oldest of them has waited, in milliseconds
+ */
+
+void get_status_queue_stats(
+
+  long *depth,
+  long *lag)
+
+  {
+  struct timeval  now;
+  struct timeval *oldest = NULL;
+
+  gettimeofday(&now, NULL);
+
+  pthread_mutex_lock(&status_queue_mutex);
+
+  *depth = queued_status_count;
+
+  for (std::map<std::string, std::deque<queued_status> >::iterator it = queued_statuses.begin();
+       it != queued_statuses.end();
+       it++)
+    {
+    if ((it->second.size() != 0) &&
+        ((oldest == NULL) ||
+         (timercmp(&it->second.front().received, oldest, <))))
+      oldest = &it->second.front().received;
+    }
+
+  if (oldest != NULL)
+    *lag = (now.tv_sec - oldest->tv_sec) * 1000 + (now.tv_usec - oldest->tv_usec) / 1000;
+  else
+    *lag = 0;
+
+  pthread_mutex_unlock(&status_queue_mutex);
+  } /* END get_status_queue_stats() */
+
+
+
+
 int is_reporter_node(
 
   char *node_id)
@@ -186,7 +704,7 @@ int is_stat_get(
   if (is_reporter_node(node_name))
     rc = process_alps_status(node_name, status_info);
   else
-    rc = process_status_info(node_name, status_info);
+    rc = queue_status_info(node_name, status_info);
 
   return(rc);
   }  /* END is_stat_get() */
@@ -523,6 +1041,10 @@ void *svr_is_request(
           write_tcp_reply(chan,IS_PROTOCOL,IS_PROTOCOL_VER,IS_STATUS,ret);
         }
 
+      /* the delta was queued, the mom just needs to send everything next time */
+      if (ret == NEED_FULL_STATUS)
+        ret = DIS_SUCCESS;
+
       if (ret != DIS_SUCCESS)
         {
         if (LOGLEVEL >= 1)
@@ -197,7 +197,12 @@ int req_deletearray(
     /* parse the array range */
     num_skipped = delete_array_range(pa,range);
 
-    if (num_skipped < 0)
+    if (num_skipped == NO_JOBS_IN_ARRAY)
+      {
+      /* the range held the last of the array and delete_array_range() deleted it */
+      pa_mutex.set_unlock_on_exit(false);
+      }
+    else if (num_skipped < 0)
       {
       /* ERROR */
       req_reject(PBSE_IVALREQ,0,preq,NULL,"Error in specified array range");
@@ -217,7 +222,11 @@ int req_deletearray(
       }
 
     if ((num_skipped = delete_whole_array(pa)) == NO_JOBS_IN_ARRAY)
+      {
+      /* array_delete() unlocks and frees the mutex */
+      pa_mutex.set_unlock_on_exit(false);
       array_delete(pa);
+      }
     }
 
   if (num_skipped != NO_JOBS_IN_ARRAY)
@@ -149,7 +149,15 @@ int req_holdarray(
     }
   else
     {
-    /* do the entire array */
+    /* do the entire array, subjobs still in the request tokens would be
+       cloned without the hold */
+    if (materialize_virtual_subjobs(&pa) != PBSE_NONE)
+      {
+      array_mutex.set_unlock_on_exit(false);
+      req_reject(PBSE_UNKARRAYID, 0, preq, NULL, "unable to find array");
+      return(PBSE_NONE);
+      }
+
     for (i = 0;i < pa->ai_qs.array_size;i++)
       {
       if (pa->job_ids[i] == NULL)
@@ -513,6 +513,10 @@ int release_whole_array(
   int  rc;
   job *pjob;
 
+  /* subjobs still in the request tokens may have inherited a hold */
+  if ((rc = materialize_virtual_subjobs(&pa)) != PBSE_NONE)
+    return(rc);
+
   for (i = 0; i < pa->ai_qs.array_size; i++)
     {
     if (pa->job_ids[i] == NULL)
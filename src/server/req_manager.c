@@ -909,6 +909,9 @@ int mgr_set_node_attr(
 
   pnode->nd_nprops = nprops + 1;
 
+  update_prop_bits(pnode);
+  update_node_capacity(pnode);
+
   /* update status list based on new status array */
 
   free_prop_list(pnode->nd_f_st);
@@ -704,6 +704,10 @@ int modify_whole_array(
   int   modify_job_rc = PBSE_NONE;
   job  *pjob;
 
+  /* subjobs still in the request tokens would be cloned without the change */
+  if (materialize_virtual_subjobs(&pa) != PBSE_NONE)
+    return(PBSE_JOB_RECYCLED);
+
   for (i = 0; i < pa->ai_qs.array_size; i++)
     {
     if (pa->job_ids[i] == NULL)
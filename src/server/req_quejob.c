@@ -133,6 +133,8 @@
 #include "req_runjob.h"
 #include "mutex_mgr.hpp"
 #include "id_map.hpp"
+#include "job_journal.h" /* job_journal_remove */
+#include "group_commit.h" /* wait_for_commit */
 
 
 /* External Functions Called: */
@@ -1955,6 +1957,7 @@ int req_rdytocommit(
 
     snprintf(namebuf, sizeof(namebuf), "%s%s%s", path_jobs, pj->ji_qs.ji_fileprefix, JOB_FILE_SUFFIX);
     unlink(namebuf);
+    job_journal_remove(pj->ji_qs.ji_fileprefix);
     }
 
   /* acknowledge the request with the job id */
@@ -2145,6 +2148,7 @@ int req_commit(
     
     snprintf(namebuf, sizeof(namebuf), "%s%s%s", path_jobs, pj->ji_qs.ji_fileprefix, JOB_FILE_SUFFIX);
     unlink(namebuf);
+    job_journal_remove(pj->ji_qs.ji_fileprefix);
     }
 
 #endif /* QUICKCOMMIT */
@@ -2232,6 +2236,25 @@ int req_commit(
   pj->ji_wattr[JOB_ATR_qrank].at_val.at_long = ++queue_rank;
   pj->ji_wattr[JOB_ATR_qrank].at_flags |= ATR_VFLAG_SET;
 
+  /* the job must be on disk before it can be scheduled and before the
+   * client is told it exists. Nothing else can find the job until
+   * svr_enquejob() so hold it while its commit is synced */
+  if ((job_save(pj, SAVEJOB_FULL, 0) != 0) ||
+      (wait_for_commit(pj->ji_commit_ticket) != PBSE_NONE))
+    {
+    rc = PBSE_CAN_NOT_SAVE_FILE;
+    log_event(PBSEVENT_ERROR | PBSEVENT_JOB,
+      PBS_EVENTCLASS_JOB,
+      pj->ji_qs.ji_jobid,
+      "unable to sync the job file to disk, rejecting the job");
+
+    decrement_queued_jobs(&users, pj->ji_wattr[JOB_ATR_job_owner].at_val.at_str);
+    svr_job_purge(pj);
+    job_mutex.set_unlock_on_exit(false);
+    req_reject(rc, 0, preq, NULL, "unable to sync the job file to disk");
+    return(rc);
+    }
+
   if ((rc = svr_enquejob(pj, FALSE, NULL, false)) != PBSE_NONE)
     {
     if (rc != PBSE_JOB_RECYCLED)
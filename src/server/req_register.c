@@ -147,6 +147,7 @@ void   clear_depend(struct depend *, int type, int exists);
 void   del_depend(struct depend *);
 int    release_cheapest(job *, struct depend *);
 int    send_depend_req(job *, struct depend_job *pparent, int, int, int, void (*postfunc)(batch_request *),bool bAsyncOk);
+bool   depend_svr_is_local(char *svr);
 depend_job *alloc_dependjob(const char *jobid, const char *host);
 
 /* External Global Data Items */
@@ -2355,8 +2356,47 @@ struct depend_job *make_dependjob(
 
 
 
+/*
+ * depend_svr_is_local - returns true if svr names this server
+ *
+ * dc_svr is normally recorded as server_name when the dependency is
+ * registered, so compare the names before paying for an address lookup.
+ */
+
+bool depend_svr_is_local(
+
+  char *svr)
+
+  {
+  pbs_net_t svraddr1;
+  pbs_net_t svraddr2;
+  int       my_err;
+
+  if ((svr == NULL) ||
+      (svr[0] == '\0'))
+    return(false);
+
+  if (!strcmp(svr, server_name))
+    return(true);
+
+  svraddr1 = get_hostaddr(&my_err, server_name);
+  svraddr2 = get_hostaddr(&my_err, svr);
+
+  return(svraddr1 == svraddr2);
+  } /* END depend_svr_is_local() */
+
+
+
+
 /*
  * send_depend_req - build and send a Register Dependent request
+ *
+ * When both jobs live on this server the dependency edge is resolved in
+ * place by handing the request straight to req_register() instead of
+ * looping it back through a work task and a local connection.  Deletes
+ * requested asynchronously still go through que_to_local_svr(): a delete
+ * ends the dependent job, which in turn walks its own dependents, and a
+ * long chain must not be unwound on this thread's stack.
  */
 
 int send_depend_req(
@@ -2377,9 +2417,7 @@ int send_depend_req(
 
   struct batch_request *preq;
   char                  log_buf[LOCAL_LOG_BUF_SIZE];
-  pbs_net_t             svraddr1;
-  pbs_net_t             svraddr2;
-  int                   my_err;
+  bool                  local;
 
   preq = alloc_br(PBS_BATCH_RegistDep);
 
@@ -2445,13 +2483,39 @@ int send_depend_req(
   strcpy(job_id, pjob->ji_qs.ji_jobid);
   unlock_ji_mutex(pjob, __func__, "2", LOGLEVEL);
 
+  local = depend_svr_is_local(pparent->dc_svr);
+
+  if ((local == true) &&
+      ((bAsyncOk == false) ||
+       (op != JOB_DEPEND_OP_DELETE)))
+    {
+    /* req_register() always replies, which frees preq for a local connection */
+    preq->rq_fromsvr = 1;
+    preq->rq_perm = ATR_DFLAG_MGRD | ATR_DFLAG_MGWR | ATR_DFLAG_SvWR;
+    preq->rq_conn = PBS_LOCAL_CONNECTION;
+
+    if ((rc = req_register(preq)) != PBSE_NONE)
+      {
+      sprintf(log_buf, "Unable to perform dependency with job %s\n", pparent->dc_child);
+      log_err(rc, __func__, log_buf);
+
+      /* asynchronous callers never waited on the outcome of a local request */
+      if (bAsyncOk == true)
+        rc = PBSE_NONE;
+      }
+
+    if ((pjob = svr_find_job(job_id, TRUE)) == NULL)
+      {
+      return(PBSE_JOBNOTFOUND);
+      }
+
+    return(rc);
+    }
+
   get_batch_request_id(preq);
   snprintf(br_id, sizeof(br_id), "%s", preq->rq_id);
 
-  svraddr1 = get_hostaddr(&my_err, server_name);
-  svraddr2 = get_hostaddr(&my_err, pparent->dc_svr);
-
-  if((svraddr1 == svraddr2)&&(bAsyncOk))
+  if (local == true)
     {
     snprintf(preq->rq_host,sizeof(preq->rq_host),"%s",pparent->dc_svr);
     rc = que_to_local_svr(preq);
@@ -2465,7 +2529,7 @@ int send_depend_req(
     {
     /* local requests have already been processed and freed. Do not attempt to
      * free or reference again. */
-    if (svraddr1 != svraddr2)
+    if (local == false)
       {
       free_br(preq);
       }
@@ -2485,7 +2549,7 @@ int send_depend_req(
     }
   /* local requests have already been processed and freed. Do not attempt to
    * free or reference again. */
-  else if (svraddr1 != svraddr2)
+  else if (local == false)
     postfunc(preq);
 
   if ((pjob = svr_find_job(job_id, TRUE)) == NULL)
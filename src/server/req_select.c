@@ -109,6 +109,7 @@
 #include "req_stat.h" /* stat_mom_job */
 #include "ji_mutex.h"
 #include "mutex_mgr.hpp"
+#include "job_index.h"
 
 /* Private Data */
 
@@ -133,6 +134,8 @@ static void free_sellist(struct select_list *pslist);
 static int  sel_attr(pbs_attribute *, struct select_list *);
 static int  select_job(job *, struct select_list *);
 static void sel_step3(struct stat_cntl *);
+static bool select_candidates(struct select_list *, std::vector<std::string> &);
+static job *next_candidate(std::vector<std::string> &, unsigned int &, pbs_queue *);
 
 
 
@@ -373,6 +376,10 @@ static void sel_step3(
 
   all_jobs_iterator   *iter = NULL;
   long        query_others = 0;
+
+  std::vector<std::string> candidates;
+  unsigned int             next_cand = 0;
+  bool                     use_index = false;
   
   get_svr_attr_l(SRV_ATR_query_others, &query_others);
   if (cntl->sc_origrq->rq_extend != NULL)
@@ -404,33 +411,38 @@ static void sel_step3(
     if (!strncmp(preq->rq_extend, EXECQUEONLY, strlen(EXECQUEONLY)))
       exec_only = 1;
 
+  /* -u and -s can be answered from the job indexes. Array summaries
+   * aren't indexed and are always scanned */
+  if (!summarize_arrays)
+    use_index = select_candidates(cntl->sc_select, candidates);
+
   if(summarize_arrays)
     {
     if (cntl->sc_pque)
       {
       cntl->sc_pque->qu_jobs_array_sum->lock();
-      iter = cntl->sc_pque->qu_jobs_array_sum->get_iterator();
+      iter = cntl->sc_pque->qu_jobs_array_sum->get_snapshot_iterator();
       cntl->sc_pque->qu_jobs_array_sum->unlock();
       }
     else
       {
       array_summary.lock();
-      iter = array_summary.get_iterator();
+      iter = array_summary.get_snapshot_iterator();
       array_summary.unlock();
       }
     }
-  else
+  else if (!use_index)
     {
     if (cntl->sc_pque)
       {
       cntl->sc_pque->qu_jobs->lock();
-      iter = cntl->sc_pque->qu_jobs->get_iterator();
+      iter = cntl->sc_pque->qu_jobs->get_snapshot_iterator();
       cntl->sc_pque->qu_jobs->unlock();
       }
     else
       {
       alljobs.lock();
-      iter = alljobs.get_iterator();
+      iter = alljobs.get_snapshot_iterator();
       alljobs.unlock();
       }
 
@@ -447,6 +459,8 @@ static void sel_step3(
       pjob = next_job(&array_summary,iter);
       }
     }
+  else if (use_index)
+    pjob = next_candidate(candidates, next_cand, cntl->sc_pque);
   else
     {
     if (cntl->sc_pque)
@@ -535,6 +549,8 @@ nextjob:
       else
         next = next_job(&array_summary,iter);
       }
+    else if (use_index)
+      next = next_candidate(candidates, next_cand, cntl->sc_pque);
     else
       {
       if (cntl->sc_pque)
@@ -547,6 +563,9 @@ nextjob:
     }
 
 
+  if (iter != NULL)
+    delete iter;
+
   if (rc)
     req_reject(rc, 0, preq, NULL, NULL);
   else
@@ -557,6 +576,91 @@ nextjob:
 
 
 
+/*
+ * select_candidates() - look up the jobs that can match the -u (User_List)
+ * and -s (job_state) entries of the select list in the job indexes
+ *
+ * @param psel - the select list
+ * @param jobids - O, a superset of the matching jobs, in queue rank order
+ * @return true if jobids is to be used, false if the select list has no
+ * indexed entries and every job must be scanned
+ */
+
+static bool select_candidates(
+
+  struct select_list       *psel,
+  std::vector<std::string> &jobids)
+
+  {
+  std::vector<std::string>  users;
+  bool                      have_users = false;
+  const char               *states = NULL;
+
+  for (; psel != NULL; psel = psel->sl_next)
+    {
+    if ((psel->sl_atindx == JOB_ATR_userlst) &&
+        (have_users == false))
+      {
+      struct array_strings *pas = psel->sl_attr.at_val.at_arst;
+
+      if ((pas == NULL) ||
+          (pas->as_usedptr == 0))
+        continue;
+
+      for (int i = 0; i < pas->as_usedptr; i++)
+        users.push_back(pas->as_string[i]);
+
+      have_users = true;
+      }
+    else if ((psel->sl_atindx == JOB_ATR_state) &&
+             (psel->sl_op == EQ) &&
+             (states == NULL))
+      {
+      states = psel->sl_attr.at_val.at_str;
+      }
+    }
+
+  return(job_index_lookup((have_users == true) ? &users : NULL, states, jobids));
+  } /* END select_candidates() */
+
+
+
+/*
+ * next_candidate() - the next job from the candidate list that still
+ * exists and, if pque is set, is in that queue
+ *
+ * @return the job, locked, or NULL at the end of the list
+ */
+
+static job *next_candidate(
+
+  std::vector<std::string> &jobids,
+  unsigned int             &next,
+  pbs_queue                *pque)
+
+  {
+  job *pjob;
+
+  while (next < jobids.size())
+    {
+    if ((pjob = svr_find_job(jobids[next++].c_str(), FALSE)) == NULL)
+      continue;
+
+    if ((pque != NULL) &&
+        (strcmp(pjob->ji_qs.ji_queue, pque->qu_qs.qu_name)))
+      {
+      unlock_ji_mutex(pjob, __func__, NULL, LOGLEVEL);
+      continue;
+      }
+
+    return(pjob);
+    }
+
+  return(NULL);
+  } /* END next_candidate() */
+
+
+
 
 
 /*
@@ -123,6 +123,8 @@
 #include "unistd.h"
 #include "log.h"
 #include "job_func.h"
+#include "array_func.h" /* array_index_is_virtual */
+#include "mom_update.h" /* get_status_queue_stats */
 
 /* Global Data Items: */
 
@@ -144,6 +146,7 @@ extern pthread_mutex_t *netrates_mutex;
 /* Extern Functions */
 
 int status_job(job *, struct batch_request *, svrattrl *, tlist_head *, bool, int *);
+int status_virtual_subjob(job *, int, struct batch_request *, svrattrl *, tlist_head *, bool, int *);
 int status_attrib(svrattrl *, attribute_def *, pbs_attribute *, int, int, tlist_head *, bool, int *, int);
 extern int  status_nodeattrib(svrattrl *, attribute_def *, struct pbsnode *, int, int, tlist_head *, int*);
 extern int  hasprop(struct pbsnode *, struct prop *);
@@ -254,7 +257,9 @@ int req_stat_job(
       {
       type = tjstJob;
 
-      if ((pjob = svr_find_job(name, FALSE)) == NULL)
+      /* a virtual array subjob is made into a job when it is queried */
+      if (((pjob = svr_find_job(name, FALSE)) == NULL) &&
+          ((pjob = materialize_subjob(name)) == NULL))
         {
         rc = PBSE_UNKJOBID;
         }
@@ -343,6 +348,92 @@ int req_stat_job(
 
 
 
+/*
+ * next_array_subjob()
+ *
+ * finds the next subjob of the array after *job_array_index that has been
+ * made into a job. The subjobs passed over on the way that still only
+ * exist in the array's request tokens are statused from the array's
+ * template job.
+ *
+ * @param cntl - the status request
+ * @param pa - the array, locked
+ * @param job_array_index - I/O the index to search after, then the found one
+ * @param list_virtual - whether to status the virtual subjobs passed over
+ * @param pjob_ptr - RETURN: the subjob, locked, or NULL at the end
+ * @param bad - RETURN: index of the first bad pbs_attribute
+ * @return PBSE_NONE or the error from status_virtual_subjob()
+ */
+
+static int next_array_subjob(
+
+  struct stat_cntl  *cntl,
+  job_array         *pa,
+  int               *job_array_index,
+  bool               list_virtual,
+  job              **pjob_ptr,
+  int               *bad)
+
+  {
+  struct batch_request *preq = cntl->sc_origrq;
+  job                  *template_job = NULL;
+  int                   rc = PBSE_NONE;
+
+  *pjob_ptr = NULL;
+
+  while (++(*job_array_index) < pa->ai_qs.array_size)
+    {
+    if (pa->job_ids[*job_array_index] != NULL)
+      {
+      /* never hold the template and a subjob at once */
+      if (template_job != NULL)
+        {
+        unlock_ji_mutex(template_job, __func__, "1", LOGLEVEL);
+        template_job = NULL;
+        }
+
+      if ((*pjob_ptr = svr_find_job(pa->job_ids[*job_array_index], FALSE)) != NULL)
+        break;
+
+      continue;
+      }
+
+    if ((list_virtual == false) ||
+        (array_index_is_virtual(pa, *job_array_index) == false))
+      continue;
+
+    if ((template_job == NULL) &&
+        ((template_job = svr_find_job(pa->ai_qs.parent_id, TRUE)) == NULL))
+      {
+      list_virtual = false;
+      continue;
+      }
+
+    rc = status_virtual_subjob(
+           template_job,
+           *job_array_index,
+           preq,
+           (svrattrl *)GET_NEXT(preq->rq_ind.rq_status.rq_attr),
+           &preq->rq_reply.brp_un.brp_status,
+           cntl->sc_condensed,
+           bad);
+
+    if ((rc != PBSE_NONE) &&
+        (rc != PBSE_PERM))
+      break;
+
+    rc = PBSE_NONE;
+    }
+
+  if (template_job != NULL)
+    unlock_ji_mutex(template_job, __func__, "2", LOGLEVEL);
+
+  return(rc);
+  } /* END next_array_subjob() */
+
+
+
+
 /*
  * req_stat_job_step2 - continue with statusing of jobs
  *
@@ -451,8 +542,10 @@ static void req_stat_job_step2(
   else
     ajptr = &alljobs;
 
+  /* walk a snapshot so a long status scan doesn't hold up submissions,
+   * purges and lookups on the same list */
   ajptr->lock();
-  iter = ajptr->get_iterator();
+  iter = ajptr->get_snapshot_iterator();
   ajptr->unlock();
   }
 
@@ -469,6 +562,27 @@ static void req_stat_job_step2(
     }
 
 
+  DTime = 0;
+
+  if (preq->rq_extend != NULL)
+    {
+    char *ptr;
+
+    /* FORMAT:  { EXECQONLY | DELTA:<EPOCHTIME> } */
+
+    if (strstr(preq->rq_extend, EXECQUEONLY))
+      exec_only = 1;
+
+    ptr = strstr(preq->rq_extend, "DELTA:");
+
+    if (ptr != NULL)
+      {
+      ptr += strlen("delta:");
+
+      DTime = strtol(ptr, NULL, 10);
+      }
+    }
+
   if (type == tjstJob)
     pjob = svr_find_job(preq->rq_ind.rq_status.rq_id, FALSE);
 
@@ -483,43 +597,22 @@ static void req_stat_job_step2(
 
   else if (type == tjstArray)
     {
+    /* virtual subjobs aren't in any queue, so a scheduler never sees them */
     job_array_index = -1;
-    pjob = NULL;
-    /* increment job_array_index until we find a non-null pointer or hit the end */
-    while (++job_array_index < pa->ai_qs.array_size)
-      {
-      if (pa->job_ids[job_array_index] != NULL)
-        {
-        if ((pjob = svr_find_job(pa->job_ids[job_array_index], FALSE)) != NULL)
-          {
-          break;
-          }
-        }
-      }
-    }
-  else
-    pjob = next_job(&alljobs,iter);
-
-  DTime = 0;
 
-  if (preq->rq_extend != NULL)
-    {
-    char *ptr;
-
-    /* FORMAT:  { EXECQONLY | DELTA:<EPOCHTIME> } */
-
-    if (strstr(preq->rq_extend, EXECQUEONLY))
-      exec_only = 1;
+    if ((rc = next_array_subjob(cntl, pa, &job_array_index, exec_only == 0, &pjob, &bad)) != PBSE_NONE)
+      {
+      unlock_ai_mutex(pa, __func__, "2", LOGLEVEL);
 
-    ptr = strstr(preq->rq_extend, "DELTA:");
+      req_reject(rc, bad, preq, NULL, NULL);
 
-    if (ptr != NULL)
-      {
-      ptr += strlen("delta:");
+      delete iter;
 
-      DTime = strtol(ptr, NULL, 10);
+      return;
       }
     }
+  else
+    pjob = next_job(&alljobs,iter);
 
   if ((type == tjstTruncatedServer) || 
       (type == tjstTruncatedQueue))
@@ -573,7 +666,7 @@ static void req_stat_job_step2(
 
       all_jobs_iterator *jobiter = NULL;
       pque->qu_jobs->lock();
-      jobiter = pque->qu_jobs->get_iterator();
+      jobiter = pque->qu_jobs->get_snapshot_iterator();
       pque->qu_jobs->unlock();
 
       while ((pjob = next_job(pque->qu_jobs,jobiter)) != NULL)
@@ -605,6 +698,7 @@ static void req_stat_job_step2(
           unlock_ji_mutex(pjob, __func__, "7", LOGLEVEL);
           unlock_queue(pque, __func__, "perm", LOGLEVEL);
 
+          delete jobiter;
           delete iter;
 
           return;
@@ -618,6 +712,9 @@ static void req_stat_job_step2(
         unlock_ji_mutex(pjob, __func__, "8", LOGLEVEL);
         }    /* END foreach (pjob from pque) */
 
+      /* the iterator holds a reference to the queue's job snapshot */
+      delete jobiter;
+
       if (LOGLEVEL >= 5)
         {
         sprintf(log_buf,"sent scheduler %ld total jobs for queue %s\n",
@@ -717,17 +814,15 @@ nextjob:
       pjob = next_job(&array_summary,iter);
     else if (type == tjstArray)
       {
-      pjob = NULL;
-      /* increment job_array_index until we find a non-null pointer or hit the end */
-      while (++job_array_index < pa->ai_qs.array_size)
+      if ((rc = next_array_subjob(cntl, pa, &job_array_index, exec_only == 0, &pjob, &bad)) != PBSE_NONE)
         {
-        if (pa->job_ids[job_array_index] != NULL)
-          {
-          if ((pjob = svr_find_job(pa->job_ids[job_array_index], FALSE)) != NULL)
-            {
-            break;
-            }
-          }
+        unlock_ai_mutex(pa, __func__, "3", LOGLEVEL);
+
+        req_reject(rc, bad, preq, NULL, NULL);
+
+        delete iter;
+
+        return;
         }
       }
     else
@@ -1568,9 +1663,13 @@ int req_stat_svr(
   char                  nc_buf[128];
   int                   numjobs;
   int                   netrates[3];
+  long                  queue_depth;
+  long                  queue_lag;
 
   memset(netrates, 0, sizeof(netrates));
 
+  get_status_queue_stats(&queue_depth, &queue_lag);
+
   /* update count and state counts from sv_numjobs and sv_jobstates */
   lock_sv_qs_mutex(server.sv_qs_mutex, __func__);
   numjobs = server.sv_qs.sv_numjobs;
@@ -1580,6 +1679,11 @@ int req_stat_svr(
   server.sv_attr[SRV_ATR_TotalJobs].at_val.at_long = numjobs;
   server.sv_attr[SRV_ATR_TotalJobs].at_flags |= ATR_VFLAG_SET;
 
+  server.sv_attr[SRV_ATR_StatusQueueDepth].at_val.at_long = queue_depth;
+  server.sv_attr[SRV_ATR_StatusQueueDepth].at_flags |= ATR_VFLAG_SET;
+  server.sv_attr[SRV_ATR_StatusQueueLag].at_val.at_long = queue_lag;
+  server.sv_attr[SRV_ATR_StatusQueueLag].at_flags |= ATR_VFLAG_SET;
+
   pthread_mutex_lock(server.sv_jobstates_mutex);
 
   update_state_ct(
@@ -105,6 +105,7 @@
 #include "resource.h"
 #include "svr_func.h" /* get_svr_attr_* */
 #include "log.h"
+#include "job_func.h" /* subjob_id, clone_subjob_attributes */
 
 extern int     svr_authorize_jobreq(struct batch_request *, job *);
 int status_attrib(svrattrl *, attribute_def *, pbs_attribute *, int, int, tlist_head *, bool, int *, int);
@@ -200,6 +201,101 @@ int status_job(
 
 
 
+/*
+ * status_virtual_subjob()
+ *
+ * builds the status of an array subjob that so far only exists in the
+ * array's request tokens, as job_clone() would make it: the template's
+ * attributes for that index, queued or held like the template
+ *
+ * @see status_job()
+ * @param template_job - the array's template job, locked
+ * @param taskid - the index of the subjob
+ * @return PBSE_NONE, PBSE_PERM if the client may not see it, or the
+ * status_job() errors
+ */
+
+int status_virtual_subjob(
+
+  job           *template_job, /* array template to status from */
+  int            taskid,
+  batch_request *preq,
+  svrattrl      *pal,          /* specific attributes to status */
+  tlist_head    *pstathd,      /* RETURN: head of list to append status to */
+  bool           condensed,
+  int           *bad)          /* RETURN: index of first bad pbs_attribute */
+
+  {
+  struct brp_status *pstat;
+  pbs_attribute      wattr[JOB_ATR_LAST];
+  int                IsOwner = 0;
+  long               query_others = 0;
+  long               condensed_timeout = JOB_CONDENSED_TIMEOUT;
+  int                rc = PBSE_NONE;
+  int                i;
+
+  if (svr_authorize_jobreq(preq, template_job) == 0)
+    IsOwner = 1;
+
+  get_svr_attr_l(SRV_ATR_query_others, &query_others);
+  if ((!query_others) &&
+      (IsOwner == 0))
+    return(PBSE_PERM);
+
+  get_svr_attr_l(SRV_ATR_job_full_report_time, &condensed_timeout);
+
+  if ((condensed == true) &&
+      (time(NULL) < template_job->ji_mod_time + condensed_timeout))
+    condensed = false;
+
+  if ((pstat = (struct brp_status *)calloc(1, sizeof(struct brp_status))) == NULL)
+    return(PBSE_SYSTEM);
+
+  CLEAR_LINK(pstat->brp_stlink);
+  pstat->brp_objtype = MGR_OBJ_JOB;
+  subjob_id(template_job->ji_qs.ji_jobid, taskid, pstat->brp_objname, sizeof(pstat->brp_objname));
+  CLEAR_HEAD(pstat->brp_attr);
+
+  append_link(pstathd, &pstat->brp_stlink, pstat);
+
+  for (i = 0; i < JOB_ATR_LAST; i++)
+    clear_attr(&wattr[i], &job_attr_def[i]);
+
+  clone_subjob_attributes(template_job, wattr, taskid);
+
+  /* materialize_array_index() doesn't give it the array's system hold */
+  wattr[JOB_ATR_hold].at_val.at_long &= ~HOLD_a;
+
+  if (wattr[JOB_ATR_hold].at_val.at_long == 0)
+    wattr[JOB_ATR_hold].at_flags &= ~ATR_VFLAG_SET;
+
+  wattr[JOB_ATR_state].at_val.at_char = (wattr[JOB_ATR_hold].at_val.at_long != 0) ? 'H' : 'Q';
+  wattr[JOB_ATR_state].at_flags |= ATR_VFLAG_SET;
+  wattr[JOB_ATR_substate].at_val.at_long = (wattr[JOB_ATR_hold].at_val.at_long != 0) ? JOB_SUBSTATE_HELD : JOB_SUBSTATE_QUEUED;
+  wattr[JOB_ATR_substate].at_flags |= ATR_VFLAG_SET;
+
+  *bad = 0;
+
+  if (status_attrib(
+        pal,
+        job_attr_def,
+        wattr,
+        JOB_ATR_LAST,
+        preq->rq_perm,
+        &pstat->brp_attr,
+        condensed,
+        bad,
+        IsOwner))
+    rc = PBSE_NOATTR;
+
+  for (i = 0; i < JOB_ATR_LAST; i++)
+    job_attr_def[i].at_free(&wattr[i]);
+
+  return(rc);
+  }  /* END status_virtual_subjob() */
+
+
+
 /* Is this dead code? It isn't called anywhere. */
 int add_walltime_remaining(
    
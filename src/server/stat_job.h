@@ -11,6 +11,8 @@
 
 int status_job(job *pjob, struct batch_request *preq, svrattrl *pal, tlist_head *pstathd, int *bad);
 
+int status_virtual_subjob(job *template_job, int taskid, struct batch_request *preq, svrattrl *pal, tlist_head *pstathd, bool condensed, int *bad);
+
 int status_attrib(svrattrl *pal, attribute_def *padef, pbs_attribute *pattr, int limit, int priv, tlist_head *phead, int *bad, int IsOwner);
 
 #endif /* _STAT_JOB_H */
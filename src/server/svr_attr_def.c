@@ -1391,6 +1391,78 @@ attribute_def svr_attr_def[] =
    ATR_TYPE_LONG,
    PARENT_TYPE_SERVER},
 
+  /* SRV_ATR_CommitInterval */
+  {ATTR_commit_interval, /* "commit_interval" */
+   decode_l,
+   encode_l,
+   set_l,
+   comp_l,
+   free_null,
+   NULL_FUNC,
+   MGR_ONLY_SET,
+   ATR_TYPE_LONG,
+   PARENT_TYPE_SERVER},
+
+  /* SRV_ATR_CommitBatchSize */
+  {ATTR_commit_batch_size, /* "commit_batch_size" */
+   decode_l,
+   encode_l,
+   set_l,
+   comp_l,
+   free_null,
+   NULL_FUNC,
+   MGR_ONLY_SET,
+   ATR_TYPE_LONG,
+   PARENT_TYPE_SERVER},
+
+  /* SRV_ATR_BinaryJobImages */
+  {ATTR_binary_job_images, /* "binary_job_images" */
+   decode_b,
+   encode_b,
+   set_b,
+   comp_b,
+   free_null,
+   NULL_FUNC,
+   MGR_ONLY_SET,
+   ATR_TYPE_LONG,
+   PARENT_TYPE_SERVER},
+
+  /* SRV_ATR_VirtualArraySubjobs */
+  {ATTR_virtual_array_subjobs, /* "virtual_array_subjobs" */
+   decode_b,
+   encode_b,
+   set_b,
+   comp_b,
+   free_null,
+   NULL_FUNC,
+   MGR_ONLY_SET,
+   ATR_TYPE_LONG,
+   PARENT_TYPE_SERVER},
+
+  /* SRV_ATR_StatusQueueDepth */
+  {ATTR_status_queue_depth, /* "node_status_queue_depth" */
+   decode_null,
+   encode_l,
+   set_null,
+   comp_l,
+   free_null,
+   NULL_FUNC,
+   READ_ONLY,
+   ATR_TYPE_LONG,
+   PARENT_TYPE_SERVER},
+
+  /* SRV_ATR_StatusQueueLag */
+  {ATTR_status_queue_lag, /* "node_status_queue_lag" */
+   decode_null,
+   encode_l,
+   set_null,
+   comp_l,
+   free_null,
+   NULL_FUNC,
+   READ_ONLY,
+   ATR_TYPE_LONG,
+   PARENT_TYPE_SERVER},
+
 
 
   /* site supplied server pbs_attribute definitions if any, see site_svr_attr_*.h  */
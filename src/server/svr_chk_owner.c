@@ -101,6 +101,7 @@
 #include "net_cache.h"
 #include "../lib/Libnet/lib_net.h"
 #include "ji_mutex.h"
+#include "job_func.h" /* materialize_subjob */
 
 /* Global Data */
 
@@ -651,7 +652,9 @@ job *chk_job_request(
   {
   job *pjob = NULL;
 
-  if ((pjob = svr_find_job(jobid, FALSE)) == NULL)
+  /* a virtual array subjob is made into a job when it is acted on */
+  if (((pjob = svr_find_job(jobid, FALSE)) == NULL) &&
+      ((pjob = materialize_subjob(jobid)) == NULL))
     {
     log_event(
       PBSEVENT_DEBUG,
@@ -143,6 +143,7 @@
 #include "svr_jobfunc.h"
 #include "job_route.h" /*remove_procct */
 #include "mutex_mgr.hpp"
+#include "job_index.h"
 #include <string>
 #include <vector>
 
@@ -294,6 +295,16 @@ const char *PJobSubState[] =
 
 
 
+/*
+ * insert_into_alljobs_by_rank() - places pjob in aj by JOB_ATR_qrank
+ *
+ * aj keeps a rank index beside its list, so the insertion point is found
+ * without locking or even looking at the other jobs in the queue, and pjob
+ * stays locked throughout.
+ *
+ * @return PBSE_NONE, or ALREADY_IN_LIST if pjob is already in aj
+ */
+
 int insert_into_alljobs_by_rank(
 
   all_jobs         *aj,
@@ -301,64 +312,22 @@ int insert_into_alljobs_by_rank(
   char            *jobid)
 
   {
-  job  *pjcur;
-  aj->lock();
-  all_jobs_iterator  *iter = aj->get_iterator(true);
+  int   rc = PBSE_NONE;
   long  job_qrank = pjob->ji_wattr[JOB_ATR_qrank].at_val.at_long;
-  std::string curJobid = "";
-  
-  unlock_ji_mutex(pjob, __func__, "4", LOGLEVEL);
-
-  while ((pjcur = iter->get_next_item()) != NULL)
-    {
-    mutex_mgr pjcur_mgr(pjcur->ji_mutex, true);
-    if (job_qrank > pjcur->ji_wattr[JOB_ATR_qrank].at_val.at_long)
-      {
-      pjcur_mgr.set_unlock_on_exit(false);
-      break;
-      }
-    
-    if (strcmp(jobid, pjcur->ji_qs.ji_jobid) == 0)
-      {
-      delete iter;
-
-      aj->unlock();
-      return(ALREADY_IN_LIST);
-      }
-    }
-
-  delete iter;
 
-  if (pjcur != NULL)
-    {
-    if(aj->find(pjcur->ji_qs.ji_jobid))
-      {
-      curJobid = pjcur->ji_qs.ji_jobid;
-      }
-    unlock_ji_mutex(pjcur, __func__, "8", LOGLEVEL);
-    pjcur = NULL;
-    }
-  aj->unlock();
+  aj->lock();
 
-  if ((pjob = svr_find_job(jobid, FALSE)) == NULL)
+  if (aj->find(jobid) != NULL)
+    rc = ALREADY_IN_LIST;
+  else if (!aj->insert_by_rank(pjob, pjob->ji_qs.ji_jobid, job_qrank))
     {
-    return(PBSE_JOBNOTFOUND);
+    rc = ENOMEM;
+    log_err(rc, __func__, "No memory to resize the array...SYSTEM FAILURE\n");
     }
 
-  aj->lock();
-  if (curJobid.length() == 0)
-    {
-    /* link first in list */
-    aj->insert_first(pjob,pjob->ji_qs.ji_jobid);
-    }
-  else
-    {
-    /* link after 'current' job in list */
-    aj->insert_after(curJobid, pjob,pjob->ji_qs.ji_jobid);
-    }
   aj->unlock();
 
-  return(PBSE_NONE);
+  return(rc);
   } /* END insert_into_alljobs_by_rank() */
 
 
@@ -499,6 +468,8 @@ int svr_enquejob(
       alljobs.insert_after(prev_job_id,pjob,pjob->ji_qs.ji_jobid);
     alljobs.unlock();
 
+    job_index_add(pjob);
+
     if (has_sv_qs_mutex == FALSE)
       {
       lock_sv_qs_mutex(server.sv_qs_mutex, __func__);
@@ -533,8 +504,7 @@ int svr_enquejob(
     {
     rc = insert_into_alljobs_by_rank(pque->qu_jobs, pjob, job_id);
 
-    if ((rc == ALREADY_IN_LIST) ||
-        (rc == PBSE_JOBNOTFOUND))
+    if (rc != PBSE_NONE)
       {
       if (rc == ALREADY_IN_LIST)
         {
@@ -563,8 +533,7 @@ int svr_enquejob(
     {
     rc = insert_into_alljobs_by_rank(pque->qu_jobs_array_sum, pjob, job_id);
 
-    if ((rc == ALREADY_IN_LIST) ||
-        (rc == PBSE_JOBNOTFOUND))
+    if (rc != PBSE_NONE)
       {
       if (rc == ALREADY_IN_LIST)
         rc = PBSE_NONE;
@@ -853,6 +822,8 @@ int svr_dequejob(
   /* the only error is if the job isn't present */
   if ((rc = remove_job(&alljobs, pjob)) == PBSE_NONE)
     {
+    job_index_remove(pjob->ji_qs.ji_jobid);
+
     if (!pjob->ji_is_array_template)
       {
       lock_sv_qs_mutex(server.sv_qs_mutex, __func__);
@@ -3436,6 +3407,9 @@ void set_statechar(
       pjob->ji_wattr[JOB_ATR_state].at_val.at_char = 'U'; /* Unknown */
       }
     }
+
+  /* keep qselect's state index in step */
+  job_index_set_state(pjob);
   
   return;
   }  /* END set_statechar() */
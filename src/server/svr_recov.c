@@ -111,6 +111,7 @@
 #include "pbs_error.h"
 #include "resource.h"
 #include "utils.h"
+#include "group_commit.h" /* mark_file_dirty */
 #include <string>
 
 #ifndef MAXLINE
@@ -468,7 +469,7 @@ int svr_save_xml(
     }
 
   lock_sv_qs_mutex(server.sv_qs_mutex, __func__);
-  fds = open(tmp_file, O_WRONLY | O_CREAT | O_Sync | O_TRUNC, 0600);
+  fds = open(tmp_file, O_WRONLY | O_CREAT | O_TRUNC, 0600);
 
   if (fds < 0)
     {
@@ -533,6 +534,8 @@ int svr_save_xml(
     {
     rc = PBSE_CAN_NOT_MOVE_FILE;
     }
+  else
+    mark_file_dirty(path_svrdb);
 
   sprintf(log_buf, "%s:5", __func__);
   unlock_sv_qs_mutex(server.sv_qs_mutex, log_buf);
@@ -615,7 +618,7 @@ int save_acl(
   snprintf(filename2, sizeof(filename2), "%s.new",
     filename1);
 
-  fds = open(filename2, O_WRONLY | O_CREAT | O_TRUNC | O_Sync, 0600);
+  fds = open(filename2, O_WRONLY | O_CREAT | O_TRUNC, 0600);
 
   if (fds < 0)
     {
@@ -677,6 +680,8 @@ int save_acl(
 
   unlink(filename2);
 
+  mark_file_dirty(filename1);
+
   attr->at_flags &= ~ATR_VFLAG_MODIFY; /* clear modified flag */
 
   return(0);
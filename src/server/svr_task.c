@@ -89,7 +89,7 @@
  */
 
 #include <pbs_config.h>   /* the master config generated by configure */
-#include <list>
+#include <vector>
 
 #include "portability.h"
 #include <stdlib.h>
@@ -108,38 +108,195 @@ extern void check_nodes(struct work_task *);
 
 /* Global Data Items: */
 
-std::list<timed_task>  *task_list_timed;
+timed_task_heap        *task_list_timed;
 extern pthread_mutex_t  task_list_timed_mutex;
 extern task_recycler    tr;
 
 
 
-void insert_timed_task(
+bool timed_task_heap::earlier(
+
+  size_t a,
+  size_t b) const
+
+  {
+  if (this->heap[a].task_time != this->heap[b].task_time)
+    return(this->heap[a].task_time < this->heap[b].task_time);
+
+  return(this->heap[a].seq < this->heap[b].seq);
+  } /* END earlier() */
+
+
+
+void timed_task_heap::swap_entries(
+
+  size_t a,
+  size_t b)
+
+  {
+  timed_task tmp = this->heap[a];
+
+  this->heap[a] = this->heap[b];
+  this->heap[b] = tmp;
+
+  this->heap[a].wt->wt_timed_index = a + 1;
+  this->heap[b].wt->wt_timed_index = b + 1;
+  } /* END swap_entries() */
+
+
+
+void timed_task_heap::sift_up(
+
+  size_t i)
+
+  {
+  while (i > 0)
+    {
+    size_t parent = (i - 1) / 2;
+
+    if (!this->earlier(i, parent))
+      break;
+
+    this->swap_entries(i, parent);
+    i = parent;
+    }
+  } /* END sift_up() */
+
+
+
+void timed_task_heap::sift_down(
+
+  size_t i)
+
+  {
+  size_t count = this->heap.size();
+
+  for (;;)
+    {
+    size_t left = 2 * i + 1;
+    size_t right = left + 1;
+    size_t first = i;
+
+    if ((left < count) &&
+        (this->earlier(left, first)))
+      first = left;
+
+    if ((right < count) &&
+        (this->earlier(right, first)))
+      first = right;
+
+    if (first == i)
+      break;
+
+    this->swap_entries(i, first);
+    i = first;
+    }
+  } /* END sift_down() */
+
+
+
+void timed_task_heap::push(
 
   work_task *wt)
 
   {
-  std::list<timed_task>::iterator it;
-  bool                            inserted = false;
-  timed_task                      tt;
+  timed_task tt;
 
   tt.wt = wt;
   tt.task_time = wt->wt_event;
+  tt.seq = this->next_seq++;
 
-  pthread_mutex_lock(&task_list_timed_mutex);
+  this->heap.push_back(tt);
+  wt->wt_timed_index = this->heap.size();
+
+  this->sift_up(this->heap.size() - 1);
+  } /* END push() */
+
+
+
+/*
+ * remove - take wt out of the heap wherever it is
+ *
+ * @return true if wt was queued, false otherwise
+ */
+
+bool timed_task_heap::remove(
+
+  work_task *wt)
+
+  {
+  size_t i;
+  size_t last;
+
+  if ((wt->wt_timed_index == 0) ||
+      (wt->wt_timed_index > this->heap.size()))
+    return(false);
+
+  i = wt->wt_timed_index - 1;
+
+  if (this->heap[i].wt != wt)
+    return(false);
 
-  for (it = task_list_timed->begin(); it != task_list_timed->end(); it++)
+  last = this->heap.size() - 1;
+
+  if (i != last)
+    this->swap_entries(i, last);
+
+  this->heap.pop_back();
+  wt->wt_timed_index = 0;
+
+  if (i < this->heap.size())
     {
-    if (it->task_time >= tt.task_time)
-      {
-      task_list_timed->insert(it, tt);
-      inserted = true;
-      break;
-      }
+    this->sift_down(i);
+    this->sift_up(i);
     }
 
-  if (inserted == false)
-    task_list_timed->push_back(tt);
+  return(true);
+  } /* END remove() */
+
+
+
+/*
+ * pop_expired - remove and return the earliest task if it is due by time_now
+ *
+ * @return the task or NULL if no task is due
+ */
+
+work_task *timed_task_heap::pop_expired(
+
+  time_t time_now)
+
+  {
+  work_task *wt;
+
+  if ((this->heap.size() == 0) ||
+      (this->heap[0].task_time > time_now))
+    return(NULL);
+
+  wt = this->heap[0].wt;
+  this->remove(wt);
+
+  return(wt);
+  } /* END pop_expired() */
+
+
+
+size_t timed_task_heap::size() const
+
+  {
+  return(this->heap.size());
+  } /* END size() */
+
+
+
+void insert_timed_task(
+
+  work_task *wt)
+
+  {
+  pthread_mutex_lock(&task_list_timed_mutex);
+
+  task_list_timed->push(wt);
 
   pthread_mutex_unlock(&task_list_timed_mutex);
   } /* END insert_timed_task() */
@@ -151,21 +308,11 @@ work_task *pop_timed_task(
   time_t  time_now)
 
   {
-  struct work_task                *wt = NULL;
-  std::list<timed_task>::iterator  it;
+  struct work_task *wt;
 
   pthread_mutex_lock(&task_list_timed_mutex);
 
-  if (task_list_timed->begin() != task_list_timed->end())
-    {
-    it = task_list_timed->begin();
-
-    if (it->task_time <= time_now)
-      {
-      wt = it->wt;
-      task_list_timed->pop_front();
-      }
-    }
+  wt = task_list_timed->pop_expired(time_now);
   
   pthread_mutex_unlock(&task_list_timed_mutex);
 
@@ -174,6 +321,81 @@ work_task *pop_timed_task(
 
 
 
+/*
+ * pop_expired_timed_tasks - remove every task due by time_now in one pass
+ *
+ * @param time_now - the current time
+ * @param expired - receives the due tasks in the order they should run
+ * @return the number of tasks popped
+ */
+
+int pop_expired_timed_tasks(
+
+  time_t                    time_now,
+  std::vector<work_task *> &expired)
+
+  {
+  work_task *wt;
+  int        count = 0;
+
+  pthread_mutex_lock(&task_list_timed_mutex);
+
+  while ((wt = task_list_timed->pop_expired(time_now)) != NULL)
+    {
+    /* delete_task() mustn't recycle it while it waits in the batch */
+    wt->wt_timed_index = TIMED_TASK_DISPATCHING;
+    expired.push_back(wt);
+    count++;
+    }
+
+  pthread_mutex_unlock(&task_list_timed_mutex);
+
+  return(count);
+  } /* END pop_expired_timed_tasks() */
+
+
+
+/*
+ * claim_timed_task - take a task popped by pop_expired_timed_tasks() for
+ * dispatch or requeueing
+ *
+ * A task that delete_task() cancelled while it waited in the batch is
+ * recycled here instead, since delete_task() left it to us.
+ *
+ * @param wt - the task, unlocked
+ * @return true with wt locked, or false if wt was cancelled and recycled
+ */
+
+bool claim_timed_task(
+
+  work_task *wt)
+
+  {
+  bool cancelled;
+
+  pthread_mutex_lock(wt->wt_mutex);
+  pthread_mutex_lock(&task_list_timed_mutex);
+
+  cancelled = (wt->wt_timed_index == TIMED_TASK_CANCELLED);
+
+  if (cancelled == false)
+    wt->wt_timed_index = 0;
+
+  pthread_mutex_unlock(&task_list_timed_mutex);
+
+  if (cancelled == true)
+    {
+    insert_task_into_recycler(wt);
+    pthread_mutex_unlock(wt->wt_mutex);
+
+    return(false);
+    }
+
+  return(true);
+  } /* END claim_timed_task() */
+
+
+
 /*
  * set_task - add the job entry to the task list
  *
@@ -338,6 +560,31 @@ void delete_task(
   if (ptask->wt_tasklist)
     remove_task(ptask->wt_tasklist,ptask);
 
+  /* cancel the timer if it hasn't fired yet */
+  if (ptask->wt_timed_index != 0)
+    {
+    bool in_dispatch = false;
+
+    pthread_mutex_lock(&task_list_timed_mutex);
+
+    if (ptask->wt_timed_index == TIMED_TASK_DISPATCHING)
+      {
+      /* check_tasks() has it in its batch and recycles it when it gets to it */
+      ptask->wt_timed_index = TIMED_TASK_CANCELLED;
+      in_dispatch = true;
+      }
+    else
+      task_list_timed->remove(ptask);
+
+    pthread_mutex_unlock(&task_list_timed_mutex);
+
+    if (in_dispatch == true)
+      {
+      pthread_mutex_unlock(ptask->wt_mutex);
+      return;
+      }
+    }
+
   /* put the task in the recycler */
   insert_task_into_recycler(ptask);
 
@@ -9,6 +9,7 @@
 #include "work_task.h" /* work_task */
 #include "array.h" /* job_array */
 #include "server.h" /* server */
+#include "threadpool.h" /* threadpool_t */
 
 const char *text_name              = "text";
 
@@ -102,8 +103,11 @@ int attempt_delete(void *j)
 
 void append_link(tlist_head *head, list_link *new_link, void *pobj)
   {
-  fprintf(stderr, "The call to append_link needs to be mocked!!\n");
-  exit(1);
+  new_link->ll_struct = pobj;
+  new_link->ll_prior = head->ll_prior;
+  new_link->ll_next = head;
+  head->ll_prior = new_link;
+  new_link->ll_prior->ll_next = new_link;
   }
 
 bool set_array_depend_holds(job_array *pa)
@@ -138,19 +142,38 @@ char *get_correct_jobname(const char *jobid)
 
 void *get_prior(list_link pl, char *file, int line)
   {
-  fprintf(stderr, "The call to get_prior needs to be mocked!!\n");
-  exit(1);
+  if (pl.ll_prior == NULL)
+    return(NULL);
+
+  return(pl.ll_prior->ll_struct);
   }
 
 void insert_link(struct list_link *old, struct list_link *new_link, void *pobj, int position)
   {
-  fprintf(stderr, "The call to insert_link needs to be mocked!!\n");
-  exit(1);
+  if (position == LINK_INSET_AFTER)
+    {
+    new_link->ll_prior = old;
+    new_link->ll_next = old->ll_next;
+    old->ll_next->ll_prior = new_link;
+    old->ll_next = new_link;
+    }
+  else
+    {
+    new_link->ll_next = old;
+    new_link->ll_prior = old->ll_prior;
+    old->ll_prior->ll_next = new_link;
+    old->ll_prior = new_link;
+    }
+
+  new_link->ll_struct = pobj;
   }
 
 void *get_next(list_link pl, char *file, int line)
   {
-  return(pl.ll_next);
+  if (pl.ll_next == NULL)
+    return(NULL);
+
+  return(pl.ll_next->ll_struct);
   }
 
 char *threadsafe_tokenizer(char **str, const char *delims)
@@ -193,10 +216,18 @@ char *threadsafe_tokenizer(char **str, const char *delims)
   return(start);
   }
 
+bool virtual_subjobs = false;
+
 int get_svr_attr_l(int attr_index, long *l)
   {
   static int count = 0;
 
+  if (attr_index == SRV_ATR_VirtualArraySubjobs)
+    {
+    *l = virtual_subjobs;
+    return(0);
+    }
+
   if (attr_index == SRV_ATR_MaxSlotLimit)
     {
     count++;
@@ -295,3 +326,22 @@ int unlock_ss()
     }
 
 
+
+unsigned long mark_file_dirty(const char *path) {return(0);}
+
+threadpool_t *task_pool;
+
+int enqueue_threadpool_request(void *(*func)(void *), void *arg, threadpool_t *tp)
+  {
+  return(0);
+  }
+
+void *job_clone_wt(void *vp)
+  {
+  return(NULL);
+  }
+
+job *materialize_array_index(job_array **pa_ptr, int index)
+  {
+  return(NULL);
+  }
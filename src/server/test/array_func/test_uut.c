@@ -13,9 +13,11 @@ int array_request_parse_token(char *, int *, int *);
 int num_array_jobs(const char *str);
 int array_recov_binary(char *path, job_array **new_pa, char *log_buf, size_t buflen);
 int parse_array_dom(job_array **pa, xmlNodePtr root_element, char *log_buf, size_t buflen);
+int parse_array_request(char *request, tlist_head *tl);
 
 const char *array_sample = "<array>\n</array>";
 extern char *path_arrays;
+extern bool  virtual_subjobs;
 
 
 START_TEST(parse_array_dom_test)
@@ -205,6 +207,107 @@ END_TEST
 
 
 
+START_TEST(virtual_index_test)
+  {
+  job_array           pa;
+  array_request_node *rn;
+  int                 count = 0;
+
+  memset(&pa, 0, sizeof(pa));
+  CLEAR_HEAD(pa.request_tokens);
+  fail_unless(parse_array_request(strdup("0-9,20-29"), &pa.request_tokens) == 0);
+
+  /* indices come out lowest first */
+  fail_unless(array_next_virtual_index(&pa) == 0);
+  fail_unless(array_next_virtual_index(&pa) == 1);
+
+  /* dropping from the middle of a token splits it */
+  fail_unless(array_drop_virtual_range(&pa, 4, 5) == 2);
+  rn = (array_request_node *)GET_NEXT(pa.request_tokens);
+  fail_unless((rn->start == 2) && (rn->end == 3));
+  rn = (array_request_node *)GET_NEXT(rn->request_tokens_link);
+  fail_unless((rn->start == 6) && (rn->end == 9));
+
+  /* a range across tokens trims both and drops nothing twice */
+  fail_unless(array_drop_virtual_range(&pa, 8, 21) == 4);
+  fail_unless(array_drop_virtual_range(&pa, 8, 21) == 0);
+  fail_unless(array_drop_virtual_range(&pa, 3, 3) == 1);
+
+  /* 2, 6, 7 and 22-29 are left */
+  fail_unless(array_index_is_virtual(&pa, 2) == true);
+  fail_unless(array_index_is_virtual(&pa, 5) == false);
+  fail_unless(array_index_is_virtual(&pa, 29) == true);
+  fail_unless(array_index_is_virtual(&pa, 30) == false);
+  fail_unless(array_next_virtual_index(&pa) == 2);
+  fail_unless(array_next_virtual_index(&pa) == 6);
+  fail_unless(array_next_virtual_index(&pa) == 7);
+
+  while (array_next_virtual_index(&pa) >= 0)
+    count++;
+
+  fail_unless(count == 8);
+  fail_unless(GET_NEXT(pa.request_tokens) == NULL);
+
+  /* without virtual subjobs the whole array is cloned at once */
+  fail_unless(array_materialize_budget(&pa) == INT_MAX);
+
+  /* an index that couldn't be cloned goes back in order */
+  fail_unless(array_restore_virtual_index(&pa, 7) == PBSE_NONE);
+  fail_unless(array_restore_virtual_index(&pa, 3) == PBSE_NONE);
+  fail_unless(array_restore_virtual_index(&pa, 5) == PBSE_NONE);
+  fail_unless(array_restore_virtual_index(&pa, 4) == PBSE_NONE);
+  fail_unless(array_restore_virtual_index(&pa, 8) == PBSE_NONE);
+  fail_unless(array_restore_virtual_index(&pa, 4) == PBSE_NONE);
+  fail_unless(array_count_virtual_indices(&pa) == 5);
+  fail_unless(array_next_virtual_index(&pa) == 3);
+  fail_unless(array_next_virtual_index(&pa) == 4);
+  fail_unless(array_next_virtual_index(&pa) == 5);
+  fail_unless(array_next_virtual_index(&pa) == 7);
+  fail_unless(array_next_virtual_index(&pa) == 8);
+  fail_unless(array_next_virtual_index(&pa) == -1);
+  }
+END_TEST
+
+
+
+START_TEST(materialize_budget_test)
+  {
+  job_array pa;
+
+  memset(&pa, 0, sizeof(pa));
+  CLEAR_HEAD(pa.request_tokens);
+  fail_unless(parse_array_request(strdup("0-99999"), &pa.request_tokens) == 0);
+  pa.ai_qs.num_jobs = 100000;
+  pa.ai_qs.slot_limit = NO_SLOT_LIMIT;
+  virtual_subjobs = true;
+
+  /* nothing cloned yet */
+  fail_unless(array_materialize_budget(&pa) == VIRTUAL_SUBJOB_WINDOW);
+
+  /* 300 cloned, 40 of them running and 10 done */
+  for (int i = 0; i < 300; i++)
+    array_next_virtual_index(&pa);
+
+  pa.ai_qs.num_cloned = 300;
+  pa.ai_qs.jobs_running = 40;
+  pa.ai_qs.jobs_done = 10;
+  fail_unless(array_materialize_budget(&pa) == VIRTUAL_SUBJOB_WINDOW - 250);
+
+  /* subjobs deleted while still virtual are done but were never cloned */
+  fail_unless(array_drop_virtual_range(&pa, 1000, 1999) == 1000);
+  pa.ai_qs.jobs_done += 1000;
+  fail_unless(array_materialize_budget(&pa) == VIRTUAL_SUBJOB_WINDOW - 250);
+
+  /* the slot limit caps what may be queued or running */
+  pa.ai_qs.slot_limit = 100;
+  fail_unless(array_materialize_budget(&pa) == 100 - 40 - 250);
+
+  virtual_subjobs = false;
+  }
+END_TEST
+
+
+
 
 Suite *array_func_suite(void)
   {
@@ -242,6 +345,14 @@ Suite *array_func_suite(void)
   tcase_add_test(tc_core, array_recov_binary_test);
   suite_add_tcase(s, tc_core);
 
+  tc_core = tcase_create("virtual_index_test");
+  tcase_add_test(tc_core, virtual_index_test);
+  suite_add_tcase(s, tc_core);
+
+  tc_core = tcase_create("materialize_budget_test");
+  tcase_add_test(tc_core, materialize_budget_test);
+  suite_add_tcase(s, tc_core);
+
   return s;
   }
 
@@ -0,0 +1,110 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <check.h>
+
+#include "capacity_index.hpp"
+
+
+START_TEST(test_buckets)
+  {
+  capacity_index ci;
+  prop_bitset    nodes;
+
+  ci.nodes_with_free(0, nodes);
+  fail_unless(prop_bitset_next(nodes, -1) == -1);
+  fail_unless(ci.get_node_free(3) == -1);
+
+  ci.set_node_free(3, 4);
+  ci.set_node_free(70, 16);
+  ci.set_node_free(5, 0);
+  ci.set_node_free(9, -1);
+
+  fail_unless(ci.get_node_free(3) == 4);
+  fail_unless(ci.get_node_free(9) == -1);
+
+  ci.nodes_with_free(0, nodes);
+  fail_unless(prop_bitset_next(nodes, -1) == 3);
+  fail_unless(prop_bitset_next(nodes, 3) == 5);
+  fail_unless(prop_bitset_next(nodes, 5) == 70);
+  fail_unless(prop_bitset_next(nodes, 70) == -1);
+
+  ci.nodes_with_free(4, nodes);
+  fail_unless(prop_bitset_next(nodes, -1) == 3);
+  fail_unless(prop_bitset_next(nodes, 3) == 70);
+  fail_unless(prop_bitset_next(nodes, 70) == -1);
+
+  ci.nodes_with_free(5, nodes);
+  fail_unless(prop_bitset_next(nodes, -1) == 70);
+  fail_unless(prop_bitset_next(nodes, 70) == -1);
+
+  ci.nodes_with_free(17, nodes);
+  fail_unless(prop_bitset_next(nodes, -1) == -1);
+  }
+END_TEST
+
+
+
+
+START_TEST(test_moves)
+  {
+  capacity_index ci;
+  prop_bitset    nodes;
+
+  ci.set_node_free(1, 8);
+  ci.set_node_free(2, 8);
+
+  // node 1 takes a 6 slot job
+  ci.set_node_free(1, 2);
+  ci.nodes_with_free(4, nodes);
+  fail_unless(prop_bitset_next(nodes, -1) == 2);
+  fail_unless(prop_bitset_next(nodes, 2) == -1);
+
+  // node 2 goes down
+  ci.set_node_free(2, -1);
+  ci.nodes_with_free(1, nodes);
+  fail_unless(prop_bitset_next(nodes, -1) == 1);
+  fail_unless(prop_bitset_next(nodes, 1) == -1);
+
+  // both come back empty
+  ci.set_node_free(1, 8);
+  ci.set_node_free(2, 8);
+  ci.nodes_with_free(8, nodes);
+  fail_unless(prop_bitset_next(nodes, -1) == 1);
+  fail_unless(prop_bitset_next(nodes, 1) == 2);
+  fail_unless(prop_bitset_next(nodes, 2) == -1);
+  }
+END_TEST
+
+
+
+
+Suite *capacity_index_suite(void)
+  {
+  Suite *s = suite_create("capacity_index test suite methods");
+  TCase *tc_core = tcase_create("test_buckets");
+  tcase_add_test(tc_core, test_buckets);
+  suite_add_tcase(s, tc_core);
+  
+  tc_core = tcase_create("test_moves");
+  tcase_add_test(tc_core, test_moves);
+  suite_add_tcase(s, tc_core);
+  
+  return(s);
+  }
+
+void rundebug()
+  {
+  }
+
+int main(void)
+  {
+  int number_failed = 0;
+  SRunner *sr = NULL;
+  rundebug();
+  sr = srunner_create(capacity_index_suite());
+  srunner_set_log(sr, "capacity_index_suite.log");
+  srunner_run_all(sr, CK_NORMAL);
+  number_failed = srunner_ntests_failed(sr);
+  srunner_free(sr);
+  return(number_failed);
+  }
@@ -1,6 +1,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <check.h>
+#include <vector>
 
 
 #include "execution_slot_tracker.hpp"
@@ -193,6 +194,89 @@ START_TEST(test_occupied_iterator)
 END_TEST
 
 
+START_TEST(test_wide_nodes)
+  {
+  int widths[] = { 64, 256, 1024 };
+
+  for (int w = 0; w < 3; w++)
+    {
+    int                                 width = widths[w];
+    execution_slot_tracker              node(width);
+    std::vector<execution_slot_tracker> jobs(width / 8);
+
+    // fill the node with 8 slot jobs
+    for (unsigned int j = 0; j < jobs.size(); j++)
+      {
+      fail_unless(node.reserve_execution_slots(8, jobs[j]) == PBSE_NONE);
+      fail_unless(jobs[j].get_total_execution_slots() == width);
+      fail_unless(jobs[j].get_number_free() == width - 8);
+      }
+
+    fail_unless(node.get_number_free() == 0);
+    fail_unless(node.reserve_execution_slots(1, jobs[0]) == INSUFFICIENT_FREE_EXECUTION_SLOTS);
+
+    // the last job has the last 8 slots
+    int iter = -1;
+    fail_unless(jobs.back().get_next_occupied_index(iter) == width - 8);
+
+    // free every other job and take the space back with one wide job
+    for (unsigned int j = 0; j < jobs.size(); j += 2)
+      fail_unless(node.unreserve_execution_slots(jobs[j]) == PBSE_NONE);
+
+    fail_unless(node.get_number_free() == width / 2);
+
+    execution_slot_tracker wide;
+    fail_unless(node.reserve_execution_slots(width / 2, wide) == PBSE_NONE);
+    fail_unless(node.get_number_free() == 0);
+
+    iter = -1;
+    fail_unless(wide.get_next_occupied_index(iter) == 0);
+    fail_unless(wide.get_next_occupied_index(iter) == 1);
+
+    for (int i = 0; i < width; i++)
+      fail_unless(wide.is_occupied(i) == ((i / 8) % 2 == 0));
+
+    node.unreserve_execution_slots(wide);
+
+    for (unsigned int j = 1; j < jobs.size(); j += 2)
+      node.unreserve_execution_slots(jobs[j]);
+
+    fail_unless(node.get_number_free() == width);
+
+    iter = -1;
+    fail_unless(node.get_next_occupied_index(iter) == -1);
+    }
+  }
+END_TEST
+
+
+START_TEST(test_remove_slot)
+  {
+  execution_slot_tracker est(70);
+
+  est.mark_as_used(69);
+  est.mark_as_used(3);
+  fail_unless(est.get_number_free() == 68);
+
+  fail_unless(est.remove_execution_slot() == PBSE_NONE);
+  fail_unless(est.get_total_execution_slots() == 69);
+  fail_unless(est.get_number_free() == 68);
+  fail_unless(est.is_occupied(69) == false);
+
+  fail_unless(est.remove_execution_slot() == PBSE_NONE);
+  fail_unless(est.get_number_free() == 67);
+
+  // growing again gives back free slots
+  est.add_execution_slot();
+  fail_unless(est.is_occupied(68) == false);
+  fail_unless(est.get_number_free() == 68);
+
+  execution_slot_tracker empty;
+  fail_unless(empty.remove_execution_slot() != PBSE_NONE);
+  }
+END_TEST
+
+
 Suite *execution_slot_tracker_suite(void)
   {
   Suite *s = suite_create("execution_slot_tracker test suite methods");
@@ -206,6 +290,8 @@ Suite *execution_slot_tracker_suite(void)
   tcase_add_test(tc_core, test_reserving);
   tcase_add_test(tc_core, test_occupied_iterator);
   tcase_add_test(tc_core, test_reserve_slot);
+  tcase_add_test(tc_core, test_wide_nodes);
+  tcase_add_test(tc_core, test_remove_slot);
   suite_add_tcase(s, tc_core);
   
   return(s);
@@ -0,0 +1,12 @@
+#include <stdlib.h>
+#include <stdio.h>
+
+bool exit_called = false;
+int LOGLEVEL;
+
+int get_svr_attr_l(int index, long *l)
+  {
+  return(-1);
+  }
+
+void log_err(int errnum, const char *routine, const char *text) {}
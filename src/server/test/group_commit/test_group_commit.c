@@ -0,0 +1,162 @@
+#include "pbs_config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+
+#include "group_commit.h"
+#include "pbs_error.h"
+#include <check.h>
+
+
+void write_file(const char *path)
+  {
+  int fds = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+
+  write(fds, "x", 1);
+  close(fds);
+  }
+
+
+void *mark_and_wait(void *vp)
+  {
+  char           path[64];
+  commit_ticket  ticket;
+  long           i = (long)vp;
+
+  snprintf(path, sizeof(path), "/tmp/group_commit_test.%ld", i);
+  write_file(path);
+
+  ticket = mark_file_dirty(path);
+
+  if (wait_for_commit(ticket) != PBSE_NONE)
+    return((void *)1);
+
+  unlink(path);
+
+  return(NULL);
+  }
+
+
+START_TEST(mark_and_wait_test)
+  {
+  commit_ticket t1;
+  commit_ticket t2;
+
+  set_group_commit_params(0, 0);
+
+  write_file("/tmp/group_commit_test.a");
+  t1 = mark_file_dirty("/tmp/group_commit_test.a");
+  t2 = mark_file_dirty("/tmp/group_commit_test.a");
+  fail_unless(t2 > t1);
+
+  fail_unless(wait_for_commit(t2) == PBSE_NONE);
+
+  // older tickets are covered by the same commit
+  fail_unless(wait_for_commit(t1) == PBSE_NONE);
+  fail_unless(wait_for_commit(0) == PBSE_NONE);
+
+  // a file removed before its commit has nothing left to sync
+  t1 = mark_file_dirty("/tmp/group_commit_test.a");
+  unlink("/tmp/group_commit_test.a");
+  fail_unless(wait_for_commit(t1) == PBSE_NONE);
+
+  fail_unless(flush_dirty_files() == PBSE_NONE);
+  }
+END_TEST
+
+
+START_TEST(failed_commit_test)
+  {
+  commit_ticket bad;
+  commit_ticket later_bad;
+  commit_ticket good;
+
+  write_file("/tmp/group_commit_test.f");
+
+  // a path under a regular file can't be opened to sync
+  bad = mark_file_dirty("/tmp/group_commit_test.f/child");
+#if TDISABLEFILESYNC
+  fail_unless(wait_for_commit(bad) == PBSE_NONE);
+#else
+  fail_unless(wait_for_commit(bad) == -1);
+#endif
+
+  good = mark_file_dirty("/tmp/group_commit_test.f");
+  fail_unless(wait_for_commit(good) == PBSE_NONE);
+
+  // a failed batch is still reported after later batches commit
+  later_bad = mark_file_dirty("/tmp/group_commit_test.f/child");
+  wait_for_commit(later_bad);
+  good = mark_file_dirty("/tmp/group_commit_test.f");
+  fail_unless(wait_for_commit(good) == PBSE_NONE);
+
+#if TDISABLEFILESYNC
+  fail_unless(wait_for_commit(bad) == PBSE_NONE);
+  fail_unless(wait_for_commit(later_bad) == PBSE_NONE);
+#else
+  fail_unless(wait_for_commit(bad) == -1);
+  fail_unless(wait_for_commit(later_bad) == -1);
+  fail_unless(wait_for_commit(later_bad - 1) == PBSE_NONE);
+#endif
+
+  unlink("/tmp/group_commit_test.f");
+  }
+END_TEST
+
+
+START_TEST(concurrent_commit_test)
+  {
+  pthread_t threads[16];
+  void     *rc;
+
+  set_group_commit_params(1000, 4);
+
+  for (long i = 0; i < 16; i++)
+    pthread_create(threads + i, NULL, mark_and_wait, (void *)i);
+
+  for (int i = 0; i < 16; i++)
+    {
+    pthread_join(threads[i], &rc);
+    fail_unless(rc == NULL);
+    }
+
+  set_group_commit_params(0, 0);
+  }
+END_TEST
+
+
+Suite *group_commit_suite(void)
+  {
+  Suite *s = suite_create("group_commit_suite methods");
+  TCase *tc_core = tcase_create("mark_and_wait_test");
+  tcase_add_test(tc_core, mark_and_wait_test);
+  tcase_add_test(tc_core, failed_commit_test);
+  suite_add_tcase(s, tc_core);
+
+  tc_core = tcase_create("concurrent_commit_test");
+  tcase_add_test(tc_core, concurrent_commit_test);
+  suite_add_tcase(s, tc_core);
+
+  return(s);
+  }
+
+void rundebug()
+  {
+  }
+
+int main(void)
+  {
+  int number_failed = 0;
+  SRunner *sr = NULL;
+  rundebug();
+  sr = srunner_create(group_commit_suite());
+  srunner_set_log(sr, "group_commit_suite.log");
+  srunner_run_all(sr, CK_NORMAL);
+  number_failed = srunner_ntests_failed(sr);
+  srunner_free(sr);
+  return(number_failed);
+  }
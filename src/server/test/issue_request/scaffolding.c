@@ -111,12 +111,11 @@ int enqueue_threadpool_request(
   }
 
 
-int insert_timed_task(
+void insert_timed_task(
 
     work_task *wt)
 
   {
-  return(PBSE_NONE);
   }
 
 
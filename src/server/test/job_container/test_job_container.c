@@ -4,6 +4,7 @@
 #include "pbs_job.h"
 #include "pbs_error.h"
 #include <check.h>
+#include <pthread.h>
 
 char *get_correct_jobname(const char *jobid);
 
@@ -90,6 +91,61 @@ START_TEST(insert_job_after_test)
   }
 END_TEST
 
+START_TEST(insert_by_rank_test)
+  {
+  all_jobs    aj;
+  long        ranks[] = {30, 10, 20, 20, 40, 20};
+  const char *ids[] = {"j0", "j1", "j2", "j3", "j4", "j5"};
+  const char *order1[] = {"j1", "j3", "j2", "j0", "j4"};
+  const char *order2[] = {"j1", "j5", "j2", "j0", "j4"};
+  job        *pjob;
+  int         i;
+
+  aj.lock();
+
+  for (i = 0; i < 5; i++)
+    {
+    pjob = job_alloc();
+    strcpy(pjob->ji_qs.ji_jobid, ids[i]);
+    fail_unless(aj.insert_by_rank(pjob, ids[i], ranks[i]) == true);
+    }
+
+  /* an id can only be ranked once */
+  fail_unless(aj.insert_by_rank(pjob, ids[4], 50) == false);
+  fail_unless(aj.count() == 5);
+
+  all_jobs_iterator *iter = aj.get_iterator();
+  for (i = 0; (pjob = iter->get_next_item()) != NULL; i++)
+    fail_unless(!strcmp(pjob->ji_qs.ji_jobid, order1[i]), "position %d is %s", i, pjob->ji_qs.ji_jobid);
+  fail_unless(i == 5);
+  delete iter;
+
+  /* removing a job takes it out of the rank index too */
+  aj.remove(ids[3]);
+  pjob = job_alloc();
+  strcpy(pjob->ji_qs.ji_jobid, ids[5]);
+  fail_unless(aj.insert_by_rank(pjob, ids[5], ranks[5]) == true);
+
+  iter = aj.get_iterator();
+  for (i = 0; (pjob = iter->get_next_item()) != NULL; i++)
+    fail_unless(!strcmp(pjob->ji_qs.ji_jobid, order2[i]), "position %d is %s", i, pjob->ji_qs.ji_jobid);
+  fail_unless(i == 5);
+  delete iter;
+
+  /* jobs ranked ahead of everything go first */
+  pjob = job_alloc();
+  strcpy(pjob->ji_qs.ji_jobid, "j6");
+  fail_unless(aj.insert_by_rank(pjob, "j6", 1) == true);
+  iter = aj.get_iterator();
+  pjob = iter->get_next_item();
+  fail_unless(!strcmp(pjob->ji_qs.ji_jobid, "j6"));
+  delete iter;
+
+  aj.clear();
+  aj.unlock();
+  }
+END_TEST
+
 START_TEST(insert_job_first_test)
   {
   all_jobs alljobs;
@@ -258,6 +314,229 @@ START_TEST(find_job_by_array_with_removed_record_test)
   }
 END_TEST
 
+START_TEST(snapshot_iterator_test)
+  {
+  all_jobs  alljobs;
+  job      *jobs[5];
+  job      *pjob;
+  job      *late_job;
+  int       jobcount = 0;
+
+  for (int i = 0; i < 5; i++)
+    {
+    jobs[i] = job_alloc();
+    sprintf(jobs[i]->ji_qs.ji_jobid, "%d.napali", i);
+    fail_unless(insert_job(&alljobs, jobs[i]) == PBSE_NONE);
+    }
+
+  all_jobs_iterator *iter;
+  alljobs.lock();
+  iter = alljobs.get_snapshot_iterator();
+  alljobs.unlock();
+
+  fail_unless(iter->is_snapshot() == true);
+
+  /* changes after the snapshot: the removed job must be skipped and the
+   * new one isn't part of this scan */
+  fail_unless(remove_job(&alljobs, jobs[2]) == PBSE_NONE);
+  late_job = job_alloc();
+  strcpy(late_job->ji_qs.ji_jobid, "5.napali");
+  fail_unless(insert_job(&alljobs, late_job) == PBSE_NONE);
+
+  while ((pjob = next_job(&alljobs, iter)) != NULL)
+    {
+    fail_unless(pjob != jobs[2], "snapshot returned a removed job");
+    fail_unless(pjob != late_job);
+    jobcount++;
+    }
+
+  fail_unless(jobcount == 4, "Expected 4 jobs, got %d", jobcount);
+  delete iter;
+
+  /* lookups go through the sharded index */
+  fail_unless(find_job_by_array(&alljobs, "2.napali", FALSE, false) == NULL);
+  fail_unless(find_job_by_array(&alljobs, "5.napali", FALSE, false) == late_job);
+  fail_unless(find_job_by_array(&alljobs, "3.napali", FALSE, false) == jobs[3]);
+
+  /* a fresh snapshot sees the current contents */
+  alljobs.lock();
+  iter = alljobs.get_snapshot_iterator(true);
+  alljobs.unlock();
+
+  pjob = next_job(&alljobs, iter);
+  fail_unless(pjob == late_job, "reverse snapshot should start at the newest job");
+
+  jobcount = 1;
+  while (next_job(&alljobs, iter) != NULL)
+    jobcount++;
+
+  fail_unless(jobcount == 5);
+  delete iter;
+  }
+END_TEST
+
+
+
+START_TEST(snapshot_reinsert_test)
+  {
+  all_jobs            alljobs;
+  job                *jobs[SNAPSHOT_CHUNK + 44];
+  job                *pjob;
+  all_jobs_iterator  *before;
+  all_jobs_iterator  *after;
+  int                 count = sizeof(jobs) / sizeof(jobs[0]);
+  int                 seen = 0;
+
+  for (int i = 0; i < count; i++)
+    {
+    jobs[i] = job_alloc();
+    sprintf(jobs[i]->ji_qs.ji_jobid, "%d.napali", i);
+    fail_unless(insert_job(&alljobs, jobs[i]) == PBSE_NONE);
+    }
+
+  alljobs.lock();
+  before = alljobs.get_snapshot_iterator();
+  alljobs.unlock();
+
+  /* the job moves to the end: it belongs to the later scan only, once */
+  fail_unless(remove_job(&alljobs, jobs[10]) == PBSE_NONE);
+  fail_unless(insert_job(&alljobs, jobs[10]) == PBSE_NONE);
+
+  alljobs.lock();
+  after = alljobs.get_snapshot_iterator();
+  alljobs.unlock();
+
+  while ((pjob = next_job(&alljobs, before)) != NULL)
+    {
+    fail_unless(pjob != jobs[10], "earlier snapshot returned the re-inserted job");
+    seen++;
+    }
+
+  fail_unless(seen == count - 1, "Expected %d jobs, got %d", count - 1, seen);
+
+  seen = 0;
+  while ((pjob = next_job(&alljobs, after)) != NULL)
+    {
+    seen++;
+
+    if (pjob == jobs[10])
+      fail_unless(seen == count, "re-inserted job should come last");
+    }
+
+  fail_unless(seen == count, "Expected %d jobs, got %d", count, seen);
+
+  delete before;
+  delete after;
+  }
+END_TEST
+
+
+
+#define CONTENTION_JOBS    2000
+#define CONTENTION_ROUNDS  20
+
+all_jobs contention_jobs;
+job     *contention_pool[CONTENTION_JOBS];
+
+/* insert and remove the odd jobs over and over */
+void *contention_writer(void *vp)
+  {
+  for (int round = 0; round < CONTENTION_ROUNDS; round++)
+    {
+    for (int i = 1; i < CONTENTION_JOBS; i += 2)
+      remove_job(&contention_jobs, contention_pool[i]);
+
+    for (int i = 1; i < CONTENTION_JOBS; i += 2)
+      insert_job(&contention_jobs, contention_pool[i]);
+    }
+
+  return(NULL);
+  }
+
+/* the even jobs are never removed, so they must always be found */
+void *contention_finder(void *vp)
+  {
+  char jobid[PBS_MAXSVRJOBID + 1];
+  long found = 0;
+
+  for (int round = 0; round < CONTENTION_ROUNDS; round++)
+    {
+    for (int i = 0; i < CONTENTION_JOBS; i++)
+      {
+      sprintf(jobid, "%d.napali", i);
+
+      job *pjob = find_job_by_array(&contention_jobs, jobid, FALSE, false);
+
+      if (pjob != NULL)
+        {
+        if (pjob != contention_pool[i])
+          return((void *)-1);
+
+        found++;
+        }
+      else if ((i % 2) == 0)
+        return((void *)-1);
+      }
+    }
+
+  return((void *)found);
+  }
+
+/* full scans must always see at least the even jobs */
+void *contention_scanner(void *vp)
+  {
+  for (int round = 0; round < CONTENTION_ROUNDS; round++)
+    {
+    all_jobs_iterator *iter;
+    int                count = 0;
+
+    contention_jobs.lock();
+    iter = contention_jobs.get_snapshot_iterator();
+    contention_jobs.unlock();
+
+    while (next_job(&contention_jobs, iter) != NULL)
+      count++;
+
+    delete iter;
+
+    if (count < CONTENTION_JOBS / 2)
+      return((void *)-1);
+    }
+
+  return(NULL);
+  }
+
+START_TEST(container_contention_test)
+  {
+  pthread_t  threads[6];
+  void      *rc;
+
+  for (int i = 0; i < CONTENTION_JOBS; i++)
+    {
+    contention_pool[i] = job_alloc();
+    sprintf(contention_pool[i]->ji_qs.ji_jobid, "%d.napali", i);
+    insert_job(&contention_jobs, contention_pool[i]);
+    }
+
+  pthread_create(&threads[0], NULL, contention_writer, NULL);
+  pthread_create(&threads[1], NULL, contention_scanner, NULL);
+  pthread_create(&threads[2], NULL, contention_scanner, NULL);
+
+  for (int i = 3; i < 6; i++)
+    pthread_create(&threads[i], NULL, contention_finder, NULL);
+
+  for (int i = 0; i < 6; i++)
+    {
+    pthread_join(threads[i], &rc);
+    fail_unless(rc != (void *)-1, "thread %d saw an inconsistent container", i);
+    }
+
+  contention_jobs.lock();
+  fail_unless(contention_jobs.count() == CONTENTION_JOBS);
+  contention_jobs.unlock();
+  }
+END_TEST
+
 Suite *job_container_suite(void)
   {
   Suite *s = suite_create("job_container test suite methods");
@@ -277,6 +556,10 @@ Suite *job_container_suite(void)
   tcase_add_test(tc_core, insert_job_after_test);
   suite_add_tcase(s, tc_core);
 
+  tc_core = tcase_create("insert_by_rank_test");
+  tcase_add_test(tc_core, insert_by_rank_test);
+  suite_add_tcase(s, tc_core);
+
   tc_core = tcase_create("insert_job_first_test");
   tcase_add_test(tc_core, insert_job_first_test);
   suite_add_tcase(s, tc_core);
@@ -297,6 +580,16 @@ Suite *job_container_suite(void)
   tcase_add_test(tc_core, find_job_by_array_with_removed_record_test);
   suite_add_tcase(s, tc_core);
 
+  tc_core = tcase_create("snapshot_iterator_test");
+  tcase_add_test(tc_core, snapshot_iterator_test);
+  tcase_add_test(tc_core, snapshot_reinsert_test);
+  suite_add_tcase(s, tc_core);
+
+  tc_core = tcase_create("container_contention_test");
+  tcase_add_test(tc_core, container_contention_test);
+  tcase_set_timeout(tc_core, 60);
+  suite_add_tcase(s, tc_core);
+
   return(s);
   }
 
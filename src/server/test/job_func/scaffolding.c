@@ -607,3 +607,30 @@ id_map job_mapper;
 void handle_complete_second_time(struct work_task *ptask)
   {
   }
+
+void job_journal_remove(const char *fileprefix) {}
+
+bool use_virtual_subjobs()
+  {
+  return(false);
+  }
+
+int array_next_virtual_index(job_array *pa)
+  {
+  return(-1);
+  }
+
+int array_drop_virtual_range(job_array *pa, int start, int end)
+  {
+  return(0);
+  }
+
+int array_materialize_budget(job_array *pa)
+  {
+  return(0);
+  }
+
+void array_get_parent_id(char *job_id, char *parent_id)
+  {
+  strcpy(parent_id, job_id);
+  }
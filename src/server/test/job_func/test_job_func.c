@@ -273,6 +273,18 @@ START_TEST(job_clone_test)
   }
 END_TEST
 
+START_TEST(subjob_id_test)
+  {
+  char id[PBS_MAXSVRJOBID + 1];
+
+  subjob_id("12[].napali", 3, id, sizeof(id));
+  fail_unless(!strcmp(id, "12[3].napali"), id);
+
+  subjob_id("12[]", 40, id, sizeof(id));
+  fail_unless(!strcmp(id, "12[40]"), id);
+  }
+END_TEST
+
 START_TEST(job_clone_wt_test)
   {
   void *result = job_clone_wt(NULL);
@@ -476,6 +488,10 @@ Suite *job_func_suite(void)
   tcase_add_test(tc_core, get_jobs_queue_test);
   suite_add_tcase(s, tc_core);
 
+  tc_core = tcase_create("subjob_id_test");
+  tcase_add_test(tc_core, subjob_id_test);
+  suite_add_tcase(s, tc_core);
+
   tc_core = tcase_create("handle_aborted_job_test");
   tcase_add_test(tc_core, handle_aborted_job_test);
   suite_add_tcase(s, tc_core);
@@ -0,0 +1,9 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+
+
+ssize_t write_ac_socket(int fd, const void *buf, ssize_t count)
+  {
+  return(write(fd, buf, count));
+  }
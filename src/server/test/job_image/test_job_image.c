@@ -0,0 +1,251 @@
+#include "pbs_config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <string>
+
+#include "job_image.h"
+#include "pbs_error.h"
+#include <check.h>
+
+
+const char *xml_job =
+  "<?xml version=\"1.0\"?>\n"
+  "<job>\n"
+  "  <version>768</version>\n"
+  "  <state>1</state>\n"
+  "  <jobid>1.napali</jobid>\n"
+  "  <fileprefix>1.napali</fileprefix>\n"
+  "  <queue>batch</queue>\n"
+  "  <record_type>2</record_type>\n"
+  "  <attributes>\n"
+  "    <Job_Name flags=\"1\">STDIN</Job_Name>\n"
+  "    <Resource_List>\n"
+  "      <nodes flags=\"1\">2:ppn=4</nodes>\n"
+  "      <walltime flags=\"1\">01:00:00</walltime>\n"
+  "    </Resource_List>\n"
+  "    <Output_Path flags=\"5\">napali:/home/dbeer/STDIN.o1</Output_Path>\n"
+  "  </attributes>\n"
+  "</job>\n";
+
+
+void write_file(
+
+  const char *path,
+  const char *buf,
+  size_t      len)
+
+  {
+  int fds = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+
+  write(fds, buf, len);
+  close(fds);
+  }
+
+
+std::string read_file(
+
+  const char *path)
+
+  {
+  std::string  contents;
+  char         buf[1024];
+  int          fds = open(path, O_RDONLY);
+  int          len;
+
+  while ((len = read(fds, buf, sizeof(buf))) > 0)
+    contents.append(buf, len);
+
+  close(fds);
+
+  return(contents);
+  }
+
+
+START_TEST(image_round_trip_test)
+  {
+  std::string     image;
+  job_image_map   map;
+  job_image_item  item;
+  const char     *path = "/tmp/job_image_test.JB";
+
+  job_image_begin(image);
+  job_image_add(image, JOB_IMAGE_FIELD, "jobid", NULL, "1.napali", 0);
+  job_image_add(image, JOB_IMAGE_ATTR, "Job_Name", NULL, "STDIN", 1);
+  job_image_add(image, JOB_IMAGE_ATTR, "Resource_List", "nodes", "2:ppn=4", 3);
+  job_image_add(image, JOB_IMAGE_ATTR, "Account_Name", NULL, NULL, 1);
+
+  fail_unless(image.size() % JOB_IMAGE_ALIGN == 0);
+  fail_unless(job_image_write(image, path) == PBSE_NONE);
+  fail_unless(job_image_open(path, &map) == PBSE_NONE);
+
+  fail_unless(job_image_next(&map, &item) == 1);
+  fail_unless(item.it_type == JOB_IMAGE_FIELD);
+  fail_unless(!strcmp(item.it_name, "jobid"));
+  fail_unless(!strcmp(item.it_value, "1.napali"));
+
+  fail_unless(job_image_next(&map, &item) == 1);
+  fail_unless(item.it_type == JOB_IMAGE_ATTR);
+  fail_unless(!strcmp(item.it_name, "Job_Name"));
+  fail_unless(item.it_resc[0] == '\0');
+  fail_unless(item.it_flags == 1);
+
+  fail_unless(job_image_next(&map, &item) == 1);
+  fail_unless(!strcmp(item.it_name, "Resource_List"));
+  fail_unless(!strcmp(item.it_resc, "nodes"));
+  fail_unless(!strcmp(item.it_value, "2:ppn=4"));
+  fail_unless(item.it_flags == 3);
+
+  /* values can be modified in place without changing the file */
+  item.it_value[0] = '9';
+
+  fail_unless(job_image_next(&map, &item) == 1);
+  fail_unless(!strcmp(item.it_name, "Account_Name"));
+  fail_unless(item.it_value[0] == '\0');
+
+  fail_unless(job_image_next(&map, &item) == 0);
+  job_image_close(&map);
+
+  fail_unless(read_file(path) == image);
+
+  unlink(path);
+  }
+END_TEST
+
+
+START_TEST(bad_image_test)
+  {
+  std::string     image;
+  job_image_map   map;
+  job_image_item  item;
+  job_image_entry entry;
+  const char     *path = "/tmp/job_image_bad.JB";
+
+  fail_unless(job_image_open("/tmp/job_image_missing.JB", &map) == -1);
+
+  write_file(path, xml_job, strlen(xml_job));
+  fail_unless(job_image_open(path, &map) == PBSE_INVALID_SYNTAX);
+
+  write_file(path, "TB", 2);
+  fail_unless(job_image_open(path, &map) == PBSE_INVALID_SYNTAX);
+
+  job_image_begin(image);
+  job_image_add(image, JOB_IMAGE_FIELD, "jobid", NULL, "1.napali", 0);
+
+  /* truncated */
+  write_file(path, image.c_str(), image.size() - 4);
+  fail_unless(job_image_open(path, &map) == -1);
+
+  /* an entry that claims to run past the end of the file */
+  memcpy(&entry, image.c_str() + sizeof(job_image_header), sizeof(entry));
+  entry.je_value_len += 64;
+  memcpy(&image[sizeof(job_image_header)], &entry, sizeof(entry));
+  write_file(path, image.c_str(), image.size());
+  fail_unless(job_image_open(path, &map) == PBSE_NONE);
+  fail_unless(job_image_next(&map, &item) == -1);
+  job_image_close(&map);
+
+  /* an entry whose strings aren't terminated where they should be */
+  entry.je_value_len -= 65;
+  memcpy(&image[sizeof(job_image_header)], &entry, sizeof(entry));
+  write_file(path, image.c_str(), image.size());
+  fail_unless(job_image_open(path, &map) == PBSE_NONE);
+  fail_unless(job_image_next(&map, &item) == -1);
+  job_image_close(&map);
+
+  unlink(path);
+  }
+END_TEST
+
+
+START_TEST(xml_conversion_test)
+  {
+  job_image_map   map;
+  job_image_item  item;
+  std::string     image;
+  const char     *xml_path = "/tmp/job_image_test.xml";
+  const char     *xml_path2 = "/tmp/job_image_test2.xml";
+  const char     *image_path = "/tmp/job_image_test.img";
+  const char     *image_path2 = "/tmp/job_image_test2.img";
+  int             fields = 0;
+  int             attrs = 0;
+
+  write_file(xml_path, xml_job, strlen(xml_job));
+
+  fail_unless(job_image_from_xml(xml_path, image_path) == PBSE_NONE);
+  fail_unless(job_image_from_xml(image_path, image_path2) == PBSE_INVALID_SYNTAX);
+  fail_unless(job_image_to_xml(xml_path, xml_path2) == PBSE_INVALID_SYNTAX);
+
+  fail_unless(job_image_open(image_path, &map) == PBSE_NONE);
+
+  while (job_image_next(&map, &item) == 1)
+    {
+    if (item.it_type == JOB_IMAGE_FIELD)
+      fields++;
+    else
+      {
+      attrs++;
+
+      if (!strcmp(item.it_name, "Resource_List"))
+        fail_unless(item.it_resc[0] != '\0');
+      else
+        fail_unless(item.it_resc[0] == '\0');
+
+      if (!strcmp(item.it_name, "Output_Path"))
+        fail_unless(item.it_flags == 5);
+      }
+    }
+
+  job_image_close(&map);
+
+  fail_unless(fields == 6);
+  fail_unless(attrs == 4);
+
+  /* converting back to xml and to an image again changes nothing */
+  fail_unless(job_image_to_xml(image_path, xml_path2) == PBSE_NONE);
+  fail_unless(job_image_from_xml(xml_path2, image_path2) == PBSE_NONE);
+  fail_unless(read_file(image_path) == read_file(image_path2));
+  fail_unless(read_file(xml_path2) == xml_job);
+
+  unlink(xml_path);
+  unlink(xml_path2);
+  unlink(image_path);
+  unlink(image_path2);
+  }
+END_TEST
+
+
+Suite *job_image_suite(void)
+  {
+  Suite *s = suite_create("job_image_suite methods");
+  TCase *tc_core = tcase_create("image_round_trip_test");
+  tcase_add_test(tc_core, image_round_trip_test);
+  tcase_add_test(tc_core, bad_image_test);
+  suite_add_tcase(s, tc_core);
+
+  tc_core = tcase_create("xml_conversion_test");
+  tcase_add_test(tc_core, xml_conversion_test);
+  suite_add_tcase(s, tc_core);
+
+  return(s);
+  }
+
+void rundebug()
+  {
+  }
+
+int main(void)
+  {
+  int number_failed = 0;
+  SRunner *sr = NULL;
+  rundebug();
+  sr = srunner_create(job_image_suite());
+  srunner_set_log(sr, "job_image_suite.log");
+  srunner_run_all(sr, CK_NORMAL);
+  number_failed = srunner_ntests_failed(sr);
+  srunner_free(sr);
+  return(number_failed);
+  }
@@ -0,0 +1,142 @@
+#include "license_pbs.h" /* See here for the software license */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pbs_job.h"
+#include "job_index.h"
+#include <check.h>
+
+
+job *make_job(
+
+  const char *jobid,
+  const char *owner,
+  char        state,
+  long        qrank)
+
+  {
+  job *pjob = (job *)calloc(1, sizeof(job));
+
+  snprintf(pjob->ji_qs.ji_jobid, sizeof(pjob->ji_qs.ji_jobid), "%s", jobid);
+  pjob->ji_wattr[JOB_ATR_job_owner].at_val.at_str = strdup(owner);
+  pjob->ji_wattr[JOB_ATR_state].at_val.at_char = state;
+  pjob->ji_wattr[JOB_ATR_qrank].at_val.at_long = qrank;
+
+  return(pjob);
+  }
+
+
+START_TEST(lookup_by_owner_and_state_test)
+  {
+  std::vector<std::string> users;
+  std::vector<std::string> ids;
+  job *jobs[4];
+
+  jobs[0] = make_job("1.napali", "dbeer@napali", 'Q', 1);
+  jobs[1] = make_job("2.napali", "tom@napali", 'R', 2);
+  jobs[2] = make_job("3.napali", "dbeer@waimea", 'R', 3);
+  jobs[3] = make_job("4.napali", "dbeer@napali", 'H', 4);
+
+  /* add out of rank order, lookups still come back by rank */
+  for (int i = 3; i >= 0; i--)
+    job_index_add(jobs[i]);
+
+  fail_unless(job_index_lookup(NULL, NULL, ids) == false);
+
+  users.push_back("dbeer");
+  fail_unless(job_index_lookup(&users, NULL, ids) == true);
+  fail_unless(ids.size() == 3);
+  fail_unless(ids[0] == "1.napali");
+  fail_unless(ids[1] == "3.napali");
+  fail_unless(ids[2] == "4.napali");
+
+  /* the host part of a user entry doesn't narrow the index */
+  users[0] = "dbeer@napali";
+  fail_unless(job_index_lookup(&users, "R", ids) == true);
+  fail_unless(ids.size() == 1);
+  fail_unless(ids[0] == "3.napali");
+
+  fail_unless(job_index_lookup(NULL, "RH", ids) == true);
+  fail_unless(ids.size() == 3);
+  fail_unless(ids[0] == "2.napali");
+
+  users.push_back("tom");
+  fail_unless(job_index_lookup(&users, "QR", ids) == true);
+  fail_unless(ids.size() == 3);
+
+  users.clear();
+  users.push_back("nobody");
+  fail_unless(job_index_lookup(&users, NULL, ids) == true);
+  fail_unless(ids.size() == 0);
+
+  for (int i = 0; i < 4; i++)
+    job_index_remove(jobs[i]->ji_qs.ji_jobid);
+  }
+END_TEST
+
+
+START_TEST(state_change_and_remove_test)
+  {
+  std::vector<std::string> ids;
+  job *pjob = make_job("5.napali", "dbeer@napali", 'Q', 5);
+  job *unindexed = make_job("6.napali", "dbeer@napali", 'Q', 6);
+
+  job_index_add(pjob);
+
+  pjob->ji_wattr[JOB_ATR_state].at_val.at_char = 'R';
+  job_index_set_state(pjob);
+
+  fail_unless(job_index_lookup(NULL, "Q", ids) == true);
+  fail_unless(ids.size() == 0);
+  fail_unless(job_index_lookup(NULL, "R", ids) == true);
+  fail_unless(ids.size() == 1);
+
+  /* jobs that were never added stay out of the index */
+  unindexed->ji_wattr[JOB_ATR_state].at_val.at_char = 'R';
+  job_index_set_state(unindexed);
+  fail_unless(job_index_lookup(NULL, "R", ids) == true);
+  fail_unless(ids.size() == 1);
+
+  /* adding again refreshes the entry instead of duplicating it */
+  pjob->ji_wattr[JOB_ATR_state].at_val.at_char = 'E';
+  job_index_add(pjob);
+  fail_unless(job_index_lookup(NULL, "RE", ids) == true);
+  fail_unless(ids.size() == 1);
+
+  job_index_remove(pjob->ji_qs.ji_jobid);
+  fail_unless(job_index_lookup(NULL, "QRE", ids) == true);
+  fail_unless(ids.size() == 0);
+  }
+END_TEST
+
+
+Suite *job_index_suite(void)
+  {
+  Suite *s = suite_create("job_index test suite methods");
+  TCase *tc_core = tcase_create("lookup_by_owner_and_state_test");
+  tcase_add_test(tc_core, lookup_by_owner_and_state_test);
+  suite_add_tcase(s, tc_core);
+
+  tc_core = tcase_create("state_change_and_remove_test");
+  tcase_add_test(tc_core, state_change_and_remove_test);
+  suite_add_tcase(s, tc_core);
+
+  return(s);
+  }
+
+void rundebug()
+  {
+  }
+
+int main(void)
+  {
+  int number_failed = 0;
+  SRunner *sr = NULL;
+  rundebug();
+  sr = srunner_create(job_index_suite());
+  srunner_set_log(sr, "job_index_suite.log");
+  srunner_run_all(sr, CK_NORMAL);
+  number_failed = srunner_ntests_failed(sr);
+  srunner_free(sr);
+  return(number_failed);
+  }
@@ -0,0 +1,71 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+
+#include "pbs_job.h"
+#include "attribute.h"
+#include "log.h"
+
+bool exit_called = false;
+int LOGLEVEL = 0;
+char *path_jobs = (char *)"/tmp/";
+int   encoded_attrs = 0;
+
+attribute_def job_attr_def[JOB_ATR_LAST];
+
+int find_attr(
+
+  struct attribute_def *attr_def,
+  const char           *name,
+  int                   limit)
+
+  {
+  for (int i = 0; i < limit; i++)
+    {
+    if ((attr_def[i].at_name != NULL) &&
+        (!strcmp(attr_def[i].at_name, name)))
+      return(i);
+    }
+
+  return(-1);
+  }
+
+void encode_job_attr_value(pbs_attribute *pattr, int index, std::string &value)
+  {
+  encoded_attrs++;
+
+  if (pattr[index].at_val.at_str != NULL)
+    value = pattr[index].at_val.at_str;
+  }
+
+svrattrl *fill_svrattr_info(const char *aname, const char *avalue, const char *rname, char *log_buf, size_t buf_len)
+  {
+  svrattrl *pal = (svrattrl *)calloc(1, sizeof(svrattrl));
+
+  pal->al_name = strdup(aname);
+  pal->al_value = strdup(avalue);
+
+  return(pal);
+  }
+
+void decode_attribute(svrattrl *pal, job **pjob, bool freeExisting)
+  {
+  int index = find_attr(job_attr_def, pal->al_name, JOB_ATR_LAST);
+
+  if (index < 0)
+    return;
+
+  (*pjob)->ji_wattr[index].at_val.at_str = strdup(pal->al_value);
+  (*pjob)->ji_wattr[index].at_flags = pal->al_flags & ~ATR_VFLAG_MODIFY;
+  }
+
+ssize_t read_ac_socket(int fd, void *buf, ssize_t count)
+  {
+  return(read(fd, buf, count));
+  }
+
+void log_err(int errnum, const char *routine, const char *text) {}
+void log_event(int eventtype, int objclass, const char *objname, const char *text) {}
+
+unsigned long mark_file_dirty(const char *path) {return(0);}
@@ -0,0 +1,275 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include "job_journal.h"
+#include "pbs_error.h"
+#include <check.h>
+
+extern int encoded_attrs;
+
+
+void free_str_attr(pbs_attribute *pattr)
+  {
+  if (pattr->at_val.at_str != NULL)
+    free(pattr->at_val.at_str);
+
+  pattr->at_val.at_str = NULL;
+  pattr->at_flags = 0;
+  }
+
+
+void setup_attr_defs()
+  {
+  job_attr_def[JOB_ATR_jobname].at_name = "Job_Name";
+  job_attr_def[JOB_ATR_jobname].at_type = ATR_TYPE_STR;
+  job_attr_def[JOB_ATR_jobname].at_free = free_str_attr;
+  job_attr_def[JOB_ATR_job_owner].at_name = "Job_Owner";
+  job_attr_def[JOB_ATR_job_owner].at_type = ATR_TYPE_STR;
+  job_attr_def[JOB_ATR_job_owner].at_free = free_str_attr;
+  }
+
+
+void set_str_attr(job *pjob, int index, const char *value)
+  {
+  pjob->ji_wattr[index].at_val.at_str = strdup(value);
+  pjob->ji_wattr[index].at_flags = ATR_VFLAG_SET | ATR_VFLAG_MODIFY;
+  }
+
+
+job *new_journal_job(const char *prefix)
+  {
+  job  *pjob = (job *)calloc(1, sizeof(job));
+  char  path[MAXPATHLEN];
+
+  setup_attr_defs();
+
+  pjob->ji_qs.qs_version = PBS_QS_VERSION;
+  snprintf(pjob->ji_qs.ji_jobid, sizeof(pjob->ji_qs.ji_jobid), "%s.napali", prefix);
+  snprintf(pjob->ji_qs.ji_fileprefix, sizeof(pjob->ji_qs.ji_fileprefix), "%s", prefix);
+
+  snprintf(path, sizeof(path), "/tmp/%s%s", prefix, JOB_FILE_JOURNAL);
+  unlink(path);
+
+  return(pjob);
+  }
+
+
+off_t journal_size(const char *prefix)
+  {
+  char        path[MAXPATHLEN];
+  struct stat statbuf;
+
+  snprintf(path, sizeof(path), "/tmp/%s%s", prefix, JOB_FILE_JOURNAL);
+
+  if (stat(path, &statbuf) != 0)
+    return(-1);
+
+  return(statbuf.st_size);
+  }
+
+
+START_TEST(journal_crc32_test)
+  {
+  fail_unless(journal_crc32(0, "123456789", 9) == 0xcbf43926);
+  fail_unless(journal_crc32(journal_crc32(0, "1234", 4), "56789", 5) == 0xcbf43926);
+  }
+END_TEST
+
+
+START_TEST(job_journal_append_test)
+  {
+  job  *pjob = new_journal_job("100");
+  bool  compact = true;
+  off_t first;
+
+  // no baseline yet
+  fail_unless(job_journal_append(pjob, compact) == -1);
+
+  set_str_attr(pjob, JOB_ATR_jobname, "STDIN");
+  set_str_attr(pjob, JOB_ATR_job_owner, "dbeer@napali");
+  encoded_attrs = 0;
+  job_journal_reset(pjob);
+  fail_unless(pjob->ji_journal_sums != NULL);
+  fail_unless(journal_size("100") == -1);
+
+  // nothing changed, only the fixed fields are recorded
+  fail_unless(job_journal_append(pjob, compact) == PBSE_NONE);
+  fail_unless(encoded_attrs == 0);
+  fail_unless(compact == false);
+  fail_unless(pjob->ji_journal_seq == 1);
+  first = journal_size("100");
+  fail_unless(first == (off_t)(sizeof(journal_record_header) + sizeof(struct jobfix)));
+
+  free(pjob->ji_wattr[JOB_ATR_jobname].at_val.at_str);
+  set_str_attr(pjob, JOB_ATR_jobname, "renamed");
+  fail_unless(job_journal_append(pjob, compact) == PBSE_NONE);
+  fail_unless(encoded_attrs == 1);
+  fail_unless(pjob->ji_journal_seq == 2);
+  fail_unless(journal_size("100") > 2 * first);
+  fail_unless(journal_size("100") < 2 * first + 64);
+  fail_unless((pjob->ji_wattr[JOB_ATR_jobname].at_flags & ATR_VFLAG_MODIFY) == 0);
+
+  job_journal_reset(pjob);
+  fail_unless(journal_size("100") == -1);
+  }
+END_TEST
+
+
+START_TEST(job_journal_replay_test)
+  {
+  job  *pjob = new_journal_job("101");
+  job  *recov;
+  bool  compact;
+  char  log_buf[1024];
+
+  set_str_attr(pjob, JOB_ATR_jobname, "STDIN");
+  set_str_attr(pjob, JOB_ATR_job_owner, "dbeer@napali");
+  job_journal_reset(pjob);
+
+  pjob->ji_qs.ji_state = JOB_STATE_RUNNING;
+  free(pjob->ji_wattr[JOB_ATR_jobname].at_val.at_str);
+  set_str_attr(pjob, JOB_ATR_jobname, "renamed");
+  fail_unless(job_journal_append(pjob, compact) == PBSE_NONE);
+
+  free_str_attr(pjob->ji_wattr + JOB_ATR_job_owner);
+  fail_unless(job_journal_append(pjob, compact) == PBSE_NONE);
+
+  // the recovered image holds the state as of the reset
+  recov = (job *)calloc(1, sizeof(job));
+  memcpy(&recov->ji_qs, &pjob->ji_qs, sizeof(recov->ji_qs));
+  recov->ji_qs.ji_state = JOB_STATE_QUEUED;
+  set_str_attr(recov, JOB_ATR_jobname, "STDIN");
+  set_str_attr(recov, JOB_ATR_job_owner, "dbeer@napali");
+
+  job_journal_replay(recov, log_buf, sizeof(log_buf));
+  fail_unless(recov->ji_journal_seq == 2);
+  fail_unless(recov->ji_qs.ji_state == JOB_STATE_RUNNING);
+  fail_unless(!strcmp(recov->ji_wattr[JOB_ATR_jobname].at_val.at_str, "renamed"));
+  fail_unless((recov->ji_wattr[JOB_ATR_job_owner].at_flags & ATR_VFLAG_SET) == 0);
+
+  // records already folded into the image are skipped
+  recov->ji_journal_seq = 2;
+  recov->ji_qs.ji_state = JOB_STATE_EXITING;
+  job_journal_replay(recov, log_buf, sizeof(log_buf));
+  fail_unless(recov->ji_qs.ji_state == JOB_STATE_EXITING);
+
+  // a journal for another job is discarded and the job keeps its image
+  strcpy(recov->ji_qs.ji_jobid, "102.napali");
+  recov->ji_journal_seq = 0;
+  job_journal_replay(recov, log_buf, sizeof(log_buf));
+  fail_unless(recov->ji_journal_seq == 0);
+  fail_unless(recov->ji_qs.ji_state == JOB_STATE_EXITING);
+  fail_unless(journal_size("101") == 0);
+
+  job_journal_remove("101");
+  }
+END_TEST
+
+
+START_TEST(job_journal_torn_record_test)
+  {
+  job  *pjob = new_journal_job("103");
+  job  *recov;
+  bool  compact;
+  char  log_buf[1024];
+  char  path[MAXPATHLEN];
+
+  set_str_attr(pjob, JOB_ATR_jobname, "STDIN");
+  job_journal_reset(pjob);
+
+  pjob->ji_qs.ji_substate = 1;
+  fail_unless(job_journal_append(pjob, compact) == PBSE_NONE);
+  pjob->ji_qs.ji_substate = 2;
+  fail_unless(job_journal_append(pjob, compact) == PBSE_NONE);
+
+  // simulate a crash part way through the second record
+  snprintf(path, sizeof(path), "/tmp/103%s", JOB_FILE_JOURNAL);
+  fail_unless(truncate(path, journal_size("103") - 3) == 0);
+
+  recov = (job *)calloc(1, sizeof(job));
+  memcpy(&recov->ji_qs, &pjob->ji_qs, sizeof(recov->ji_qs));
+  recov->ji_qs.ji_substate = 0;
+
+  job_journal_replay(recov, log_buf, sizeof(log_buf));
+  fail_unless(recov->ji_journal_seq == 1);
+  fail_unless(recov->ji_qs.ji_substate == 1);
+
+  // the torn record is cut off so the next record can be replayed
+  fail_unless(journal_size("103") == (off_t)(sizeof(journal_record_header) + sizeof(struct jobfix)));
+  pjob->ji_qs.ji_substate = 3;
+  fail_unless(job_journal_append(pjob, compact) == PBSE_NONE);
+
+  recov->ji_journal_seq = 0;
+  recov->ji_qs.ji_substate = 0;
+  job_journal_replay(recov, log_buf, sizeof(log_buf));
+  fail_unless(recov->ji_journal_seq == 3);
+  fail_unless(recov->ji_qs.ji_substate == 3);
+
+  job_journal_remove("103");
+  }
+END_TEST
+
+
+START_TEST(job_journal_compact_test)
+  {
+  job  *pjob = new_journal_job("104");
+  bool  compact = false;
+  int   records = 0;
+
+  job_journal_reset(pjob);
+
+  while (compact == false)
+    {
+    fail_unless(job_journal_append(pjob, compact) == PBSE_NONE);
+    records++;
+    }
+
+  fail_unless(journal_size("104") >= JOURNAL_COMPACT_SIZE);
+  fail_unless(records == (int)(JOURNAL_COMPACT_SIZE / (sizeof(journal_record_header) + sizeof(struct jobfix))) + 1);
+
+  job_journal_remove("104");
+  fail_unless(journal_size("104") == -1);
+  }
+END_TEST
+
+
+Suite *job_journal_suite(void)
+  {
+  Suite *s = suite_create("job_journal_suite methods");
+  TCase *tc_core = tcase_create("journal_crc32_test");
+  tcase_add_test(tc_core, journal_crc32_test);
+  suite_add_tcase(s, tc_core);
+
+  tc_core = tcase_create("job_journal_append_test");
+  tcase_add_test(tc_core, job_journal_append_test);
+  tcase_add_test(tc_core, job_journal_compact_test);
+  suite_add_tcase(s, tc_core);
+
+  tc_core = tcase_create("job_journal_replay_test");
+  tcase_add_test(tc_core, job_journal_replay_test);
+  tcase_add_test(tc_core, job_journal_torn_record_test);
+  suite_add_tcase(s, tc_core);
+
+  return(s);
+  }
+
+void rundebug()
+  {
+  }
+
+int main(void)
+  {
+  int number_failed = 0;
+  SRunner *sr = NULL;
+  rundebug();
+  sr = srunner_create(job_journal_suite());
+  srunner_set_log(sr, "job_journal_suite.log");
+  srunner_run_all(sr, CK_NORMAL);
+  number_failed = srunner_ntests_failed(sr);
+  srunner_free(sr);
+  return(number_failed);
+  }
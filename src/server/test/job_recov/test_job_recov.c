@@ -11,10 +11,12 @@
 #include "pbs_job.h"
 #include "attribute.h"
 #include "resource.h"
+#include "server.h"
 
 sem_t *job_clone_semaphore;
 extern int set_nodes_attr(job *pjob);
 extern int svr_resc_size;
+extern struct server server;
 extern attribute_def job_attr_def[];
 extern void free_server_attrs(tlist_head *att_head);
 int fill_resource_list(job **pj, xmlNodePtr resource_list_node, char *log_buf, size_t buflen, const char *aname);
@@ -295,6 +297,8 @@ START_TEST(test_job_recover)
   const char *jobid = "unit_test_job1"; 
 
   job *pj;
+  server.sv_attr_mutex = (pthread_mutex_t *)calloc(1, sizeof(pthread_mutex_t));
+  pthread_mutex_init(server.sv_attr_mutex, NULL);
   pj = create_a_job(jobid);
   fail_unless((pj != NULL), "unable to create a job");
   snprintf(jobFileName, MAXPATHLEN, "/tmp/%s.JB", jobid);
@@ -311,12 +315,43 @@ START_TEST(test_job_recover)
   }
 END_TEST
 
+START_TEST(test_job_recover_image)
+  {
+  char jobFileName[MAXPATHLEN];
+  char buf[1024];
+  const char *jobid = "unit_test_job2"; 
+
+  job *pj;
+  server.sv_attr_mutex = (pthread_mutex_t *)calloc(1, sizeof(pthread_mutex_t));
+  pthread_mutex_init(server.sv_attr_mutex, NULL);
+  pj = create_a_job(jobid);
+  fail_unless((pj != NULL), "unable to create a job");
+  snprintf(jobFileName, MAXPATHLEN, "/tmp/%s.JB", jobid);
+  int rc = saveJobToImage(pj, jobFileName);
+  fail_unless(rc == PBSE_NONE, "Failed to save job to an image file");
+
+  job *recov_pj = job_recov(jobFileName);
+  fail_unless(recov_pj != NULL);
+
+  rc = job_compare(pj, recov_pj);
+  fail_unless(rc == 0, "jobs (saved & recovered) did not compare the same");
+
+  /* an xml job file isn't mistaken for an image */
+  rc = saveJobToXML(pj, jobFileName);
+  fail_unless(rc == PBSE_NONE);
+  fail_unless(job_recov_image(jobFileName, &recov_pj, buf, sizeof(buf)) == PBSE_INVALID_SYNTAX);
+
+  unlink(jobFileName);
+  }
+END_TEST
+
 Suite *job_recov_suite(void)
   {
   Suite *s = suite_create("job_recov_suite methods");
 
   TCase *tc_core = tcase_create("test_job_recover");
   tcase_add_test(tc_core, test_job_recover);
+  tcase_add_test(tc_core, test_job_recover_image);
   tcase_add_test(tc_core, fill_resource_list_test);
   tcase_add_test(tc_core, test_add_encoded_attributes);
   tcase_add_test(tc_core, test_translate_dependency_to_string);
@@ -88,6 +88,8 @@ int unlock_node(
   return(0);
   }
 
+void update_node_capacity(struct pbsnode *pnode) {}
+
 int nodeId = 0;
 int create_partial_pbs_node(char *nodename, unsigned long addr, int perms)
   {
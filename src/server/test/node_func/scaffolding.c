@@ -442,3 +442,29 @@ void free_br(struct batch_request *preq)
 void mom_hierarchy_handler::reloadHierarchy()
 {
 }
+
+property_index node_props;
+
+property_index::property_index() {}
+
+int property_index::intern(const char *name)
+  {
+  return(0);
+  }
+
+void property_index::set_node_props(int node_id, const prop_bitset &old_props, const prop_bitset &new_props) {}
+
+void prop_bitset_set(prop_bitset &bits, int id) {}
+
+capacity_index node_capacity;
+
+capacity_index::capacity_index() {}
+
+int capacity_node_id = -1;
+int capacity_free = -1;
+
+void capacity_index::set_node_free(int node_id, int free)
+  {
+  capacity_node_id = node_id;
+  capacity_free = free;
+  }
@@ -21,6 +21,8 @@ void add_to_property_list(std::stringstream &property_list, const char *token);
 int login_encode_jobs(struct pbsnode *pnode, tlist_head *phead);
 int cray_enabled;
 int read_val_and_advance(int *val, char **str);
+extern int capacity_node_id;
+extern int capacity_free;
 char *parse_node_token(char **start, int flags, int *err, char *term);
 
 void initialize_allnodes(all_nodes *an, struct pbsnode *n1, struct pbsnode *n2)
@@ -453,6 +455,35 @@ START_TEST(add_execution_slot_test)
   }
 END_TEST
 
+START_TEST(update_node_capacity_test)
+  {
+  struct pbsnode node;
+  initialize_pbsnode(&node, NULL, NULL, 0, FALSE);
+  node.nd_id = 7;
+
+  add_execution_slot(&node);
+  add_execution_slot(&node);
+
+  // a down node isn't indexed
+  node.nd_state = INUSE_DOWN;
+  update_node_capacity(&node);
+  fail_unless(capacity_node_id == 7);
+  fail_unless(capacity_free == -1);
+
+  node.nd_state = INUSE_FREE;
+  update_node_capacity(&node);
+  fail_unless(capacity_free == 2);
+
+  node.nd_slots.mark_as_used(0);
+  update_node_capacity(&node);
+  fail_unless(capacity_free == 1);
+
+  node.nd_power_state = POWER_STATE_SLEEP;
+  update_node_capacity(&node);
+  fail_unless(capacity_free == -1);
+  }
+END_TEST
+
 START_TEST(create_a_gpusubnode_test)
   {
   int result = -1;
@@ -876,6 +907,7 @@ Suite *node_func_suite(void)
 
   tc_core = tcase_create("add_execution_slot_test");
   tcase_add_test(tc_core, add_execution_slot_test);
+  tcase_add_test(tc_core, update_node_capacity_test);
   suite_add_tcase(s, tc_core);
 
   tc_core = tcase_create("create_a_gpusubnode_test");
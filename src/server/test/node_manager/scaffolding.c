@@ -630,3 +630,59 @@ ssize_t write_ac_socket(int fd, const void *buf, ssize_t count)
   return(0);
   }
 
+
+property_index node_props;
+
+property_index::property_index() {}
+
+int property_index::get_id(const char *name)
+  {
+  return(-1);
+  }
+
+bool property_index::nodes_with_all(const prop_bitset &props, prop_bitset &nodes)
+  {
+  return(false);
+  }
+
+void prop_bitset_set(prop_bitset &bits, int id)
+  {
+  if ((unsigned int)id / 64 >= bits.size())
+    bits.resize(id / 64 + 1, 0);
+
+  bits[id / 64] |= 1UL << (id % 64);
+  }
+
+bool prop_bitset_contains(const prop_bitset &have, const prop_bitset &need)
+  {
+  for (unsigned int i = 0; i < need.size(); i++)
+    {
+    unsigned long have_word = (i < have.size()) ? have[i] : 0;
+
+    if ((need[i] & have_word) != need[i])
+      return(false);
+    }
+
+  return(true);
+  }
+
+int prop_bitset_next(const prop_bitset &bits, int after)
+  {
+  return(-1);
+  }
+
+capacity_index node_capacity;
+
+capacity_index::capacity_index() {}
+
+void capacity_index::nodes_with_free(int min_free, prop_bitset &nodes)
+  {
+  nodes.clear();
+  }
+
+bool prop_bitset_test(const prop_bitset &bits, int id)
+  {
+  return(false);
+  }
+
+void update_node_capacity(struct pbsnode *pnode) {}
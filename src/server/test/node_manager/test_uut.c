@@ -262,6 +262,25 @@ START_TEST(node_is_spec_acceptable_test)
   pnode.nd_state = INUSE_FREE;
   fail_unless(node_is_spec_acceptable(&pnode, &spec, NULL, &eligible_nodes,false) == true);
   fail_unless(eligible_nodes == 1);
+
+  // the spec wants properties 2 and 65, the node only has 2
+  prop_bitset want;
+  prop_bitset_set(want, 2);
+  prop_bitset_set(want, 65);
+  prop_bitset_set(pnode.nd_prop_bits, 2);
+  spec.prop_bits = &want;
+
+  eligible_nodes = 0;
+  fail_unless(node_is_spec_acceptable(&pnode, &spec, NULL, &eligible_nodes,false) == false);
+  fail_unless(eligible_nodes == 0);
+
+  prop_bitset_set(pnode.nd_prop_bits, 65);
+  fail_unless(node_is_spec_acceptable(&pnode, &spec, NULL, &eligible_nodes,false) == true);
+  fail_unless(eligible_nodes == 1);
+
+  // a property no node has can never be satisfied
+  spec.prop_unknown = true;
+  fail_unless(node_is_spec_acceptable(&pnode, &spec, NULL, &eligible_nodes,false) == false);
   }
 END_TEST
 
@@ -0,0 +1,162 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "node_status.hpp"
+#include "attribute.h"
+#include "pbs_nodes.h"
+#include "pbs_error.h"
+#include <check.h>
+
+/* a status update captured from a mom, with a few awkward strings added */
+const char *captured[] = { "opsys=linux", "uname=Linux n001 3.10.0-957.el7.x86_64 #1 SMP x86_64",
+                           "sessions=2731 2755", "nsessions=2", "nusers=1", "idletime=4132",
+                           "totmem=65766988kb", "availmem=61352780kb", "physmem=65766988kb",
+                           "ncpus=16", "loadave=0.52", "gres=tmp:100,scratch:2",
+                           "message=ERROR: disk\\, full", "netload=1948313924", " state=free ",
+                           "jobs=12.svr 13.svr", "varattr=", "cpuclock=Fixed",
+                           "macaddr=00:1a:2b:3c:4d:5e", "first_update=true", "trailing=a,", "loadave=0.75",
+                           "gres=tmp:50" };
+
+
+void add_all(
+
+  node_status  &ns,
+  const char  **strings,
+  int           count)
+
+  {
+  for (int i = 0; i < count; i++)
+    ns.add(strings[i], strlen(strings[i]));
+  }
+
+
+START_TEST(test_add)
+  {
+  node_status ns;
+  const char *delta[] = { "status_delta=true", "status_removed=gres,varattr", "state=busy", "ncpus=x" };
+
+  add_all(ns, captured, sizeof(captured) / sizeof(captured[0]));
+
+  /* the entries are in order, first_update and the delta markers aren't among them */
+  fail_unless(ns.entries.size() == sizeof(captured) / sizeof(captured[0]) - 1);
+  fail_unless(ns.state == -1);
+  fail_unless(ns.state_str.is_set() == false);
+  fail_unless(ns.ncpus == 16);
+  fail_unless(ns.first_update == true);
+  fail_unless(ns.delta == false);
+  fail_unless(ns.jobs.to_string() == "12.svr 13.svr");
+  fail_unless(ns.macaddr.to_string() == "00:1a:2b:3c:4d:5e");
+  fail_unless(ns.message.starts_with("ERROR"));
+  fail_unless(!strncmp(ns.uname.ptr, "Linux n001", 10));
+  fail_unless(ns.others[status_view("availmem", 8)].to_string() == "61352780kb");
+  fail_unless(ns.others[status_view("varattr", 7)].to_string() == "");
+  fail_unless(ns.others.find(status_view("ncpus", 5)) == ns.others.end());
+
+  ns.clear();
+  fail_unless(ns.entries.size() == 0);
+  fail_unless(ns.jobs.is_set() == false);
+
+  add_all(ns, delta, 4);
+  fail_unless(ns.delta == true);
+  fail_unless(ns.removed.to_string() == "gres,varattr");
+  fail_unless(ns.state == INUSE_BUSY);
+  fail_unless(ns.state_str.to_string() == "state=busy");
+  fail_unless(ns.ncpus == -1);
+  fail_unless(ns.entries.size() == 2);
+
+  ns.clear();
+  ns.add("state=bogus", strlen("state=bogus"));
+  fail_unless(ns.state == INUSE_UNKNOWN);
+  }
+END_TEST
+
+
+
+
+START_TEST(test_encode)
+  {
+  node_status                ns;
+  pbs_attribute              encoded;
+  pbs_attribute              decoded;
+  std::vector<const char *>  kept;
+  struct array_strings      *enc;
+  struct array_strings      *dec;
+
+  memset(&encoded, 0, sizeof(encoded));
+  memset(&decoded, 0, sizeof(decoded));
+
+  /* nothing to store */
+  fail_unless(ns.encode(&encoded, kept) == PBSE_NONE);
+  fail_unless(encoded.at_val.at_arst == NULL);
+
+  add_all(ns, captured, sizeof(captured) / sizeof(captured[0]));
+  kept.push_back("arch=x86_64");
+  kept.push_back("message=a,b");
+
+  for (unsigned int i = 0; i < sizeof(captured) / sizeof(captured[0]); i++)
+    {
+    if (strcmp(captured[i], "first_update=true"))
+      fail_unless(decode_arst(&decoded, NULL, NULL, captured[i], 0) == PBSE_NONE);
+    }
+
+  fail_unless(ns.encode(&encoded, kept) == PBSE_NONE);
+  fail_unless((encoded.at_flags & ATR_VFLAG_SET) != 0);
+
+  /* one encode() leaves the strings just like a decode_arst() per stored string */
+  enc = encoded.at_val.at_arst;
+  dec = decoded.at_val.at_arst;
+  fail_unless(enc->as_usedptr == dec->as_usedptr + 2);
+  fail_unless(!strcmp(enc->as_string[0], "arch=x86_64"));
+  fail_unless(!strcmp(enc->as_string[1], "message=a,b"));
+
+  for (int i = 0; i < dec->as_usedptr; i++)
+    fail_unless(!strcmp(enc->as_string[i + 2], dec->as_string[i]), "'%s' vs '%s'", enc->as_string[i + 2], dec->as_string[i]);
+
+  fail_unless(enc->as_next <= enc->as_buf + enc->as_bufsize);
+
+  /* it can still be added to */
+  fail_unless(decode_arst(&encoded, NULL, NULL, "rectime=5", 0) == PBSE_NONE);
+  fail_unless(!strcmp(encoded.at_val.at_arst->as_string[0], "rectime=5"));
+  fail_unless(encoded.at_val.at_arst->as_usedptr == dec->as_usedptr + 3);
+
+  free_arst(&encoded);
+  free_arst(&decoded);
+  }
+END_TEST
+
+
+
+
+Suite *node_status_suite(void)
+  {
+  Suite *s = suite_create("node_status test suite methods");
+  TCase *tc_core = tcase_create("test_add");
+  tcase_add_test(tc_core, test_add);
+  suite_add_tcase(s, tc_core);
+  
+  tc_core = tcase_create("test_encode");
+  tcase_add_test(tc_core, test_encode);
+  suite_add_tcase(s, tc_core);
+  
+  return(s);
+  }
+
+void rundebug()
+  {
+  }
+
+int main(void)
+  {
+  int number_failed = 0;
+  SRunner *sr = NULL;
+  rundebug();
+  sr = srunner_create(node_status_suite());
+  srunner_set_log(sr, "node_status_suite.log");
+  srunner_run_all(sr, CK_NORMAL);
+  number_failed = srunner_ntests_failed(sr);
+  srunner_free(sr);
+  return(number_failed);
+  }
@@ -3,11 +3,58 @@
 #include "test_pbsd_init.h"
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
 #include "pbs_error.h"
-START_TEST(test_one)
+
+int recover_in_parallel(std::vector<std::string> &files, std::vector<void *> &results, void *(*recover)(const char *));
+
+void *recover_name(
+
+  const char *filename)
+
+  {
+  /* fail every file whose name starts with 'x' */
+  if (filename[0] == 'x')
+    return(NULL);
+
+  return(strdup(filename));
+  }
+
+START_TEST(test_recover_in_parallel)
   {
+  std::vector<std::string> files;
+  std::vector<void *>      results;
+  char                     buf[64];
+  int                      threads;
+
+  threads = recover_in_parallel(files, results, recover_name);
+  fail_unless(threads == 1);
+  fail_unless(results.size() == 0);
+
+  for (int i = 0; i < 1000; i++)
+    {
+    snprintf(buf, sizeof(buf), "%s%d.JB", (i % 10 == 0) ? "x" : "", i);
+    files.push_back(buf);
+    }
 
+  threads = recover_in_parallel(files, results, recover_name);
+  fail_unless(threads >= 1);
+  fail_unless(results.size() == files.size());
 
+  /* every result lands at the index of the file it was recovered from */
+  for (unsigned int i = 0; i < files.size(); i++)
+    {
+    if (i % 10 == 0)
+      fail_unless(results[i] == NULL);
+    else
+      {
+      fail_unless(results[i] != NULL);
+      fail_unless(files[i] == (char *)results[i]);
+      free(results[i]);
+      }
+    }
   }
 END_TEST
 
@@ -21,8 +68,8 @@ END_TEST
 Suite *pbsd_init_suite(void)
   {
   Suite *s = suite_create("pbsd_init_suite methods");
-  TCase *tc_core = tcase_create("test_one");
-  tcase_add_test(tc_core, test_one);
+  TCase *tc_core = tcase_create("test_recover_in_parallel");
+  tcase_add_test(tc_core, test_recover_in_parallel);
   suite_add_tcase(s, tc_core);
 
   tc_core = tcase_create("test_two");
@@ -493,6 +493,22 @@ work_task *pop_timed_task(
   return(NULL);
   }
 
+int pop_expired_timed_tasks(
+
+  time_t                    time_now,
+  std::vector<work_task *> &expired)
+
+  {
+  return(0);
+  }
+
+void insert_timed_task(
+
+  work_task *wt)
+
+  {
+  }
+
 void *remove_extra_recycle_jobs(void *)
   {
   return(NULL);
@@ -504,3 +520,6 @@ void mom_hierarchy_handler::checkAndSendHierarchy(void)
 
 void clear_all_alps_reservations() {}
 
+void *group_commit_task(void *vp) {return(NULL);}
+int flush_dirty_files() {return(0);}
+
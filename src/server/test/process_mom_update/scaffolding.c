@@ -12,6 +12,7 @@
 #include "pbs_job.h"
 #include "u_tree.h"
 #include "id_map.hpp"
+#include "server.h"
 
 #include "id_map.hpp"
 
@@ -61,6 +62,9 @@ int get_svr_attr_l(
   long *l)
 
   {
+  if (attr_index == SRV_ATR_MomJobSync)
+    *l = 1;
+
   return(0);
   }
 
@@ -104,6 +108,7 @@ void *sync_node_jobs(
   }
 
 threadpool_t *task_pool;
+std::string   synced_jobs;
 
 int enqueue_threadpool_request(
 
@@ -112,6 +117,12 @@ int enqueue_threadpool_request(
   threadpool_t *tp)
 
   {
+  sync_job_info *sji = (sync_job_info *)arg;
+
+  synced_jobs = sji->input;
+  free(sji->input);
+  free(sji);
+
   return(0);
   }
 
@@ -126,12 +137,16 @@ int lock_node(
   return(0);
   }
 
+int             reported_state = -1;
+struct pbsnode *found_node;
+
 void update_node_state(
 
   struct pbsnode *np,         /* I (modified) */
   int             newstate)   /* I (one of INUSE_*) */
 
   {
+  reported_state = newstate;
   }
 
 struct pbsnode *find_nodebyname(
@@ -139,7 +154,7 @@ struct pbsnode *find_nodebyname(
   const char *nodename) /* I */
 
   {
-  return(NULL);
+  return(found_node);
   }
 
 int unlock_node(
@@ -167,6 +182,10 @@ struct prop *init_prop(
   return(NULL);
   }
 
+void update_prop_bits(struct pbsnode *pnode) {}
+
+void update_node_capacity(struct pbsnode *pnode) {}
+
 int is_job_on_node(
 
   struct pbsnode *pnode, /* I */
@@ -183,6 +202,8 @@ int node_status_list(
   int            actmode)       /*action mode; "NEW" or "ALTER"   */
 
   {
+  ((struct pbsnode *)pnode)->nd_status = new_attr->at_val.at_arst;
+
   return(0);
   }
 
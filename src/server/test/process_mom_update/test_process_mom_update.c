@@ -1,7 +1,49 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string>
+#include <vector>
+
+#include "pbs_nodes.h"
+#include "attribute.h"
+#include "pbs_error.h"
+#include "node_status.hpp"
 #include <check.h>
 
+void merge_status_delta(struct pbsnode *np, const node_status &ns, std::vector<const char *> &kept);
+int process_status_info(char *nd_name, std::vector<std::string> &status_info);
+
+extern int             reported_state;
+extern struct pbsnode *found_node;
+extern std::string     synced_jobs;
+
+
+struct array_strings *make_arst(
+
+  const char **strings,
+  int          count)
+
+  {
+  struct array_strings *arst = (struct array_strings *)calloc(1, sizeof(struct array_strings) + count * sizeof(char *));
+
+  arst->as_npointers = count;
+  arst->as_usedptr = count;
+
+  for (int i = 0; i < count; i++)
+    arst->as_string[i] = (char *)strings[i];
+
+  return(arst);
+  }
+
+
+void free_arst_strings(
+
+  struct array_strings *arst)
+
+  {
+  free(arst->as_buf);
+  free(arst);
+  }
+
 
 START_TEST(test_one)
   {
@@ -19,6 +61,167 @@ END_TEST
 
 
 
+START_TEST(merge_status_delta_test)
+  {
+  struct pbsnode             pnode;
+  node_status                ns;
+  std::vector<const char *>  kept;
+  const char                *stored[] = { "arch=linux", "gres=a:1", "b:2", "varattr=x", "rectime=5",
+                                          "availmem=100kb", "message=a,b", "state=free" };
+
+  ns.add("status_delta=true", strlen("status_delta=true"));
+  ns.add("status_removed=varattr", strlen("status_removed=varattr"));
+  ns.add("state=busy", strlen("state=busy"));
+  ns.add("availmem=200kb", strlen("availmem=200kb"));
+
+  /* nothing stored, nothing to carry over */
+  pnode.nd_status = NULL;
+  merge_status_delta(&pnode, ns, kept);
+  fail_unless(kept.size() == 0);
+
+  /* keep what wasn't sent, removed or stamped */
+  pnode.nd_status = make_arst(stored, 8);
+  merge_status_delta(&pnode, ns, kept);
+  fail_unless(kept.size() == 4, "%d strings carried over", (int)kept.size());
+  fail_unless(!strcmp(kept[0], "arch=linux"));
+  fail_unless(!strcmp(kept[1], "gres=a:1"));
+  fail_unless(!strcmp(kept[2], "b:2"));
+  fail_unless(!strcmp(kept[3], "message=a,b"));
+
+  /* a new value replaces everything that was split off the old one */
+  ns.clear();
+  ns.add("status_delta=true", strlen("status_delta=true"));
+  ns.add("gres=c:3", strlen("gres=c:3"));
+  kept.clear();
+  merge_status_delta(&pnode, ns, kept);
+  fail_unless(kept.size() == 5, "%d strings carried over", (int)kept.size());
+  fail_unless(!strcmp(kept[0], "arch=linux"));
+  fail_unless(!strcmp(kept[1], "varattr=x"));
+  fail_unless(!strcmp(kept[2], "availmem=100kb"));
+  fail_unless(!strcmp(kept[4], "state=free"));
+
+  /* several keys can be removed at once */
+  ns.clear();
+  ns.add("status_delta=true", strlen("status_delta=true"));
+  ns.add("status_removed=arch,message", strlen("status_removed=arch,message"));
+  kept.clear();
+  merge_status_delta(&pnode, ns, kept);
+  fail_unless(kept.size() == 5, "%d strings carried over", (int)kept.size());
+  fail_unless(!strcmp(kept[0], "gres=a:1"));
+
+  free(pnode.nd_status);
+  }
+END_TEST
+
+
+
+
+START_TEST(process_status_info_test)
+  {
+  struct pbsnode           pnode;
+  std::vector<std::string> status;
+  struct array_strings    *stored;
+
+  pnode.nd_name = (char *)"n001";
+  pnode.nd_state = INUSE_FREE;
+  pnode.nd_power_state = POWER_STATE_RUNNING;
+  pnode.nd_mom_reported_down = FALSE;
+  pnode.nd_status = NULL;
+  found_node = &pnode;
+
+  status.push_back("node=n001");
+  status.push_back("first_update=true");
+  status.push_back("state=busy");
+  status.push_back("jobs=1.svr 2.svr");
+  status.push_back("gres=a:1,b:2");
+  status.push_back("availmem=100kb");
+
+  fail_unless(process_status_info(pnode.nd_name, status) == SEND_HELLO);
+  fail_unless(reported_state == INUSE_BUSY);
+  fail_unless(synced_jobs == "n001:1.svr 2.svr", synced_jobs.c_str());
+
+  /* first_update=true asks for the hierarchy, it isn't part of the status */
+  stored = pnode.nd_status;
+  fail_unless(stored != NULL);
+  fail_unless(stored->as_usedptr == 5, "%d strings stored", stored->as_usedptr);
+  fail_unless(!strcmp(stored->as_string[0], "availmem=100kb"));
+  fail_unless(!strcmp(stored->as_string[1], "gres=a:1"));
+  fail_unless(!strcmp(stored->as_string[2], "b:2"));
+  fail_unless(!strcmp(stored->as_string[4], "state=busy"));
+
+  /* a delta keeps what it didn't mention */
+  status.clear();
+  status.push_back("node=n001");
+  status.push_back("status_delta=true");
+  status.push_back("state=free");
+  status.push_back("availmem=200kb");
+
+  fail_unless(process_status_info(pnode.nd_name, status) == PBSE_NONE);
+  fail_unless(reported_state == INUSE_FREE);
+  fail_unless(pnode.nd_status->as_usedptr == 5, "%d strings stored", pnode.nd_status->as_usedptr);
+  fail_unless(!strcmp(pnode.nd_status->as_string[0], "gres=a:1"));
+  fail_unless(!strcmp(pnode.nd_status->as_string[1], "b:2"));
+  fail_unless(!strcmp(pnode.nd_status->as_string[3], "availmem=200kb"));
+  fail_unless(!strcmp(pnode.nd_status->as_string[4], "state=free"));
+
+  free_arst_strings(stored);
+  free_arst_strings(pnode.nd_status);
+  found_node = NULL;
+  }
+END_TEST
+
+
+
+
+START_TEST(process_status_info_gpu_test)
+  {
+  struct pbsnode           pnode;
+  std::vector<std::string> status;
+  struct array_strings    *stored;
+
+  memset(&pnode, 0, sizeof(pnode));
+  pnode.nd_name = (char *)"n002";
+  pnode.nd_state = INUSE_FREE;
+  pnode.nd_power_state = POWER_STATE_RUNNING;
+  found_node = &pnode;
+
+  status.push_back("node=n002");
+  status.push_back("first_update=true");
+  status.push_back("state=free");
+  status.push_back(START_GPU_STATUS);
+  status.push_back("timestamp=Mon Jan 1 00:00:00 2024");
+  status.push_back(END_GPU_STATUS);
+  status.push_back("availmem=100kb");
+
+  fail_unless(process_status_info(pnode.nd_name, status) == SEND_HELLO);
+
+  /* neither the gpu block, its end marker nor first_update are stored */
+  stored = pnode.nd_status;
+  fail_unless(stored != NULL);
+  fail_unless(stored->as_usedptr == 2, "%d strings stored", stored->as_usedptr);
+  fail_unless(!strcmp(stored->as_string[0], "availmem=100kb"));
+  fail_unless(!strcmp(stored->as_string[1], "state=free"));
+
+  /* a block without its end marker ends the status */
+  status.clear();
+  status.push_back("node=n002");
+  status.push_back("state=busy");
+  status.push_back(START_GPU_STATUS);
+  status.push_back("timestamp=Mon Jan 1 00:00:00 2024");
+
+  fail_unless(process_status_info(pnode.nd_name, status) == PBSE_NONE);
+  fail_unless(pnode.nd_status->as_usedptr == 1, "%d strings stored", pnode.nd_status->as_usedptr);
+  fail_unless(!strcmp(pnode.nd_status->as_string[0], "state=busy"));
+
+  free_arst_strings(stored);
+  free_arst_strings(pnode.nd_status);
+  found_node = NULL;
+  }
+END_TEST
+
+
+
+
 Suite *process_mom_update_suite(void)
   {
   Suite *s = suite_create("process_mom_update test suite methods");
@@ -29,6 +232,18 @@ Suite *process_mom_update_suite(void)
   tc_core = tcase_create("test_two");
   tcase_add_test(tc_core, test_two);
   suite_add_tcase(s, tc_core);
+
+  tc_core = tcase_create("merge_status_delta_test");
+  tcase_add_test(tc_core, merge_status_delta_test);
+  suite_add_tcase(s, tc_core);
+
+  tc_core = tcase_create("process_status_info_test");
+  tcase_add_test(tc_core, process_status_info_test);
+  suite_add_tcase(s, tc_core);
+
+  tc_core = tcase_create("process_status_info_gpu_test");
+  tcase_add_test(tc_core, process_status_info_gpu_test);
+  suite_add_tcase(s, tc_core);
   
   return(s);
   }
@@ -0,0 +1,139 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <check.h>
+
+#include "prop_index.hpp"
+
+
+START_TEST(test_bitset_ops)
+  {
+  prop_bitset have;
+  prop_bitset need;
+
+  fail_unless(prop_bitset_next(have, -1) == -1);
+  fail_unless(prop_bitset_test(have, 3) == false);
+
+  prop_bitset_set(have, 3);
+  prop_bitset_set(have, 70);
+  prop_bitset_set(have, 200);
+
+  fail_unless(prop_bitset_test(have, 3) == true);
+  fail_unless(prop_bitset_test(have, 4) == false);
+  fail_unless(prop_bitset_test(have, 70) == true);
+  fail_unless(prop_bitset_test(have, 5000) == false);
+
+  fail_unless(prop_bitset_next(have, -1) == 3);
+  fail_unless(prop_bitset_next(have, 3) == 70);
+  fail_unless(prop_bitset_next(have, 70) == 200);
+  fail_unless(prop_bitset_next(have, 200) == -1);
+
+  // an empty need is always contained
+  fail_unless(prop_bitset_contains(have, need) == true);
+
+  prop_bitset_set(need, 70);
+  fail_unless(prop_bitset_contains(have, need) == true);
+
+  prop_bitset_set(need, 71);
+  fail_unless(prop_bitset_contains(have, need) == false);
+
+  // need is longer than have
+  need.clear();
+  prop_bitset_set(need, 300);
+  fail_unless(prop_bitset_contains(have, need) == false);
+  }
+END_TEST
+
+
+
+
+START_TEST(test_index)
+  {
+  property_index pi;
+  prop_bitset    napali;
+  prop_bitset    waimea;
+  prop_bitset    empty;
+  prop_bitset    want;
+  prop_bitset    nodes;
+
+  int bigmem = pi.intern("bigmem");
+  int gpu    = pi.intern("gpu");
+  int fast   = pi.intern("fast");
+
+  fail_unless(pi.intern("gpu") == gpu);
+  fail_unless(pi.get_id("fast") == fast);
+  fail_unless(pi.get_id("slow") == -1);
+
+  // node 1 has bigmem and gpu, node 100 has gpu and fast
+  prop_bitset_set(napali, bigmem);
+  prop_bitset_set(napali, gpu);
+  pi.set_node_props(1, empty, napali);
+
+  prop_bitset_set(waimea, gpu);
+  prop_bitset_set(waimea, fast);
+  pi.set_node_props(100, empty, waimea);
+
+  fail_unless(pi.nodes_with_all(empty, nodes) == false);
+
+  prop_bitset_set(want, gpu);
+  fail_unless(pi.nodes_with_all(want, nodes) == true);
+  fail_unless(prop_bitset_next(nodes, -1) == 1);
+  fail_unless(prop_bitset_next(nodes, 1) == 100);
+  fail_unless(prop_bitset_next(nodes, 100) == -1);
+
+  prop_bitset_set(want, fast);
+  fail_unless(pi.nodes_with_all(want, nodes) == true);
+  fail_unless(prop_bitset_next(nodes, -1) == 100);
+  fail_unless(prop_bitset_next(nodes, 100) == -1);
+
+  // node 100 loses fast
+  pi.set_node_props(100, waimea, napali);
+  fail_unless(pi.nodes_with_all(want, nodes) == true);
+  fail_unless(prop_bitset_next(nodes, -1) == -1);
+
+  want.clear();
+  prop_bitset_set(want, bigmem);
+  fail_unless(pi.nodes_with_all(want, nodes) == true);
+  fail_unless(prop_bitset_next(nodes, -1) == 1);
+  fail_unless(prop_bitset_next(nodes, 1) == 100);
+
+  // node 1 is deleted
+  pi.set_node_props(1, napali, empty);
+  fail_unless(pi.nodes_with_all(want, nodes) == true);
+  fail_unless(prop_bitset_next(nodes, -1) == 100);
+  fail_unless(prop_bitset_next(nodes, 100) == -1);
+  }
+END_TEST
+
+
+
+
+Suite *prop_index_suite(void)
+  {
+  Suite *s = suite_create("prop_index test suite methods");
+  TCase *tc_core = tcase_create("test_bitset_ops");
+  tcase_add_test(tc_core, test_bitset_ops);
+  suite_add_tcase(s, tc_core);
+  
+  tc_core = tcase_create("test_index");
+  tcase_add_test(tc_core, test_index);
+  suite_add_tcase(s, tc_core);
+  
+  return(s);
+  }
+
+void rundebug()
+  {
+  }
+
+int main(void)
+  {
+  int number_failed = 0;
+  SRunner *sr = NULL;
+  rundebug();
+  sr = srunner_create(prop_index_suite());
+  srunner_set_log(sr, "prop_index_suite.log");
+  srunner_run_all(sr, CK_NORMAL);
+  number_failed = srunner_ntests_failed(sr);
+  srunner_free(sr);
+  return(number_failed);
+  }
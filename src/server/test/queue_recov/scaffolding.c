@@ -90,3 +90,5 @@ void log_err(int errnum, const char *routine, const char *text) {}
 void log_record(int eventtype, int objclass, const char *objname, const char *text) {}
 void log_event(int eventtype, int objclass, const char *objname, const char *text) {}
 
+
+unsigned long mark_file_dirty(const char *path) {return(0);}
@@ -3,6 +3,7 @@
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <netdb.h>
+#include <sstream>
 
 #include "u_tree.h"
 #include "dynamic_string.h"
@@ -13,6 +14,7 @@
 #include "execution_slot_tracker.hpp"
 #include "execution_slot_tracker.hpp"
 #include "mom_hierarchy_handler.h"
+#include "dis.h"
 
 
 int         allow_any_mom;
@@ -36,6 +38,9 @@ const char *dis_emsg[] =
   };
 
 threadpool_t *task_pool;
+int           enqueued = 0;
+int           enqueue_rc = 0;
+std::vector<std::vector<std::string> > applied;
 
 
 char * netaddr(struct sockaddr_in *ap)
@@ -91,7 +96,8 @@ int enqueue_threadpool_request(
   threadpool_t *tp)
 
   {
-  return(0);
+  enqueued++;
+  return(enqueue_rc);
   }
 
 int lock_node(
@@ -182,13 +188,40 @@ struct pbsnode *AVL_find(
   return(NULL);
   }
 
+std::vector<std::string> dis_strings;
+
 char *disrst(
 
   struct tcp_chan *chan,
   int *retval)
 
   {
-  return(NULL);
+  char *str;
+
+  if (dis_strings.size() == 0)
+    {
+    *retval = DIS_EOF;
+    return(NULL);
+    }
+
+  str = strdup(dis_strings[0].c_str());
+  dis_strings.erase(dis_strings.begin());
+  *retval = DIS_SUCCESS;
+
+  return(str);
+  }
+
+void unpack_status_frame(
+
+  const char               *frame,
+  std::vector<std::string> &strings)
+
+  {
+  std::stringstream packed(frame);
+  std::string       str;
+
+  while (std::getline(packed, str))
+    strings.push_back(str);
   }
 
 long disrsl(
@@ -215,6 +248,7 @@ int process_status_info(
   std::vector<std::string> &status_info)
 
   {
+  applied.push_back(status_info);
   return(0);
   }
 
@@ -1,7 +1,58 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string>
+#include <vector>
+
+#include "pbs_nodes.h"
+#include "pbs_error.h"
+#include "mom_update.h"
+#include "mom_hierarchy.h"
 #include <check.h>
 
+void get_status_info(struct tcp_chan *chan, std::vector<std::string> &status);
+
+extern int enqueued;
+extern int enqueue_rc;
+extern std::vector<std::vector<std::string> > applied;
+extern std::vector<std::string> dis_strings;
+
+
+queued_status make_status(
+
+  const char *sender,
+  const char *strings[])
+
+  {
+  queued_status qs;
+
+  qs.sender = sender;
+  gettimeofday(&qs.received, NULL);
+
+  for (int i = 0; strings[i] != NULL; i++)
+    qs.strings.push_back(strings[i]);
+
+  return(qs);
+  }
+
+
+bool status_is(
+
+  std::vector<std::string> &status,
+  const char               *strings[])
+
+  {
+  unsigned int i;
+
+  for (i = 0; strings[i] != NULL; i++)
+    {
+    if ((i >= status.size()) ||
+        (status[i] != strings[i]))
+      return(false);
+    }
+
+  return(i == status.size());
+  }
+
 
 START_TEST(test_one)
   {
@@ -19,6 +70,143 @@ END_TEST
 
 
 
+START_TEST(fold_full_status_test)
+  {
+  const char   *waiting[] = {"node=n1", "first_update=true", "state=free", "jobs=", NULL};
+  const char   *newer[] = {"node=n1", "state=busy", NULL};
+  const char   *folded[] = {"node=n1", "first_update=true", "state=busy", NULL};
+  queued_status queued = make_status("n1", waiting);
+  queued_status latest = make_status("parent", newer);
+
+  /* a full status replaces the waiting one, but keeps the hierarchy request */
+  fail_unless(fold_node_status(queued, latest) == true);
+  fail_unless(status_is(queued.strings, folded));
+  fail_unless(queued.sender == "parent");
+  }
+END_TEST
+
+
+
+
+START_TEST(fold_status_delta_test)
+  {
+  const char   *full[] = {"node=n1", "state=free", "ncpus=4", "loadave=1.00", NULL};
+  const char   *delta[] = {"node=n1", STATUS_DELTA_KEYWORD, "state=busy", "<gpu_status>", "gpu[0]=x", "</gpu_status>", STATUS_REMOVED_KEYWORD "loadave", NULL};
+  const char   *onto_full[] = {"node=n1", "state=busy", "ncpus=4", "<gpu_status>", "gpu[0]=x", "</gpu_status>", NULL};
+  queued_status queued = make_status("n1", full);
+  queued_status latest = make_status("n1", delta);
+
+  fail_unless(fold_node_status(queued, latest) == true);
+  fail_unless(status_is(queued.strings, onto_full));
+
+  /* a delta folded into a delta stays a delta, and passes removals on */
+  const char   *delta1[] = {"node=n1", STATUS_DELTA_KEYWORD, "state=free", STATUS_REMOVED_KEYWORD "gres", NULL};
+  const char   *delta2[] = {"node=n1", STATUS_DELTA_KEYWORD, "gres=a", "state=busy", STATUS_REMOVED_KEYWORD "ncpus", NULL};
+  const char   *onto_delta[] = {"node=n1", STATUS_DELTA_KEYWORD, "state=busy", "gres=a", STATUS_REMOVED_KEYWORD "ncpus", NULL};
+
+  queued = make_status("n1", delta1);
+  latest = make_status("n1", delta2);
+  fail_unless(fold_node_status(queued, latest) == true);
+  fail_unless(status_is(queued.strings, onto_delta));
+
+  /* numa boards share their keys, so deltas aren't folded into them */
+  const char   *numa[] = {"node=n1", "numa0", "state=free", "numa1", "state=free", NULL};
+  const char   *numa_copy[] = {"node=n1", "numa0", "state=free", "numa1", "state=free", NULL};
+
+  queued = make_status("n1", numa);
+  latest = make_status("n1", delta);
+  fail_unless(fold_node_status(queued, latest) == false);
+  fail_unless(status_is(queued.strings, numa_copy));
+  }
+END_TEST
+
+
+
+
+START_TEST(queue_status_info_test)
+  {
+  const char               *first[] = {"node=n1", "state=free", "node=n2", "state=free", NULL};
+  const char               *second[] = {"node=n1", "state=busy", NULL};
+  const char               *delta[] = {"node=n3", STATUS_DELTA_KEYWORD, "state=busy", NULL};
+  const char               *n1[] = {"node=n1", "state=busy", NULL};
+  queued_status             update;
+  long                      depth;
+  long                      lag;
+
+  /* leave the queue to the test */
+  applied.clear();
+  enqueued = 0;
+  enqueue_rc = 0;
+
+  update = make_status("n1", first);
+  fail_unless(queue_status_info((char *)"n1", update.strings) == PBSE_NONE);
+  update = make_status("n1", second);
+  fail_unless(queue_status_info((char *)"n1", update.strings) == PBSE_NONE);
+
+  /* n1's second status was folded into its first */
+  get_status_queue_stats(&depth, &lag);
+  fail_unless(depth == 2, "depth %ld", depth);
+  fail_unless(lag >= 0);
+  fail_unless(enqueued == 2);
+
+  /* n3 has nothing for the delta to be applied to */
+  update = make_status("n1", delta);
+  fail_unless(queue_status_info((char *)"n1", update.strings) == NEED_FULL_STATUS);
+
+  /* run the threads that were asked for, one for each node that was ready */
+  fail_unless(enqueued == 3);
+
+  for (int i = 0; i < enqueued; i++)
+    apply_queued_statuses(NULL);
+
+  get_status_queue_stats(&depth, &lag);
+  fail_unless(depth == 0);
+  fail_unless(lag == 0);
+  fail_unless(applied.size() == 3);
+  fail_unless(status_is(applied[0], n1));
+
+  /* without a free thread the update is applied right away */
+  enqueue_rc = -1;
+  update = make_status("n1", second);
+  fail_unless(queue_status_info((char *)"n1", update.strings) == PBSE_NONE);
+  fail_unless(applied.size() == 4);
+  get_status_queue_stats(&depth, &lag);
+  fail_unless(depth == 0);
+  enqueue_rc = 0;
+  }
+END_TEST
+
+
+
+
+START_TEST(get_status_info_test)
+  {
+  std::vector<std::string> status;
+
+  dis_strings.push_back("node=n001");
+  dis_strings.push_back("state=free");
+  dis_strings.push_back(STATUS_FRAME_KEYWORD "node=n002\nstate=busy\n");
+  dis_strings.push_back("opsys=linux");
+  dis_strings.push_back(IS_EOL_MESSAGE);
+  dis_strings.push_back("after=eol");
+
+  get_status_info(NULL, status);
+
+  /* the frame's strings take its place */
+  fail_unless(status.size() == 5, "%d strings read", (int)status.size());
+  fail_unless(status[1] == "state=free");
+  fail_unless(status[2] == "node=n002");
+  fail_unless(status[3] == "state=busy");
+  fail_unless(status[4] == "opsys=linux");
+  fail_unless(dis_strings.size() == 1);
+
+  dis_strings.clear();
+  }
+END_TEST
+
+
+
+
 Suite *receive_mom_communication_suite(void)
   {
   Suite *s = suite_create("receive_mom_communication test suite methods");
@@ -29,6 +217,19 @@ Suite *receive_mom_communication_suite(void)
   tc_core = tcase_create("test_two");
   tcase_add_test(tc_core, test_two);
   suite_add_tcase(s, tc_core);
+
+  tc_core = tcase_create("fold_node_status_test");
+  tcase_add_test(tc_core, fold_full_status_test);
+  tcase_add_test(tc_core, fold_status_delta_test);
+  suite_add_tcase(s, tc_core);
+
+  tc_core = tcase_create("queue_status_info_test");
+  tcase_add_test(tc_core, queue_status_info_test);
+  suite_add_tcase(s, tc_core);
+
+  tc_core = tcase_create("get_status_info_test");
+  tcase_add_test(tc_core, get_status_info_test);
+  suite_add_tcase(s, tc_core);
   
   return(s);
   }
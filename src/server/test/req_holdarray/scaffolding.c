@@ -93,3 +93,8 @@ int unlock_ai_mutex(job_array *pa, const char *id, const char *msg, int logging)
   }
 
 void log_event(int eventtype, int objclass, const char *objname, const char *text) {}
+
+int materialize_virtual_subjobs(job_array **pa_ptr)
+  {
+  return(0);
+  }
@@ -156,3 +156,8 @@ batch_request *duplicate_request(batch_request *preq, int type)
   {
   return(NULL);
   }
+
+int materialize_virtual_subjobs(job_array **pa_ptr)
+  {
+  return(0);
+  }
@@ -167,6 +167,10 @@ struct prop *init_prop(char *pname)
   exit(1);
   }
 
+void update_prop_bits(struct pbsnode *pnode) {}
+
+void update_node_capacity(struct pbsnode *pnode) {}
+
 int attr_atomic_set(struct svrattrl *plist, pbs_attribute *old, pbs_attribute *new_attr, attribute_def *pdef, int limit, int unkn, int privil, int *badattr)
   {
   fprintf(stderr, "The call to attr_atomic_set to be mocked!!\n");
@@ -28,8 +28,10 @@ int   is_attr_set;
 
 struct batch_request *alloc_br(int type)
   {
-  fprintf(stderr, "The call to alloc_br to be mocked!!\n");
-  exit(1);
+  batch_request *preq = (batch_request *)calloc(1, sizeof(batch_request));
+
+  preq->rq_type = type;
+  return(preq);
   }
 
 int job_save(job *pjob, int updatetype, int mom_port)
@@ -40,6 +40,10 @@ int req_register(batch_request *preq);
 bool remove_array_dependency_job_from_job(struct array_depend *pdep, job *pjob, char *job_array_id);
 void removeAfterAnyDependency(const char *pJobID, const char *targetJob);
 bool job_ids_match(const char *parent, const char *child);
+int send_depend_req(job *pjob, struct depend_job *pparent, int type, int op, int schedhint, void (*postfunc)(batch_request *), bool bAsyncOk);
+bool depend_svr_is_local(char *svr);
+depend_job *alloc_dependjob(const char *jobid, const char *host);
+void free_br(batch_request *preq);
 
 
 extern char server_name[];
@@ -782,6 +786,37 @@ END_TEST
 
 
 
+START_TEST(send_depend_req_local_test)
+  {
+  job        *pjob = job_alloc();
+  depend_job *pparent = alloc_dependjob(job1, host);
+
+  strcpy(server_name, host);
+  fail_unless(depend_svr_is_local(host) == true);
+  fail_unless(depend_svr_is_local((char *)"") == false);
+
+  strcpy(pjob->ji_qs.ji_jobid, "3.napali");
+  pjob->ji_wattr[JOB_ATR_job_owner].at_val.at_str = strdup("dbeer@napali");
+  pGlobalJob = pjob;
+
+  /* local edges are resolved in place - que_to_local_svr() and issue_to_svr()
+   * exit if they are reached */
+  fail_unless(send_depend_req(pjob, pparent, JOB_DEPEND_TYPE_AFTEROK, JOB_DEPEND_OP_RELEASE, 0, free_br, true) == PBSE_NONE);
+  fail_unless(send_depend_req(pjob, pparent, JOB_DEPEND_TYPE_AFTEROK, JOB_DEPEND_OP_REGISTER, 0, free_br, false) == PBSE_NONE);
+
+  /* an unknown parent is only reported to callers that wait on the answer */
+  strcpy(pparent->dc_child, "bob");
+  fail_unless(send_depend_req(pjob, pparent, JOB_DEPEND_TYPE_AFTEROK, JOB_DEPEND_OP_RELEASE, 0, free_br, true) == PBSE_NONE);
+  fail_unless(send_depend_req(pjob, pparent, JOB_DEPEND_TYPE_AFTEROK, JOB_DEPEND_OP_RELEASE, 0, free_br, false) == PBSE_UNKJOBID);
+
+  pGlobalJob = NULL;
+  server_name[0] = '\0';
+  }
+END_TEST
+
+
+
+
 Suite *req_register_suite(void)
   {
   Suite *s = suite_create("req_register_suite methods");
@@ -824,6 +859,7 @@ Suite *req_register_suite(void)
   tcase_add_test(tc_core, set_depend_hold_test);
   tcase_add_test(tc_core, delete_dependency_job_test);
   tcase_add_test(tc_core, remove_after_any_test);
+  tcase_add_test(tc_core, send_depend_req_local_test);
   tcase_add_test(tc_core, req_register_test);
   tcase_add_test(tc_core, set_array_depend_holds_test);
   tcase_add_test(tc_core, remove_array_dependency_from_job_test);
@@ -347,3 +347,24 @@ void log_record(int eventtype, int objclass, const char *objname, const char *te
 void log_event(int eventtype, int objclass, const char *objname, const char *text) {}
 
 int svr_unresolvednodes = 0;
+
+job *materialize_subjob(const char *jobid)
+  {
+  return(NULL);
+  }
+
+void get_status_queue_stats(long *depth, long *lag)
+  {
+  *depth = 0;
+  *lag = 0;
+  }
+
+bool array_index_is_virtual(job_array *pa, int index)
+  {
+  return(false);
+  }
+
+int status_virtual_subjob(job *template_job, int taskid, struct batch_request *preq, svrattrl *pal, tlist_head *pstathd, bool condensed, int *bad)
+  {
+  return(0);
+  }
@@ -6,6 +6,7 @@
 #include "server.h" /* server */
 #include "batch_request.h" /* batch_request */
 #include "list_link.h" /* list_link */
+#include "pbs_job.h" /* job */
 
 attribute_def job_attr_def[10];
 struct server server;
@@ -48,3 +49,7 @@ int get_svr_attr_l(int index, long *l)
   }
 
 void log_event(int eventtype, int objclass, const char *objname, const char *text) {}
+
+void subjob_id(const char *array_id, int taskid, char *buf, size_t buflen) {}
+
+void clone_subjob_attributes(job *template_job, pbs_attribute *wattr, int taskid) {}
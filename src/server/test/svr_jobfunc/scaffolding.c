@@ -66,6 +66,7 @@ pbs_queue *find_queuebyname(const char *quename)
   pq->qu_jobs_array_sum = new all_jobs();
 
   snprintf(pq->qu_qs.qu_name, sizeof(pq->qu_qs.qu_name), "%s", quename);
+  pq->qu_attr[QA_ATR_QType].at_val.at_str = strdup("Execution");
 
   /* set up the user info struct */
   pq->qu_uih = (user_info_holder *)calloc(1, sizeof(user_info_holder));
@@ -451,3 +452,7 @@ char *csv_nth(const char *csv_str, int n)
   exit(1);
   }
 
+
+void job_index_add(job *pjob) {}
+void job_index_remove(const char *jobid) {}
+void job_index_set_state(job *pjob) {}
@@ -76,6 +76,13 @@ START_TEST(chk_mppnodect_test)
   }
 END_TEST
 
+void free_in_queue(pbs_attribute *pattr) {}
+
+int decode_in_queue(pbs_attribute *pattr, const char *name, const char *rescn, const char *val, int perm)
+  {
+  return(0);
+  }
+
 START_TEST(svr_enquejob_test)
   {
   struct job test_job;
@@ -95,9 +102,14 @@ START_TEST(svr_enquejob_test)
   result = svr_enquejob(NULL, 0, NULL, false);
   fail_unless(result != PBSE_NONE, "NULL input pointer fail");
 
+  /* the job stays locked while it is ranked into the queue, so it is never
+   * looked up again and the attribute updates that follow are reached */
+  job_attr_def[JOB_ATR_in_queue].at_free = free_in_queue;
+  job_attr_def[JOB_ATR_in_queue].at_decode = decode_in_queue;
+  test_job.ji_wattr[JOB_ATR_qtime].at_flags = ATR_VFLAG_SET;
+
   result = svr_enquejob(&test_job, 0, NULL, false);
-  /*Need more complicated mocking in order to have other result than PBSE_JOBNOTFOUND*/
-  fail_unless(result == PBSE_JOBNOTFOUND, "svr_enquejob fail: %d", result);
+  fail_unless(result == PBSE_NONE, "svr_enquejob fail: %d", result);
 
   }
 END_TEST
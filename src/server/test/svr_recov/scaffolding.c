@@ -147,3 +147,5 @@ int str_to_attr(
   {
   return(0);
   }
+
+unsigned long mark_file_dirty(const char *path) {return(0);}
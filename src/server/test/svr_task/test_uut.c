@@ -9,6 +9,7 @@
 extern void  check_nodes(struct work_task *ptask);
 void         insert_timed_task(work_task *wt);
 work_task   *pop_timed_task(time_t  time_now);
+void         delete_task(struct work_task *ptask);
 bool         can_dispatch_task();
 int          dispatch_timed_task(work_task *ptask);
 
@@ -16,7 +17,7 @@ int          dispatch_timed_task(work_task *ptask);
 extern all_tasks      task_list_event;
 extern task_recycler  tr;
 extern threadpool_t  *request_pool;
-extern std::list<timed_task> *task_list_timed;
+extern timed_task_heap *task_list_timed;
 
 START_TEST(dispatch_timed_task_test)
   {
@@ -27,7 +28,7 @@ START_TEST(dispatch_timed_task_test)
   wt.wt_event = 200;
 
   if (task_list_timed == NULL)
-    task_list_timed = new std::list<timed_task>();
+    task_list_timed = new timed_task_heap();
 
   if (request_pool == NULL)
     initialize_threadpool(&request_pool,10,50,50);
@@ -74,7 +75,7 @@ START_TEST(manage_timed_task_test)
   memset(&ptask3, 0, sizeof(ptask3));
 
   if (task_list_timed == NULL)
-    task_list_timed = new std::list<timed_task>();
+    task_list_timed = new timed_task_heap();
 
   ptask1.wt_event = 100;
   ptask2.wt_event = 200;
@@ -103,6 +104,122 @@ START_TEST(manage_timed_task_test)
   }
 END_TEST
 
+START_TEST(timed_task_cancel_test)
+  {
+  work_task  tasks[5];
+  work_task *wt;
+  std::vector<work_task *> expired;
+
+  memset(tasks, 0, sizeof(tasks));
+
+  if (task_list_timed == NULL)
+    task_list_timed = new timed_task_heap();
+
+  for (int i = 0; i < 5; i++)
+    {
+    tasks[i].wt_event = 100 * (i + 1);
+    insert_timed_task(tasks + i);
+    fail_unless(tasks[i].wt_timed_index != 0);
+    }
+
+  // cancel one from the middle and the earliest
+  fail_unless(task_list_timed->remove(tasks + 2) == true);
+  fail_unless(tasks[2].wt_timed_index == 0);
+  fail_unless(task_list_timed->remove(tasks + 2) == false);
+  fail_unless(task_list_timed->remove(tasks) == true);
+  fail_unless(task_list_timed->size() == 3);
+
+  fail_unless(pop_expired_timed_tasks(400, expired) == 2);
+  fail_unless(expired[0] == tasks + 1);
+  fail_unless(expired[1] == tasks + 3);
+
+  wt = pop_timed_task(1000);
+  fail_unless(wt == tasks + 4);
+  fail_unless(task_list_timed->size() == 0);
+  }
+END_TEST
+
+START_TEST(timed_task_delete_in_dispatch_test)
+  {
+  work_task  tasks[3];
+  std::vector<work_task *> expired;
+
+  memset(tasks, 0, sizeof(tasks));
+  initialize_task_recycler();
+
+  if (task_list_timed == NULL)
+    task_list_timed = new timed_task_heap();
+
+  for (int i = 0; i < 3; i++)
+    {
+    tasks[i].wt_mutex = (pthread_mutex_t *)calloc(1, sizeof(pthread_mutex_t));
+    pthread_mutex_init(tasks[i].wt_mutex, NULL);
+    tasks[i].wt_event = 100 * (i + 1);
+    insert_timed_task(tasks + i);
+    }
+
+  fail_unless(pop_expired_timed_tasks(400, expired) == 3);
+  fail_unless(tasks[1].wt_timed_index == TIMED_TASK_DISPATCHING);
+
+  // deleting a popped task leaves it to check_tasks()
+  pthread_mutex_lock(tasks[1].wt_mutex);
+  delete_task(tasks + 1);
+  fail_unless(tasks[1].wt_timed_index == TIMED_TASK_CANCELLED);
+  fail_unless(tasks[1].wt_being_recycled == FALSE);
+
+  fail_unless(claim_timed_task(tasks) == true);
+  fail_unless(tasks[0].wt_timed_index == 0);
+  pthread_mutex_unlock(tasks[0].wt_mutex);
+
+  fail_unless(claim_timed_task(tasks + 1) == false);
+  fail_unless(tasks[1].wt_being_recycled == TRUE);
+
+  // once claimed a task is deleted as usual
+  fail_unless(claim_timed_task(tasks + 2) == true);
+  delete_task(tasks + 2);
+  fail_unless(tasks[2].wt_being_recycled == TRUE);
+  }
+END_TEST
+
+START_TEST(timed_task_order_test)
+  {
+  int                       num_tasks = 500000;
+  work_task                *tasks = (work_task *)calloc(num_tasks, sizeof(work_task));
+  std::vector<work_task *>  expired;
+  long                      last = 0;
+
+  if (task_list_timed == NULL)
+    task_list_timed = new timed_task_heap();
+
+  // a scattered, repeating set of times like re-armed poll_job_task timers
+  for (int i = 0; i < num_tasks; i++)
+    {
+    tasks[i].wt_event = ((long)i * 7919) % 3600;
+    insert_timed_task(tasks + i);
+    }
+
+  // cancel every tenth task
+  for (int i = 0; i < num_tasks; i += 10)
+    fail_unless(task_list_timed->remove(tasks + i) == true);
+
+  fail_unless(pop_expired_timed_tasks(1799, expired) > 0);
+  fail_unless(pop_expired_timed_tasks(3600, expired) > 0);
+  fail_unless((int)expired.size() == num_tasks - num_tasks / 10);
+  fail_unless(task_list_timed->size() == 0);
+
+  for (size_t i = 0; i < expired.size(); i++)
+    {
+    fail_unless(expired[i]->wt_event >= last);
+    last = expired[i]->wt_event;
+    }
+
+  // equal times come out in insertion order
+  fail_unless(expired[0] < expired[1]);
+
+  free(tasks);
+  }
+END_TEST
+
 START_TEST(test_one)
   {
   int rc;
@@ -110,7 +227,7 @@ START_TEST(test_one)
   initialize_task_recycler();
 
   if (task_list_timed == NULL)
-    task_list_timed = new std::list<timed_task>();
+    task_list_timed = new timed_task_heap();
 
   rc = initialize_threadpool(&request_pool, 5, 50, 60);
   fail_unless(rc == PBSE_NONE, "initalize_threadpool failed", rc);
@@ -145,6 +262,9 @@ Suite *svr_task_suite(void)
   tcase_add_test(tc_core, can_dispatch_task_test);
   tcase_add_test(tc_core, manage_timed_task_test);
   tcase_add_test(tc_core, dispatch_timed_task_test);
+  tcase_add_test(tc_core, timed_task_cancel_test);
+  tcase_add_test(tc_core, timed_task_delete_in_dispatch_test);
+  tcase_add_test(tc_core, timed_task_order_test);
   suite_add_tcase(s, tc_core);
 
   return s;
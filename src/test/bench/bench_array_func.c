@@ -0,0 +1,77 @@
+#include "license_pbs.h" /* See here for the software license */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "array.h"
+#include "pbs_job.h"
+#include "bench_timer.h"
+
+/*
+ * Times the virtual subjob indices of the largest array allowed: every index
+ * handed out from the request tokens, and single subjobs deleted at scattered
+ * indices first, which splits a token each time. Prints what the tokens hold
+ * next to what cloning every subjob up front would.
+ *
+ * usage: bench_array_func
+ */
+
+#define INDICES (PBS_MAXJOBARRAY + 1)
+#define DROPS   1000
+
+int parse_array_request(char *request, tlist_head *tl);
+
+
+
+int main(
+
+  int   argc,
+  char *argv[])
+
+  {
+  job_array           pa;
+  double              start;
+  int                 taken = 0;
+  int                 dropped = 0;
+  int                 step = INDICES / DROPS;
+  int                 tokens = 0;
+  char                request[64];
+  array_request_node *rn;
+
+  memset(&pa, 0, sizeof(pa));
+  CLEAR_HEAD(pa.request_tokens);
+  snprintf(request, sizeof(request), "0-%d", INDICES - 1);
+  BENCH_CHECK(parse_array_request(strdup(request), &pa.request_tokens) == 0);
+
+  /* a qdel of single subjobs spread over the array */
+  start = bench_now_usecs();
+
+  for (int i = 0; i < DROPS; i++)
+    dropped += array_drop_virtual_range(&pa, i * step, i * step);
+
+  bench_report_rate("bench_array_func", "scattered subjob drop", bench_elapsed_usecs(start), DROPS);
+
+  BENCH_CHECK(dropped == DROPS);
+  BENCH_CHECK(array_count_virtual_indices(&pa) == INDICES - DROPS);
+
+  for (rn = (array_request_node *)GET_NEXT(pa.request_tokens);
+       rn != NULL;
+       rn = (array_request_node *)GET_NEXT(rn->request_tokens_link))
+    tokens++;
+
+  start = bench_now_usecs();
+
+  while (array_next_virtual_index(&pa) >= 0)
+    taken++;
+
+  bench_report_rate("bench_array_func", "virtual index taken", bench_elapsed_usecs(start), taken);
+
+  BENCH_CHECK(taken == INDICES - DROPS);
+
+  printf("bench_array_func: %d indices: %lu bytes of request tokens vs %lu bytes of job structs cloned up front\n",
+    INDICES,
+    (unsigned long)(tokens * sizeof(array_request_node)),
+    (unsigned long)INDICES * sizeof(job));
+
+  return(0);
+  }
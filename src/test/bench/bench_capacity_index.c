@@ -0,0 +1,73 @@
+#include "license_pbs.h" /* See here for the software license */
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "capacity_index.hpp"
+#include "bench_timer.h"
+
+/*
+ * Times placing 8 slot jobs on clusters of 32 slot nodes where one node in
+ * twenty has room. Each placement asks the capacity index for the nodes with
+ * 8 free slots, takes the first and marks it busy, and a finished job frees
+ * another node. Also reports how many nodes each lookup offers.
+ *
+ * usage: bench_capacity_index
+ */
+
+#define PLACEMENTS 10000
+
+int node_counts[] = { 1000, 10000, 50000 };
+
+
+
+void run(
+
+  int num_nodes)
+
+  {
+  capacity_index ci;
+  prop_bitset    nodes;
+  long           offered = 0;
+  double         start;
+  int            id;
+  char           what[128];
+
+  for (int i = 0; i < num_nodes; i++)
+    ci.set_node_free(i, ((i % 20) == 0) ? 32 : 4);
+
+  start = bench_now_usecs();
+
+  for (int i = 0; i < PLACEMENTS; i++)
+    {
+    ci.nodes_with_free(8, nodes);
+
+    for (id = prop_bitset_next(nodes, -1); id != -1; id = prop_bitset_next(nodes, id))
+      offered++;
+
+    BENCH_CHECK((id = prop_bitset_next(nodes, -1)) != -1);
+
+    ci.set_node_free(id, 4);
+
+    /* a job finishes on some other node */
+    ci.set_node_free((id + 7 * (i + 1)) % num_nodes, 32);
+    }
+
+  snprintf(what, sizeof(what), "%d nodes, placement (%ld nodes offered each)",
+    num_nodes,
+    offered / PLACEMENTS);
+  bench_report_rate("bench_capacity_index", what, bench_elapsed_usecs(start), PLACEMENTS);
+  }
+
+
+
+int main(
+
+  int   argc,
+  char *argv[])
+
+  {
+  for (unsigned int i = 0; i < sizeof(node_counts) / sizeof(node_counts[0]); i++)
+    run(node_counts[i]);
+
+  return(0);
+  }
@@ -0,0 +1,149 @@
+#include "license_pbs.h" /* See here for the software license */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+
+#include "pbs_cgroup.h"
+#include "pbs_error.h"
+#include "bench_timer.h"
+
+/*
+ * Times reading job usage from the per job cgroups the way mom_get_sample()
+ * does, in a fake cgroup v2 hierarchy under /tmp. Runs many small jobs and
+ * a few large ones, and reports the cost of one sample of every job.
+ *
+ * usage: bench_cgroup
+ */
+
+#define SAMPLES 100
+
+struct job_mix
+  {
+  int jobs;
+  int procs;
+  };
+
+job_mix mixes[] = { { 100, 100 }, { 20, 1000 } };
+
+std::string root;
+
+
+
+void put_file(
+
+  std::string path,
+  const char *contents)
+
+  {
+  FILE *fp = fopen(path.c_str(), "w");
+
+  BENCH_CHECK(fp != NULL);
+  fputs(contents, fp);
+  fclose(fp);
+  }
+
+
+
+std::string job_dir(
+
+  const char *jobid)
+
+  {
+  return(root + "/" TORQUE_CGROUP "/" + jobid);
+  }
+
+
+
+void run(
+
+  job_mix &mix)
+
+  {
+  std::string        procs;
+  std::vector<pid_t> pids;
+  cgroup_usage       usage;
+  double             start;
+  double             usecs;
+  char               jobid[64];
+  char               line[32];
+  char               what[128];
+
+  for (int j = 0; j < mix.procs; j++)
+    {
+    snprintf(line, sizeof(line), "%d\n", 100000 + j);
+    procs += line;
+    }
+
+  for (int i = 0; i < mix.jobs; i++)
+    {
+    snprintf(jobid, sizeof(jobid), "%d-%d.napali", mix.procs, i);
+    BENCH_CHECK(create_job_cgroup(jobid) == PBSE_NONE);
+
+    put_file(job_dir(jobid) + "/cgroup.procs", procs.c_str());
+    put_file(job_dir(jobid) + "/cpu.stat", "usage_usec 12500000\nuser_usec 10000000\nsystem_usec 2500000\n");
+    put_file(job_dir(jobid) + "/memory.current", "4096000\n");
+    put_file(job_dir(jobid) + "/memory.stat", "anon 3000000\nfile 1000000\nfile_mapped 50000\n");
+    }
+
+  start = bench_now_usecs();
+
+  for (int sample = 0; sample < SAMPLES; sample++)
+    {
+    for (int i = 0; i < mix.jobs; i++)
+      {
+      snprintf(jobid, sizeof(jobid), "%d-%d.napali", mix.procs, i);
+      pids.clear();
+      BENCH_CHECK(read_job_cgroup_usage(jobid, usage, pids) == PBSE_NONE);
+      BENCH_CHECK((int)pids.size() == mix.procs);
+      }
+    }
+
+  usecs = bench_elapsed_usecs(start);
+
+  snprintf(what, sizeof(what), "%d jobs of %d processes, sample of every job", mix.jobs, mix.procs);
+  bench_report_rate("bench_cgroup", what, usecs, SAMPLES);
+
+  /* the pids are made up, so the cgroups are removed by hand rather than
+   * by delete_job_cgroup(), which would signal them */
+  for (int i = 0; i < mix.jobs; i++)
+    {
+    snprintf(jobid, sizeof(jobid), "%d-%d.napali", mix.procs, i);
+    unlink((job_dir(jobid) + "/cgroup.procs").c_str());
+    unlink((job_dir(jobid) + "/cpu.stat").c_str());
+    unlink((job_dir(jobid) + "/memory.current").c_str());
+    unlink((job_dir(jobid) + "/memory.stat").c_str());
+    rmdir(job_dir(jobid).c_str());
+    }
+  }
+
+
+
+int main(
+
+  int   argc,
+  char *argv[])
+
+  {
+  char root_template[] = "/tmp/bench_cgroupXXXXXX";
+
+  BENCH_CHECK(mkdtemp(root_template) != NULL);
+  root = root_template;
+
+  put_file(root + "/cgroup.controllers", "cpu memory");
+  put_file(root + "/cgroup.subtree_control", "");
+  BENCH_CHECK(init_job_cgroups(root.c_str()) == PBSE_NONE);
+
+  for (unsigned int i = 0; i < sizeof(mixes) / sizeof(mixes[0]); i++)
+    run(mixes[i]);
+
+  unlink((root + "/cgroup.controllers").c_str());
+  unlink((root + "/cgroup.subtree_control").c_str());
+  unlink((root + "/" TORQUE_CGROUP "/cgroup.subtree_control").c_str());
+  rmdir((root + "/" TORQUE_CGROUP).c_str());
+  rmdir(root.c_str());
+
+  return(0);
+  }
@@ -0,0 +1,105 @@
+#include "license_pbs.h" /* See here for the software license */
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "pbs_job.h"
+#include "bench_timer.h"
+
+/*
+ * Times taking a snapshot iterator right after a submission, which appends
+ * to the shared snapshot, against taking one after a swap, which makes the
+ * next scan rebuild the snapshot from the whole list. Runs at several
+ * queue lengths.
+ *
+ * usage: bench_job_container
+ */
+
+#define ROUNDS 200
+
+int job_counts[] = { 1000, 10000, 50000 };
+
+
+
+/* job_container.c logs through this, the unit test defines it the same way */
+void log_err(int, const char *, const char *) {}
+
+
+
+void time_snapshots(
+
+  all_jobs   &alljobs,
+  job       **jobs,
+  int         first,
+  bool        rebuild,
+  const char *what)
+
+  {
+  all_jobs_iterator *iter;
+  double             start = bench_now_usecs();
+
+  for (int i = first; i < first + ROUNDS; i++)
+    {
+    insert_job(&alljobs, jobs[i]);
+
+    if (rebuild == true)
+      swap_jobs(&alljobs, jobs[0], jobs[1]);
+
+    alljobs.lock();
+    iter = alljobs.get_snapshot_iterator();
+    alljobs.unlock();
+
+    /* only the first job is read, it's the snapshot that is being timed */
+    BENCH_CHECK(next_job(&alljobs, iter) != NULL);
+
+    delete iter;
+    }
+
+  bench_report_rate("bench_job_container", what, bench_elapsed_usecs(start), ROUNDS);
+  }
+
+
+
+void run(
+
+  int num_jobs)
+
+  {
+  all_jobs   alljobs;
+  job      **jobs = (job **)calloc(num_jobs + 2 * ROUNDS, sizeof(job *));
+  char       what[128];
+
+  BENCH_CHECK(jobs != NULL);
+
+  for (int i = 0; i < num_jobs + 2 * ROUNDS; i++)
+    {
+    BENCH_CHECK((jobs[i] = job_alloc()) != NULL);
+    sprintf(jobs[i]->ji_qs.ji_jobid, "%d.napali", i);
+
+    if (i < num_jobs)
+      insert_job(&alljobs, jobs[i]);
+    }
+
+  snprintf(what, sizeof(what), "%d jobs, snapshot after a submission", num_jobs);
+  time_snapshots(alljobs, jobs, num_jobs, false, what);
+
+  snprintf(what, sizeof(what), "%d jobs, snapshot after a swap", num_jobs);
+  time_snapshots(alljobs, jobs, num_jobs + ROUNDS, true, what);
+
+  alljobs.lock();
+  BENCH_CHECK(alljobs.count() == num_jobs + 2 * ROUNDS);
+  alljobs.unlock();
+  }
+
+
+
+int main(
+
+  int   argc,
+  char *argv[])
+
+  {
+  for (unsigned int i = 0; i < sizeof(job_counts) / sizeof(job_counts[0]); i++)
+    run(job_counts[i]);
+
+  return(0);
+  }
@@ -0,0 +1,266 @@
+#include "license_pbs.h" /* See here for the software license */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/select.h>
+
+#include "pbs_error.h"
+#include "server_limits.h"
+#include "net_connect.h"
+#include "lib_net.h"
+#include "bench_timer.h"
+
+/*
+ * Times wait_request() the way pbs_server uses it: thousands of idle client
+ * and mom connections registered and a hot subset with requests arriving.
+ * Reports the latency from a request's write to its dispatch, and from a
+ * connect() to the connection being accepted and its first request
+ * dispatched, under select() and epoll.
+ *
+ * usage: bench_net_server [idle connections, default 20000]
+ */
+
+#define HOT_CONNECTIONS   64
+#define HOT_PER_ROUND     8
+#define DISPATCH_ROUNDS   5000
+#define ACCEPTS           2000
+
+extern char *net_server_name;
+
+void *accept_conn(void *new_conn);
+
+int    idle_socks[PBS_NET_MAX_CONNECTIONS][2];
+int    hot_socks[HOT_CONNECTIONS][2];
+double dispatched_at[PBS_NET_MAX_CONNECTIONS];
+int    dispatched;
+int    last_dispatched;
+
+double dispatch_samples[DISPATCH_ROUNDS * HOT_PER_ROUND];
+double accept_samples[ACCEPTS];
+double first_dispatch_samples[ACCEPTS];
+
+
+
+void *read_ready_sock(
+
+  void *args)
+
+  {
+  int  sock = ((int *)args)[0];
+  char c;
+
+  dispatched_at[sock] = bench_now_usecs();
+  dispatched++;
+  last_dispatched = sock;
+
+  if (read(sock, &c, 1) != 1)
+    {
+    /* the client went away */
+    globalset_del_sock(sock);
+    }
+
+  return(NULL);
+  }
+
+
+
+void add_socketpairs(
+
+  int (*socks)[2],
+  int   count)
+
+  {
+  for (int i = 0; i < count; i++)
+    {
+    BENCH_CHECK(socketpair(AF_UNIX, SOCK_STREAM, 0, socks[i]) == 0);
+    BENCH_CHECK(add_conn(socks[i][0], FromClientDIS, 0, 0, PBS_SOCK_UNIX, read_ready_sock) == PBSE_NONE);
+    }
+  }
+
+
+
+void remove_socketpairs(
+
+  int (*socks)[2],
+  int   count)
+
+  {
+  for (int i = 0; i < count; i++)
+    {
+    close_conn(socks[i][0], FALSE);
+    close(socks[i][1]);
+    }
+  }
+
+
+
+/*
+ * time_dispatch() - writes to HOT_PER_ROUND of the hot connections at a time
+ * and waits until wait_request() has dispatched all of them
+ */
+
+void time_dispatch(
+
+  const char *what)
+
+  {
+  int    samples = 0;
+  double start;
+  double round_start;
+
+  start = bench_now_usecs();
+
+  for (int round = 0; round < DISPATCH_ROUNDS; round++)
+    {
+    int first = (round * HOT_PER_ROUND) % HOT_CONNECTIONS;
+
+    dispatched = 0;
+    round_start = bench_now_usecs();
+
+    for (int i = 0; i < HOT_PER_ROUND; i++)
+      BENCH_CHECK(write(hot_socks[(first + i) % HOT_CONNECTIONS][1], "x", 1) == 1);
+
+    while (dispatched < HOT_PER_ROUND)
+      BENCH_CHECK(wait_request(1, NULL) == PBSE_NONE);
+
+    for (int i = 0; i < HOT_PER_ROUND; i++)
+      dispatch_samples[samples++] = dispatched_at[hot_socks[(first + i) % HOT_CONNECTIONS][0]] - round_start;
+    }
+
+  bench_report_rate("bench_net_server", what, bench_elapsed_usecs(start), DISPATCH_ROUNDS);
+  bench_report_latencies("bench_net_server", "  write to dispatch", dispatch_samples, samples);
+  }
+
+
+
+/*
+ * time_accept() - connects to a listening socket registered like pbs_server's
+ * and times until the new connection is accepted, and until the request the
+ * client sends on it is dispatched
+ */
+
+void time_accept(
+
+  const char *path)
+
+  {
+  struct sockaddr_un addr;
+  int                listener;
+  double             connect_start;
+
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", path);
+  unlink(path);
+
+  BENCH_CHECK((listener = socket(AF_UNIX, SOCK_STREAM, 0)) >= 0);
+  BENCH_CHECK(bind(listener, (struct sockaddr *)&addr, sizeof(addr)) == 0);
+  BENCH_CHECK(listen(listener, 512) == 0);
+  BENCH_CHECK(add_conn(listener, Primary, 0, 0, PBS_SOCK_UNIX, accept_conn) == PBSE_NONE);
+
+  for (int i = 0; i < ACCEPTS; i++)
+    {
+    int client;
+    int connections = get_num_connections();
+
+    BENCH_CHECK((client = socket(AF_UNIX, SOCK_STREAM, 0)) >= 0);
+
+    connect_start = bench_now_usecs();
+    BENCH_CHECK(connect(client, (struct sockaddr *)&addr, sizeof(addr)) == 0);
+
+    while (get_num_connections() == connections)
+      BENCH_CHECK(wait_request(1, NULL) == PBSE_NONE);
+
+    accept_samples[i] = bench_elapsed_usecs(connect_start);
+
+    dispatched = 0;
+    BENCH_CHECK(write(client, "x", 1) == 1);
+
+    while (dispatched == 0)
+      BENCH_CHECK(wait_request(1, NULL) == PBSE_NONE);
+
+    first_dispatch_samples[i] = dispatched_at[last_dispatched] - connect_start;
+
+    close_conn(last_dispatched, FALSE);
+    close(client);
+    }
+
+  bench_report_latencies("bench_net_server", "  connect to accept", accept_samples, ACCEPTS);
+  bench_report_latencies("bench_net_server", "  connect to first dispatch", first_dispatch_samples, ACCEPTS);
+
+  close_conn(listener, FALSE);
+  unlink(path);
+  }
+
+
+
+void run(
+
+  enum wait_request_type  type,
+  int                     idle)
+
+  {
+  char what[128];
+  char path[64];
+
+  BENCH_CHECK(set_wait_request_mechanism(type) == PBSE_NONE);
+
+  add_socketpairs(idle_socks, idle);
+  add_socketpairs(hot_socks, HOT_CONNECTIONS);
+
+  snprintf(what, sizeof(what), "%s with %d idle and %d hot connections, %d requests per wakeup",
+    (type == WAIT_REQUEST_EPOLL) ? "epoll" : "select",
+    idle,
+    HOT_CONNECTIONS,
+    HOT_PER_ROUND);
+
+  time_dispatch(what);
+
+  snprintf(path, sizeof(path), "/tmp/bench_net_server.%d", (int)getpid());
+  time_accept(path);
+
+  remove_socketpairs(hot_socks, HOT_CONNECTIONS);
+  remove_socketpairs(idle_socks, idle);
+  }
+
+
+
+int main(
+
+  int   argc,
+  char *argv[])
+
+  {
+  int idle = (argc > 1) ? atoi(argv[1]) : 20000;
+  int max_fds = bench_raise_fd_limit();
+  int select_idle;
+
+  /* each connection is a socketpair, keep some descriptors for the rest */
+  if (idle * 2 + HOT_CONNECTIONS * 2 + 64 > max_fds)
+    {
+    idle = (max_fds - HOT_CONNECTIONS * 2 - 64) / 2;
+
+    printf("bench_net_server: the open file limit of %d allows %d idle connections\n",
+      max_fds,
+      idle);
+    }
+
+  if (idle > PBS_NET_MAX_CONNECTIONS / 2 - HOT_CONNECTIONS - 32)
+    idle = PBS_NET_MAX_CONNECTIONS / 2 - HOT_CONNECTIONS - 32;
+
+  /* select() only takes descriptors below FD_SETSIZE */
+  select_idle = FD_SETSIZE / 2 - HOT_CONNECTIONS - 32;
+
+  net_server_name = strdup("bench");
+  BENCH_CHECK(init_network(0, read_ready_sock) == PBSE_NONE);
+
+  run(WAIT_REQUEST_SELECT, select_idle);
+  run(WAIT_REQUEST_EPOLL, select_idle);
+  run(WAIT_REQUEST_EPOLL, idle);
+
+  return(0);
+  }
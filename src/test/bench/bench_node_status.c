@@ -0,0 +1,83 @@
+#include "license_pbs.h" /* See here for the software license */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#include "node_status.hpp"
+#include "attribute.h"
+#include "pbs_nodes.h"
+#include "pbs_error.h"
+#include "bench_timer.h"
+
+/*
+ * Times storing a mom's status update: once through node_status, which
+ * parses the strings in one pass and encodes the attribute once, and once
+ * with a decode_arst() per string as the server used to.
+ *
+ * usage: bench_node_status
+ */
+
+#define UPDATES 20000
+
+/* a status update captured from a mom, the same as the unit test's */
+const char *captured[] = { "opsys=linux", "uname=Linux n001 3.10.0-957.el7.x86_64 #1 SMP x86_64",
+                           "sessions=2731 2755", "nsessions=2", "nusers=1", "idletime=4132",
+                           "totmem=65766988kb", "availmem=61352780kb", "physmem=65766988kb",
+                           "ncpus=16", "loadave=0.52", "gres=tmp:100,scratch:2",
+                           "message=ERROR: disk\\, full", "netload=1948313924", " state=free ",
+                           "jobs=12.svr 13.svr", "varattr=", "cpuclock=Fixed",
+                           "macaddr=00:1a:2b:3c:4d:5e", "first_update=true", "trailing=a,", "loadave=0.75",
+                           "gres=tmp:50" };
+
+
+
+int main(
+
+  int   argc,
+  char *argv[])
+
+  {
+  node_status                ns;
+  pbs_attribute              attr;
+  std::vector<const char *>  kept;
+  double                     start;
+  int                        count = sizeof(captured) / sizeof(captured[0]);
+  char                       what[128];
+
+  memset(&attr, 0, sizeof(attr));
+
+  start = bench_now_usecs();
+
+  for (int i = 0; i < UPDATES; i++)
+    {
+    ns.clear();
+
+    for (int j = 0; j < count; j++)
+      ns.add(captured[j], strlen(captured[j]));
+
+    BENCH_CHECK(ns.encode(&attr, kept) == PBSE_NONE);
+    free_arst(&attr);
+    }
+
+  snprintf(what, sizeof(what), "update of %d strings, parsed by node_status", count);
+  bench_report_rate("bench_node_status", what, bench_elapsed_usecs(start), UPDATES);
+
+  start = bench_now_usecs();
+
+  for (int i = 0; i < UPDATES; i++)
+    {
+    for (int j = 0; j < count; j++)
+      {
+      if (strcmp(captured[j], "first_update=true"))
+        BENCH_CHECK(decode_arst(&attr, NULL, NULL, captured[j], 0) == PBSE_NONE);
+      }
+
+    free_arst(&attr);
+    }
+
+  snprintf(what, sizeof(what), "update of %d strings, decoded a string at a time", count);
+  bench_report_rate("bench_node_status", what, bench_elapsed_usecs(start), UPDATES);
+
+  return(0);
+  }
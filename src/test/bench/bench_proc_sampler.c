@@ -0,0 +1,146 @@
+#include "license_pbs.h" /* See here for the software license */
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <string>
+#include <vector>
+
+#include "proc_sampler.hpp"
+#include "pbs_error.h"
+#include "bench_timer.h"
+
+/*
+ * Times PROC_REFRESH_POLLS polls of a fake /proc of 10000 processes, 100 of
+ * them job sessions, through one proc_sampler kept between polls as pbs_mom
+ * keeps it, and through a new sampler each poll, which reads every stat file
+ * like the scan it replaced. Reports the time per poll and the stat files
+ * each way read.
+ *
+ * usage: bench_proc_sampler [processes, default 10000]
+ */
+
+#define JOB_PROCS 100
+
+
+
+void write_stat(
+
+  const std::string &root,
+  pid_t              pid,
+  int                session,
+  unsigned long      utime)
+
+  {
+  char  path[1024];
+  FILE *fp;
+
+  snprintf(path, sizeof(path), "%s/%d", root.c_str(), (int)pid);
+  mkdir(path, 0755);
+  snprintf(path, sizeof(path), "%s/%d/stat", root.c_str(), (int)pid);
+
+  BENCH_CHECK((fp = fopen(path, "w")) != NULL);
+  fprintf(fp, "%d (a.out) S 1 %d %d 0 -1 4202496 0 0 0 0 %lu 0 0 0 20 0 1 0 100 1000 10\n",
+    (int)pid, session, session, utime);
+  fclose(fp);
+  }
+
+
+
+void remove_stat(
+
+  const std::string &root,
+  pid_t              pid)
+
+  {
+  char path[1024];
+
+  snprintf(path, sizeof(path), "%s/%d/stat", root.c_str(), (int)pid);
+  unlink(path);
+  snprintf(path, sizeof(path), "%s/%d", root.c_str(), (int)pid);
+  rmdir(path);
+  }
+
+
+
+int main(
+
+  int   argc,
+  char *argv[])
+
+  {
+  char                       root_template[] = "/tmp/bench_procXXXXXX";
+  std::vector<pid_t>         pids;
+  std::vector<proc_stat_t *> sampled;
+  job_pid_set_t              job_sids;
+  pid2jobsid_map_t           job_procs;
+  int                        count = (argc > 1) ? atoi(argv[1]) : 10000;
+  int                        kept_reads = 0;
+  int                        full_reads = 0;
+  double                     start;
+  char                       what[128];
+
+  if (count < JOB_PROCS)
+    {
+    fprintf(stderr, "usage: %s [processes, at least %d]\n", argv[0], JOB_PROCS);
+    return(1);
+    }
+
+  BENCH_CHECK(mkdtemp(root_template) != NULL);
+  std::string root(root_template);
+
+  for (int i = 0; i < count; i++)
+    write_stat(root, 1000 + i, 1000 + i, i);
+
+  for (int i = 0; i < JOB_PROCS; i++)
+    {
+    job_sids.insert(1000 + i);
+    job_procs[1000 + i] = 1000 + i;
+    }
+
+  proc_sampler kept(root.c_str());
+
+  start = bench_now_usecs();
+
+  for (int i = 0; i < PROC_REFRESH_POLLS; i++)
+    {
+    BENCH_CHECK(kept.list_pids(pids) == PBSE_NONE);
+    BENCH_CHECK(kept.sample(pids, job_sids, 1, sampled) == PBSE_NONE);
+    BENCH_CHECK((int)sampled.size() == count);
+    kept.mark_job_procs(job_procs);
+    kept_reads += kept.get_stats_read();
+    }
+
+  snprintf(what, sizeof(what), "%d processes, poll with the sampler kept (%d stat files read)",
+    count,
+    kept_reads);
+  bench_report_rate("bench_proc_sampler", what, bench_elapsed_usecs(start), PROC_REFRESH_POLLS);
+
+  start = bench_now_usecs();
+
+  for (int i = 0; i < PROC_REFRESH_POLLS; i++)
+    {
+    proc_sampler full(root.c_str());
+
+    BENCH_CHECK(full.list_pids(pids) == PBSE_NONE);
+    BENCH_CHECK(full.sample(pids, job_sids, 1, sampled) == PBSE_NONE);
+    BENCH_CHECK((int)sampled.size() == count);
+    full_reads += full.get_stats_read();
+    }
+
+  snprintf(what, sizeof(what), "%d processes, poll with a new sampler (%d stat files read)",
+    count,
+    full_reads);
+  bench_report_rate("bench_proc_sampler", what, bench_elapsed_usecs(start), PROC_REFRESH_POLLS);
+
+  /* the first poll reads everything, the others only the job processes */
+  BENCH_CHECK(full_reads == count * PROC_REFRESH_POLLS);
+  BENCH_CHECK(kept_reads == count + JOB_PROCS * (PROC_REFRESH_POLLS - 1));
+
+  for (int i = 0; i < count; i++)
+    remove_stat(root, 1000 + i);
+
+  rmdir(root.c_str());
+
+  return(0);
+  }
@@ -0,0 +1,86 @@
+#include "license_pbs.h" /* See here for the software license */
+#include <stdlib.h>
+#include <stdio.h>
+#include <vector>
+
+#include "work_task.h"
+#include "bench_timer.h"
+
+/*
+ * Times arming, cancelling and expiring timed tasks at the sizes of a server
+ * re-arming a timer per job. A tenth of the tasks are cancelled before they
+ * expire, and the rest expire a second's worth at a time over an hour, like
+ * the main loop's calls to check_tasks().
+ *
+ * usage: bench_svr_task
+ */
+
+#define SPREAD_SECS 3600
+
+extern timed_task_heap *task_list_timed;
+
+int task_counts[] = { 10000, 100000, 500000 };
+
+
+
+void run(
+
+  int num_tasks)
+
+  {
+  work_task                *tasks = (work_task *)calloc(num_tasks, sizeof(work_task));
+  std::vector<work_task *>  expired;
+  double                    start;
+  char                      what[128];
+
+  BENCH_CHECK(tasks != NULL);
+
+  start = bench_now_usecs();
+
+  for (int i = 0; i < num_tasks; i++)
+    {
+    tasks[i].wt_event = ((long)i * 7919) % SPREAD_SECS;
+    insert_timed_task(tasks + i);
+    }
+
+  snprintf(what, sizeof(what), "%d timed tasks, insert", num_tasks);
+  bench_report_rate("bench_svr_task", what, bench_elapsed_usecs(start), num_tasks);
+
+  start = bench_now_usecs();
+
+  for (int i = 0; i < num_tasks; i += 10)
+    task_list_timed->remove(tasks + i);
+
+  snprintf(what, sizeof(what), "%d timed tasks, cancel", num_tasks);
+  bench_report_rate("bench_svr_task", what, bench_elapsed_usecs(start), (num_tasks + 9) / 10);
+
+  start = bench_now_usecs();
+
+  for (time_t now = 0; now < SPREAD_SECS; now++)
+    pop_expired_timed_tasks(now, expired);
+
+  snprintf(what, sizeof(what), "%d timed tasks, expire", num_tasks);
+  bench_report_rate("bench_svr_task", what, bench_elapsed_usecs(start), expired.size());
+
+  BENCH_CHECK((int)expired.size() == num_tasks - (num_tasks + 9) / 10);
+  BENCH_CHECK(task_list_timed->size() == 0);
+
+  free(tasks);
+  }
+
+
+
+int main(
+
+  int   argc,
+  char *argv[])
+
+  {
+  if (task_list_timed == NULL)
+    task_list_timed = new timed_task_heap();
+
+  for (unsigned int i = 0; i < sizeof(task_counts) / sizeof(task_counts[0]); i++)
+    run(task_counts[i]);
+
+  return(0);
+  }
@@ -0,0 +1,151 @@
+#include "license_pbs.h" /* See here for the software license */
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "pbs_error.h"
+#include "threadpool.h"
+#include "bench_timer.h"
+
+/*
+ * Times enqueue_threadpool_request() the way the listener threads feed
+ * request_pool: several producers queueing small requests to pools of 8, 32
+ * and 128 workers. Each size runs once with the lock-free ring and once with
+ * the ring disabled, so every request goes through the tp_mutex list queue
+ * the pool used before the ring. Reports the throughput and the latency from
+ * queueing a request to a worker starting it.
+ *
+ * usage: bench_threadpool [producers, default 4]
+ */
+
+#define MAX_PRODUCERS 64
+#define REQUESTS      50000
+
+threadpool_t  *pool;
+int            producers;
+volatile int   work_done;
+double        *queued_at;
+double        *started_at;
+
+int            pool_sizes[] = { 8, 32, 128 };
+
+
+
+void *time_work(
+
+  void *arg)
+
+  {
+  started_at[(long)arg] = bench_now_usecs();
+  __sync_add_and_fetch(&work_done, 1);
+
+  return(NULL);
+  }
+
+
+
+void *producer(
+
+  void *arg)
+
+  {
+  long first = (long)arg * REQUESTS;
+
+  for (long i = first; i < first + REQUESTS; i++)
+    {
+    queued_at[i] = bench_now_usecs();
+    BENCH_CHECK(enqueue_threadpool_request(time_work, (void *)i, pool) == PBSE_NONE);
+    }
+
+  return(NULL);
+  }
+
+
+
+void run(
+
+  int  threads,
+  bool use_ring)
+
+  {
+  pthread_t producer_ids[MAX_PRODUCERS];
+  int       total = producers * REQUESTS;
+  double    start;
+  double    usecs;
+  char      what[128];
+
+  BENCH_CHECK(initialize_threadpool(&pool, threads, threads, -1) == PBSE_NONE);
+
+  if (use_ring == false)
+    {
+    /* with no ring every request takes the overflow list under tp_mutex */
+    free(pool->tp_ring);
+    pool->tp_ring = NULL;
+    }
+
+  start_request_pool(pool);
+
+  /* let the workers reach their wait before timing */
+  usleep(100000);
+
+  work_done = 0;
+  start = bench_now_usecs();
+
+  for (long i = 0; i < producers; i++)
+    BENCH_CHECK(pthread_create(&producer_ids[i], NULL, producer, (void *)i) == 0);
+
+  for (int i = 0; i < producers; i++)
+    pthread_join(producer_ids[i], NULL);
+
+  while (work_done < total)
+    usleep(100);
+
+  usecs = bench_elapsed_usecs(start);
+
+  for (int i = 0; i < total; i++)
+    started_at[i] -= queued_at[i];
+
+  snprintf(what, sizeof(what), "%s, %d workers, %d producers",
+    (use_ring == true) ? "ring" : "list",
+    threads,
+    producers);
+
+  bench_report_rate("bench_threadpool", what, usecs, total);
+  bench_report_latencies("bench_threadpool", "  queued to started", started_at, total);
+
+  destroy_request_pool(pool);
+  free(pool);
+  pool = NULL;
+  }
+
+
+
+int main(
+
+  int   argc,
+  char *argv[])
+
+  {
+  producers = (argc > 1) ? atoi(argv[1]) : 4;
+
+  if ((producers < 1) || (producers > MAX_PRODUCERS))
+    {
+    fprintf(stderr, "usage: %s [producers, 1 to %d]\n", argv[0], MAX_PRODUCERS);
+    return(1);
+    }
+
+  if (sysconf(_SC_NPROCESSORS_ONLN) < 2)
+    printf("bench_threadpool: only one cpu is online, the producers and workers won't contend\n");
+
+  BENCH_CHECK((queued_at = (double *)calloc(producers * REQUESTS, sizeof(double))) != NULL);
+  BENCH_CHECK((started_at = (double *)calloc(producers * REQUESTS, sizeof(double))) != NULL);
+
+  for (unsigned int i = 0; i < sizeof(pool_sizes) / sizeof(pool_sizes[0]); i++)
+    {
+    run(pool_sizes[i], false);
+    run(pool_sizes[i], true);
+    }
+
+  return(0);
+  }
@@ -0,0 +1,132 @@
+#include "license_pbs.h" /* See here for the software license */
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#include <algorithm>
+
+#include "bench_timer.h"
+
+
+
+/*
+ * bench_check_failed() - reports the check that failed and ends the run
+ */
+
+void bench_check_failed(
+
+  const char *cond,
+  const char *file,
+  int         line)
+
+  {
+  fprintf(stderr, "%s:%d: check failed: %s\n", file, line, cond);
+  exit(1);
+  } /* END bench_check_failed() */
+
+
+
+/*
+ * bench_now_usecs() - the monotonic clock in microseconds
+ */
+
+double bench_now_usecs()
+
+  {
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  return(now.tv_sec * 1000000.0 + now.tv_nsec / 1000.0);
+  } /* END bench_now_usecs() */
+
+
+
+/*
+ * bench_elapsed_usecs() - microseconds since start, a bench_now_usecs() value
+ */
+
+double bench_elapsed_usecs(
+
+  double start)
+
+  {
+  return(bench_now_usecs() - start);
+  } /* END bench_elapsed_usecs() */
+
+
+
+/*
+ * bench_report_rate() - prints the cost per operation of count operations
+ * that took usecs in all
+ */
+
+void bench_report_rate(
+
+  const char *bench,
+  const char *what,
+  double      usecs,
+  long        count)
+
+  {
+  printf("%s: %s: %.3f usecs each (%ld in %.1f ms)\n",
+    bench,
+    what,
+    (count > 0) ? usecs / count : 0.0,
+    count,
+    usecs / 1000.0);
+  fflush(stdout);
+  } /* END bench_report_rate() */
+
+
+
+/*
+ * bench_report_latencies() - prints the median, 99th percentile and worst of
+ * count samples in microseconds. The samples are sorted in place.
+ */
+
+void bench_report_latencies(
+
+  const char *bench,
+  const char *what,
+  double     *samples,
+  int         count)
+
+  {
+  if (count <= 0)
+    return;
+
+  std::sort(samples, samples + count);
+
+  printf("%s: %s: p50 %.2f usecs, p99 %.2f usecs, max %.2f usecs (%d samples)\n",
+    bench,
+    what,
+    samples[count / 2],
+    samples[(count * 99) / 100],
+    samples[count - 1],
+    count);
+  fflush(stdout);
+  } /* END bench_report_latencies() */
+
+
+
+/*
+ * bench_raise_fd_limit() - raises the open file limit to its hard limit
+ *
+ * @return the number of descriptors the benchmark may open
+ */
+
+int bench_raise_fd_limit()
+
+  {
+  struct rlimit limit;
+
+  if (getrlimit(RLIMIT_NOFILE, &limit) == 0)
+    {
+    limit.rlim_cur = limit.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &limit);
+    }
+
+  return(getdtablesize());
+  } /* END bench_raise_fd_limit() */
@@ -0,0 +1,21 @@
+#ifndef _BENCH_TIMER_H
+#define _BENCH_TIMER_H
+#include "license_pbs.h" /* See here for the software license */
+
+/*
+ * bench_timer.h - timing and reporting shared by the benchmarks in
+ * src/test/bench. Each benchmark is its own program, run with 'make bench'.
+ */
+
+/* fails the benchmark if cond isn't true, so a broken run prints no numbers */
+#define BENCH_CHECK(cond) \
+  ((cond) ? (void)0 : bench_check_failed(#cond, __FILE__, __LINE__))
+
+void   bench_check_failed(const char *cond, const char *file, int line);
+double bench_now_usecs();
+double bench_elapsed_usecs(double start);
+void   bench_report_rate(const char *bench, const char *what, double usecs, long count);
+void   bench_report_latencies(const char *bench, const char *what, double *samples, int count);
+int    bench_raise_fd_limit();
+
+#endif /* _BENCH_TIMER_H */